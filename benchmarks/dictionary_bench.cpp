@@ -0,0 +1,95 @@
+// Dictionary column benchmark: an orders table whose status, carrier, country and
+// city columns hold a few hundred distinct strings between them, loaded once with
+// plain STRING columns and once with dictionary columns. Reports the table's pages
+// after a flush, the time of a full scan, and of an unindexed equality lookup on
+// status, which compares codes instead of strings when the column is a dictionary.
+#include "storage/interface/storage_engine.hpp"
+#include "common/constants.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+static constexpr int ROWS = 50000;
+static constexpr int ROUNDS = 5;
+
+static Relational::TableSchema make_schema(bool dictionary) {
+    Relational::TableSchema schema;
+    schema.pk_index = 0;
+    schema.columns = {
+        {"id", Relational::ColumnType::INT},
+        {"status", Relational::ColumnType::STRING, false, dictionary},
+        {"carrier", Relational::ColumnType::STRING, false, dictionary},
+        {"country", Relational::ColumnType::STRING, false, dictionary},
+        {"city", Relational::ColumnType::STRING, false, dictionary},
+        {"amount", Relational::ColumnType::DOUBLE}
+    };
+    return schema;
+}
+
+static std::vector<Relational::Tuple> make_rows() {
+    // Skewed like a real order log: most orders are delivered, few are returned
+    const char* statuses[] = {"delivered", "delivered", "delivered", "delivered", "shipped",
+                              "shipped", "pending", "cancelled", "returned"};
+    const char* carriers[] = {"UPS", "FedEx", "DHL Express", "USPS", "Royal Mail", "Canada Post", "La Poste",
+                              "Deutsche Post"};
+    const char* countries[] = {"United States", "Canada", "United Kingdom", "Germany", "France", "Spain",
+                               "Italy", "Netherlands", "Sweden", "Poland", "Japan", "Australia",
+                               "Brazil", "Mexico", "India", "South Korea"};
+    std::mt19937 rng(42);
+    std::vector<Relational::Tuple> rows;
+    rows.reserve(ROWS);
+    for (int i = 0; i < ROWS; i++) {
+        size_t country = rng() % 16;
+        std::string city = std::string(countries[country]) + " city " + std::to_string(rng() % 12);
+        rows.push_back({i, std::string(statuses[rng() % 9]), std::string(carriers[rng() % 8]),
+                        std::string(countries[country]), city, static_cast<double>(rng() % 100000) / 100});
+    }
+    return rows;
+}
+
+static void run(bool dictionary, const std::vector<Relational::Tuple>& rows) {
+    const std::string table = dictionary ? "bench_dictionary_coded" : "bench_dictionary_plain";
+    const std::string path = "data/" + table + ".db";
+    std::remove(path.c_str());
+    StorageEngine engine;
+    engine.create_table(table, make_schema(dictionary));
+    for (const auto& row : rows) {
+        if (!engine.insert(table, row)) {
+            std::printf("  [ERROR] insert failed\n");
+            return;
+        }
+    }
+    engine.flush_all();
+    size_t pages = static_cast<size_t>(std::filesystem::file_size(path)) / PAGE_SIZE;
+
+    size_t scanned = 0;
+    size_t matched = 0;
+    double scan_ms = 0;
+    double lookup_ms = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        auto start = std::chrono::steady_clock::now();
+        scanned += engine.scan(table).size();
+        auto mid = std::chrono::steady_clock::now();
+        matched += engine.lookup(table, "status", std::string("returned")).size();
+        auto end = std::chrono::steady_clock::now();
+        scan_ms += std::chrono::duration<double, std::milli>(mid - start).count();
+        lookup_ms += std::chrono::duration<double, std::milli>(end - mid).count();
+    }
+    std::printf("  %-10s %6zu pages   scan %7.2f ms   status lookup %7.2f ms   (%zu rows, %zu matches)\n",
+                dictionary ? "dictionary" : "plain", pages, scan_ms / ROUNDS, lookup_ms / ROUNDS,
+                scanned / ROUNDS, matched / ROUNDS);
+    engine.drop_table(table);
+}
+
+int main() {
+    std::filesystem::create_directories("data");
+    std::printf("=== Dictionary column benchmark: %d orders (PAGE_SIZE=%u), %d rounds ===\n", ROWS, PAGE_SIZE,
+                ROUNDS);
+    std::vector<Relational::Tuple> rows = make_rows();
+    run(false, rows);
+    run(true, rows);
+    return 0;
+}
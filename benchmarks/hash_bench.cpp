@@ -0,0 +1,81 @@
+// Point lookup benchmark: extendible hash file vs B+tree on the same keys.
+// Both files go through a default-sized buffer pool, so larger key counts also
+// measure how many page fetches each lookup needs once the file outgrows it.
+#include "storage/btree.hpp"
+#include "storage/hash_index.hpp"
+#include "storage/buffer_pool.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::vector<std::string> make_keys(size_t count) {
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        char buf[24];
+        std::snprintf(buf, sizeof(buf), "user_%010zu", i * 7919 % 1000000007);
+        keys.push_back(buf);
+    }
+    return keys;
+}
+
+static bool load(TableHandle& th, bool hash, const std::vector<std::string>& keys) {
+    const uint8_t value[16] = {0};
+    for (const auto& k : keys) {
+        bool ok = hash ? hash_insert(th, Key(k), Value(value, sizeof(value)))
+                       : btree_insert(th, Key(k), Value(value, sizeof(value)));
+        if (!ok) {
+            return false;
+        }
+    }
+    th.bpm->flush_all();
+    return true;
+}
+
+static double run(TableHandle& th, bool hash, const std::vector<std::string>& probes) {
+    size_t found = 0;
+    Value out;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& k : probes) {
+        found += hash ? hash_search(th, Key(k), out) : btree_search(th, Key(k), out);
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (found != probes.size()) {
+        std::printf("  [ERROR] only %zu of %zu keys found\n", found, probes.size());
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / probes.size();
+}
+
+int main() {
+    std::printf("=== Point lookup benchmark: hash vs B+tree (PAGE_SIZE=%u) ===\n", PAGE_SIZE);
+    for (size_t count : {2000, 20000, 100000}) {
+        std::vector<std::string> keys = make_keys(count);
+        std::remove("data/bench_lookup_btree.db");
+        std::remove("data/bench_lookup_hash.db");
+        create_table("bench_lookup_btree");
+        hash_create("bench_lookup_hash");
+        TableHandle btree("bench_lookup_btree");
+        TableHandle hash("bench_lookup_hash");
+        if (!open_table("bench_lookup_btree", btree) || !hash_open("bench_lookup_hash", hash) ||
+            !load(btree, false, keys) || !load(hash, true, keys)) {
+            std::printf("  [ERROR] could not build the %zu-key files\n", count);
+            return 1;
+        }
+
+        std::mt19937 rng(42);
+        std::vector<std::string> probes;
+        const size_t lookups = 500000;
+        for (size_t i = 0; i < lookups; i++) {
+            probes.push_back(keys[rng() % keys.size()]);
+        }
+        double tree_ns = run(btree, false, probes);
+        double hash_ns = run(hash, true, probes);
+        std::printf("  %6zu keys: btree %7.1f ns/lookup, hash %7.1f ns/lookup (%zu directory slots), %.2fx\n",
+                    count, tree_ns, hash_ns, hash.hash_directory.size(), tree_ns / hash_ns);
+    }
+    std::remove("data/bench_lookup_btree.db");
+    std::remove("data/bench_lookup_hash.db");
+    return 0;
+}
@@ -0,0 +1,100 @@
+// Ingest benchmark: LSM file vs B+tree on the same random keys.
+// insert-heavy loads every key; mixed interleaves inserts of new keys with point
+// lookups of loaded ones (3 inserts per lookup). Both files use a default-sized
+// buffer pool, so B+tree inserts past its size pay for random leaf writes while
+// LSM inserts only write whole runs sequentially.
+#include "storage/btree.hpp"
+#include "storage/lsm_tree.hpp"
+#include "storage/buffer_pool.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::vector<std::string> make_keys(size_t count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        char buf[24];
+        std::snprintf(buf, sizeof(buf), "user_%010u", static_cast<unsigned>(rng()));
+        keys.push_back(buf);
+    }
+    return keys;
+}
+
+static bool insert(TableHandle& th, bool lsm, const std::string& key) {
+    const uint8_t value[16] = {0};
+    return lsm ? lsm_insert(th, Key(key), Value(value, sizeof(value)))
+               : btree_insert(th, Key(key), Value(value, sizeof(value)));
+}
+
+static double load(TableHandle& th, bool lsm, const std::vector<std::string>& keys) {
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& k : keys) {
+        insert(th, lsm, k);
+    }
+    if (lsm) {
+        lsm_flush(th);
+    }
+    th.bpm->flush_all();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / keys.size();
+}
+
+static double mixed(TableHandle& th, bool lsm, const std::vector<std::string>& loaded,
+                    const std::vector<std::string>& fresh) {
+    std::mt19937 rng(42);
+    size_t found = 0;
+    size_t lookups = 0;
+    Value out;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < fresh.size(); i++) {
+        insert(th, lsm, fresh[i]);
+        if (i % 3 == 2) {
+            const std::string& k = loaded[rng() % loaded.size()];
+            found += lsm ? lsm_search(th, Key(k), out) : btree_search(th, Key(k), out);
+            lookups++;
+        }
+    }
+    if (lsm) {
+        lsm_flush(th);
+    }
+    th.bpm->flush_all();
+    auto end = std::chrono::steady_clock::now();
+    if (found != lookups) {
+        std::printf("  [ERROR] only %zu of %zu keys found\n", found, lookups);
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / (fresh.size() + lookups);
+}
+
+int main() {
+    std::printf("=== Ingest benchmark: LSM vs B+tree (PAGE_SIZE=%u, memtable %u KB) ===\n",
+                PAGE_SIZE, LSM_MEMTABLE_BYTES / 1024);
+    for (size_t count : {20000, 100000}) {
+        std::vector<std::string> keys = make_keys(count, 7);
+        std::vector<std::string> fresh = make_keys(count / 2, 11);
+        std::remove("data/bench_ingest_btree.db");
+        std::remove("data/bench_ingest_lsm.db");
+        create_table("bench_ingest_btree");
+        lsm_create("bench_ingest_lsm");
+        TableHandle btree("bench_ingest_btree");
+        TableHandle lsm("bench_ingest_lsm");
+        if (!open_table("bench_ingest_btree", btree) || !lsm_open("bench_ingest_lsm", lsm)) {
+            std::printf("  [ERROR] could not create the %zu-key files\n", count);
+            return 1;
+        }
+        double tree_load = load(btree, false, keys);
+        double lsm_load_ns = load(lsm, true, keys);
+        double tree_mixed = mixed(btree, false, keys, fresh);
+        double lsm_mixed = mixed(lsm, true, keys, fresh);
+        std::printf("  %6zu keys: insert-heavy btree %7.1f ns/op, lsm %7.1f ns/op (%.2fx); "
+                    "mixed btree %7.1f ns/op, lsm %7.1f ns/op (%.2fx), %zu runs\n",
+                    count, tree_load, lsm_load_ns, tree_load / lsm_load_ns,
+                    tree_mixed, lsm_mixed, tree_mixed / lsm_mixed, lsm.lsm->runs.size());
+    }
+    std::remove("data/bench_ingest_btree.db");
+    std::remove("data/bench_ingest_lsm.db");
+    return 0;
+}
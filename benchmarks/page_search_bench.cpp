@@ -0,0 +1,89 @@
+// In-page search benchmark: prefixed slot directory vs legacy 2-byte slots.
+// Built twice by CMake: bench_page_search (2 KB pages) and bench_page_search_8k.
+#include "storage/page.hpp"
+#include "storage/record.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+static std::vector<std::string> make_keys(bool shared_prefix, size_t count, std::mt19937& rng) {
+    std::vector<std::string> keys;
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (size_t i = 0; i < count; i++) {
+        std::string k;
+        if (shared_prefix) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "user_%08u", static_cast<unsigned>(rng()));
+            k = buf;
+        } else {
+            for (int j = 0; j < 12; j++) k.push_back(static_cast<char>(byte(rng)));
+        }
+        keys.push_back(k);
+    }
+    return keys;
+}
+
+// Fills the page until it is full and returns the keys that made it in
+static std::vector<std::string> fill_page(Page& page, bool prefixed, const std::vector<std::string>& keys) {
+    init_page(page, 2, PageType::DATA, PageLevel::LEAF);
+    if (!prefixed) {
+        get_header(page)->flags &= ~PAGE_FLAG_KEY_PREFIX;
+    }
+    std::vector<std::string> inserted;
+    const uint8_t value[8] = {0};
+    for (const auto& k : keys) {
+        if (!can_insert(page, record_size(k.size(), sizeof(value)))) break;
+        if (page_insert(page, (const uint8_t*)k.data(), (uint16_t)k.size(), value, sizeof(value))) {
+            inserted.push_back(k);
+        }
+    }
+    return inserted;
+}
+
+static double run(bool prefixed, bool shared_prefix) {
+    std::mt19937 rng(42);
+    std::vector<std::string> keys = make_keys(shared_prefix, PAGE_SIZE, rng);
+
+    // Many distinct pages so probes do not all hit one hot page in L1
+    const size_t num_pages = 256;
+    std::vector<Page> pages(num_pages);
+    std::vector<std::vector<std::string>> page_keys(num_pages);
+    for (size_t p = 0; p < num_pages; p++) {
+        std::shuffle(keys.begin(), keys.end(), rng);
+        page_keys[p] = fill_page(pages[p], prefixed, keys);
+    }
+
+    const size_t lookups = 2000000;
+    std::uniform_int_distribution<size_t> pick_page(0, num_pages - 1);
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; i++) {
+        size_t p = pick_page(rng);
+        const std::string& k = page_keys[p][rng() % page_keys[p].size()];
+        BSearchResult r = search_record(pages[p], (const uint8_t*)k.data(), (uint16_t)k.size());
+        found += r.found;
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (found != lookups) {
+        std::printf("  [ERROR] only %zu of %zu keys found\n", found, lookups);
+    }
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / lookups;
+    std::printf("  %-8s slots, %-13s keys: %4zu keys/page, %7.1f ns/search\n",
+                prefixed ? "prefixed" : "legacy", shared_prefix ? "shared-prefix" : "random",
+                page_keys[0].size(), ns);
+    return ns;
+}
+
+int main() {
+    std::printf("=== In-page search benchmark (PAGE_SIZE=%u) ===\n", PAGE_SIZE);
+    for (bool shared : {false, true}) {
+        double legacy = run(false, shared);
+        double prefixed = run(true, shared);
+        std::printf("  speedup: %.2fx\n", legacy / prefixed);
+    }
+    return 0;
+}
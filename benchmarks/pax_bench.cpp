@@ -0,0 +1,131 @@
+// PAX layout benchmark: the same order lines loaded into a row-layout B+tree table
+// and a PAX table. Reports the table's pages after a flush, then the time of a
+// single-column aggregate (SUM(amount) through scan_column), a single-column filter
+// counted over the batches (quantity = 3), the same filter returning whole rows
+// through lookup, a full scan, and point lookups by primary key, which on a PAX
+// table find the row's slot in its block.
+#include "storage/interface/storage_engine.hpp"
+#include "common/constants.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+static constexpr int ROWS = 50000;
+static constexpr int ROUNDS = 5;
+static constexpr int POINT_LOOKUPS = 5000;
+
+static Relational::TableSchema make_schema(bool pax) {
+    Relational::TableSchema schema;
+    schema.pk_index = 0;
+    schema.storage = pax ? Relational::TableStorage::PAX : Relational::TableStorage::BTREE;
+    schema.columns = {
+        {"id", Relational::ColumnType::INT},
+        {"customer", Relational::ColumnType::INT},
+        {"quantity", Relational::ColumnType::INT},
+        {"amount", Relational::ColumnType::DOUBLE},
+        {"shipped", Relational::ColumnType::BOOLEAN},
+        {"sku", Relational::ColumnType::STRING}
+    };
+    return schema;
+}
+
+static std::vector<Relational::Tuple> make_rows() {
+    std::mt19937 rng(42);
+    std::vector<Relational::Tuple> rows;
+    rows.reserve(ROWS);
+    for (int i = 0; i < ROWS; i++) {
+        rows.push_back({i, static_cast<int>(rng() % 5000), static_cast<int>(1 + rng() % 10),
+                        static_cast<double>(rng() % 100000) / 100, rng() % 4 != 0,
+                        "SKU-" + std::to_string(100000 + rng() % 900000)});
+    }
+    return rows;
+}
+
+struct Aggregate {
+    double sum = 0;
+    size_t matched = 0;
+};
+
+static void sum_amount(const Relational::ColumnBatch& batch, void* ctx) {
+    Aggregate* total = static_cast<Aggregate*>(ctx);
+    for (size_t i = 0; i < batch.count; i++) {
+        double v;
+        std::memcpy(&v, batch.data + i * 8, 8);
+        total->sum += v;
+    }
+}
+
+static void count_quantity(const Relational::ColumnBatch& batch, void* ctx) {
+    Aggregate* total = static_cast<Aggregate*>(ctx);
+    for (size_t i = 0; i < batch.count; i++) {
+        int32_t v;
+        std::memcpy(&v, batch.data + i * 4, 4);
+        total->matched += v == 3;
+    }
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void run(bool pax, const std::vector<Relational::Tuple>& rows) {
+    const std::string table = pax ? "bench_pax_columns" : "bench_pax_rows";
+    const std::string path = "data/" + table + ".db";
+    std::remove(path.c_str());
+    StorageEngine engine;
+    engine.create_table(table, make_schema(pax));
+    for (const auto& row : rows) {
+        if (!engine.insert(table, row)) {
+            std::printf("  [ERROR] insert failed\n");
+            return;
+        }
+    }
+    engine.flush_all();
+    size_t pages = static_cast<size_t>(std::filesystem::file_size(path)) / PAGE_SIZE;
+
+    std::mt19937 rng(7);
+    Aggregate total;
+    size_t filtered = 0;
+    size_t scanned = 0;
+    size_t found = 0;
+    double sum_ms = 0, count_ms = 0, filter_ms = 0, scan_ms = 0, point_ms = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        auto start = std::chrono::steady_clock::now();
+        engine.scan_column(table, "amount", sum_amount, &total);
+        sum_ms += elapsed_ms(start);
+        start = std::chrono::steady_clock::now();
+        engine.scan_column(table, "quantity", count_quantity, &total);
+        count_ms += elapsed_ms(start);
+        start = std::chrono::steady_clock::now();
+        filtered += engine.lookup(table, "quantity", 3).size();
+        filter_ms += elapsed_ms(start);
+        start = std::chrono::steady_clock::now();
+        scanned += engine.scan(table).size();
+        scan_ms += elapsed_ms(start);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < POINT_LOOKUPS; i++) {
+            found += engine.lookup(table, "id", static_cast<int>(rng() % ROWS)).size();
+        }
+        point_ms += elapsed_ms(start);
+    }
+    std::printf("  %-4s %5zu pages   SUM %6.2f ms   COUNT filter %6.2f ms   lookup filter %6.2f ms   "
+                "scan %6.2f ms   %d point lookups %6.2f ms\n",
+                pax ? "PAX" : "row", pages, sum_ms / ROUNDS, count_ms / ROUNDS, filter_ms / ROUNDS,
+                scan_ms / ROUNDS, POINT_LOOKUPS, point_ms / ROUNDS);
+    std::printf("       (SUM %.2f, %zu counted, %zu filtered, %zu scanned, %zu found per round)\n",
+                total.sum / ROUNDS, total.matched / ROUNDS, filtered / ROUNDS, scanned / ROUNDS, found / ROUNDS);
+    engine.drop_table(table);
+}
+
+int main() {
+    std::filesystem::create_directories("data");
+    std::printf("=== PAX layout benchmark: %d rows (PAGE_SIZE=%u), %d rounds ===\n", ROWS, PAGE_SIZE, ROUNDS);
+    std::vector<Relational::Tuple> rows = make_rows();
+    run(false, rows);
+    run(true, rows);
+    return 0;
+}
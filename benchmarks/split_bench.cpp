@@ -0,0 +1,114 @@
+// Leaf split microbenchmark: the old per-record vector copy vs split_leaf_records.
+// Only the in-memory redistribution is timed; page allocation and buffer pool I/O
+// are the same for both and are left out.
+#include "storage/btree.hpp"
+#include "storage/buffer_pool.hpp"
+#include "storage/page.hpp"
+#include "storage/record.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+static size_t g_allocations = 0;
+
+void* operator new(size_t size) {
+    g_allocations++;
+    if (void* p = std::malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// Split as it was done before: every record copied into two heap vectors
+static void legacy_split(Page& page, Page& new_page, uint16_t split_idx) {
+    struct Record {
+        std::vector<uint8_t> key;
+        std::vector<uint8_t> value;
+    };
+    std::vector<Record> all_records;
+    PageHeader* ph = get_header(page);
+    uint16_t total = ph->cell_count;
+    for (uint16_t i = 0; i < total; i++) {
+        uint16_t key_len = 0;
+        uint16_t value_len = 0;
+        const uint8_t* key_data = slot_key(page, i, key_len);
+        const uint8_t* value_data = slot_value(page, i, value_len);
+        Record rec;
+        rec.key.assign(key_data, key_data + key_len);
+        rec.value.assign(value_data, value_data + value_len);
+        all_records.push_back(std::move(rec));
+    }
+    init_page(page, ph->page_id, PageType::DATA, PageLevel::LEAF);
+    for (uint16_t i = 0; i < total; i++) {
+        Page& target = i < split_idx ? page : new_page;
+        const auto& rec = all_records[i];
+        uint16_t offset = write_record(target, rec.key.data(), rec.key.size(), rec.value.data(), rec.value.size());
+        insert_slot(target, get_header(target)->cell_count, offset);
+    }
+}
+
+static void fill_leaf(Page& page, uint16_t value_size) {
+    init_page(page, 3, PageType::DATA, PageLevel::LEAF);
+    std::vector<uint8_t> value(value_size, 'v');
+    for (uint32_t i = 0;; i++) {
+        char key[16];
+        int len = std::snprintf(key, sizeof(key), "key_%08u", i);
+        if (!page_insert(page, (const uint8_t*)key, (uint16_t)len, value.data(), value_size)) {
+            break;
+        }
+    }
+}
+
+static double run(bool legacy, uint16_t value_size, size_t& allocs_per_split, uint16_t& records) {
+    Page full;
+    fill_leaf(full, value_size);
+    records = get_header(full)->cell_count;
+    uint16_t split_idx = records / 2;
+
+    const size_t iterations = 200000;
+    Page page;
+    Page new_page;
+    size_t allocs_before = g_allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        std::memcpy(page.data, full.data, PAGE_SIZE);
+        init_page(new_page, 4, PageType::DATA, PageLevel::LEAF);
+        if (legacy) {
+            legacy_split(page, new_page, split_idx);
+        } else {
+            split_leaf_records(page, new_page, split_idx);
+        }
+        if (get_header(page)->cell_count + get_header(new_page)->cell_count != records) {
+            std::printf("  [ERROR] split lost records\n");
+            return 0;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    allocs_per_split = (g_allocations - allocs_before) / iterations;
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int main() {
+    std::printf("=== Leaf split benchmark (PAGE_SIZE=%u) ===\n", PAGE_SIZE);
+    for (uint16_t value_size : {8, 40, 200}) {
+        size_t legacy_allocs = 0;
+        size_t raw_allocs = 0;
+        uint16_t records = 0;
+        double legacy = run(true, value_size, legacy_allocs, records);
+        double raw = run(false, value_size, raw_allocs, records);
+        std::printf("  %3u-byte values, %3u records: legacy %8.1f ns (%zu allocs), raw %8.1f ns (%zu allocs), %.2fx\n",
+                    value_size, records, legacy, legacy_allocs, raw, raw_allocs, legacy / raw);
+    }
+    return 0;
+}
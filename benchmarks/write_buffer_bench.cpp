@@ -0,0 +1,88 @@
+// Random-key ingest benchmark: B+tree with and without a write buffer.
+// Both trees go through a default-sized buffer pool, so once the tree outgrows
+// it every insert fetches a cold leaf. A buffered insert reads no leaf and writes
+// a buffer page; a flush writes the leaves it dirties back a group per sync.
+#include "storage/btree.hpp"
+#include "storage/buffer_pool.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::vector<std::string> make_keys(size_t count) {
+    std::mt19937 rng(7);
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        char buf[24];
+        std::snprintf(buf, sizeof(buf), "user_%010u", static_cast<unsigned>(rng()));
+        keys.push_back(buf);
+    }
+    return keys;
+}
+
+static double ingest(TableHandle& th, const std::vector<std::string>& keys) {
+    const uint8_t value[16] = {0};
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& k : keys) {
+        btree_insert(th, Key(k), Value(value, sizeof(value)));
+    }
+    btree_flush_write_buffer(th);
+    th.bpm->flush_all();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / keys.size();
+}
+
+static double lookup(TableHandle& th, const std::vector<std::string>& probes) {
+    size_t found = 0;
+    Value out;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& k : probes) {
+        found += btree_search(th, Key(k), out);
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (found != probes.size()) {
+        std::printf("  [ERROR] only %zu of %zu keys found\n", found, probes.size());
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / probes.size();
+}
+
+int main() {
+    std::printf("=== Random ingest benchmark: buffered vs plain B+tree (PAGE_SIZE=%u, %u buffer pages) ===\n",
+                PAGE_SIZE, WRITE_BUFFER_PAGES);
+    for (size_t count : {20000, 100000, 200000}) {
+        std::vector<std::string> keys = make_keys(count);
+        std::remove("data/bench_ingest_plain.db");
+        std::remove("data/bench_ingest_buffered.db");
+        create_table("bench_ingest_plain");
+        create_table("bench_ingest_buffered");
+        TableHandle plain("bench_ingest_plain");
+        TableHandle buffered("bench_ingest_buffered");
+        if (!open_table("bench_ingest_plain", plain) || !open_table("bench_ingest_buffered", buffered) ||
+            !btree_enable_write_buffer(buffered)) {
+            std::printf("  [ERROR] could not create the %zu-key files\n", count);
+            return 1;
+        }
+        double plain_ns = ingest(plain, keys);
+        double buffered_ns = ingest(buffered, keys);
+
+        // Lookups while the buffer holds fresh writes pay one extra page probe
+        std::mt19937 rng(42);
+        std::vector<std::string> probes;
+        for (size_t i = 0; i < 200000; i++) {
+            probes.push_back(keys[rng() % keys.size()]);
+        }
+        const uint8_t value[16] = {1};
+        for (size_t i = 0; i < keys.size() && i < 500; i++) {
+            btree_update(buffered, Key(keys[i]), Value(value, sizeof(value)));
+        }
+        double plain_read = lookup(plain, probes);
+        double buffered_read = lookup(buffered, probes);
+        std::printf("  %6zu keys: insert plain %7.1f ns, buffered %7.1f ns (%.2fx); lookup plain %6.1f ns, buffered %6.1f ns\n",
+                    count, plain_ns, buffered_ns, plain_ns / buffered_ns, plain_read, buffered_read);
+    }
+    std::remove("data/bench_ingest_plain.db");
+    std::remove("data/bench_ingest_buffered.db");
+    return 0;
+}
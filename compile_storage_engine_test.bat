@@ -13,6 +13,14 @@ g++ -std=c++17 -I./include ^
     src/storage/btree/leaf.cpp ^
     src/storage/btree/internal.cpp ^
     src/storage/btree/helpers.cpp ^
+    src/storage/btree/cursor.cpp ^
+    src/storage/btree/multi_search.cpp ^
+    src/storage/btree/overflow.cpp ^
+    src/storage/btree/write_buffer.cpp ^
+    src/storage/btree/vacuum.cpp ^
+    src/storage/hash/hash_index.cpp ^
+    src/storage/lsm/lsm_tree.cpp ^
+    src/storage/lsm/memtable.cpp ^
     src/storage/interface/storage_engine.cpp ^
     -o test_storage_engine.exe
 
@@ -18,6 +18,7 @@ struct AnalysisResult {
     // DDL performed by analyser (orchestrator only prints message)
     std::optional<std::string> create_database_name;
     std::optional<CreateTableStmt> create_table_stmt;
+    std::optional<CreateIndexStmt> create_index_stmt;
     std::optional<std::string> use_database_name;
 };
 
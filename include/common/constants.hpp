@@ -1,10 +1,49 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 
-inline constexpr uint32_t PAGE_SIZE = 2048;
+// Page size can be overridden at build time (e.g. -DADVANCEDB_PAGE_SIZE=8192 for benchmarks).
+#ifndef ADVANCEDB_PAGE_SIZE
+#define ADVANCEDB_PAGE_SIZE 2048
+#endif
+
+inline constexpr uint32_t PAGE_SIZE = ADVANCEDB_PAGE_SIZE;
 inline constexpr uint32_t INVALID_PAGE_ID = -1;
 inline constexpr uint32_t BUFFER_POOL_SIZE = 128;  // Default buffer pool size (can be overridden)
 inline constexpr uint32_t MAX_FILE_PATH_LENGTH = 255;
 
 inline constexpr uint8_t RECORD_DELETED = 1 << 0;
-inline constexpr uint16_t MERGE_THRESHOLD_PERCENT = 50;
\ No newline at end of file
+inline constexpr uint8_t RECORD_OVERFLOW = 1 << 1;  // Value is an OverflowRef plus an inline prefix
+
+// Values longer than OVERFLOW_THRESHOLD move to a chain of overflow pages; the leaf
+// keeps an OverflowRef and the first OVERFLOW_INLINE_PREFIX bytes
+inline constexpr uint16_t OVERFLOW_THRESHOLD = PAGE_SIZE / 4;
+inline constexpr uint16_t OVERFLOW_INLINE_PREFIX = 32;
+// Pages below MERGE_THRESHOLD_PERCENT are rebalanced with a sibling. The pair is merged only
+// if the result stays at or below MERGE_MAX_FILL_PERCENT, leaving room for inserts before the
+// page splits again; otherwise entries are borrowed from the sibling instead.
+inline constexpr uint16_t MERGE_THRESHOLD_PERCENT = 40;
+inline constexpr uint16_t MERGE_MAX_FILL_PERCENT = 75;
+inline constexpr uint16_t APPEND_SPLIT_PERCENT = 90;  // Share kept on the left when a split is caused by an append
+inline constexpr uint16_t VACUUM_FILL_PERCENT = 90;   // Page fill btree_vacuum packs leaves and internal pages to
+
+// Pages given to a B+tree write buffer by default, a quarter of the buffer pool.
+// A full buffer page flushes the whole buffer.
+inline constexpr uint16_t WRITE_BUFFER_PAGES = 32;
+
+// LSM files: memtable size that triggers a flush to a level 0 run, level 0 runs
+// before they merge into level 1, level 1 size in pages and the growth per level
+inline constexpr uint32_t LSM_MEMTABLE_BYTES = 512 * 1024;
+inline constexpr uint16_t LSM_L0_RUNS = 4;
+inline constexpr uint32_t LSM_LEVEL1_PAGES = 1024;
+inline constexpr uint32_t LSM_LEVEL_RATIO = 10;
+inline constexpr uint16_t LSM_BLOOM_BITS_PER_KEY = 10;
+
+// Rows RowStream::next_batch returns by default
+inline constexpr size_t ROW_STREAM_BATCH = 256;
+
+// Key prefixes cached in the slot directory (first KEY_PREFIX_SIZE key bytes)
+inline constexpr uint16_t KEY_PREFIX_SIZE = 4;
+inline constexpr bool KEY_PREFIX_SLOTS = true;  // New pages are created with prefixed slots
+
+static_assert(PAGE_SIZE <= 32768, "Page offsets are stored as uint16_t");
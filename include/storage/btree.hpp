@@ -2,70 +2,119 @@
 #include <cstdint>
 #include "storage/table_handle.hpp"
 #include "storage/page.hpp"
+#include "storage/record.hpp"
 #include <vector>
+#include <algorithm>
 #include <cstring>
+#include <memory>
 #include <string_view>
 
-class Key {
+// Bytes a Key or Value either borrows or owns. Owned bytes up to INLINE_BYTES live
+// inside the object, so integer and short string keys never allocate; longer ones
+// go to a heap buffer that assign reuses. Both types are move-only: a move hands
+// the heap buffer over, and a deep copy is spelled owned(other.data(), other.size()).
+class ByteRef {
+public:
+    static constexpr uint16_t INLINE_BYTES = 48;
+
+    ByteRef(const ByteRef&) = delete;
+    ByteRef& operator=(const ByteRef&) = delete;
+
+    [[nodiscard]] const uint8_t* data() const { return data_; }
+    [[nodiscard]] uint16_t size() const { return size_; }
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+    // True when the bytes live on the heap rather than inline or borrowed
+    [[nodiscard]] bool on_heap() const { return heap_ && data_ == heap_.get(); }
+
+    // Owns a copy of src, which may point into this object's own bytes
+    void assign(const uint8_t* src, uint16_t len) {
+        uint8_t* dst = inline_;
+        if (len > INLINE_BYTES) {
+            if (len > heap_capacity_) {
+                std::unique_ptr<uint8_t[]> grown(new uint8_t[len]);
+                if (len > 0) std::memcpy(grown.get(), src, len);
+                heap_ = std::move(grown);
+                heap_capacity_ = len;
+                data_ = heap_.get();
+                size_ = len;
+                return;
+            }
+            dst = heap_.get();
+        }
+        if (len > 0) std::memmove(dst, src, len);
+        data_ = dst;
+        size_ = len;
+    }
+
+protected:
+    ByteRef() = default;
+    ByteRef(const uint8_t* d, uint16_t s) : data_(d), size_(s) {}
+
+    ByteRef(ByteRef&& other) noexcept { take(other); }
+
+    ByteRef& operator=(ByteRef&& other) noexcept {
+        if (this != &other) {
+            take(other);
+        }
+        return *this;
+    }
+
 private:
-    std::vector<uint8_t> owned_data_;
     const uint8_t* data_ = nullptr;
     uint16_t size_ = 0;
+    uint16_t heap_capacity_ = 0;
+    std::unique_ptr<uint8_t[]> heap_;
+    uint8_t inline_[INLINE_BYTES];
+
+    void take(ByteRef& other) {
+        size_ = other.size_;
+        if (other.data_ == other.inline_) {
+            // Inline data never exceeds INLINE_BYTES; the bound lets the compiler see it
+            std::memcpy(inline_, other.inline_, std::min<size_t>(other.size_, INLINE_BYTES));
+            data_ = inline_;
+        } else if (other.on_heap()) {
+            heap_ = std::move(other.heap_);
+            heap_capacity_ = other.heap_capacity_;
+            data_ = heap_.get();
+            other.heap_capacity_ = 0;
+        } else {
+            data_ = other.data_;
+        }
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+};
 
+class Key : public ByteRef {
 public:
     Key() = default;
-    
-    Key(const uint8_t* d, uint16_t s) : data_(d), size_(s) {}
-    
-    Key(std::string_view sv) : data_(reinterpret_cast<const uint8_t*>(sv.data())), size_(static_cast<uint16_t>(sv.size())) {}
-    
+    Key(Key&&) noexcept = default;
+    Key& operator=(Key&&) noexcept = default;
+
+    Key(const uint8_t* d, uint16_t s) : ByteRef(d, s) {}
+
+    Key(std::string_view sv) : ByteRef(reinterpret_cast<const uint8_t*>(sv.data()), static_cast<uint16_t>(sv.size())) {}
+
     static Key owned(const uint8_t* src, uint16_t len) {
         Key k;
-        k.owned_data_.assign(src, src + len);
-        k.data_ = k.owned_data_.data();
-        k.size_ = len;
+        k.assign(src, len);
         return k;
     }
-    
-    void assign(const uint8_t* src, uint16_t len) {
-        owned_data_.assign(src, src + len);
-        data_ = owned_data_.data();
-        size_ = len;
-    }
-    
-    [[nodiscard]] const uint8_t* data() const { return data_; }
-    [[nodiscard]] uint16_t size() const { return size_; }
-    [[nodiscard]] bool empty() const { return size_ == 0; }
 };
 
-class Value {
-private:
-    std::vector<uint8_t> owned_data_;
-    const uint8_t* data_ = nullptr;
-    uint16_t size_ = 0;
-
+class Value : public ByteRef {
 public:
     Value() = default;
-    
-    Value(const uint8_t* d, uint16_t s) : data_(d), size_(s) {}
-    
+    Value(Value&&) noexcept = default;
+    Value& operator=(Value&&) noexcept = default;
+
+    Value(const uint8_t* d, uint16_t s) : ByteRef(d, s) {}
+
     static Value owned(const uint8_t* src, uint16_t len) {
         Value v;
-        v.owned_data_.assign(src, src + len);
-        v.data_ = v.owned_data_.data();
-        v.size_ = len;
+        v.assign(src, len);
         return v;
     }
-    
-    void assign(const uint8_t* src, uint16_t len) {
-        owned_data_.assign(src, src + len);
-        data_ = owned_data_.data();
-        size_ = len;
-    }
-    
-    [[nodiscard]] const uint8_t* data() const { return data_; }
-    [[nodiscard]] uint16_t size() const { return size_; }
-    [[nodiscard]] bool empty() const { return size_ == 0; }
 };
 
 struct SplitLeafResult {
@@ -80,29 +129,137 @@ using SplitInternalResult = SplitLeafResult;
 // B+Tree operations
 bool btree_search(TableHandle& th, const Key& key, Value& value);
 bool btree_insert(TableHandle& th, const Key& key, const Value& value);
+// Removes key and rebalances its leaf, or only marks it deleted when
+// th.deferred_deletes is set; tombstoned keys are invisible to every lookup.
 bool btree_delete(TableHandle& th, const Key& key);
+// Turns deferred deletes on or off and records the setting in the meta page, so the
+// file reopens with it. Tombstones already written stay until btree_compact.
+bool btree_set_deferred_deletes(TableHandle& th, bool enabled);
+// Replaces the value of an existing key inside its leaf; the tree shape only
+// changes if the leaf cannot hold the larger value even after compaction.
+bool btree_update(TableHandle& th, const Key& key, const Value& value);
+
+// Looks up a batch of keys with one descent per subtree instead of one per key.
+// out_values[i] answers keys[i] when out_found[i] is set; returns how many were found.
+// Keys may come in any order; already sorted input skips the sort.
+size_t btree_multi_search(TableHandle& th, const std::vector<Key>& keys, std::vector<Value>& out_values,
+                          std::vector<bool>& out_found);
 
+// Buffered write mode. While th.write_buffer is set, insert, update and delete only
+// record a message in the buffer pages (one per key, the newest wins). Insert, update
+// and delete return true without reading the tree: an insert is rejected only when
+// the buffer holds a put of the key (or an update, and the key is live), and one of a
+// key live in the leaves is dropped when applied, as an unbuffered insert refuses it. A full buffer
+// page flushes the whole buffer in key order and writes the dirtied leaves back in
+// groups with one sync each. btree_search checks the buffer first; cursors, range
+// scans, multi-search and compaction flush it before reading the leaves.
+bool btree_enable_write_buffer(TableHandle& th, uint16_t pages = WRITE_BUFFER_PAGES);
+// Flushes and frees the buffer; writes go straight to the leaves again. Fails, keeping
+// the buffer, when a message could not be applied.
+bool btree_disable_write_buffer(TableHandle& th);
+// Applies every buffered message to the tree; returns how many were applied. The
+// buffer pages are cleared only once every message has landed; a message the tree
+// could not take stays buffered.
+size_t btree_flush_write_buffer(TableHandle& th);
+
+// Reclaims tombstones left by deferred deletes in one pass over the leaves, then
+// merges or rebalances the leaves that pass left underfull. Returns the number of
+// tombstones removed.
+size_t btree_compact(TableHandle& th);
+
+// Rebuilds the tree in place: drops tombstones, packs the leaves to fill_percent,
+// lays the leaf chain out in ascending page order at the front of the file (then the
+// internal levels and overflow chains) and truncates the free pages left at the end.
+// The new tree is written in full before the root switches to it, so a failure
+// (including an unreadable overflow chain) returns 0 with the tree unchanged. The
+// file stays open throughout. Returns how many pages the file shrank by.
+uint32_t btree_vacuum(TableHandle& th, uint16_t fill_percent = VACUUM_FILL_PERCENT);
+
+// key/value passed to the callback are views into the pinned leaf, valid only during the call
 using BTreeRangeScanCallback = void (*)(const Key& key, const Value& value, void* ctx);
 void btree_range_scan(TableHandle& th, const Key& start_key, const Key& end_key,
                      BTreeRangeScanCallback callback, void* ctx);
 
-#pragma pack(push, 1)
-struct InternalEntry {
-    uint16_t key_size;
-    uint32_t child_page;
-    uint8_t key[];
-};
-#pragma pack(pop)
+// Stateful leaf-level cursor. The current leaf stays pinned in the buffer pool
+// until the cursor moves off it or is closed; key()/value() are views into that
+// pinned page and are invalidated by the next move. Do not modify the tree
+// while a cursor on it is open.
+class BTreeCursor {
+public:
+    explicit BTreeCursor(TableHandle& th);
+    ~BTreeCursor();
+
+    BTreeCursor(const BTreeCursor&) = delete;
+    BTreeCursor& operator=(const BTreeCursor&) = delete;
+
+    bool seek(const Key& key);   // First entry >= key
+    bool seek_first();
+    bool seek_last();
+    bool next();
+    bool prev();
+    void close();
 
+    [[nodiscard]] bool valid() const { return page_ != nullptr; }
+    [[nodiscard]] Key key() const;
+    // Full value; an overflow value is read from its page chain into a cursor-owned buffer
+    [[nodiscard]] Value value() const;
+    // Leading bytes of the value available in the leaf, never touching overflow pages
+    [[nodiscard]] Value inline_value() const;
+    [[nodiscard]] bool value_is_overflow() const;
+
+private:
+    bool descend(const Key* key, bool rightmost);
+    bool pin(uint32_t page_id);
+    void unpin();
+    bool skip_forward();
+
+    TableHandle& th_;
+    uint32_t page_id_ = 0;
+    Page* page_ = nullptr;
+    uint16_t index_ = 0;
+    mutable Value overflow_value_;
+};
 
 uint16_t write_raw_record(Page& page, const uint8_t* raw, uint16_t size);
+// Appends the raw leaf records in slots [from, to) of src to dst, keeping slot order
+void append_leaf_records(Page& dst, Page& src, uint16_t from, uint16_t to);
+// Moves slots [split_idx, count) of page into new_page and compacts page in place
+void split_leaf_records(Page& page, Page& new_page, uint16_t split_idx);
+
+// Overflow page chains for values longer than OVERFLOW_THRESHOLD
+uint32_t overflow_write(TableHandle& th, const uint8_t* data, uint32_t size);
+bool overflow_read(TableHandle& th, uint32_t first_page, uint8_t* out, uint32_t size);
+void overflow_free(TableHandle& th, uint32_t first_page);
+// Writes the value's tail to a chain and fills stored (OverflowRef + inline prefix); returns its length or 0
+uint16_t overflow_store(TableHandle& th, const Value& value, uint8_t* stored);
+bool overflow_load(TableHandle& th, const uint8_t* stored, uint16_t stored_len, Value& value);
+uint32_t overflow_first_page(const uint8_t* stored, uint16_t stored_len);
+inline constexpr uint16_t OVERFLOW_STORED_SIZE = sizeof(OverflowRef) + OVERFLOW_INLINE_PREFIX;
+// Longest key a leaf split can take: any two records with keys this long and inline
+// values up to OVERFLOW_THRESHOLD fit in one leaf, so each half of a split keeps one
+inline constexpr uint16_t BTREE_MAX_KEY_SIZE = (PAGE_SIZE - sizeof(PageHeader)) / 2 - NEW_SLOT_ENTRY_SIZE -
+                                               sizeof(RecordHeader) - OVERFLOW_THRESHOLD;
+
+// Write buffer messages; the op byte leads each buffered value. A put lands only on
+// a key that is not live when it is applied; an upsert (a put after a pending delete,
+// or an update after a pending put) lands either way.
+enum WriteMessage : uint8_t { MSG_PUT = 1, MSG_UPDATE = 2, MSG_DELETE = 3, MSG_UPSERT = 4 };
+bool write_buffer_put(TableHandle& th, const Key& key, WriteMessage op, const Value& value);
+// Pending message for key, if any; value receives its payload
+bool write_buffer_find(TableHandle& th, const Key& key, WriteMessage& op, Value& value);
+// True while some buffer page still holds a message
+bool write_buffer_pending(TableHandle& th);
 
 uint32_t find_leaf_page(TableHandle& th, const Key& key, Page& out_page);
 uint32_t find_leftmost_leaf_page(TableHandle& th, Page& out_page);
-bool btree_insert_leaf_no_split(TableHandle& th, uint32_t page_id, Page& page, const Key& key, const Value& value);
-SplitLeafResult split_leaf_page(TableHandle& th, Page& page);
+bool btree_insert_leaf_no_split(TableHandle& th, uint32_t page_id, Page& page, const Key& key, const Value& value,
+                                uint8_t flags = 0);
+SplitLeafResult split_leaf_page(TableHandle& th, Page& page, bool append = false);
 
-uint32_t internal_find_child(Page& page, const Key& key);
+// Child key routes to; out_pos receives its slot position, 0 for the leftmost child,
+// otherwise the child of entry pos - 1
+uint32_t internal_find_child(Page& page, const Key& key, uint16_t* out_pos = nullptr);
+uint32_t internal_child_at(Page& page, uint16_t pos);
 bool insert_internal_no_split(Page& page, const Key& key, uint32_t child);
 SplitInternalResult split_internal_page(TableHandle& th, Page& page);
 void create_new_root(TableHandle& th, uint32_t left, const Key& key, uint32_t right);
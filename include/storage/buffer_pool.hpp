@@ -21,7 +21,12 @@ public:
     Page* new_page(uint32_t page_id, PageType page_type = PageType::DATA, PageLevel page_level = PageLevel::LEAF);
     bool delete_page(uint32_t page_id);
     bool flush_page(uint32_t page_id);
+    // Writes every dirty page, then syncs the file once
     void flush_all();
+    // Drops cached pages at or past page_count and cuts the file back to page_count
+    // pages; fails while any of those pages is pinned
+    bool truncate(uint32_t page_count);
+    uint32_t file_page_count();
     size_t get_pinned_count() const;
     size_t get_free_frame_count() const;
 
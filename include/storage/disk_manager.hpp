@@ -14,8 +14,12 @@ public:
     DiskManager& operator=(const DiskManager&) = delete;
 
     void read_page(int page_id, uint8_t* page_data);
-    void write_page(int page_id, const void* page_data); // void as pointer can be anything for now
+    // Syncs the file after the write unless sync is false; flush() then makes it durable
+    void write_page(int page_id, const void* page_data, bool sync = true); // void as pointer can be anything for now
     void flush();
+    // Pages the file currently spans, and cutting it back to page_count pages
+    uint32_t page_count();
+    void truncate(uint32_t page_count);
 
 private: 
     int file_descriptor{-1};
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "storage/table_handle.hpp"
+#include "storage/btree.hpp"
+
+// Extendible hash files: a point lookup reads one bucket page instead of
+// descending a B+tree. They share the file layout, page allocator, record format
+// and buffer pool with B+tree files:
+//   page 0          META  - PageHeader, then HashMeta (global depth, directory pages)
+//   page 1          META  - allocation bitmap
+//   INDEX / NONE          - directory pages of uint32_t bucket page ids
+//   INDEX / LEAF          - buckets: slotted leaf pages with the local depth in
+//                           reserved[0]; next_page_id chains overflow buckets once
+//                           the directory cannot double any more
+// While the file is open the directory is cached in TableHandle::hash_directory.
+// Keys are unordered and buckets are never merged; deleted space is reused by inserts.
+
+inline constexpr uint32_t HASH_MAGIC = 0x48534148;  // "HASH"
+
+#pragma pack(push, 1)
+struct HashMeta {
+    uint32_t magic;
+    uint8_t global_depth;
+    uint8_t reserved[3];
+    uint32_t dir_page_count;
+};
+#pragma pack(pop)
+
+inline constexpr uint32_t HASH_DIR_ENTRIES_PER_PAGE = (PAGE_SIZE - sizeof(PageHeader)) / sizeof(uint32_t);
+inline constexpr uint32_t HASH_MAX_DIR_PAGES = (PAGE_SIZE - sizeof(PageHeader) - sizeof(HashMeta)) / sizeof(uint32_t);
+
+inline bool is_hash_table(const TableHandle& th) {
+    return !th.hash_directory.empty();
+}
+
+// Creates data/<name>.db as an empty hash file: one bucket, global depth 0
+bool hash_create(const std::string& name);
+// open_table followed by hash_load; false when the file is missing or not a hash file
+bool hash_open(const std::string& name, TableHandle& th);
+// Reads the directory of an open file into th; returns false for B+tree files
+bool hash_load(TableHandle& th);
+uint64_t hash_key(const uint8_t* key, uint16_t key_len);
+
+bool hash_search(TableHandle& th, const Key& key, Value& value);
+bool hash_insert(TableHandle& th, const Key& key, const Value& value);
+bool hash_update(TableHandle& th, const Key& key, const Value& value);
+bool hash_delete(TableHandle& th, const Key& key);
+// Visits every record once, bucket by bucket, in no particular key order
+void hash_scan(TableHandle& th, BTreeRangeScanCallback callback, void* ctx);
+// Visits the records of the bucket whose primary page is bucket_id, chained pages
+// included; false when a page cannot be read. Several directory entries may share a
+// bucket, so a caller walking th.hash_directory skips the ids it has seen.
+bool hash_scan_bucket(TableHandle& th, uint32_t bucket_id, BTreeRangeScanCallback callback, void* ctx);
@@ -1,14 +1,83 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <cstdint>
 #include <vector>
 #include <memory>
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
+#include "storage/btree.hpp"
+#include "storage/lsm_tree.hpp"
+#include "storage/buffer_pool.hpp"
 #include "storage/relational/catalog.hpp"
 #include "storage/relational/row_codec.hpp"
+#include "storage/relational/row_view.hpp"
+#include "common/constants.hpp"
 struct TableHandle;
 
+// A record read in place by StorageEngine::get_record. On a B+tree the view keeps
+// the leaf pinned through a cursor and value() points into the page (or the
+// cursor's buffer for an overflow value); hash and LSM records are held in a buffer
+// of the view's own. Valid until reset, the next get_record into it, or
+// destruction; do not modify the table while holding one.
+class RecordView {
+public:
+    RecordView() = default;
+    RecordView(const RecordView&) = delete;
+    RecordView& operator=(const RecordView&) = delete;
+
+    [[nodiscard]] std::string_view value() const { return value_; }
+    void reset();
+
+private:
+    friend class StorageEngine;
+    std::optional<BTreeCursor> cursor_;
+    Value owned_;
+    std::string_view value_;
+};
+
+// Rows of a relational table read one at a time by StorageEngine::open_scan. On a
+// B+tree or PAX table the stream holds a cursor on one pinned leaf, and on an LSM
+// table an LsmCursor with one pinned page per run; each row is decoded as it is asked
+// for, so memory stays constant however large the table. A hash table is read one
+// bucket at a time, holding only that bucket's rows. Rows come in key order (hash
+// tables: bucket order). Closing or destroying the
+// stream ends the scan early; do not modify the table while holding one, or keep it
+// past the engine.
+class RowStream {
+public:
+    RowStream() = default;
+    RowStream(const RowStream&) = delete;
+    RowStream& operator=(const RowStream&) = delete;
+
+    // False once every row has been read
+    bool next(Relational::Tuple& row);
+    // Up to max_rows rows into rows, reusing its tuples; returns how many, 0 at the end
+    size_t next_batch(std::vector<Relational::Tuple>& rows, size_t max_rows = ROW_STREAM_BATCH);
+    void close();
+
+private:
+    friend class StorageEngine;
+    bool decode(const uint8_t* data, size_t size, Relational::Tuple& row) const;
+    bool next_pax(Relational::Tuple& row);
+    bool next_bucket();
+    static void buffer_bucket_row(const Key& key, const Value& value, void* ctx);
+
+    const Relational::TableSchema* schema_ = nullptr;
+    const Relational::CompiledRowCodec* codec_ = nullptr;
+    std::optional<Relational::RowLayout> layout_;  // Projections only
+    std::vector<size_t> columns_;                  // Projected columns, empty for all
+    std::optional<BTreeCursor> cursor_;
+    size_t block_row_ = 0;                         // Next row of the cursor's PAX block
+    std::optional<LsmCursor> lsm_cursor_;
+    TableHandle* hash_table_ = nullptr;
+    size_t directory_slot_ = 0;                    // Next hash directory slot to read
+    std::unordered_set<uint32_t> buckets_read_;    // Buckets shared by several slots are read once
+    std::vector<Relational::Tuple> buffered_;      // Rows of the current hash bucket
+    size_t position_ = 0;
+};
 
 class StorageEngine {
 public:
@@ -20,23 +89,99 @@ public:
 
     bool create_table(const std::string& table_name);
     bool create_table(const std::string& table_name, const Relational::TableSchema& schema);
+    // Extendible hash file: one bucket read per point lookup, scans in no key order
+    bool create_hash_table(const std::string& table_name);
+    // Log-structured merge file: memtable plus sorted runs, for insert-heavy tables
+    bool create_lsm_table(const std::string& table_name);
     bool drop_table(const std::string& table_name);
     TableHandle* open_table(const std::string& table_name);
     void close_table(TableHandle* handle);
 
     bool insert_record(TableHandle* handle, const std::vector<uint8_t>& key, const std::vector<uint8_t>& value);
     bool get_record(TableHandle* handle, const std::vector<uint8_t>& key, std::vector<uint8_t>& out_value);
+    // Borrows the value instead of copying it, see RecordView
+    bool get_record(TableHandle* handle, std::string_view key, RecordView& out);
     bool delete_record(TableHandle* handle, const std::vector<uint8_t>& key);
     bool update_record(TableHandle* handle, const std::vector<uint8_t>& key, const std::vector<uint8_t>& new_value);
+    // Deferred deletes on a B+tree file: delete_record only tombstones the record, and
+    // compact_table reclaims it later. Kept in the file, so it survives a reopen.
+    bool set_deferred_deletes(TableHandle* handle, bool enabled);
+    // Reclaims tombstones left by deferred deletes, or merges every run of an LSM
+    // file into one; returns how many tombstones were removed
+    size_t compact_table(TableHandle* handle);
+    // Online VACUUM of a B+tree file: repacks the leaves to fill_percent in page
+    // order and truncates the free tail; returns how many pages the file shrank by
+    uint32_t vacuum_table(TableHandle* handle, uint16_t fill_percent = VACUUM_FILL_PERCENT);
 
     using ScanCallback = void (*)(const std::vector<uint8_t>& key, const std::vector<uint8_t>& value, void* ctx);
     void scan_table(TableHandle* handle, ScanCallback callback, void* ctx);
     void range_scan(TableHandle* handle, const std::vector<uint8_t>& start_key, const std::vector<uint8_t>& end_key, ScanCallback callback, void* ctx);
+    // The same scans handing out views of the record bytes in place, valid only
+    // during the call, so no row is copied or allocated
+    using ViewCallback = void (*)(std::string_view key, std::string_view value, void* ctx);
+    void scan_table(TableHandle* handle, ViewCallback callback, void* ctx);
+    void range_scan(TableHandle* handle, std::string_view start_key, std::string_view end_key, ViewCallback callback,
+                    void* ctx);
 
     void flush_all();
 
+    // Any column outside the primary key may be NULL (Relational::Null)
     bool insert(const std::string& table_name, const Relational::Tuple& row);
+    // Replaces the row with the same primary key
+    bool update(const std::string& table_name, const Relational::Tuple& row);
+    bool remove(const std::string& table_name, const Relational::Value& pk);
+    // Composite primary keys: key lists every key column value in key order
+    bool remove(const std::string& table_name, const Relational::Tuple& key);
     std::vector<Relational::Tuple> scan(const std::string& table_name);
+    // Only the listed columns, in that order; the rest of each row is never decoded
+    std::vector<Relational::Tuple> scan(const std::string& table_name, const std::vector<std::string>& columns);
+    // Streams the rows, or only the listed columns in that order, see RowStream;
+    // false for an unknown table or column
+    bool open_scan(const std::string& table_name, RowStream& out, const std::vector<std::string>& columns = {});
+    // Visits each row as a view over the stored record, valid only during the call
+    using RowCallback = void (*)(const Relational::RowView& row, void* ctx);
+    void scan_rows(const std::string& table_name, RowCallback callback, void* ctx);
+    // Visits a fixed-width column in batches, in key order: on PAX tables each batch is
+    // a block's minipage in place, elsewhere values gathered from the rows. Batches are
+    // valid only during the call. False for a STRING or unknown column.
+    using ColumnCallback = void (*)(const Relational::ColumnBatch& batch, void* ctx);
+    bool scan_column(const std::string& table_name, const std::string& column_name, ColumnCallback callback,
+                     void* ctx);
+    // Rows with low <= primary key <= high, in key order on B+tree and LSM tables.
+    // A bound holds leading key column values and may be shorter than the key, or
+    // empty for an open end; keys are order-preserving, so this is one range scan.
+    std::vector<Relational::Tuple> scan_range(const std::string& table_name, const Relational::Tuple& low,
+                                              const Relational::Tuple& high);
+    // Rows whose column equals value: a primary key lookup on the key column, else read
+    // through a secondary index when one covers the column
+    std::vector<Relational::Tuple> lookup(const std::string& table_name, const std::string& column_name,
+                                          const Relational::Value& value);
+
+    // Secondary indexes are B+trees keyed by (column value, primary key) and kept in
+    // sync by insert, update and remove. UNIQUE columns get one from create_table.
+    // INCLUDE columns are stored in the index value for index-only scans. Rows whose
+    // key column is NULL get no entry, so index_only_scan leaves them out.
+    bool create_index(const std::string& table_name, const std::string& index_name,
+                      const std::string& column_name, bool unique = false,
+                      const std::vector<std::string>& include = {});
+    // An index holding every listed column (key column, primary key or INCLUDE),
+    // optionally keyed on key_column; nullptr when none covers them
+    const Relational::IndexDef* find_covering_index(const std::string& table_name,
+                                                    const std::vector<std::string>& columns,
+                                                    const std::string& key_column = "") const;
+    // Projects columns from the index leaves alone, never reading the base table.
+    // With equals set, only entries whose key column equals it are returned.
+    // Returns false, with out_rows empty, when the index does not cover the columns or
+    // an entry does not decode.
+    bool index_only_scan(const std::string& table_name, const std::string& index_name,
+                         const std::vector<std::string>& columns, std::vector<Relational::Tuple>& out_rows,
+                         const Relational::Value* equals = nullptr);
+    // OPTIMIZE TABLE: vacuums a relational table and each of its secondary indexes;
+    // returns the pages released across all of their files
+    uint32_t optimize_table(const std::string& table_name, uint16_t fill_percent = VACUUM_FILL_PERCENT);
+    // ALTER TABLE ... ADD COLUMN: a new schema version, O(1) on any table. Stored rows
+    // are not rewritten; they read column.default_value (NULL unless set) until updated.
+    bool add_column(const std::string& table_name, const Relational::ColumnDef& column);
     bool has_table(const std::string& table_name) const;
     const Relational::TableSchema* get_schema(const std::string& table_name) const;
 
@@ -44,4 +189,16 @@ private:
     std::unordered_map<std::string, std::unique_ptr<TableHandle>> open_tables_;
     Relational::Catalog catalog_;
     TableHandle* get_or_open_table(const std::string& table_name);
+    TableHandle* open_index(const std::string& table_name, const Relational::IndexDef& index);
+    bool drop_tree(const std::string& tree_name);
+    bool read_row(const std::string& table_name, const std::vector<uint8_t>& key, Relational::Tuple& out_row);
+    // The writes behind insert and update. Encoding the row interns its dictionary
+    // strings; the callers drop those codes again when the row is rejected.
+    bool insert_row(const std::string& table_name, const Relational::Tuple& row);
+    bool update_row(const std::string& table_name, const Relational::Tuple& row);
+    // Moves every index entry of table_name from old_row to new_row, either of which may
+    // be null for an insert or a remove. A failed write puts back the entries already
+    // changed and returns false.
+    bool write_indexes(const std::string& table_name, const Relational::RowCodec& codec,
+                       const Relational::Tuple* old_row, const Relational::Tuple* new_row);
 };
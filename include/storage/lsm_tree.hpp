@@ -0,0 +1,153 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "storage/table_handle.hpp"
+#include "storage/btree.hpp"
+
+// Log-structured merge files for ingest-heavy tables. Writes land in an in-memory
+// skiplist memtable; a full memtable is written out sequentially as an immutable
+// sorted run, and runs are merged level by level. Runs reuse the page allocator,
+// record format and buffer pool of B+tree files:
+//   page 0          META  - PageHeader, then LsmMeta and the run header page ids
+//   page 1          META  - allocation bitmap
+//   page 2                - unused (the B+tree root written by create_table)
+//   INDEX / NONE          - run header: LsmRunHeader
+//   DATA  / LEAF          - run data: sorted slotted pages chained by next_page_id
+//   INDEX / LEAF          - fence pointers: first key of each data page -> page id
+//   META  / NONE          - bloom filter bits, chained by next_page_id
+// Level 0 holds up to LSM_L0_RUNS runs with overlapping keys, newest first; every
+// deeper level is a single run LSM_LEVEL_RATIO times larger than the one above.
+// Deletes are tombstones (RECORD_DELETED) until a merge into the deepest run.
+// The memtable is written out by lsm_flush, so it must run before the file closes.
+
+inline constexpr uint32_t LSM_MAGIC = 0x4D534C54;  // "TLSM"
+
+#pragma pack(push, 1)
+struct LsmMeta {
+    uint32_t magic;
+    uint32_t run_count;
+};
+
+struct LsmRunHeader {
+    uint8_t level;
+    uint8_t reserved[3];
+    uint32_t first_page;    // First data page
+    uint32_t page_count;    // Data pages
+    uint32_t fence_page;    // First fence page
+    uint32_t bloom_page;    // First bloom page
+    uint32_t bloom_bits;
+    uint64_t entry_count;
+    uint64_t tombstone_count;
+};
+#pragma pack(pop)
+
+inline constexpr uint32_t LSM_MAX_RUNS = (PAGE_SIZE - sizeof(PageHeader) - sizeof(LsmMeta)) / sizeof(uint32_t);
+
+// Skiplist of the newest writes, in key order; tombstones are kept as entries
+class LsmMemTable {
+public:
+    struct Node {
+        std::vector<uint8_t> key;
+        std::vector<uint8_t> value;
+        bool deleted = false;
+        std::vector<Node*> next;
+    };
+
+    LsmMemTable();
+    ~LsmMemTable();
+    LsmMemTable(const LsmMemTable&) = delete;
+    LsmMemTable& operator=(const LsmMemTable&) = delete;
+
+    // Inserts or replaces the entry for key
+    void put(const Key& key, const Value& value, bool deleted);
+    const Node* find(const Key& key) const;
+    // First entry with a key >= key, or the first entry when key is empty
+    const Node* seek(const Key& key) const;
+    size_t bytes() const { return bytes_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    void clear();
+
+private:
+    static constexpr int MAX_HEIGHT = 12;
+    Node head_;
+    int height_ = 1;
+    uint32_t rng_ = 0x9E3779B9;
+    size_t bytes_ = 0;
+    size_t size_ = 0;
+
+    int random_height();
+};
+
+// One immutable sorted run, with its fence pointers and bloom filter in memory
+struct LsmRun {
+    uint32_t header_page = 0;
+    LsmRunHeader header{};
+    std::vector<std::vector<uint8_t>> fence_keys;
+    std::vector<uint32_t> fence_pages;
+    std::vector<uint8_t> bloom;
+};
+
+// Open state of an LSM file, cached in TableHandle::lsm
+struct LsmTree {
+    LsmMemTable memtable;
+    std::vector<LsmRun> runs;  // Level 0 newest first, then levels 1, 2, ...
+};
+
+inline bool is_lsm_table(const TableHandle& th) {
+    return th.lsm != nullptr;
+}
+
+// Creates data/<name>.db as an empty LSM file
+bool lsm_create(const std::string& name);
+// open_table followed by lsm_load; false when the file is missing or not an LSM file
+bool lsm_open(const std::string& name, TableHandle& th);
+// Reads the run directory, fence pointers and bloom filters of an open file into th
+bool lsm_load(TableHandle& th);
+
+bool lsm_search(TableHandle& th, const Key& key, Value& value);
+bool lsm_insert(TableHandle& th, const Key& key, const Value& value);
+bool lsm_update(TableHandle& th, const Key& key, const Value& value);
+bool lsm_delete(TableHandle& th, const Key& key);
+// Visits live records with start_key <= key <= end_key in key order (empty bounds are open)
+void lsm_range_scan(TableHandle& th, const Key& start_key, const Key& end_key,
+                    BTreeRangeScanCallback callback, void* ctx);
+
+struct MergeSource;
+
+// Pull form of lsm_range_scan over the whole file: the newest live version of each key
+// in key order, merged from the memtable and one pinned page per run. key()/value()
+// are views valid until the next move. Do not modify the table while a cursor on it
+// is open.
+class LsmCursor {
+public:
+    explicit LsmCursor(TableHandle& th);
+    ~LsmCursor();
+
+    LsmCursor(const LsmCursor&) = delete;
+    LsmCursor& operator=(const LsmCursor&) = delete;
+
+    bool seek_first();
+    bool next();
+    void close();
+
+    [[nodiscard]] bool valid() const { return current_ >= 0; }
+    [[nodiscard]] Key key() const;
+    // Full value; an overflow value is read from its page chain into a cursor-owned buffer
+    [[nodiscard]] Value value() const;
+
+private:
+    bool settle();
+
+    TableHandle& th_;
+    std::vector<MergeSource> sources_;  // Newest first, as the merge expects
+    int current_ = -1;                  // Source holding the current key
+    mutable Value overflow_value_;
+};
+
+// Writes the memtable out as a level 0 run, then merges any level over its budget
+bool lsm_flush(TableHandle& th);
+// Flushes, then merges every run into one, dropping tombstones; returns how many were dropped
+size_t lsm_compact(TableHandle& th);
@@ -7,7 +7,8 @@ enum class PageType : uint16_t {
     META = 1,
     INDEX = 2,
     DATA = 3,
-    FREE = 4
+    FREE = 4,
+    OVERFLOW = 5
 };
 
 enum class PageLevel : uint16_t {
@@ -16,6 +17,11 @@ enum class PageLevel : uint16_t {
     INTERNAL = 2
 };
 
+enum PageFlags : uint16_t {
+    PAGE_FLAG_KEY_PREFIX = 1 << 0,      // Slot entries carry a KEY_PREFIX_SIZE key prefix
+    PAGE_FLAG_DEFERRED_DELETES = 1 << 1 // Meta page: the B+tree's deletes leave tombstones
+};
+
 #pragma pack(push, 1)
 struct PageHeader {
     uint32_t page_id;
@@ -48,9 +54,22 @@ static_assert(sizeof(PageHeader) == 40, "PageHeader size must be 40 bytes");
 inline PageHeader* get_header(Page& page);
 void init_page(Page& page, uint32_t page_id, PageType page_type, PageLevel page_level);
 uint16_t* slot_ptr(Page& page, uint16_t index);
+uint32_t slot_prefix(Page& page, uint16_t index);
 void insert_slot(Page& page, uint16_t index, uint16_t record_offset);
 void remove_slot(Page& page, uint16_t index);
 
 inline PageHeader* get_header(Page& page) {
     return reinterpret_cast<PageHeader*>(page.data);
 }
+
+// Slot entry size used by init_page for LEAF/INTERNAL pages
+inline constexpr uint16_t NEW_SLOT_ENTRY_SIZE = KEY_PREFIX_SLOTS ? sizeof(uint16_t) + KEY_PREFIX_SIZE : sizeof(uint16_t);
+
+// Slot entry = uint16_t record offset, followed by the big-endian key prefix
+// when PAGE_FLAG_KEY_PREFIX is set. Pages written without the flag keep 2-byte slots.
+inline uint16_t slot_entry_size(Page& page) {
+    if (get_header(page)->flags & PAGE_FLAG_KEY_PREFIX) {
+        return sizeof(uint16_t) + KEY_PREFIX_SIZE;
+    }
+    return sizeof(uint16_t);
+}
@@ -9,6 +9,18 @@ struct RecordHeader {
     uint16_t key_size;
     uint16_t value_size;
 };
+
+struct InternalEntry {
+    uint16_t key_size;
+    uint32_t child_page;
+    uint8_t key[];
+};
+
+// Stored value of a RECORD_OVERFLOW record, followed by the value's inline prefix
+struct OverflowRef {
+    uint32_t first_page;
+    uint32_t total_size;
+};
 #pragma pack(pop)
 
 struct BSearchResult {
@@ -23,8 +35,23 @@ inline uint16_t record_size(uint16_t key_size, uint16_t value_size) {
 uint16_t write_record(Page& page, const uint8_t* key, uint16_t key_len, const uint8_t* value, uint16_t value_len);
 const uint8_t* slot_key(Page& page, uint16_t slot_index, uint16_t& key_len);
 const uint8_t* slot_value(Page& page, uint16_t slot_index, uint16_t& value_len);
+uint8_t* slot_flags(Page& page, uint16_t slot_index);
+// True when the record in slot_index is a tombstone left by a deferred delete
+bool slot_is_deleted(Page& page, uint16_t slot_index);
 int compare_keys(const uint8_t* first, uint16_t first_size, const uint8_t* second, uint16_t second_size);
+uint32_t key_prefix(const uint8_t* key, uint16_t key_len);
+bool compare_slot_key(Page& page, uint16_t index, const uint8_t* key, uint16_t key_len, uint32_t prefix, int& cmp);
 BSearchResult search_record(Page& page, const uint8_t* key, uint16_t key_len);
 bool can_insert(Page& page, uint16_t record_size);
-bool page_insert(Page& page, const uint8_t* key, uint16_t key_size, const uint8_t* value, uint16_t value_size);
-bool page_delete(Page& page, const uint8_t* key, uint16_t key_len);
\ No newline at end of file
+// flags are the new record's RECORD_* bits
+bool page_insert(Page& page, const uint8_t* key, uint16_t key_size, const uint8_t* value, uint16_t value_size,
+                 uint8_t flags = 0);
+bool page_delete(Page& page, const uint8_t* key, uint16_t key_len);
+// Overwrites the value of an existing key without changing slot order. Values that
+// grow are rewritten into free space (compacting the page first if needed); returns
+// false when the key is missing or the page cannot hold the new record.
+bool page_update(Page& page, const uint8_t* key, uint16_t key_len, const uint8_t* value, uint16_t value_len);
+// Bytes taken by the record (leaf) or InternalEntry (internal page) in slot index
+uint16_t stored_entry_size(Page& page, uint16_t index);
+// Packs live entries to the front of the page, dropping space left by deletes and updates
+void page_compact(Page& page);
\ No newline at end of file
@@ -4,8 +4,23 @@
 #include <unordered_map>
 #include <optional>
 #include <memory>
+#include <variant>
 
 namespace Relational {
+    struct TableSchema;
+    class CompiledRowCodec;
+    class StringDictionary;
+    using TableDictionaries = std::vector<StringDictionary>;
+
+    // NULL is the last alternative, so a default Value is still int 0
+    using Null = std::monostate;
+    using Value = std::variant<int, float, double, std::string, bool, Null>;
+    using Tuple = std::vector<Value>;
+
+    inline bool is_null(const Value& value) {
+        return std::holds_alternative<Null>(value);
+    }
+
     enum class ColumnType {
         INT,
         FLOAT,
@@ -18,23 +33,76 @@ namespace Relational {
     struct ColumnDef {
         std::string name;
         ColumnType type;
+        bool is_unique = false;  // Gets an implicit unique secondary index
+        bool dictionary = false;  // STRING stored as a code into the table's dictionary
+        // Schema version that added the column; rows written before it read default_value
+        uint32_t added_in = 0;
+        Value default_value = Null();
+    };
+
+    // Secondary index: its own B+tree keyed by (column value, primary key). The
+    // value holds the primary key and the INCLUDE columns, so queries reading only
+    // those columns never touch the base table.
+    struct IndexDef {
+        std::string name;
+        size_t column;
+        bool unique = false;
+        std::vector<size_t> include;
+
+        bool covers(size_t col, const TableSchema& schema) const;
+    };
+
+    // Where the rows live: an ordered B+tree, an extendible hash file that
+    // answers primary key lookups in one bucket read but scans in no key order,
+    // an LSM file that turns inserts into sequential run writes, or a B+tree of
+    // PAX blocks that store rows column by column for scan-heavy tables
+    enum class TableStorage {
+        BTREE,
+        HASH,
+        LSM,
+        PAX,
     };
 
     struct TableSchema {
         int pk_index;
+        // Composite primary key columns in key order; empty for a key on pk_index
+        // alone. pk_index names the leading key column either way.
+        std::vector<size_t> key_columns;
         std::vector<ColumnDef> columns;
+        std::vector<IndexDef> indexes;
+        TableStorage storage = TableStorage::BTREE;
+        // Bumped by every ADD COLUMN; rows record the version they were written under
+        uint32_t version = 0;
+
+        // Primary key columns in key order
+        std::vector<size_t> primary_key() const;
+        bool is_key_column(size_t column) const;
+        // Columns a row written under version holds: added columns come last, so the
+        // first column_count(version) columns
+        size_t column_count(uint32_t version) const;
     };
 
     class Catalog {
     private:
         std::unordered_map<std::string, TableSchema> tables;
+        // Row codec of each table, compiled once when the table is registered
+        std::unordered_map<std::string, std::unique_ptr<CompiledRowCodec>> codecs;
+        // Strings of each table's dictionary columns, shared by all of its rows
+        std::unordered_map<std::string, std::unique_ptr<TableDictionaries>> dictionaries;
     public:
         Catalog(); 
         ~Catalog();
 
         bool register_table(const std::string& table_name, const TableSchema& schema);
         std::optional<const TableSchema*> get_schema(const std::string& table_name) const;
+        const CompiledRowCodec* get_codec(const std::string& table_name) const;
+        TableDictionaries* get_dictionaries(const std::string& table_name) const;
         bool has_table(const std::string& table_name) const;
         bool drop_table(const std::string& table_name);
+        bool add_index(const std::string& table_name, const IndexDef& index);
+        // Appends column under a new schema version without touching stored rows. The
+        // column cannot be UNIQUE, and default_value is NULL or of the column's type.
+        bool add_column(const std::string& table_name, const ColumnDef& column);
+        const IndexDef* find_index(const std::string& table_name, const std::string& index_name) const;
     };
 }
\ No newline at end of file
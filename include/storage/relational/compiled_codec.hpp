@@ -0,0 +1,68 @@
+#pragma once
+#include "storage/relational/row_codec.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Relational {
+    // RowCodec::encode and decode, compiled once per schema into a flat program
+    // producing the same compact rows. FLOAT, DOUBLE and BOOLEAN columns are copies
+    // at offsets fixed by the schema; INT, DATETIME and STRING columns are the
+    // variable-length fixups, placed by the offset table. Each fixed column is read
+    // and written by a function picked when the program is built, so a row costs no
+    // switch on column types, and a schema without variable columns skips the
+    // offset table entirely. Rows in the older tagged format go to RowCodec. There is
+    // a program per schema version, so rows written before an ADD COLUMN decode
+    // without going through the switch either.
+    class CompiledRowCodec {
+    public:
+        // Dictionary columns are coded through dictionaries when given, see RowCodec
+        explicit CompiledRowCodec(const TableSchema& schema, TableDictionaries* dictionaries = nullptr);
+
+        // Empty on a tuple that does not match the schema
+        std::vector<uint8_t> encode(const Tuple& tuple) const;
+        bool encode(const Tuple& tuple, std::vector<uint8_t>& out) const;
+        // Empty on a malformed row
+        Tuple decode(const std::vector<uint8_t>& data) const;
+        bool decode(const uint8_t* data, size_t size, Tuple& out) const;
+        bool all_fixed() const { return programs_.back().variable.empty(); }
+
+    private:
+        using Store = bool (*)(const Value& value, uint8_t* out);
+        using Load = void (*)(const uint8_t* data, Value& out);
+
+        struct FixedField {
+            uint32_t column;
+            uint32_t offset;  // From the start of the row
+            bool key;
+            Store store;
+            Load load;
+        };
+        enum class VariableKind : uint8_t {
+            VARINT,
+            STRING,
+            DICTIONARY,
+        };
+        struct VariableField {
+            uint32_t column;
+            bool key;
+            VariableKind kind;
+            StringDictionary* dictionary;
+        };
+
+        // Reads and writes rows of the first column_count columns
+        struct Program {
+            size_t column_count;
+            size_t head_size;  // Format byte, null bitmap and fixed section
+            std::vector<FixedField> fixed;
+            std::vector<VariableField> variable;
+        };
+
+        const TableSchema& schema_;
+        TableDictionaries* dictionaries_;
+        size_t column_count_;
+        std::vector<Program> programs_;  // By schema version
+
+        Program compile(size_t column_count) const;
+        bool decode_fixed(const Program& program, const uint8_t* data, size_t size, Tuple& out) const;
+    };
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "storage/relational/row_view.hpp"
+#include "storage/table_handle.hpp"
+#include "storage/btree.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Relational {
+    // PAX tables (TableStorage::PAX) keep their rows column by column. A B+tree record
+    // is a block of consecutive rows keyed by the primary key of its first row, and
+    // its value lays the rows out as one minipage per column:
+    //   uint16_t row_count, column_count
+    //   uint16_t end[column_count + 1]   end of the key minipage, then of each column's
+    //   key minipage     uint16_t end[row_count], then the encoded primary keys
+    //   column minipage  null bitmap, then FLOAT (4), DOUBLE (8), BOOLEAN (1) and
+    //                    INT/DATETIME (4, little-endian) values back to back, or for
+    //                    STRING uint16_t end[row_count] and the bytes
+    // A block is at most PAX_BLOCK_BYTES, so it stays inline and, with its record
+    // header, slot and a short key, four of them fill a leaf. A scan reading one
+    // column touches only its minipages, and a fixed-width minipage is a plain array
+    // a filter or aggregate loops over. Row i of a block is its slot for point
+    // access: found by binary search of the keys.
+    // Columns added after a block was written read as their default.
+    inline constexpr size_t PAX_BLOCK_BYTES = OVERFLOW_THRESHOLD - 32;
+
+    // Width of a column's values in a PAX minipage and a ColumnBatch; 0 for STRING
+    size_t pax_width(ColumnType type);
+    // Writes value as a minipage holds it, pax_width(type) bytes, zeros for NULL;
+    // false when it has another type
+    bool pax_value_bytes(ColumnType type, const Value& value, uint8_t* out);
+
+    // Reads a block in place; the bytes must outlive the view
+    class PaxBlockView {
+    private:
+        const TableSchema& schema;
+        const uint8_t* data;
+        size_t size;
+        size_t rows = 0;
+        size_t stored_columns = 0;
+        bool ok = false;
+
+        // Start and end of minipage m: 0 for the keys, column + 1 for a column
+        bool minipage(size_t m, size_t& start, size_t& end) const;
+        // Entry row of a uint16_t-indexed minipage starting at start
+        bool entry(size_t start, size_t end, size_t row, const uint8_t*& out, size_t& len) const;
+    public:
+        PaxBlockView(const TableSchema& schema, const uint8_t* data, size_t size);
+
+        bool valid() const { return ok; }
+        size_t row_count() const { return rows; }
+        bool key(size_t row, const uint8_t*& out, size_t& len) const;
+        // First row whose key is >= key; found when it is equal
+        size_t lower_bound(const uint8_t* key, size_t len, bool& found) const;
+        bool get(size_t row, size_t column, Value& out) const;
+        Tuple row(size_t row) const;  // Empty when the block is malformed
+        // The column's minipage; false when the block predates the column or it is STRING
+        bool column(size_t column, ColumnBatch& out) const;
+    };
+
+    // Writes rows and their encoded primary keys, in key order, as one block; empty
+    // when a row does not match the schema or the block is too large for uint16_t offsets
+    std::vector<uint8_t> encode_pax_block(const TableSchema& schema, const std::vector<std::vector<uint8_t>>& keys,
+                                          const std::vector<Tuple>& rows);
+}
+
+// Row operations on a PAX table's B+tree; key is the row's encoded primary key
+bool pax_search(TableHandle& th, const Relational::TableSchema& schema, const std::vector<uint8_t>& key,
+                Relational::Tuple& row);
+// Fails on an existing key, or a row too wide to fit a block on its own
+bool pax_insert(TableHandle& th, const Relational::TableSchema& schema, const std::vector<uint8_t>& key,
+                const Relational::Tuple& row);
+bool pax_update(TableHandle& th, const Relational::TableSchema& schema, const std::vector<uint8_t>& key,
+                const Relational::Tuple& row);
+bool pax_delete(TableHandle& th, const Relational::TableSchema& schema, const std::vector<uint8_t>& key);
+// Visits the blocks holding keys in [start, end] (empty bounds are open) in key order;
+// the block is a view into the pinned leaf, valid only during the call, and its rows
+// outside the bounds are the callback's to skip
+using PaxBlockCallback = void (*)(const Relational::PaxBlockView& block, void* ctx);
+void pax_scan(TableHandle& th, const Relational::TableSchema& schema, const std::vector<uint8_t>& start,
+              const std::vector<uint8_t>& end, PaxBlockCallback callback, void* ctx);
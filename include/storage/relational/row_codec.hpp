@@ -1,21 +1,145 @@
 #pragma once
 #include "storage/relational/catalog.hpp"
 #include <cstdint>
-#include <variant>
+#include <string>
+#include <unordered_map>
 
 namespace Relational {
-    using Value = std::variant<int, float, double, std::string, bool>;
-    using Tuple = std::vector<Value>;
+    // Type tag leading each column of an encoded row
+    inline constexpr uint8_t TAG_INT = 0;
+    inline constexpr uint8_t TAG_FLOAT = 1;
+    inline constexpr uint8_t TAG_DOUBLE = 2;
+    inline constexpr uint8_t TAG_STRING = 3;
+    inline constexpr uint8_t TAG_BOOLEAN = 4;
+    inline constexpr uint8_t TAG_DATETIME = 5;
+    inline constexpr uint8_t TAG_NULL = 6;
+
+    // Compact row format, version 1:
+    //   format byte    ROW_COMPACT_V1, or ROW_COMPACT_V1_WIDE when offsets take 2 bytes
+    //   null bitmap    one bit per column, set when the column is NULL
+    //   fixed section  FLOAT (4), DOUBLE (8) and BOOLEAN (1) columns in column order
+    //   offset table   end of each variable column's bytes, from the start of the data
+    //   variable data  INT and DATETIME as zigzag varints, then STRING bytes unprefixed;
+    //                  a dictionary column holds the zigzag varint of its code + 1, or 0
+    //                  followed by the bytes of a value the dictionary had no room for
+    // A NULL column keeps its fixed width and has no variable bytes, so any column is
+    // found from the schema and the offset table without reading the others. Rows
+    // written in the older tagged format start with a column tag (< 0x80) and still
+    // decode; the format byte of later versions will differ.
+    //
+    // Once a table has added columns, rows start with ROW_VERSIONED and the varint of
+    // the schema version they were written under, followed by a compact row of that
+    // version's columns. Columns added after it read as their default, so ADD COLUMN
+    // rewrites no rows. Rows without the prefix, compact or tagged, are version 0.
+    inline constexpr uint8_t ROW_COMPACT_V1 = 0x81;
+    inline constexpr uint8_t ROW_COMPACT_V1_WIDE = 0x82;
+    inline constexpr uint8_t ROW_VERSIONED = 0x83;
+
+    inline constexpr size_t DICTIONARY_MAX_ENTRIES = 4096;
+
+    // Distinct values of a dictionary-encoded STRING column. Rows hold a value's code
+    // instead of its bytes, so a column with few distinct values takes a byte or two
+    // per row, and an equality test compares codes. Once the dictionary holds
+    // DICTIONARY_MAX_ENTRIES values, new ones are written into the rows as they are.
+    class StringDictionary {
+    private:
+        std::vector<std::string> values;
+        std::unordered_map<std::string, uint32_t> codes;
+        bool spilled_ = false;
+    public:
+        static constexpr uint32_t NO_CODE = UINT32_MAX;
+
+        // The value's code, adding it when there is room; NO_CODE when full
+        uint32_t intern(const std::string& value);
+        uint32_t find(const std::string& value) const;
+        const std::string* value(uint32_t code) const;
+        size_t size() const { return values.size(); }
+        // Drops the values after the first count and sets spilled() back, undoing the
+        // codes a row that was not written took
+        void truncate(size_t count, bool spilled);
+        // A value was written uncoded, so a value with no code may still be in rows
+        bool spilled() const { return spilled_; }
+    };
+
+    enum class RowFormat {
+        TAGGED,
+        COMPACT,
+        INVALID,
+    };
+
+    // The format of the row, after any version prefix
+    RowFormat row_format(const uint8_t* data, size_t size);
+    // Skips the version prefix of a row, leaving data and size on the row itself;
+    // version is 0 for rows without one. False when the prefix is malformed.
+    bool split_row_version(const uint8_t*& data, size_t& size, uint32_t& version);
+
+    // Where each column of a schema sits in a compact row, for rows holding the first
+    // column_count columns
+    struct CompactLayout {
+        explicit CompactLayout(const TableSchema& schema, size_t column_count = SIZE_MAX);
+
+        size_t bitmap_bytes = 0;
+        size_t fixed_bytes = 0;
+        size_t var_count = 0;
+        // Offset in the fixed section, or index in the offset table for variable columns
+        std::vector<uint32_t> position;
+        std::vector<uint8_t> width;  // Bytes of a fixed column, 0 for variable ones
+    };
+
+    // Locates a column of a compact row in place, past any version prefix; data is
+    // nullptr when it is NULL. False when the row is malformed.
+    bool compact_column(const CompactLayout& layout, const uint8_t* row, size_t size, size_t column,
+                        const uint8_t*& data, size_t& len);
+    // Reads a compact column's bytes as a value; a dictionary column needs its dictionary
+    // unless the value was written uncoded
+    bool read_compact_value(const ColumnDef& column, const uint8_t* data, size_t len, Value& out,
+                            const StringDictionary* dictionary = nullptr);
+    // The code in a dictionary column's bytes, NO_CODE when the value was written
+    // uncoded; false when they are malformed
+    bool read_dictionary_code(const uint8_t* data, size_t len, uint32_t& code);
+    // Writes a dictionary column's bytes, interning value when dictionary is given
+    void append_dictionary_string(std::vector<uint8_t>& out, const std::string& value, StringDictionary* dictionary);
+    // Writes the zigzag varint of an INT or DATETIME; returns its size, at most 10 bytes
+    size_t write_varint(int64_t value, uint8_t* out);
 
     class RowCodec {
     private:
         const TableSchema& schema;
+        TableDictionaries* dictionaries;
+        StringDictionary* dictionary(size_t column) const;
     public:
-        RowCodec(const TableSchema& schema);
+        // Dictionary columns are written uncoded without dictionaries, and coded rows
+        // then fail to decode
+        RowCodec(const TableSchema& schema, TableDictionaries* dictionaries = nullptr);
         ~RowCodec() = default;
+        // Compact format; NULL is allowed in any column outside the primary key
         std::vector<uint8_t> encode(const Tuple& tuple) const;
+        // The bytes column holds in a compact row, to compare rows without decoding them.
+        // Dictionary values are looked up, not added. False for NULL.
+        bool encode_compact_column(size_t column, const Value& value, std::vector<uint8_t>& out) const;
+        // The older format: a type tag before every column
+        std::vector<uint8_t> encode_tagged(const Tuple& tuple) const;
+        // Keys are memcmp-ordered like their values: numbers big-endian with the sign
+        // flipped, strings escaped and terminated, composite keys concatenated in key
+        // column order. B+tree order is then value order, and range scans work.
         std::vector<uint8_t> encode_key(const Tuple& tuple) const;
+        // Leading primary key values in key order; fewer values than key columns give
+        // a prefix of every key that starts with them
+        std::vector<uint8_t> encode_key_prefix(const Tuple& key_values) const;
+        std::vector<uint8_t> encode_key_column(size_t column, const Value& value) const;
         std::vector<uint8_t> encode_value(const Tuple& tuple) const;
+        std::vector<uint8_t> encode_column(size_t column, const Value& value) const;
+        // Secondary index key: the column's key encoding followed by the primary key
+        std::vector<uint8_t> encode_index_key(const Tuple& tuple, size_t column) const;
+        // Secondary index value: the primary key followed by the INCLUDE columns
+        std::vector<uint8_t> encode_index_value(const Tuple& tuple, const std::vector<size_t>& include) const;
+        // Either format; empty on a malformed row
         Tuple decode(const std::vector<uint8_t>& data) const;
+        Tuple decode(const uint8_t* data, size_t size) const;
+        // Decodes one tagged column at p and advances p past it
+        bool decode_column(size_t column, const uint8_t*& p, const uint8_t* end, Value& out) const;
+        bool decode_key_column(size_t column, const uint8_t*& p, const uint8_t* end, Value& out) const;
+        // Decodes a whole primary key at p into the key columns of row
+        bool decode_key(const uint8_t*& p, const uint8_t* end, Tuple& row) const;
     };
 }
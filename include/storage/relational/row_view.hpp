@@ -0,0 +1,74 @@
+#pragma once
+#include "storage/relational/row_codec.hpp"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace Relational {
+    // Where the columns of an encoded row start. A compact row places every column
+    // through the CompactLayout of the schema version it was written under and its
+    // offset table; columns added later read as their default. In an older tagged row every column
+    // before the first STRING has a fixed width, so those offsets are the same in
+    // every row; later columns are found by walking from there.
+    struct RowLayout {
+        // Dictionary columns read their values from dictionaries, see RowCodec
+        explicit RowLayout(const TableSchema& schema, TableDictionaries* dictionaries = nullptr);
+
+        const TableSchema& schema;
+        TableDictionaries* dictionaries;
+        RowCodec codec;
+        std::vector<CompactLayout> compact;  // By schema version
+        // Tagged rows: offset of each column up to and including the first STRING column
+        std::vector<uint32_t> fixed_offsets;
+    };
+
+    // Values of one fixed-width column in row order: count values at data, the
+    // column's pax_width apart (INT and DATETIME as 4-byte int32). Bit i of nulls,
+    // LSB first, is set when row i is NULL; its value bytes are zero.
+    struct ColumnBatch {
+        ColumnType type;
+        size_t count;
+        const uint8_t* data;
+        const uint8_t* nulls;
+    };
+
+    // Reads the columns of an encoded row in place, without building a Tuple. The
+    // bytes are not copied: a view over a scanned record is valid only while the
+    // scan callback runs, and string_views into it no longer than that.
+    class RowView {
+    private:
+        const RowLayout& layout;
+        const uint8_t* row;   // With its version prefix
+        const uint8_t* data;  // Past it
+        const uint8_t* end;
+        RowFormat format;
+        const CompactLayout* compact = nullptr;
+        size_t stored_columns = 0;  // Columns the row holds; later ones are defaults
+
+        // Tagged rows: the tag byte of column, or nullptr when the row is too short
+        const uint8_t* column_data(size_t column) const;
+        const StringDictionary* dictionary_for(size_t column) const;
+        template <typename T>
+        bool get_as(size_t column, T& out) const;
+    public:
+        RowView(const RowLayout& layout, const uint8_t* data, size_t size);
+
+        size_t column_count() const { return layout.schema.columns.size(); }
+        bool is_null(size_t column) const;
+        // Typed reads; false when the column is NULL, has another type or the row is malformed
+        bool get_int(size_t column, int& out) const;
+        bool get_float(size_t column, float& out) const;
+        bool get_double(size_t column, double& out) const;
+        bool get_bool(size_t column, bool& out) const;
+        // A dictionary column's view points into the dictionary, and a column added
+        // after the row was written into the schema's default; both outlive the row
+        bool get_string(size_t column, std::string_view& out) const;
+        bool get(size_t column, Value& out) const;
+        // The column's bytes in a compact row, as RowCodec::encode_compact_column writes
+        // them; false for NULL, a column the row predates, a tagged row or a malformed one
+        bool get_raw(size_t column, const uint8_t*& out, size_t& len) const;
+        // Copies out the listed columns in that order, or every column when columns is
+        // empty; an empty tuple when the row is malformed
+        Tuple materialize(const std::vector<size_t>& columns = {}) const;
+    };
+}
@@ -2,9 +2,11 @@
 #include <string>
 #include <memory>
 #include <cstdint>
+#include <vector>
 #include "storage/disk_manager.hpp"
 
 class BufferPoolManager;
+struct LsmTree;
 
 struct TableHandle {
     std::string table_name;
@@ -14,6 +16,11 @@ struct TableHandle {
     std::unique_ptr<BufferPoolManager> bpm;
 
     uint32_t root_page;
+    uint32_t rightmost_leaf = 0;  // Cached append target for monotonic keys, 0 when unknown
+    bool deferred_deletes = false;  // btree_delete leaves tombstones for btree_compact, see btree_set_deferred_deletes
+    std::vector<uint32_t> hash_directory;  // Bucket page per directory slot of a hash file, empty for B+trees
+    std::vector<uint32_t> write_buffer;    // Message buffer pages of a buffered B+tree, empty when unbuffered
+    std::shared_ptr<LsmTree> lsm;          // Memtable and runs of an LSM file, null for B+trees
 
     TableHandle() = default;
 
@@ -26,7 +33,17 @@ struct TableHandle {
     {}
 };
 
+// Meta page body of a B+tree with a write buffer: the magic, then page_count buffer page ids
+struct WriteBufferMeta {
+    uint32_t magic;
+    uint32_t page_count;
+};
+inline constexpr uint32_t WRITE_BUFFER_MAGIC = 0x46554257;  // "WBUF"
+
 bool open_table(const std::string &name, TableHandle &th);
 bool create_table(const std::string &name);
 uint32_t allocate_page(TableHandle &th);
 void free_page(TableHandle &th, uint32_t page_id);
+// Cuts the free pages after the last allocated one off the end of the file;
+// returns how many pages the file shrank by
+uint32_t release_free_tail(TableHandle &th);
@@ -4,6 +4,7 @@
 #include "storage_new/page/page.h"
 #include "../parser/statements/create.h"
 #include <array>
+#include <optional>
 #include <string>
 #include <vector>
 #include <utility>
@@ -172,6 +173,33 @@ public:
      */
     void write_schema(const std::string& db_path, const std::string& table_name, const CreateTableStmt& schema);
 
+    /**
+     * Add a secondary index entry to a table's schema on page 1 (marks it dirty).
+     * Throws if the column does not exist or the index name is taken.
+     * @param db_path Database path
+     * @param table_name Indexed table
+     * @param index Index name, column and uniqueness
+     */
+    void add_index(const std::string& db_path, const std::string& table_name, const IndexDef& index);
+
+    /**
+     * List a table's secondary indexes in creation order.
+     * @param db_path Database path
+     * @param table_name Table name
+     * @return Index entries from the cached meta page
+     */
+    std::vector<IndexDef> list_indexes(const std::string& db_path, const std::string& table_name);
+
+    /**
+     * Find an index on a column, for the planner to turn equality filters into index scans.
+     * Prefers a unique index when the column has several.
+     * @param db_path Database path
+     * @param table_name Table name
+     * @param column_name Column to look up
+     * @return Index entry, or std::nullopt when the column is not indexed
+     */
+    std::optional<IndexDef> find_index(const std::string& db_path, const std::string& table_name, const std::string& column_name);
+
     /**
      * Flush all dirty pages from catalog pool to disk.
      * Writes all modified meta pages to their .ibd files, then clears dirty flags.
@@ -13,6 +13,12 @@ enum ColumnFlags : uint8_t {
     COL_FLAG_AUTO_INCREMENT = 1 << 3
 };
 
+// Index flags
+enum IndexFlags : uint8_t {
+    INDEX_FLAG_UNIQUE = 1 << 0,
+    INDEX_FLAG_INCLUDE = 1 << 1     // An INCLUDE column list follows the flags
+};
+
 // Serialize CreateTableStmt to binary format
 // Returns byte vector containing serialized schema
 std::vector<uint8_t> serialize_schema(const CreateTableStmt& schema);
@@ -29,6 +35,9 @@ CreateTableStmt deserialize_schema(const uint8_t* data, uint16_t size);
 // | column_1         |
 // | column_2         |
 // | ...              |
+// | num_indexes (2B)  |  optional, only when the table has indexes
+// | index_1           |
+// | ...              |
 // +-------------------+
 //
 // Column Format:
@@ -39,5 +48,18 @@ CreateTableStmt deserialize_schema(const uint8_t* data, uint16_t size);
 // | type              |  variable length
 // | flags      (1B)   |  ColumnFlags
 // +-------------------+
+//
+// Index Format:
+// +-------------------+
+// | name_len   (2B)   |
+// | name              |  variable length
+// | column_len (2B)   |
+// | column            |  variable length
+// | flags      (1B)   |  IndexFlags
+// | num_include (2B)  |  only with INDEX_FLAG_INCLUDE
+// | include_1_len (2B)|
+// | include_1         |  variable length
+// | ...              |
+// +-------------------+
 
 #endif // SCHEMA_SERIALIZER_H
@@ -66,8 +66,36 @@ AnalysisResult analyse(const Statement& stmt, DatabaseManager& db_mgr, const std
                     throw std::runtime_error("At most one PRIMARY KEY column is allowed. Composite primary keys are not supported.");
                 }
                 // pk_count == 0 is now allowed; row_id will be used as key
-                catalog.create_table_meta(db_path, table_stmt.table_name, table_stmt);
-                result.create_table_stmt = table_stmt;
+                // UNIQUE columns are enforced through an implicit unique index
+                CreateTableStmt stored = table_stmt;
+                for (const auto& col : stored.columns) {
+                    if (col.is_unique && !col.is_primary_key) {
+                        IndexDef index;
+                        index.name = stored.table_name + "_" + col.name + "_key";
+                        index.column_name = col.name;
+                        index.is_unique = true;
+                        stored.indexes.push_back(index);
+                    }
+                }
+                catalog.create_table_meta(db_path, stored.table_name, stored);
+                result.create_table_stmt = stored;
+            } else if (create_stmt.is_index()) {
+                const CreateIndexStmt& index_stmt = create_stmt.as_index();
+                Storage* eng = db_mgr.get_storage_engine();
+                if (db_path.empty() || !eng) {
+                    throw std::runtime_error("No database selected. Use USE <db>; first.");
+                }
+                std::string table_path = db_path + index_stmt.table_name + ".ibd";
+                if (!std::filesystem::exists(table_path)) {
+                    throw std::runtime_error("Table '" + index_stmt.table_name + "' does not exist");
+                }
+                IndexDef index;
+                index.name = index_stmt.index_name;
+                index.column_name = index_stmt.column_name;
+                index.is_unique = index_stmt.is_unique;
+                index.include_columns = index_stmt.include_columns;
+                eng->get_catalog().add_index(db_path, index_stmt.table_name, index);
+                result.create_index_stmt = index_stmt;
             }
             break;
         }
@@ -28,6 +28,15 @@ void run_query(const std::string& sql, DatabaseManager& db_mgr, TransactionManag
                         for (const auto& col : table_stmt.columns) {
                             out << "  - " << col.name << " " << col.data_type << "\n";
                         }
+                    } else if (create_stmt.is_index() && result.create_index_stmt) {
+                        const CreateIndexStmt& index_stmt = *result.create_index_stmt;
+                        out << (index_stmt.is_unique ? "Unique index created: " : "Index created: ")
+                            << index_stmt.index_name << " ON " << index_stmt.table_name
+                            << " (" << index_stmt.column_name << ")";
+                        for (size_t i = 0; i < index_stmt.include_columns.size(); ++i) {
+                            out << (i == 0 ? " INCLUDE (" : ", ") << index_stmt.include_columns[i];
+                        }
+                        out << (index_stmt.include_columns.empty() ? "\n" : ")\n");
                     }
                     break;
                 }
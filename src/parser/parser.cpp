@@ -12,7 +12,7 @@ enum class TokenType {
 
     Select, From, Where, And, Or,
     OrderBy, GroupBy, By,
-    Create, Database, Table, In,
+    Create, Database, Table, In, Index, On, Include,
     Primary, Key, Unique, Not, Null,
     Auto, Increment,
     Insert, Into, Values,
@@ -82,6 +82,9 @@ public:
             if (word_upper == "DATABASE") return {TokenType::Database, word};
             if (word_upper == "TABLE")  return {TokenType::Table, word};
             if (word_upper == "IN")     return {TokenType::In, word};
+            if (word_upper == "INDEX")  return {TokenType::Index, word};
+            if (word_upper == "ON")     return {TokenType::On, word};
+            if (word_upper == "INCLUDE") return {TokenType::Include, word};
             if (word_upper == "PRIMARY") return {TokenType::Primary, word};
             if (word_upper == "KEY")    return {TokenType::Key, word};
             if (word_upper == "UNIQUE") return {TokenType::Unique, word};
@@ -191,7 +191,59 @@ CreateTableStmt parse_create_table(Parser& parser) {
     return stmt;
 }
 
-// Main CREATE parser - routes to DATABASE or TABLE parser
+// Parse CREATE INDEX statement (CREATE [UNIQUE] already consumed)
+// Format: INDEX index_name ON table_name (column_name);
+CreateIndexStmt parse_create_index(Parser& parser, bool is_unique) {
+    CreateIndexStmt stmt;
+    stmt.is_unique = is_unique;
+
+    parser.eat(TokenType::Index);
+
+    if (parser.current.type != TokenType::Identifier) {
+        throw std::runtime_error("Expected index name");
+    }
+    stmt.index_name = parser.current.text;
+    parser.eat(TokenType::Identifier);
+
+    parser.eat(TokenType::On);
+    if (parser.current.type != TokenType::Identifier) {
+        throw std::runtime_error("Expected table name");
+    }
+    stmt.table_name = parser.current.text;
+    parser.eat(TokenType::Identifier);
+
+    // Single-column indexes only
+    parser.eat(TokenType::LParen);
+    if (parser.current.type != TokenType::Identifier) {
+        throw std::runtime_error("Expected column name");
+    }
+    stmt.column_name = parser.current.text;
+    parser.eat(TokenType::Identifier);
+    parser.eat(TokenType::RParen);
+
+    // Optional INCLUDE (col, ...): stored in the index for index-only scans
+    if (parser.current.type == TokenType::Include) {
+        parser.eat(TokenType::Include);
+        parser.eat(TokenType::LParen);
+        while (true) {
+            if (parser.current.type != TokenType::Identifier) {
+                throw std::runtime_error("Expected column name in INCLUDE list");
+            }
+            stmt.include_columns.push_back(parser.current.text);
+            parser.eat(TokenType::Identifier);
+            if (parser.current.type != TokenType::Comma) {
+                break;
+            }
+            parser.eat(TokenType::Comma);
+        }
+        parser.eat(TokenType::RParen);
+    }
+
+    parser.eat(TokenType::Semicolon);
+    return stmt;
+}
+
+// Main CREATE parser - routes to DATABASE, TABLE or INDEX parser
 CreateStmt parse_create(Parser& parser) {
     if (parser.current.type != TokenType::Create) {
         throw std::runtime_error("Expected CREATE keyword");
@@ -206,8 +258,15 @@ CreateStmt parse_create(Parser& parser) {
     } else if (parser.current.type == TokenType::Table) {
         CreateTableStmt table_stmt = parse_create_table(parser);
         return CreateStmt(table_stmt);
+    } else if (parser.current.type == TokenType::Index || parser.current.type == TokenType::Unique) {
+        bool is_unique = parser.current.type == TokenType::Unique;
+        if (is_unique) {
+            parser.eat(TokenType::Unique);
+        }
+        CreateIndexStmt index_stmt = parse_create_index(parser, is_unique);
+        return CreateStmt(index_stmt);
     } else {
-        throw std::runtime_error("Expected DATABASE or TABLE after CREATE");
+        throw std::runtime_error("Expected DATABASE, TABLE or INDEX after CREATE");
     }
 }
 
@@ -19,6 +19,10 @@
  * );
  *   - Creates a table named "users"
  *   - With columns: id (INT, PRIMARY KEY), name (VARCHAR(255), NOT NULL), email (VARCHAR(255), UNIQUE)
+ *
+ * CREATE [UNIQUE] INDEX users_name ON users (name) [INCLUDE (email)];
+ *   - Creates a secondary index named "users_name" on users.name
+ *   - INCLUDE columns are copied into the index so queries can skip the table
  */
 
 // Column definition structure
@@ -38,17 +42,36 @@ struct CreateDatabaseStmt {
     std::string database_name;     // Name of the database to create
 };
 
+// Secondary index on one column, stored in the catalog with its table's schema
+struct IndexDef {
+    std::string name;              // Index name (unique per table)
+    std::string column_name;       // Indexed column
+    bool is_unique = false;        // True for UNIQUE columns and CREATE UNIQUE INDEX
+    std::vector<std::string> include_columns; // INCLUDE columns carried in the index
+};
+
 // CREATE TABLE statement structure
 // Example: CREATE TABLE users (id INT, name VARCHAR(255));
 struct CreateTableStmt {
     std::string table_name;        // Name of the table to create
     std::vector<ColumnDef> columns; // List of column definitions
+    std::vector<IndexDef> indexes; // Secondary indexes (filled in by the catalog, not the parser)
+};
+
+// CREATE INDEX statement structure
+// Example: CREATE UNIQUE INDEX users_email ON users (email);
+struct CreateIndexStmt {
+    std::string index_name;        // Name of the index to create
+    std::string table_name;        // Indexed table
+    std::string column_name;       // Indexed column
+    bool is_unique = false;        // True for CREATE UNIQUE INDEX
+    std::vector<std::string> include_columns; // Columns listed in INCLUDE (...)
 };
 
-// CREATE statement variant (can be either DATABASE or TABLE)
+// CREATE statement variant (DATABASE, TABLE or INDEX)
 struct CreateStmt {
 private:
-    std::variant<CreateDatabaseStmt, CreateTableStmt> data;
+    std::variant<CreateDatabaseStmt, CreateTableStmt, CreateIndexStmt> data;
 
 public:
     // Constructor for CREATE DATABASE
@@ -57,6 +80,9 @@ public:
     // Constructor for CREATE TABLE
     CreateStmt(CreateTableStmt table_stmt) : data(table_stmt) {}
 
+    // Constructor for CREATE INDEX
+    CreateStmt(CreateIndexStmt index_stmt) : data(index_stmt) {}
+
     // Copy constructor
     CreateStmt(const CreateStmt& other) = default;
 
@@ -76,6 +102,11 @@ public:
         return std::holds_alternative<CreateTableStmt>(data);
     }
 
+    // Check if it's a CREATE INDEX
+    bool is_index() const {
+        return std::holds_alternative<CreateIndexStmt>(data);
+    }
+
     // Access CREATE DATABASE statement
     CreateDatabaseStmt& as_database() {
         if (!std::holds_alternative<CreateDatabaseStmt>(data)) {
@@ -105,6 +136,21 @@ public:
         }
         return std::get<CreateTableStmt>(data);
     }
+
+    // Access CREATE INDEX statement
+    CreateIndexStmt& as_index() {
+        if (!std::holds_alternative<CreateIndexStmt>(data)) {
+            throw std::runtime_error("CreateStmt is not a CREATE INDEX statement");
+        }
+        return std::get<CreateIndexStmt>(data);
+    }
+
+    const CreateIndexStmt& as_index() const {
+        if (!std::holds_alternative<CreateIndexStmt>(data)) {
+            throw std::runtime_error("CreateStmt is not a CREATE INDEX statement");
+        }
+        return std::get<CreateIndexStmt>(data);
+    }
 };
 
 // Forward declaration
@@ -114,6 +160,7 @@ class Parser;
 ColumnDef parse_column_def(Parser& parser);
 CreateDatabaseStmt parse_create_database(Parser& parser);
 CreateTableStmt parse_create_table(Parser& parser);
+CreateIndexStmt parse_create_index(Parser& parser, bool is_unique);
 CreateStmt parse_create(Parser& parser);
 
 #endif // CREATE_H
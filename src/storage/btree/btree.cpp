@@ -12,70 +12,43 @@
 
 extern uint32_t find_leaf_page(TableHandle& th, const Key& key, Page& out_page);
 extern uint32_t find_leftmost_leaf_page(TableHandle& th, Page& out_page);
-extern bool btree_insert_leaf_no_split(TableHandle& th, uint32_t page_id, Page& page, const Key& key, const Value& value);
-extern SplitLeafResult split_leaf_page(TableHandle& th, Page& page);
 extern void insert_into_parent(TableHandle& th, uint32_t left, const Key& key, uint32_t right);
 extern uint16_t write_raw_record(Page& page, const uint8_t* raw, uint16_t size);
+extern uint16_t write_internal_entry(Page& page, const Key& key, uint32_t child);
 
 void btree_range_scan(TableHandle& th, const Key& start_key, const Key& end_key,
                      BTreeRangeScanCallback callback, void* ctx) {
     if (th.root_page == 0 || callback == nullptr) {
         return;
     }
-    Page page;
-    uint32_t page_id;
-    uint16_t start_index;
-    if (start_key.empty()) {
-        page_id = find_leftmost_leaf_page(th, page);
-        if (page_id == UINT32_MAX) {
-            return;
+    BTreeCursor cursor(th);
+    for (bool ok = cursor.seek(start_key); ok; ok = cursor.next()) {
+        Key k = cursor.key();
+        Value v = cursor.value();
+        if (k.data() == nullptr || v.data() == nullptr) {
+            continue;
         }
-        start_index = 0;
-    } else {
-        page_id = find_leaf_page(th, start_key, page);
-        if (page_id == UINT32_MAX) {
+        if (!end_key.empty() && compare_keys(k.data(), k.size(), end_key.data(), end_key.size()) > 0) {
             return;
         }
-        BSearchResult sr = search_record(page, start_key.data(), start_key.size());
-        start_index = sr.index;
+        callback(k, v, ctx);
     }
-    PageHeader* ph = get_header(page);
-    while (true) {
-        for (uint16_t i = start_index; i < ph->cell_count; i++) {
-            uint16_t key_len = 0;
-            const uint8_t* key_data = slot_key(page, i, key_len);
-            uint16_t value_len = 0;
-            const uint8_t* value_data = slot_value(page, i, value_len);
-            if (key_data == nullptr || value_data == nullptr) {
-                continue;
-            }
-            if (!end_key.empty() && compare_keys(key_data, key_len, end_key.data(), end_key.size()) > 0) {
-                return;
-            }
-            Key k(key_data, key_len);
-            Value v;
-            v.assign(value_data, value_len);
-            callback(k, v, ctx);
-        }
-        page_id = ph->next_page_id;
-        if (page_id == 0) {
-            return;
-        }
-        if (!th.bpm) {
-            return;
-        }
-        Page* next = th.bpm->fetch_page(page_id);
-        if (!next) {
-            return;
-        }
-        std::memcpy(page.data, next->data, PAGE_SIZE);
-        th.bpm->unpin_page(page_id, false);
-        ph = get_header(page);
-        start_index = 0;
+}
+
+// True when key has a live record in the leaves; reads no overflow chain
+static bool leaves_contain(TableHandle& th, const Key& key) {
+    if (th.root_page == 0) {
+        return false;
+    }
+    Page leaf_page;
+    if (find_leaf_page(th, key, leaf_page) == UINT32_MAX) {
+        return false;
     }
+    BSearchResult result = search_record(leaf_page, key.data(), key.size());
+    return result.found && !slot_is_deleted(leaf_page, result.index);
 }
 
-bool btree_search(TableHandle& th, const Key& key, Value& value) {
+static bool search_leaves(TableHandle& th, const Key& key, Value& value) {
     if (th.root_page == 0) {
         return false;
     }
@@ -87,24 +60,139 @@ bool btree_search(TableHandle& th, const Key& key, Value& value) {
     }
     
     BSearchResult result = search_record(leaf_page, key.data(), key.size());
-    if (!result.found) {
+    if (!result.found || slot_is_deleted(leaf_page, result.index)) {
         return false;
     }
     
     uint16_t value_len;
     const uint8_t* value_data = slot_value(leaf_page, result.index, value_len);
-    if (value_data == nullptr || value_len == 0) {
+    if (value_data == nullptr) {
         return false;
     }
     
+    if (*slot_flags(leaf_page, result.index) & RECORD_OVERFLOW) {
+        return overflow_load(th, value_data, value_len, value);
+    }
     value.assign(value_data, value_len);
     return true;
 }
 
-bool btree_insert(TableHandle& th, const Key& key, const Value& value) {
-    if (!th.bpm) {
+bool btree_search(TableHandle& th, const Key& key, Value& value) {
+    if (!th.write_buffer.empty()) {
+        WriteMessage op;
+        Value buffered;
+        if (write_buffer_find(th, key, op, buffered)) {
+            // A buffered update only lands if the key is in the tree, a buffered insert
+            // only if it is not
+            if (op == MSG_DELETE) {
+                return false;
+            }
+            if (op == MSG_PUT || op == MSG_UPDATE) {
+                bool live = search_leaves(th, key, value);
+                if (live != (op == MSG_UPDATE)) {
+                    return live;
+                }
+            }
+            value = std::move(buffered);
+            return true;
+        }
+    }
+    return search_leaves(th, key, value);
+}
+
+
+// Removes the tombstoned records of a pinned leaf and frees their overflow chains
+static uint16_t purge_tombstones(TableHandle& th, Page& leaf) {
+    uint16_t removed = 0;
+    for (uint16_t i = get_header(leaf)->cell_count; i-- > 0;) {
+        const uint8_t* flags = slot_flags(leaf, i);
+        if (flags == nullptr || !(*flags & RECORD_DELETED)) {
+            continue;
+        }
+        if (*flags & RECORD_OVERFLOW) {
+            uint16_t stored_len = 0;
+            const uint8_t* stored = slot_value(leaf, i, stored_len);
+            overflow_free(th, overflow_first_page(stored, stored_len));
+        }
+        remove_slot(leaf, i);
+        removed++;
+    }
+    if (removed > 0) {
+        page_compact(leaf);
+    }
+    return removed;
+}
+
+static bool has_tombstones(Page& leaf) {
+    for (uint16_t i = 0; i < get_header(leaf)->cell_count; i++) {
+        if (slot_is_deleted(leaf, i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Purges the leaf's tombstones and refreshes the caller's copy of it.
+// Returns false when the leaf had none.
+static bool purge_leaf_tombstones(TableHandle& th, uint32_t leaf_page_id, Page& leaf_page) {
+    if (!has_tombstones(leaf_page)) {
+        return false;
+    }
+    Page* leaf_bp = th.bpm->fetch_page(leaf_page_id);
+    if (!leaf_bp) {
+        return false;
+    }
+    uint16_t removed = purge_tombstones(th, *leaf_bp);
+    std::memcpy(leaf_page.data, leaf_bp->data, PAGE_SIZE);
+    th.bpm->unpin_page(leaf_page_id, removed > 0);
+    return removed > 0;
+}
+
+// Packs the leaf's records to close holes left by deletes and grown updates, and
+// refreshes the caller's copy of it. Returns false when there were none.
+static bool compact_leaf(TableHandle& th, uint32_t leaf_page_id, Page& leaf_page) {
+    Page* leaf_bp = th.bpm->fetch_page(leaf_page_id);
+    if (!leaf_bp) {
+        return false;
+    }
+    uint16_t before = get_header(*leaf_bp)->free_start;
+    page_compact(*leaf_bp);
+    bool packed = get_header(*leaf_bp)->free_start < before;
+    std::memcpy(leaf_page.data, leaf_bp->data, PAGE_SIZE);
+    th.bpm->unpin_page(leaf_page_id, packed);
+    return packed;
+}
+
+// True when the key sorts after every key of the rightmost leaf
+static bool is_rightmost_append(Page& leaf_page, const Key& key) {
+    PageHeader* ph = get_header(leaf_page);
+    if (ph->page_level != PageLevel::LEAF || ph->next_page_id != 0 || ph->cell_count == 0) {
         return false;
     }
+    uint16_t last_len = 0;
+    const uint8_t* last_key = slot_key(leaf_page, ph->cell_count - 1, last_len);
+    return last_key != nullptr && compare_keys(key.data(), key.size(), last_key, last_len) > 0;
+}
+
+// Appends go straight to the cached rightmost leaf without a root-to-leaf descent
+static uint32_t find_append_leaf_page(TableHandle& th, const Key& key, Page& out_page) {
+    if (th.rightmost_leaf == 0) {
+        return UINT32_MAX;
+    }
+    Page* page = th.bpm->fetch_page(th.rightmost_leaf);
+    if (!page) {
+        return UINT32_MAX;
+    }
+    bool hit = is_rightmost_append(*page, key);
+    if (hit) {
+        std::memcpy(out_page.data, page->data, PAGE_SIZE);
+    }
+    th.bpm->unpin_page(th.rightmost_leaf, false);
+    return hit ? th.rightmost_leaf : UINT32_MAX;
+}
+
+// Inserts the record as stored, with its RECORD_* flags, in one descent
+static bool insert_record(TableHandle& th, const Key& key, const Value& value, uint8_t flags) {
     if (th.root_page == 0) {
         uint32_t root_page_id = allocate_page(th);
         if (root_page_id == INVALID_PAGE_ID) {
@@ -122,20 +210,43 @@ bool btree_insert(TableHandle& th, const Key& key, const Value& value) {
             th.bpm->unpin_page(0, true);
         }
 
-        page_insert(*root, key.data(), key.size(), value.data(), value.size());
+        page_insert(*root, key.data(), key.size(), value.data(), value.size(), flags);
         th.bpm->unpin_page(root_page_id, true);
+        th.rightmost_leaf = root_page_id;
         return true;
     }
 
     Page leaf_page;
-    uint32_t leaf_page_id = find_leaf_page(th, key, leaf_page);
+    uint32_t leaf_page_id = find_append_leaf_page(th, key, leaf_page);
+    if (leaf_page_id == UINT32_MAX) {
+        leaf_page_id = find_leaf_page(th, key, leaf_page);
+        if (leaf_page_id == UINT32_MAX) {
+            return false;
+        }
+        if (get_header(leaf_page)->next_page_id == 0) {
+            th.rightmost_leaf = leaf_page_id;
+        }
+    }
 
     BSearchResult search_result = search_record(leaf_page, key.data(), key.size());
     if (search_result.found) {
-        return false;
+        // A tombstoned key may be inserted again once its old record is gone
+        if (!slot_is_deleted(leaf_page, search_result.index) ||
+            !purge_leaf_tombstones(th, leaf_page_id, leaf_page)) {
+            return false;
+        }
     }
 
-    if (btree_insert_leaf_no_split(th, leaf_page_id, leaf_page, key, value)) {
+    if (btree_insert_leaf_no_split(th, leaf_page_id, leaf_page, key, value, flags)) {
+        return true;
+    }
+    // Space held by tombstones is reused before the leaf is split
+    if (purge_leaf_tombstones(th, leaf_page_id, leaf_page) &&
+        btree_insert_leaf_no_split(th, leaf_page_id, leaf_page, key, value, flags)) {
+        return true;
+    }
+    if (compact_leaf(th, leaf_page_id, leaf_page) &&
+        btree_insert_leaf_no_split(th, leaf_page_id, leaf_page, key, value, flags)) {
         return true;
     }
 
@@ -146,7 +257,14 @@ bool btree_insert(TableHandle& th, const Key& key, const Value& value) {
     std::memcpy(leaf_page.data, leaf_bp->data, PAGE_SIZE);
     th.bpm->unpin_page(leaf_page_id, false);
 
-    SplitLeafResult split_result = split_leaf_page(th, leaf_page);
+    bool append = is_rightmost_append(leaf_page, key);
+    SplitLeafResult split_result = split_leaf_page(th, leaf_page, append);
+    if (split_result.new_page == 0) {
+        return false;
+    }
+    if (append) {
+        th.rightmost_leaf = split_result.new_page;
+    }
     
     Key sep_key;
     sep_key.assign(split_result.seperator_key.data(), split_result.seperator_key.size());
@@ -158,7 +276,7 @@ bool btree_insert(TableHandle& th, const Key& key, const Value& value) {
             assert(false && "Left page doesn't have space after split");
             return false;
         }
-        if (!page_insert(split_result.left_page, key.data(), key.size(), value.data(), value.size())) {
+        if (!page_insert(split_result.left_page, key.data(), key.size(), value.data(), value.size(), flags)) {
             assert(false && "page_insert failed for left page");
             return false;
         }
@@ -172,7 +290,7 @@ bool btree_insert(TableHandle& th, const Key& key, const Value& value) {
             assert(false && "Right page doesn't have space after split");
             return false;
         }
-        if (!page_insert(split_result.right_page, key.data(), key.size(), value.data(), value.size())) {
+        if (!page_insert(split_result.right_page, key.data(), key.size(), value.data(), value.size(), flags)) {
             assert(false && "page_insert failed for right page");
             return false;
         }
@@ -188,419 +306,687 @@ bool btree_insert(TableHandle& th, const Key& key, const Value& value) {
     return true;
 }
 
-struct SiblingInfo {
-    uint32_t left_sibling;
-    uint32_t right_sibling;
-    Key separator_key;        // Key that points to current page (for merge with left)
-    Key right_separator_key;  // Key that points to right sibling (for merge with right)
-    bool is_leftmost;
-    bool is_rightmost;
-};
-
-SiblingInfo find_leaf_siblings(TableHandle& th, uint32_t leaf_page_id, Page& leaf_page) {
-    SiblingInfo info = {0, 0, Key(), Key(), false, false};
+bool btree_insert(TableHandle& th, const Key& key, const Value& value) {
+    if (!th.bpm) {
+        return false;
+    }
+    if (!th.write_buffer.empty()) {
+        // The leaves are read only behind a pending update; any other insert of a live
+        // key is dropped when the buffer is applied
+        WriteMessage op;
+        Value pending;
+        if (write_buffer_find(th, key, op, pending) &&
+            (op == MSG_PUT || op == MSG_UPSERT || (op == MSG_UPDATE && leaves_contain(th, key)))) {
+            return false;
+        }
+        return write_buffer_put(th, key, MSG_PUT, value);
+    }
+    if (value.size() <= OVERFLOW_THRESHOLD) {
+        return insert_record(th, key, value, 0);
+    }
+    // Large values go to an overflow chain; the leaf record holds only the reference
+    // and carries RECORD_OVERFLOW from the moment it is written
+    uint8_t stored[OVERFLOW_STORED_SIZE];
+    uint16_t stored_len = overflow_store(th, value, stored);
+    if (stored_len == 0) {
+        return false;
+    }
+    if (!insert_record(th, key, Value(stored, stored_len), RECORD_OVERFLOW)) {
+        overflow_free(th, overflow_first_page(stored, stored_len));
+        return false;
+    }
+    return true;
+}
 
-    PageHeader* ph = get_header(leaf_page);
-    if (ph->parent_page_id == 0) {
-        info.is_leftmost = true;
-        info.is_rightmost = true;
-        return info;
+// Puts a record btree_update removed back into the leaf it came from, which has room
+// for it again once packed
+static void restore_record(TableHandle& th, const Key& key, const std::vector<uint8_t>& stored, uint8_t flags) {
+    Page leaf_page;
+    uint32_t leaf_page_id = find_leaf_page(th, key, leaf_page);
+    Page* leaf_bp = leaf_page_id == UINT32_MAX ? nullptr : th.bpm->fetch_page(leaf_page_id);
+    if (!leaf_bp) {
+        return;
     }
+    page_compact(*leaf_bp);
+    bool restored = page_insert(*leaf_bp, key.data(), key.size(), stored.data(), static_cast<uint16_t>(stored.size()),
+                                flags);
+    th.bpm->unpin_page(leaf_page_id, restored);
+}
 
-    if (!th.bpm) {
-        return info;
+bool btree_update(TableHandle& th, const Key& key, const Value& value) {
+    if (!th.write_buffer.empty()) {
+        return write_buffer_put(th, key, MSG_UPDATE, value);
     }
-    Page* parent = th.bpm->fetch_page(ph->parent_page_id);
-    if (!parent) {
-        return info;
+    if (!th.bpm || th.root_page == 0) {
+        return false;
     }
-    PageHeader* parent_ph = get_header(*parent);
-    
-    if (parent_ph->page_level != PageLevel::INTERNAL) {
-        return info;
+    Page leaf_page;
+    uint32_t leaf_page_id = find_leaf_page(th, key, leaf_page);
+    if (leaf_page_id == UINT32_MAX) {
+        return false;
     }
-    
-    uint32_t leftmost = *reinterpret_cast<uint32_t*>(parent_ph->reserved);
-    if (leftmost == leaf_page_id) {
-        info.is_leftmost = true;
-        if (parent_ph->cell_count > 0) {
-            uint16_t entry_offset = *slot_ptr(*parent, 0);
-            InternalEntry* entry = reinterpret_cast<InternalEntry*>(parent->data + entry_offset);
-            info.right_sibling = entry->child_page;
-            
-            uint16_t sep_len = entry->key_size;
-            if (sep_len > 256) {
-                assert(false && "Key too large");
-                return info;
-            }
-            // For leftmost page, entry[0]'s key IS the right separator
-            info.right_separator_key.assign(entry->key, sep_len);
+    Page* leaf_bp = th.bpm->fetch_page(leaf_page_id);
+    if (!leaf_bp) {
+        return false;
+    }
+    BSearchResult result = search_record(*leaf_bp, key.data(), key.size());
+    if (!result.found || slot_is_deleted(*leaf_bp, result.index)) {
+        th.bpm->unpin_page(leaf_page_id, false);
+        return false;
+    }
+    uint32_t old_chain = 0;
+    if (*slot_flags(*leaf_bp, result.index) & RECORD_OVERFLOW) {
+        uint16_t old_len = 0;
+        const uint8_t* old_stored = slot_value(*leaf_bp, result.index, old_len);
+        old_chain = overflow_first_page(old_stored, old_len);
+    }
+
+    const uint8_t* new_data = value.data();
+    uint16_t new_len = value.size();
+    uint8_t stored[OVERFLOW_STORED_SIZE];
+    bool overflow = value.size() > OVERFLOW_THRESHOLD;
+    if (overflow) {
+        new_len = overflow_store(th, value, stored);
+        new_data = stored;
+        if (new_len == 0) {
+            th.bpm->unpin_page(leaf_page_id, false);
+            return false;
         }
-        th.bpm->unpin_page(ph->parent_page_id, false);
-        return info;
     }
 
-    for (uint16_t i = 0; i < parent_ph->cell_count; i++) {
-        uint16_t entry_offset = *slot_ptr(*parent, i);
-        InternalEntry* entry = reinterpret_cast<InternalEntry*>(parent->data + entry_offset);
+    if (page_update(*leaf_bp, key.data(), key.size(), new_data, new_len)) {
+        uint8_t* flags = slot_flags(*leaf_bp, result.index);
+        *flags = overflow ? (*flags | RECORD_OVERFLOW) : (*flags & ~RECORD_OVERFLOW);
+        th.bpm->unpin_page(leaf_page_id, true);
+        overflow_free(th, old_chain);
+        return true;
+    }
 
-        if (entry->child_page == leaf_page_id) {
-            if (i == 0) {
-                info.left_sibling = leftmost;
-            } else {
-                uint16_t prev_offset = *slot_ptr(*parent, i - 1);
-                InternalEntry* prev_entry = reinterpret_cast<InternalEntry*>(parent->data + prev_offset);
-                info.left_sibling = prev_entry->child_page;
-            }
-            
-            if (i + 1 < parent_ph->cell_count) {
-                uint16_t next_offset = *slot_ptr(*parent, i + 1);
-                InternalEntry* next_entry = reinterpret_cast<InternalEntry*>(parent->data + next_offset);
-                info.right_sibling = next_entry->child_page;
-                // Right separator is the key of entry[i+1]
-                info.right_separator_key.assign(next_entry->key, next_entry->key_size);
-            } else {
-                info.is_rightmost = true;
-            }
-            
-            // Current page's separator key (for merging with left)
-            uint16_t sep_len = entry->key_size;
-            if (sep_len > 256) {
-                assert(false && "Key too large");
-                return info;
-            }
-            info.separator_key.assign(entry->key, sep_len);
+    // The leaf cannot hold the larger record: drop it without merging and let
+    // the insert path split the leaf. The old record and its chain are kept until
+    // the new version is in, and put back if the insert fails.
+    if (overflow) {
+        overflow_free(th, overflow_first_page(stored, new_len));
+    }
+    uint16_t old_len = 0;
+    const uint8_t* old_data = slot_value(*leaf_bp, result.index, old_len);
+    std::vector<uint8_t> old_stored(old_data, old_data + old_len);
+    uint8_t old_flags = *slot_flags(*leaf_bp, result.index);
+    page_delete(*leaf_bp, key.data(), key.size());
+    th.bpm->unpin_page(leaf_page_id, true);
+    if (!btree_insert(th, key, value)) {
+        restore_record(th, key, old_stored, old_flags);
+        return false;
+    }
+    overflow_free(th, old_chain);
+    return true;
+}
 
-            th.bpm->unpin_page(ph->parent_page_id, false);
-            return info;
-        }
+
+static constexpr uint32_t USABLE_PAGE_BYTES = PAGE_SIZE - sizeof(PageHeader);
+
+// Live bytes of a leaf or internal page: entries plus their slots, excluding holes
+static uint32_t page_used_bytes(Page& page) {
+    PageHeader* ph = get_header(page);
+    uint32_t used = ph->cell_count * slot_entry_size(page);
+    for (uint16_t i = 0; i < ph->cell_count; i++) {
+        used += stored_entry_size(page, i);
+    }
+    return used;
+}
+
+static bool is_page_underutilized(Page& page) {
+    if (get_header(page)->cell_count == 0) {
+        return true;
     }
+    return (page_used_bytes(page) * 100) / USABLE_PAGE_BYTES < MERGE_THRESHOLD_PERCENT;
+}
+
+static bool fits_after_merge(uint32_t used_bytes) {
+    return (used_bytes * 100) / USABLE_PAGE_BYTES <= MERGE_MAX_FILL_PERCENT;
+}
+
+// Bytes page's entries take once moved to a page whose slots are slot_size bytes
+static uint32_t moved_bytes(Page& page, uint32_t slot_size) {
+    PageHeader* ph = get_header(page);
+    return page_used_bytes(page) - ph->cell_count * slot_entry_size(page) + ph->cell_count * slot_size;
+}
+
+static void reset_page_space(Page& page) {
+    PageHeader* ph = get_header(page);
+    ph->cell_count = 0;
+    ph->free_start = sizeof(PageHeader);
+    ph->free_end = PAGE_SIZE;
+}
+
+static InternalEntry* internal_entry(Page& page, uint16_t index) {
+    return reinterpret_cast<InternalEntry*>(page.data + *slot_ptr(page, index));
+}
+
+static uint32_t& leftmost_child(Page& page) {
+    return *reinterpret_cast<uint32_t*>(get_header(page)->reserved);
+}
 
-    th.bpm->unpin_page(ph->parent_page_id, false);
-    assert(false && "Leaf page not found in parent");
-    return info;
+static void set_parent(TableHandle& th, uint32_t page_id, uint32_t parent_id) {
+    Page* page = th.bpm->fetch_page(page_id);
+    if (page) {
+        get_header(*page)->parent_page_id = parent_id;
+        th.bpm->unpin_page(page_id, true);
+    }
 }
 
-static int16_t find_internal_entry_index(Page& parent, const Key& key_to_remove) {
+struct SiblingPair {
+    uint32_t left;
+    uint32_t right;
+    uint16_t sep_index;  // Parent slot whose child is right
+};
+
+// Pairs a page with an adjacent sibling under the same parent, preferring the left one
+static bool find_sibling_pair(Page& parent, uint32_t page_id, SiblingPair& pair) {
     PageHeader* ph = get_header(parent);
+    if (ph->page_level != PageLevel::INTERNAL || ph->cell_count == 0) {
+        return false;
+    }
+    if (leftmost_child(parent) == page_id) {
+        pair = {page_id, internal_entry(parent, 0)->child_page, 0};
+        return true;
+    }
     for (uint16_t i = 0; i < ph->cell_count; i++) {
-        uint16_t offset = *slot_ptr(parent, i);
-        InternalEntry* entry = reinterpret_cast<InternalEntry*>(parent.data + offset);
-        const uint8_t* entry_key = parent.data + offset + sizeof(InternalEntry);
-        if (entry->key_size == key_to_remove.size() &&
-            memcmp(entry_key, key_to_remove.data(), key_to_remove.size()) == 0) {
-            return static_cast<int16_t>(i);
+        if (internal_entry(parent, i)->child_page == page_id) {
+            uint32_t left = i == 0 ? leftmost_child(parent) : internal_entry(parent, i - 1)->child_page;
+            pair = {left, page_id, i};
+            return true;
         }
     }
-    return -1;
+    assert(false && "Page not found in parent");
+    return false;
 }
 
-void remove_from_internal(TableHandle& th, uint32_t parent_id, const Key& key_to_remove, uint32_t deleted_child_page) {
-    if (!th.bpm) {
-        return;
-    }
-    Page* parent = th.bpm->fetch_page(parent_id);
-    if (!parent) {
-        return;
+// Swaps the key of a parent entry, keeping its child. Callers check the fit first.
+static void replace_separator(Page& parent, uint16_t index, const uint8_t* key, uint16_t key_len) {
+    uint32_t child = internal_entry(parent, index)->child_page;
+    remove_slot(parent, index);
+    PageHeader* ph = get_header(parent);
+    uint16_t needed = sizeof(InternalEntry) + key_len + slot_entry_size(parent);
+    if (ph->free_start + needed > ph->free_end) {
+        page_compact(parent);
     }
-    PageHeader* ph = get_header(*parent);
+    uint16_t offset = write_internal_entry(parent, Key(key, key_len), child);
+    insert_slot(parent, index, offset);
+}
 
-    if (ph->page_level != PageLevel::INTERNAL) {
-        th.bpm->unpin_page(parent_id, false);
-        return;
+static bool separator_fits(Page& parent, uint16_t index, uint16_t new_key_len) {
+    uint32_t old_size = stored_entry_size(parent, index);
+    uint32_t new_size = sizeof(InternalEntry) + new_key_len;
+    return page_used_bytes(parent) - old_size + new_size <= USABLE_PAGE_BYTES;
+}
+
+// Appends right's records to left and unlinks right from the leaf chain
+static void merge_leaf_pages(TableHandle& th, Page& left_page, Page& right_page) {
+    Page scratch;
+    std::memcpy(scratch.data, left_page.data, PAGE_SIZE);
+    reset_page_space(left_page);
+    append_leaf_records(left_page, scratch, 0, get_header(scratch)->cell_count);
+    append_leaf_records(left_page, right_page, 0, get_header(right_page)->cell_count);
+
+    uint32_t right_next = get_header(right_page)->next_page_id;
+    get_header(left_page)->next_page_id = right_next;
+    if (right_next != 0) {
+        Page* next_page = th.bpm->fetch_page(right_next);
+        if (next_page) {
+            get_header(*next_page)->prev_page_id = get_header(left_page)->page_id;
+            th.bpm->unpin_page(right_next, true);
+        }
     }
+}
 
-    uint32_t* leftmost_ptr = reinterpret_cast<uint32_t*>(ph->reserved);
-    if (deleted_child_page != 0 && *leftmost_ptr == deleted_child_page) {
-        if (ph->cell_count > 0) {
-            uint16_t first_offset = *slot_ptr(*parent, 0);
-            InternalEntry* first_entry = reinterpret_cast<InternalEntry*>(parent->data + first_offset);
-            *leftmost_ptr = first_entry->child_page;
-            remove_slot(*parent, 0);
-        } else {
-            *leftmost_ptr = 0;
+// Moves records between two adjacent leaves so they hold about the same number of
+// bytes, then points the parent separator at right's new first key. Returns false
+// when no split point is better than the current one or the separator does not fit.
+static bool redistribute_leaves(Page& left_page, Page& right_page, Page& parent, uint16_t sep_index) {
+    uint16_t nl = get_header(left_page)->cell_count;
+    uint16_t nr = get_header(right_page)->cell_count;
+    uint16_t total = nl + nr;
+    uint32_t left_slot = slot_entry_size(left_page);
+    uint32_t right_slot = slot_entry_size(right_page);
+    auto record_bytes = [&](uint16_t i) -> uint32_t {
+        return i < nl ? stored_entry_size(left_page, i) : stored_entry_size(right_page, i - nl);
+    };
+
+    uint32_t all_bytes = 0;
+    for (uint16_t i = 0; i < total; i++) {
+        all_bytes += record_bytes(i);
+    }
+
+    // Left keeps records [0, k); pick the k that best balances the two pages
+    uint16_t best = nl;
+    uint32_t best_gap = UINT32_MAX;
+    uint32_t left_bytes = 0;
+    for (uint16_t k = 1; k < total; k++) {
+        left_bytes += record_bytes(k - 1);
+        uint32_t l = left_bytes + k * left_slot;
+        uint32_t r = all_bytes - left_bytes + (total - k) * right_slot;
+        if (l > USABLE_PAGE_BYTES || r > USABLE_PAGE_BYTES) {
+            continue;
+        }
+        uint32_t gap = l > r ? l - r : r - l;
+        if (gap < best_gap) {
+            best_gap = gap;
+            best = k;
         }
-        th.bpm->unpin_page(parent_id, true);
-        return;
+    }
+    if (best == nl) {
+        return false;
     }
 
-    int16_t idx = find_internal_entry_index(*parent, key_to_remove);
-    if (idx >= 0) {
-        remove_slot(*parent, static_cast<uint16_t>(idx));
-        th.bpm->unpin_page(parent_id, true);
+    uint16_t sep_len = 0;
+    const uint8_t* sep = best < nl ? slot_key(left_page, best, sep_len) : slot_key(right_page, best - nl, sep_len);
+    if (sep == nullptr || !separator_fits(parent, sep_index, sep_len)) {
+        return false;
+    }
+
+    Page old_left;
+    Page old_right;
+    std::memcpy(old_left.data, left_page.data, PAGE_SIZE);
+    std::memcpy(old_right.data, right_page.data, PAGE_SIZE);
+    reset_page_space(left_page);
+    reset_page_space(right_page);
+    if (best < nl) {
+        append_leaf_records(left_page, old_left, 0, best);
+        append_leaf_records(right_page, old_left, best, nl);
+        append_leaf_records(right_page, old_right, 0, nr);
     } else {
-        th.bpm->unpin_page(parent_id, false);
+        append_leaf_records(left_page, old_left, 0, nl);
+        append_leaf_records(left_page, old_right, 0, best - nl);
+        append_leaf_records(right_page, old_right, best - nl, nr);
     }
+
+    sep = slot_key(right_page, 0, sep_len);
+    replace_separator(parent, sep_index, sep, sep_len);
+    return true;
 }
 
-static bool is_page_underutilized(Page& page) {
-    PageHeader* ph = get_header(page);
-    if (ph->cell_count == 0) {
-        return true;
+// Entry i of the sequence left entries, (parent separator, right leftmost), right entries
+struct InternalRun {
+    Page& left;
+    Page& right;
+    const uint8_t* sep;
+    uint16_t sep_len;
+    uint16_t nl;
+
+    void entry(uint16_t i, const uint8_t*& key, uint16_t& key_len, uint32_t& child) {
+        if (i < nl) {
+            InternalEntry* e = internal_entry(left, i);
+            key = e->key;
+            key_len = e->key_size;
+            child = e->child_page;
+        } else if (i == nl) {
+            key = sep;
+            key_len = sep_len;
+            child = leftmost_child(right);
+        } else {
+            InternalEntry* e = internal_entry(right, i - nl - 1);
+            key = e->key;
+            key_len = e->key_size;
+            child = e->child_page;
+        }
     }
-    
-    // Calculate actual space used by remaining records (not free_start which doesn't shrink)
-    uint16_t actual_records_size = 0;
-    for (uint16_t i = 0; i < ph->cell_count; i++) {
-        uint16_t* slot = slot_ptr(page, i);
-        if (slot == nullptr) continue;
-        uint16_t offset = *slot;
-        RecordHeader* rh = reinterpret_cast<RecordHeader*>(page.data + offset);
-        actual_records_size += record_size(rh->key_size, rh->value_size);
+};
+
+static void append_internal_entries(Page& page, InternalRun& run, uint16_t from, uint16_t to) {
+    for (uint16_t i = from; i < to; i++) {
+        const uint8_t* key = nullptr;
+        uint16_t key_len = 0;
+        uint32_t child = 0;
+        run.entry(i, key, key_len, child);
+        uint16_t offset = write_internal_entry(page, Key(key, key_len), child);
+        insert_slot(page, get_header(page)->cell_count, offset);
     }
-    
-    uint16_t slots_space = ph->cell_count * sizeof(uint16_t);
-    uint16_t total_used = actual_records_size + slots_space;
-    uint16_t available_space = PAGE_SIZE - sizeof(PageHeader);
-    uint16_t utilization_percent = (total_used * 100) / available_space;
-    
-    return utilization_percent < MERGE_THRESHOLD_PERCENT;
 }
 
-static uint16_t calculate_total_records_size(Page& page) {
-    PageHeader* ph = get_header(page);
-    uint16_t total_size = 0;
-    for (uint16_t i = 0; i < ph->cell_count; i++) {
-        uint16_t* slot = slot_ptr(page, i);
-        if (slot == nullptr) continue;
-        uint16_t offset = *slot;
-        RecordHeader* rh = reinterpret_cast<RecordHeader*>(page.data + offset);
-        total_size += record_size(rh->key_size, rh->value_size);
+static void rebalance_internal(TableHandle& th, uint32_t page_id);
+
+// Merges two adjacent internal pages through their parent separator, or rotates
+// entries between them when the merged page would be too full to stay unsplit
+static void rebalance_internal_pair(TableHandle& th, uint32_t parent_id, Page& parent, const SiblingPair& pair) {
+    Page* left_bp = th.bpm->fetch_page(pair.left);
+    Page* right_bp = th.bpm->fetch_page(pair.right);
+    if (!left_bp || !right_bp) {
+        if (left_bp) th.bpm->unpin_page(pair.left, false);
+        if (right_bp) th.bpm->unpin_page(pair.right, false);
+        th.bpm->unpin_page(parent_id, false);
+        return;
     }
-    return total_size;
-}
 
-static bool can_merge_pages(Page& left_page, Page& right_page) {
-    PageHeader* left_ph = get_header(left_page);
-    PageHeader* right_ph = get_header(right_page);
-    
-    uint16_t left_records_size = calculate_total_records_size(left_page);
-    uint16_t right_records_size = calculate_total_records_size(right_page);
-    uint16_t total_records_size = left_records_size + right_records_size;
-    
-    uint16_t total_slots = left_ph->cell_count + right_ph->cell_count;
-    uint16_t slots_space = total_slots * sizeof(uint16_t);
-    
-    uint16_t total_needed = sizeof(PageHeader) + total_records_size + slots_space;
-    return total_needed <= PAGE_SIZE;
+    Page old_left;
+    Page old_right;
+    std::memcpy(old_left.data, left_bp->data, PAGE_SIZE);
+    std::memcpy(old_right.data, right_bp->data, PAGE_SIZE);
+    InternalEntry* sep_entry = internal_entry(parent, pair.sep_index);
+    uint8_t sep_buf[PAGE_SIZE];
+    std::memcpy(sep_buf, sep_entry->key, sep_entry->key_size);
+    InternalRun run{old_left, old_right, sep_buf, sep_entry->key_size, get_header(old_left)->cell_count};
+    uint16_t total = run.nl + 1 + get_header(old_right)->cell_count;
+    uint32_t entry_slot = slot_entry_size(*left_bp);
+
+    uint32_t merged = page_used_bytes(old_left) + moved_bytes(old_right, entry_slot) +
+                      sizeof(InternalEntry) + run.sep_len + entry_slot;
+    if (fits_after_merge(merged)) {
+        page_compact(*left_bp);
+        append_internal_entries(*left_bp, run, run.nl, total);
+        th.bpm->unpin_page(pair.left, true);
+        th.bpm->unpin_page(pair.right, false);
+        for (uint16_t i = run.nl; i < total; i++) {
+            const uint8_t* key;
+            uint16_t key_len;
+            uint32_t child;
+            run.entry(i, key, key_len, child);
+            set_parent(th, child, pair.left);
+        }
+        remove_slot(parent, pair.sep_index);
+        th.bpm->unpin_page(parent_id, true);
+        free_page(th, pair.right);
+        rebalance_internal(th, parent_id);
+        return;
+    }
+
+    // Left keeps entries [0, m), entry m moves up to the parent, right gets the rest
+    uint32_t all_bytes = 0;
+    for (uint16_t i = 0; i < total; i++) {
+        const uint8_t* key;
+        uint16_t key_len;
+        uint32_t child;
+        run.entry(i, key, key_len, child);
+        all_bytes += sizeof(InternalEntry) + key_len + entry_slot;
+    }
+    uint16_t best = run.nl;
+    uint32_t best_gap = UINT32_MAX;
+    uint32_t left_bytes = 0;
+    for (uint16_t m = 1; m + 1 < total; m++) {
+        const uint8_t* key;
+        uint16_t key_len;
+        uint32_t child;
+        run.entry(m - 1, key, key_len, child);
+        left_bytes += sizeof(InternalEntry) + key_len + entry_slot;
+        run.entry(m, key, key_len, child);
+        uint32_t right_bytes = all_bytes - left_bytes - (sizeof(InternalEntry) + key_len + entry_slot);
+        if (left_bytes > USABLE_PAGE_BYTES || right_bytes > USABLE_PAGE_BYTES ||
+            !separator_fits(parent, pair.sep_index, key_len)) {
+            continue;
+        }
+        uint32_t gap = left_bytes > right_bytes ? left_bytes - right_bytes : right_bytes - left_bytes;
+        if (gap < best_gap) {
+            best_gap = gap;
+            best = m;
+        }
+    }
+    if (best == run.nl) {
+        th.bpm->unpin_page(pair.left, false);
+        th.bpm->unpin_page(pair.right, false);
+        th.bpm->unpin_page(parent_id, false);
+        return;
+    }
+
+    const uint8_t* up_key;
+    uint16_t up_len;
+    uint32_t up_child;
+    run.entry(best, up_key, up_len, up_child);
+
+    reset_page_space(*left_bp);
+    reset_page_space(*right_bp);
+    append_internal_entries(*left_bp, run, 0, best);
+    leftmost_child(*right_bp) = up_child;
+    append_internal_entries(*right_bp, run, best + 1, total);
+    replace_separator(parent, pair.sep_index, up_key, up_len);
+    th.bpm->unpin_page(pair.left, true);
+    th.bpm->unpin_page(pair.right, true);
+    th.bpm->unpin_page(parent_id, true);
+
+    // Children that changed sides follow their new parent
+    uint16_t from = best < run.nl ? best : run.nl;
+    uint16_t to = best < run.nl ? run.nl : best;
+    uint32_t new_parent = best < run.nl ? pair.right : pair.left;
+    for (uint16_t i = from; i < to; i++) {
+        const uint8_t* key;
+        uint16_t key_len;
+        uint32_t child;
+        run.entry(i, key, key_len, child);
+        set_parent(th, child, new_parent);
+    }
 }
 
-static void update_leaf_links_on_free(TableHandle& th, uint32_t freed_page_id, Page& freed_page) {
-    if (!th.bpm) {
+static void rebalance_internal(TableHandle& th, uint32_t page_id) {
+    Page* page = th.bpm->fetch_page(page_id);
+    if (!page) {
         return;
     }
-    PageHeader* ph = get_header(freed_page);
-    if (ph->prev_page_id != 0) {
-        Page* prev_page = th.bpm->fetch_page(ph->prev_page_id);
-        if (prev_page) {
-            get_header(*prev_page)->next_page_id = ph->next_page_id;
-            th.bpm->unpin_page(ph->prev_page_id, true);
+    PageHeader* ph = get_header(*page);
+    uint32_t parent_id = ph->parent_page_id;
+    uint16_t cell_count = ph->cell_count;
+    uint32_t child = leftmost_child(*page);
+    bool underutilized = cell_count == 0 ||
+                         (page_used_bytes(*page) * 100) / USABLE_PAGE_BYTES < MERGE_THRESHOLD_PERCENT;
+    th.bpm->unpin_page(page_id, false);
+
+    if (parent_id == 0) {
+        // A root left with a single child hands the root over to it
+        if (cell_count > 0 || child == 0) {
+            return;
         }
-    }
-    if (ph->next_page_id != 0) {
-        Page* next_page = th.bpm->fetch_page(ph->next_page_id);
-        if (next_page) {
-            get_header(*next_page)->prev_page_id = ph->prev_page_id;
-            th.bpm->unpin_page(ph->next_page_id, true);
+        set_parent(th, child, 0);
+        th.root_page = child;
+        Page* meta = th.bpm->fetch_page(0);
+        if (meta) {
+            get_header(*meta)->root_page = child;
+            th.bpm->unpin_page(0, true);
         }
+        free_page(th, page_id);
+        return;
+    }
+
+    if (!underutilized) {
+        return;
     }
+
+    Page* parent = th.bpm->fetch_page(parent_id);
+    if (!parent) {
+        return;
+    }
+    SiblingPair pair;
+    if (!find_sibling_pair(*parent, page_id, pair)) {
+        th.bpm->unpin_page(parent_id, false);
+        return;
+    }
+    rebalance_internal_pair(th, parent_id, *parent, pair);
 }
 
-static void merge_leaf_pages(TableHandle& th, uint32_t left_page_id, Page& left_page, 
-                             uint32_t right_page_id, Page& right_page) {
-    PageHeader* left_ph = get_header(left_page);
-    PageHeader* right_ph = get_header(right_page);
-    uint32_t saved_prev = left_ph->prev_page_id;
-    uint32_t right_next = right_ph->next_page_id;
-    
-    // Extract all records from both pages (left page may have holes from deletions)
-    struct RecordData {
-        std::vector<uint8_t> data;
-    };
-    std::vector<RecordData> all_records;
-    
-    // Extract from left page
-    for (uint16_t i = 0; i < left_ph->cell_count; i++) {
-        uint16_t offset = *slot_ptr(left_page, i);
-        RecordHeader* rh = reinterpret_cast<RecordHeader*>(left_page.data + offset);
-        uint16_t rec_size = record_size(rh->key_size, rh->value_size);
-        RecordData rd;
-        rd.data.assign(left_page.data + offset, left_page.data + offset + rec_size);
-        all_records.push_back(std::move(rd));
+// Fixes an underutilized leaf: merge with a sibling when the result stays below
+// MERGE_MAX_FILL_PERCENT, otherwise borrow records from it. Returns the page that
+// now holds the leaf's records, or 0 when nothing moved.
+static uint32_t rebalance_leaf(TableHandle& th, uint32_t leaf_page_id, uint32_t parent_id) {
+    Page* parent = th.bpm->fetch_page(parent_id);
+    if (!parent) {
+        return 0;
     }
-    
-    // Extract from right page
-    for (uint16_t i = 0; i < right_ph->cell_count; i++) {
-        uint16_t offset = *slot_ptr(right_page, i);
-        RecordHeader* rh = reinterpret_cast<RecordHeader*>(right_page.data + offset);
-        uint16_t rec_size = record_size(rh->key_size, rh->value_size);
-        RecordData rd;
-        rd.data.assign(right_page.data + offset, right_page.data + offset + rec_size);
-        all_records.push_back(std::move(rd));
+    SiblingPair pair;
+    if (!find_sibling_pair(*parent, leaf_page_id, pair)) {
+        th.bpm->unpin_page(parent_id, false);
+        return 0;
     }
-    
-    // Reinitialize left page (compacts it, removes holes)
-    uint32_t parent_id = left_ph->parent_page_id;
-    init_page(left_page, left_page_id, PageType::DATA, PageLevel::LEAF);
-    left_ph = get_header(left_page);
-    left_ph->parent_page_id = parent_id;
-    left_ph->prev_page_id = saved_prev;
-    left_ph->next_page_id = right_next;
-    if (right_next != 0 && th.bpm) {
-        Page* next_page = th.bpm->fetch_page(right_next);
-        if (next_page) {
-            get_header(*next_page)->prev_page_id = left_page_id;
-            th.bpm->unpin_page(right_next, true);
-        }
+    Page* left_bp = th.bpm->fetch_page(pair.left);
+    Page* right_bp = th.bpm->fetch_page(pair.right);
+    if (!left_bp || !right_bp) {
+        if (left_bp) th.bpm->unpin_page(pair.left, false);
+        if (right_bp) th.bpm->unpin_page(pair.right, false);
+        th.bpm->unpin_page(parent_id, false);
+        return 0;
     }
 
-    // Write all records back
-    for (size_t i = 0; i < all_records.size(); i++) {
-        uint16_t new_offset = write_raw_record(left_page, all_records[i].data.data(), 
-                                                static_cast<uint16_t>(all_records[i].data.size()));
-        left_ph = get_header(left_page);
-        insert_slot(left_page, left_ph->cell_count, new_offset);
+    uint32_t merged = page_used_bytes(*left_bp) + moved_bytes(*right_bp, slot_entry_size(*left_bp));
+    bool either_empty = get_header(*left_bp)->cell_count == 0 || get_header(*right_bp)->cell_count == 0;
+    if (fits_after_merge(merged) || (either_empty && merged <= USABLE_PAGE_BYTES)) {
+        merge_leaf_pages(th, *left_bp, *right_bp);
+        th.bpm->unpin_page(pair.left, true);
+        th.bpm->unpin_page(pair.right, false);
+        remove_slot(*parent, pair.sep_index);
+        th.bpm->unpin_page(parent_id, true);
+        free_page(th, pair.right);
+        rebalance_internal(th, parent_id);
+        return pair.left;
     }
-    
-    if (th.bpm) {
-        Page* left_bp = th.bpm->fetch_page(left_page_id);
-        if (left_bp) {
-            std::memcpy(left_bp->data, left_page.data, PAGE_SIZE);
-            th.bpm->unpin_page(left_page_id, true);
-        }
+
+    bool moved = redistribute_leaves(*left_bp, *right_bp, *parent, pair.sep_index);
+    th.bpm->unpin_page(pair.left, moved);
+    th.bpm->unpin_page(pair.right, moved);
+    th.bpm->unpin_page(parent_id, moved);
+    return moved ? leaf_page_id : 0;
+}
+
+// Empties the tree once its root leaf has no records left
+static void free_root_leaf(TableHandle& th, uint32_t leaf_page_id) {
+    th.root_page = 0;
+    th.rightmost_leaf = 0;
+    Page* meta = th.bpm->fetch_page(0);
+    if (meta) {
+        get_header(*meta)->root_page = 0;
+        th.bpm->unpin_page(0, true);
     }
-    free_page(th, right_page_id);
+    free_page(th, leaf_page_id);
 }
 
-bool btree_delete(TableHandle& th, const Key& key) {
-    if (th.root_page == 0) {
+bool btree_set_deferred_deletes(TableHandle& th, bool enabled) {
+    // Hash and LSM files keep their own deletes, and their metadata, on page 0
+    if (!th.bpm || !th.hash_directory.empty() || th.lsm) {
         return false;
     }
-    
-    Page leaf_page;
-    uint32_t leaf_page_id = find_leaf_page(th, key, leaf_page);
-    
-    if (leaf_page_id == UINT32_MAX) {
+    Page* meta = th.bpm->fetch_page(0);
+    if (!meta) {
         return false;
     }
-    
-    BSearchResult result = search_record(leaf_page, key.data(), key.size());
-    if (!result.found) {
+    PageHeader* ph = get_header(*meta);
+    ph->flags = enabled ? (ph->flags | PAGE_FLAG_DEFERRED_DELETES) : (ph->flags & ~PAGE_FLAG_DEFERRED_DELETES);
+    th.bpm->unpin_page(0, true);
+    th.bpm->flush_page(0);
+    th.deferred_deletes = enabled;
+    return true;
+}
+
+bool btree_delete(TableHandle& th, const Key& key) {
+    if (!th.write_buffer.empty()) {
+        return write_buffer_put(th, key, MSG_DELETE, Value());
+    }
+    if (th.root_page == 0 || !th.bpm) {
         return false;
     }
-    
-    if (!th.bpm) {
+
+    Page leaf_page;
+    uint32_t leaf_page_id = find_leaf_page(th, key, leaf_page);
+    if (leaf_page_id == UINT32_MAX) {
         return false;
     }
+
     Page* leaf_bp = th.bpm->fetch_page(leaf_page_id);
     if (!leaf_bp) {
         return false;
     }
-    bool deleted = page_delete(*leaf_bp, key.data(), key.size());
-    if (!deleted) {
+    BSearchResult result = search_record(*leaf_bp, key.data(), key.size());
+    if (!result.found || slot_is_deleted(*leaf_bp, result.index)) {
         th.bpm->unpin_page(leaf_page_id, false);
         return false;
     }
-    th.bpm->unpin_page(leaf_page_id, true);
-
-    leaf_bp = th.bpm->fetch_page(leaf_page_id);
-    if (!leaf_bp) {
+    if (th.deferred_deletes) {
+        // Tombstone only: one leaf write, no restructuring until btree_compact
+        *slot_flags(*leaf_bp, result.index) |= RECORD_DELETED;
+        th.bpm->unpin_page(leaf_page_id, true);
+        return true;
+    }
+    uint32_t overflow_chain = 0;
+    if (*slot_flags(*leaf_bp, result.index) & RECORD_OVERFLOW) {
+        uint16_t stored_len = 0;
+        const uint8_t* stored = slot_value(*leaf_bp, result.index, stored_len);
+        overflow_chain = overflow_first_page(stored, stored_len);
+    }
+    if (!page_delete(*leaf_bp, key.data(), key.size())) {
+        th.bpm->unpin_page(leaf_page_id, false);
         return false;
     }
-    std::memcpy(leaf_page.data, leaf_bp->data, PAGE_SIZE);
-    PageHeader* ph = get_header(leaf_page);
-    th.bpm->unpin_page(leaf_page_id, false);
+    PageHeader* ph = get_header(*leaf_bp);
+    uint32_t parent_id = ph->parent_page_id;
+    bool empty = ph->cell_count == 0;
+    bool underutilized = is_page_underutilized(*leaf_bp);
+    th.bpm->unpin_page(leaf_page_id, true);
+    overflow_free(th, overflow_chain);
 
-    if (ph->parent_page_id == 0) {
-        if (ph->cell_count == 0) {
-            th.root_page = 0;
-            Page* meta = th.bpm->fetch_page(0);
-            if (meta) {
-                get_header(*meta)->root_page = 0;
-                th.bpm->unpin_page(0, true);
-            }
-            update_leaf_links_on_free(th, leaf_page_id, leaf_page);
-            free_page(th, leaf_page_id);
+    if (parent_id == 0) {
+        if (empty) {
+            free_root_leaf(th, leaf_page_id);
         }
         return true;
     }
 
-    if (is_page_underutilized(leaf_page)) {
-        SiblingInfo siblings = find_leaf_siblings(th, leaf_page_id, leaf_page);
-        uint32_t parent_id = ph->parent_page_id;
+    if (underutilized) {
+        // Merges may free the cached append leaf
+        th.rightmost_leaf = 0;
+        rebalance_leaf(th, leaf_page_id, parent_id);
+    }
+    return true;
+}
 
-        if (siblings.left_sibling != 0) {
-            Page* left_sibling = th.bpm->fetch_page(siblings.left_sibling);
-            if (left_sibling && can_merge_pages(*left_sibling, leaf_page)) {
-                merge_leaf_pages(th, siblings.left_sibling, *left_sibling, leaf_page_id, leaf_page);
-                th.bpm->unpin_page(siblings.left_sibling, false);
-                remove_from_internal(th, parent_id, siblings.separator_key, leaf_page_id);
-                return true;
-            }
-            if (left_sibling) {
-                th.bpm->unpin_page(siblings.left_sibling, false);
-            }
-        }
-        if (siblings.right_sibling != 0) {
-            Page* right_sibling = th.bpm->fetch_page(siblings.right_sibling);
-            if (right_sibling && can_merge_pages(leaf_page, *right_sibling)) {
-                merge_leaf_pages(th, leaf_page_id, leaf_page, siblings.right_sibling, *right_sibling);
-                th.bpm->unpin_page(siblings.right_sibling, false);
-                remove_from_internal(th, parent_id, siblings.right_separator_key, siblings.right_sibling);
-                leaf_bp = th.bpm->fetch_page(leaf_page_id);
-                if (leaf_bp) {
-                    std::memcpy(leaf_page.data, leaf_bp->data, PAGE_SIZE);
-                    th.bpm->unpin_page(leaf_page_id, false);
-                    ph = get_header(leaf_page);
-                }
-            } else if (right_sibling) {
-                th.bpm->unpin_page(siblings.right_sibling, false);
-            }
-        }
+size_t btree_compact(TableHandle& th) {
+    btree_flush_write_buffer(th);
+    if (!th.bpm || th.root_page == 0) {
+        return 0;
+    }
+    Page leaf_page;
+    uint32_t first_leaf = find_leftmost_leaf_page(th, leaf_page);
+    if (first_leaf == UINT32_MAX) {
+        return 0;
     }
 
-    if (ph->cell_count == 0) {
-        SiblingInfo siblings = find_leaf_siblings(th, leaf_page_id, leaf_page);
+    // Pass 1: drop tombstones leaf by leaf without touching the tree shape
+    size_t reclaimed = 0;
+    for (uint32_t page_id = first_leaf; page_id != 0;) {
+        Page* leaf = th.bpm->fetch_page(page_id);
+        if (!leaf) {
+            return reclaimed;
+        }
+        uint16_t removed = purge_tombstones(th, *leaf);
+        reclaimed += removed;
+        uint32_t next_id = get_header(*leaf)->next_page_id;
+        th.bpm->unpin_page(page_id, removed > 0);
+        page_id = next_id;
+    }
+
+    // Pass 2: merge or rebalance underfull leaves from left to right. A leaf that
+    // changed is looked at again, since a merge may leave it underfull.
+    th.rightmost_leaf = 0;
+    uint32_t page_id = first_leaf;
+    while (page_id != 0) {
+        Page* leaf = th.bpm->fetch_page(page_id);
+        if (!leaf) {
+            break;
+        }
+        PageHeader* ph = get_header(*leaf);
+        uint32_t next_id = ph->next_page_id;
         uint32_t parent_id = ph->parent_page_id;
+        bool empty = ph->cell_count == 0;
+        bool underutilized = is_page_underutilized(*leaf);
+        th.bpm->unpin_page(page_id, false);
 
-        if (siblings.is_leftmost) {
-            if (siblings.right_sibling != 0) {
-                Page* right_sibling = th.bpm->fetch_page(siblings.right_sibling);
-                if (right_sibling) {
-                    th.bpm->unpin_page(siblings.right_sibling, false);
-                    merge_leaf_pages(th, leaf_page_id, leaf_page, siblings.right_sibling, *right_sibling);
-                }
-                remove_from_internal(th, parent_id, siblings.right_separator_key, siblings.right_sibling);
-            } else {
-                Page* parent = th.bpm->fetch_page(parent_id);
-                if (parent) {
-                    PageHeader* parent_ph = get_header(*parent);
-                    uint32_t* leftmost_ptr = reinterpret_cast<uint32_t*>(parent_ph->reserved);
-                    *leftmost_ptr = 0;
-                    th.bpm->unpin_page(parent_id, true);
-                }
-                update_leaf_links_on_free(th, leaf_page_id, leaf_page);
-                free_page(th, leaf_page_id);
-            }
-        } else if (siblings.left_sibling != 0) {
-            Page* left_sibling = th.bpm->fetch_page(siblings.left_sibling);
-            if (left_sibling) {
-                th.bpm->unpin_page(siblings.left_sibling, false);
-                merge_leaf_pages(th, siblings.left_sibling, *left_sibling, leaf_page_id, leaf_page);
+        if (parent_id == 0) {
+            if (empty) {
+                free_root_leaf(th, page_id);
             }
-            remove_from_internal(th, parent_id, siblings.separator_key, leaf_page_id);
-        } else if (siblings.right_sibling != 0) {
-            Page* right_sibling = th.bpm->fetch_page(siblings.right_sibling);
-            if (right_sibling) {
-                th.bpm->unpin_page(siblings.right_sibling, false);
-                merge_leaf_pages(th, leaf_page_id, leaf_page, siblings.right_sibling, *right_sibling);
+            break;
+        }
+        if (underutilized) {
+            uint32_t survivor = rebalance_leaf(th, page_id, parent_id);
+            if (survivor != 0) {
+                page_id = survivor;
+                continue;
             }
-            remove_from_internal(th, parent_id, siblings.right_separator_key, siblings.right_sibling);
-        } else {
-            update_leaf_links_on_free(th, leaf_page_id, leaf_page);
-            free_page(th, leaf_page_id);
         }
+        page_id = next_id;
     }
-    
-    return true;
+    return reclaimed;
 }
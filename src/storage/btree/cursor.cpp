@@ -0,0 +1,204 @@
+#include <cstdint>
+#include "storage/page.hpp"
+#include "storage/btree.hpp"
+#include "storage/table_handle.hpp"
+#include "storage/buffer_pool.hpp"
+#include "storage/record.hpp"
+
+BTreeCursor::BTreeCursor(TableHandle& th) : th_(th) {}
+
+BTreeCursor::~BTreeCursor() {
+    close();
+}
+
+void BTreeCursor::close() {
+    unpin();
+}
+
+void BTreeCursor::unpin() {
+    if (page_ != nullptr && th_.bpm) {
+        th_.bpm->unpin_page(page_id_, false);
+    }
+    page_ = nullptr;
+    page_id_ = 0;
+    index_ = 0;
+}
+
+bool BTreeCursor::pin(uint32_t page_id) {
+    if (!th_.bpm || page_id == 0) {
+        return false;
+    }
+    // Pin the new leaf before releasing the old one
+    Page* page = th_.bpm->fetch_page(page_id);
+    if (!page) {
+        return false;
+    }
+    unpin();
+    page_ = page;
+    page_id_ = page_id;
+    index_ = 0;
+    return true;
+}
+
+bool BTreeCursor::descend(const Key* key, bool rightmost) {
+    unpin();
+    btree_flush_write_buffer(th_);
+    if (!th_.bpm || th_.root_page == 0) {
+        return false;
+    }
+    uint32_t page_id = th_.root_page;
+    for (int depth = 0; depth <= 100; depth++) {
+        Page* page = th_.bpm->fetch_page(page_id);
+        if (!page) {
+            return false;
+        }
+        PageHeader* ph = get_header(*page);
+        if (ph->page_level == PageLevel::LEAF) {
+            page_ = page;
+            page_id_ = page_id;
+            index_ = 0;
+            return true;
+        }
+        if (ph->page_level != PageLevel::INTERNAL) {
+            th_.bpm->unpin_page(page_id, false);
+            return false;
+        }
+
+        uint32_t child;
+        if (key != nullptr) {
+            child = internal_find_child(*page, *key);
+        } else if (rightmost && ph->cell_count > 0) {
+            uint16_t offset = *slot_ptr(*page, ph->cell_count - 1);
+            child = reinterpret_cast<InternalEntry*>(page->data + offset)->child_page;
+        } else {
+            child = *reinterpret_cast<uint32_t*>(ph->reserved);
+        }
+        th_.bpm->unpin_page(page_id, false);
+        if (child == 0) {
+            return false;
+        }
+        page_id = child;
+    }
+    return false;
+}
+
+// Moves to the first live entry at or after the current position, crossing leaves
+bool BTreeCursor::skip_forward() {
+    while (page_ != nullptr) {
+        if (index_ >= get_header(*page_)->cell_count) {
+            uint32_t next_id = get_header(*page_)->next_page_id;
+            if (next_id == 0 || !pin(next_id)) {
+                unpin();
+                return false;
+            }
+            continue;
+        }
+        if (!slot_is_deleted(*page_, index_)) {
+            return true;
+        }
+        index_++;
+    }
+    return false;
+}
+
+bool BTreeCursor::seek(const Key& key) {
+    if (key.empty()) {
+        return seek_first();
+    }
+    if (!descend(&key, false)) {
+        return false;
+    }
+    index_ = search_record(*page_, key.data(), key.size()).index;
+    return skip_forward();
+}
+
+bool BTreeCursor::seek_first() {
+    if (!descend(nullptr, false)) {
+        return false;
+    }
+    return skip_forward();
+}
+
+bool BTreeCursor::seek_last() {
+    if (!descend(nullptr, true)) {
+        return false;
+    }
+    index_ = get_header(*page_)->cell_count;
+    return prev();
+}
+
+bool BTreeCursor::next() {
+    if (page_ == nullptr) {
+        return false;
+    }
+    index_++;
+    return skip_forward();
+}
+
+bool BTreeCursor::prev() {
+    if (page_ == nullptr) {
+        return false;
+    }
+    do {
+        while (index_ == 0) {
+            uint32_t prev_id = get_header(*page_)->prev_page_id;
+            if (prev_id == 0 || !pin(prev_id)) {
+                unpin();
+                return false;
+            }
+            index_ = get_header(*page_)->cell_count;
+        }
+        index_--;
+    } while (slot_is_deleted(*page_, index_));
+    return true;
+}
+
+Key BTreeCursor::key() const {
+    if (page_ == nullptr) {
+        return Key();
+    }
+    uint16_t key_len = 0;
+    const uint8_t* key_data = slot_key(*page_, index_, key_len);
+    return key_data ? Key(key_data, key_len) : Key();
+}
+
+Value BTreeCursor::value() const {
+    if (page_ == nullptr) {
+        return Value();
+    }
+    uint16_t value_len = 0;
+    const uint8_t* value_data = slot_value(*page_, index_, value_len);
+    if (value_data == nullptr) {
+        return Value();
+    }
+    if (value_is_overflow()) {
+        if (!overflow_load(th_, value_data, value_len, overflow_value_)) {
+            return Value();
+        }
+        return Value(overflow_value_.data(), overflow_value_.size());
+    }
+    return Value(value_data, value_len);
+}
+
+Value BTreeCursor::inline_value() const {
+    if (page_ == nullptr) {
+        return Value();
+    }
+    uint16_t value_len = 0;
+    const uint8_t* value_data = slot_value(*page_, index_, value_len);
+    if (value_data == nullptr) {
+        return Value();
+    }
+    if (value_is_overflow()) {
+        return Value(value_data + sizeof(OverflowRef), value_len - sizeof(OverflowRef));
+    }
+    return Value(value_data, value_len);
+}
+
+bool BTreeCursor::value_is_overflow() const {
+    if (page_ == nullptr) {
+        return false;
+    }
+    const uint8_t* flags = slot_flags(*page_, index_);
+    return flags != nullptr && (*flags & RECORD_OVERFLOW);
+}
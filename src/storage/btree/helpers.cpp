@@ -5,6 +5,7 @@
 #include "storage/buffer_pool.hpp"
 #include "storage/record.hpp"
 #include <cstring>
+#include <cassert>
 
 uint16_t write_raw_record(Page& page, const uint8_t* raw, uint16_t size) {
     PageHeader* ph = get_header(page);
@@ -23,3 +24,34 @@ uint16_t write_raw_record(Page& page, const uint8_t* raw, uint16_t size) {
     
     return offset;
 }
+
+void append_leaf_records(Page& dst, Page& src, uint16_t from, uint16_t to) {
+    PageHeader* dh = get_header(dst);
+    uint16_t count = to - from;
+    uint16_t entry_size = slot_entry_size(dst);
+    bool copy_prefix = (dh->flags & PAGE_FLAG_KEY_PREFIX) && (get_header(src)->flags & PAGE_FLAG_KEY_PREFIX);
+
+    // Grow the slot directory once for the whole batch
+    uint16_t new_free_end = dh->free_end - count * entry_size;
+    std::memmove(dst.data + new_free_end, dst.data + dh->free_end, dh->cell_count * entry_size);
+    dh->free_end = new_free_end;
+    uint8_t* entry = dst.data + new_free_end + dh->cell_count * entry_size;
+
+    for (uint16_t i = from; i < to; i++, entry += entry_size) {
+        uint16_t src_offset = *slot_ptr(src, i);
+        RecordHeader* rh = reinterpret_cast<RecordHeader*>(src.data + src_offset);
+        uint16_t size = record_size(rh->key_size, rh->value_size);
+        assert(dh->free_start + size <= dh->free_end && "append_leaf_records overflows the page");
+
+        uint16_t offset = dh->free_start;
+        std::memcpy(dst.data + offset, rh, size);
+        dh->free_start += size;
+        std::memcpy(entry, &offset, sizeof(uint16_t));
+        if (dh->flags & PAGE_FLAG_KEY_PREFIX) {
+            uint32_t prefix = copy_prefix ? slot_prefix(src, i)
+                                          : key_prefix(src.data + src_offset + sizeof(RecordHeader), rh->key_size);
+            std::memcpy(entry + sizeof(uint16_t), &prefix, sizeof(prefix));
+        }
+    }
+    dh->cell_count += count;
+}
@@ -24,22 +24,22 @@ static const uint8_t* internal_slot_key(Page& page, uint16_t index, uint16_t& ke
     return page.data + offset + sizeof(InternalEntry);
 }
 
-uint32_t internal_find_child(Page& page, const Key& key) {
+uint32_t internal_find_child(Page& page, const Key& key, uint16_t* out_pos) {
     PageHeader* ph = get_header(page);
     assert(ph->page_level == PageLevel::INTERNAL);
 
     int left = 0;
     int right = ph->cell_count - 1;
     int pos = ph->cell_count;
+    uint32_t prefix = key_prefix(key.data(), key.size());
 
     while(left <= right) {
         int mid = (right + left) / 2;
-        uint16_t mid_key_len;
-        const uint8_t* mid_key = internal_slot_key(page, mid, mid_key_len);
-        if (mid_key == nullptr) {
+        int mid_cmp = 0;
+        if (!compare_slot_key(page, mid, key.data(), key.size(), prefix, mid_cmp)) {
             break;
         }
-        auto cmp = compare_keys(key.data(), key.size(), mid_key, mid_key_len);
+        auto cmp = -mid_cmp;
         if (cmp < 0) {
             pos = mid;
             right = mid - 1;
@@ -47,6 +47,9 @@ uint32_t internal_find_child(Page& page, const Key& key) {
             left = mid + 1;
         }
     }
+    if (out_pos != nullptr) {
+        *out_pos = static_cast<uint16_t>(pos);
+    }
 
     if (pos == 0) {
         uint32_t leftmost_child = *reinterpret_cast<uint32_t*>(ph->reserved);
@@ -78,6 +81,13 @@ uint32_t internal_find_child(Page& page, const Key& key) {
     return 0;
 }
 
+uint32_t internal_child_at(Page& page, uint16_t pos) {
+    if (pos == 0) {
+        return *reinterpret_cast<uint32_t*>(get_header(page)->reserved);
+    }
+    return reinterpret_cast<InternalEntry*>(page.data + *slot_ptr(page, pos - 1))->child_page;
+}
+
 uint16_t write_internal_entry(Page& page, const Key& key, uint32_t child) {
     PageHeader* ph = get_header(page);
     assert(ph->page_level == PageLevel::INTERNAL);
@@ -98,15 +108,14 @@ static BSearchResult internal_search_record(Page& page, const uint8_t* key, uint
     PageHeader* header = get_header(page);
     uint16_t left = 0;
     uint16_t right = header->cell_count;
+    uint32_t prefix = key_prefix(key, key_len);
 
     while (left < right) {
         uint16_t mid = left + (right - left) / 2;
-        uint16_t mid_key_len = 0;
-        const uint8_t* mid_key = internal_slot_key(page, mid, mid_key_len);
-        if (mid_key == nullptr) {
+        int cmp = 0;
+        if (!compare_slot_key(page, mid, key, key_len, prefix, cmp)) {
             return {false, left};
         }
-        int cmp = compare_keys(mid_key, mid_key_len, key, key_len);
         if (cmp < 0) {
             left = mid + 1;
         } else if (cmp > 0) {
@@ -169,10 +178,7 @@ SplitInternalResult split_internal_page(TableHandle& th, Page& page) {
         auto* ieentry = reinterpret_cast<InternalEntry*>(page.data + offset);
         uint16_t size = sizeof(InternalEntry) + ieentry->key_size;
 
-        uint8_t buf[PAGE_SIZE];
-        memcpy(buf, page.data + offset, size);
-
-        uint16_t new_off = write_raw_record(new_page, buf, size);
+        uint16_t new_off = write_raw_record(new_page, page.data + offset, size);
         insert_slot(new_page, get_header(new_page)->cell_count, new_off);
 
         uint32_t child_page_id = ieentry->child_page;
@@ -189,16 +195,31 @@ SplitInternalResult split_internal_page(TableHandle& th, Page& page) {
         *reinterpret_cast<uint32_t*>(get_header(new_page)->reserved) = new_leftmost_child;
     }
 
-    uint16_t num_to_remove = total - mid;
-    for(uint16_t j = 0; j < num_to_remove; j++) {
-        uint16_t last_index = get_header(page)->cell_count - 1;
-        if (last_index >= mid) {
-            remove_slot(page, last_index);
-        } else {
-            break;
+    if (new_leftmost_child != 0 && th.bpm) {
+        // The separator's child becomes the new page's leftmost child
+        Page* child_page = th.bpm->fetch_page(new_leftmost_child);
+        if (child_page) {
+            get_header(*child_page)->parent_page_id = new_pid;
+            th.bpm->unpin_page(new_leftmost_child, true);
         }
     }
 
+    // Rebuild the left half compactly so the space of moved entries is reusable
+    Page left_page;
+    init_page(left_page, ph->page_id, PageType::INDEX, PageLevel::INTERNAL);
+    auto* left_ph = get_header(left_page);
+    left_ph->parent_page_id = ph->parent_page_id;
+    left_ph->root_page = ph->root_page;
+    memcpy(left_ph->reserved, ph->reserved, sizeof(left_ph->reserved));
+    for (uint16_t i = 0; i < mid; i++) {
+        uint16_t offset = *slot_ptr(page, i);
+        auto* ieentry = reinterpret_cast<InternalEntry*>(page.data + offset);
+        uint16_t new_off = write_raw_record(left_page, page.data + offset, sizeof(InternalEntry) + ieentry->key_size);
+        insert_slot(left_page, get_header(left_page)->cell_count, new_off);
+    }
+    memcpy(page.data, left_page.data, PAGE_SIZE);
+    ph = get_header(page);
+
     auto* new_ph = get_header(new_page);
     new_ph->parent_page_id = ph->parent_page_id;
 
@@ -210,7 +231,7 @@ SplitInternalResult split_internal_page(TableHandle& th, Page& page) {
         }
     }
 
-    return { new_pid, sep, page, new_page };
+    return { new_pid, std::move(sep), page, new_page };
 }
 
 void create_new_root(TableHandle& th, uint32_t left, const Key& key, uint32_t right) {
@@ -298,6 +319,35 @@ void insert_into_parent(TableHandle& th, uint32_t left, const Key& key, uint32_t
     }
 
     auto split = split_internal_page(th, *parent);
+
+    // The pending separator goes into whichever half now covers its key range
+    uint32_t target_pid = parent_pid;
+    if (compare_keys(key.data(), key.size(), split.seperator_key.data(), split.seperator_key.size()) >= 0) {
+        target_pid = split.new_page;
+    }
+    Page* target = target_pid == parent_pid ? parent : th.bpm->fetch_page(target_pid);
+    if (target) {
+        BSearchResult target_sr = internal_search_record(*target, key.data(), key.size());
+        if (target_sr.index == 0) {
+            *reinterpret_cast<uint32_t*>(get_header(*target)->reserved) = left;
+        }
+        insert_internal_no_split(*target, key, right);
+        if (target != parent) {
+            th.bpm->unpin_page(target_pid, true);
+        }
+    }
     th.bpm->unpin_page(parent_pid, true);
+
+    Page* right_page = th.bpm->fetch_page(right);
+    if (right_page) {
+        get_header(*right_page)->parent_page_id = target_pid;
+        th.bpm->unpin_page(right, true);
+    }
+    Page* left_child = th.bpm->fetch_page(left);
+    if (left_child) {
+        get_header(*left_child)->parent_page_id = target_pid;
+        th.bpm->unpin_page(left, true);
+    }
+
     insert_into_parent(th, parent_pid, split.seperator_key, split.new_page);
 }
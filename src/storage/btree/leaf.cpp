@@ -77,7 +77,8 @@ uint32_t find_leftmost_leaf_page(TableHandle& th, Page& out_page) {
     }
 }
 
-bool btree_insert_leaf_no_split(TableHandle& th, uint32_t page_id, Page& page, const Key& key, const Value& value) {
+bool btree_insert_leaf_no_split(TableHandle& th, uint32_t page_id, Page& page, const Key& key, const Value& value,
+                                uint8_t flags) {
     if (!th.bpm) {
         return false;
     }
@@ -90,12 +91,30 @@ bool btree_insert_leaf_no_split(TableHandle& th, uint32_t page_id, Page& page, c
         th.bpm->unpin_page(page_id, false);
         return false;
     }
-    page_insert(*p, key.data(), key.size(), value.data(), value.size());
+    page_insert(*p, key.data(), key.size(), value.data(), value.size(), flags);
     th.bpm->unpin_page(page_id, true);
     return true;
 }
 
-SplitLeafResult split_leaf_page(TableHandle& th, Page& page) {
+void split_leaf_records(Page& page, Page& new_page, uint16_t split_idx) {
+    PageHeader* ph = get_header(page);
+    uint16_t total = ph->cell_count;
+    assert(split_idx <= total);
+
+    // Records are copied out of a stack scratch page, so the split never touches the heap
+    Page scratch;
+    std::memcpy(scratch.data, page.data, PAGE_SIZE);
+    ph->cell_count = 0;
+    ph->free_start = sizeof(PageHeader);
+    ph->free_end = PAGE_SIZE;
+
+    append_leaf_records(page, scratch, 0, split_idx);
+    append_leaf_records(new_page, scratch, split_idx, total);
+}
+
+// An append split keeps APPEND_SPLIT_PERCENT of the records on the left so
+// monotonic loads leave nearly full leaves behind instead of half empty ones.
+SplitLeafResult split_leaf_page(TableHandle& th, Page& page, bool append) {
     PageHeader* ph = get_header(page);
     assert(ph->page_level == PageLevel::LEAF);
 
@@ -106,77 +125,30 @@ SplitLeafResult split_leaf_page(TableHandle& th, Page& page) {
     }
 
     uint16_t split_idx = total / 2;
+    if (append) {
+        split_idx = static_cast<uint16_t>((static_cast<uint32_t>(total) * APPEND_SPLIT_PERCENT) / 100);
+        if (split_idx >= total) {
+            split_idx = total - 1;
+        }
+    }
     if (split_idx == 0) {
         split_idx = 1;
     }
 
     uint32_t left_page_id = ph->page_id;
-    uint32_t saved_parent_id = ph->parent_page_id;
     uint32_t old_next_page_id = ph->next_page_id;
 
-    struct Record {
-        std::vector<uint8_t> key;
-        std::vector<uint8_t> value;
-    };
-    std::vector<Record> all_records;
-    
-    for (uint16_t i = 0; i < total; i++) {
-        uint16_t key_len = 0;
-        const uint8_t* key_data = slot_key(page, i, key_len);
-        uint16_t value_len = 0;
-        const uint8_t* value_data = slot_value(page, i, value_len);
-        
-        if (key_data == nullptr || value_data == nullptr) {
-            assert(false && "Failed to read record");
-            return {0, Key()};
-        }
-        
-        Record rec;
-        rec.key.assign(key_data, key_data + key_len);
-        rec.value.assign(value_data, value_data + value_len);
-        all_records.push_back(std::move(rec));
-    }
-
-    init_page(page, left_page_id, PageType::DATA, PageLevel::LEAF);
-    ph = get_header(page);
-    ph->parent_page_id = saved_parent_id;
-
+    // Nothing is touched yet, so a full file leaves the leaf as it was
     uint32_t new_page_id = allocate_page(th);
+    if (new_page_id == INVALID_PAGE_ID) {
+        return {0, Key()};
+    }
     Page new_page;
     init_page(new_page, new_page_id, PageType::DATA, PageLevel::LEAF);
     PageHeader* new_ph = get_header(new_page);
-    new_ph->parent_page_id = saved_parent_id;
-
-    std::vector<uint16_t> left_offsets;
-    for (uint16_t i = 0; i < split_idx; i++) {
-        const auto& rec = all_records[i];
-        uint16_t offset = write_record(page, rec.key.data(), rec.key.size(), rec.value.data(), rec.value.size());
-        left_offsets.push_back(offset);
-    }
-    ph = get_header(page);
-    ph->free_end = PAGE_SIZE - static_cast<uint16_t>(left_offsets.size() * sizeof(uint16_t));
-    for (uint16_t i = 0; i < left_offsets.size(); i++) {
-        uint16_t* slot = reinterpret_cast<uint16_t*>(page.data + ph->free_end + i * sizeof(uint16_t));
-        *slot = left_offsets[i];
-    }
-    ph->cell_count = static_cast<uint16_t>(left_offsets.size());
-
-    std::vector<uint16_t> right_offsets;
-    for (uint16_t i = split_idx; i < total; i++) {
-        const auto& rec = all_records[i];
-        uint16_t offset = write_record(new_page, rec.key.data(), rec.key.size(), rec.value.data(), rec.value.size());
-        right_offsets.push_back(offset);
-    }
-    new_ph = get_header(new_page);
-    new_ph->free_end = PAGE_SIZE - static_cast<uint16_t>(right_offsets.size() * sizeof(uint16_t));
-    for (uint16_t i = 0; i < right_offsets.size(); i++) {
-        uint16_t* slot = reinterpret_cast<uint16_t*>(new_page.data + new_ph->free_end + i * sizeof(uint16_t));
-        *slot = right_offsets[i];
-    }
-    new_ph->cell_count = static_cast<uint16_t>(right_offsets.size());
+    new_ph->parent_page_id = ph->parent_page_id;
 
-    ph = get_header(page);
-    new_ph = get_header(new_page);
+    split_leaf_records(page, new_page, split_idx);
 
     if (ph->cell_count == 0 || new_ph->cell_count == 0) {
         assert(false && "Page is empty after split");
@@ -224,7 +196,7 @@ SplitLeafResult split_leaf_page(TableHandle& th, Page& page) {
 
     return {
         new_page_id,
-        sep_key,
+        std::move(sep_key),
         page,
         new_page
     };
@@ -0,0 +1,118 @@
+#include <cstdint>
+#include "storage/page.hpp"
+#include "storage/btree.hpp"
+#include "storage/table_handle.hpp"
+#include "storage/buffer_pool.hpp"
+#include "storage/record.hpp"
+#include <algorithm>
+#include <vector>
+
+struct MultiSearchBatch {
+    const std::vector<Key>& keys;
+    const std::vector<size_t>& order;   // Indexes into keys, in key order
+    std::vector<Value>& out;
+    std::vector<bool>& out_found;
+    size_t found = 0;
+};
+
+static const Key& batch_key(const MultiSearchBatch& batch, size_t i) {
+    return batch.keys[batch.order[i]];
+}
+
+// Answers keys [lo, hi) of the batch from the subtree rooted at page_id.
+// Every internal page is pinned once per batch and split among its children;
+// each leaf is pinned once and probed for all keys that route to it.
+static void multi_search_subtree(TableHandle& th, uint32_t page_id, MultiSearchBatch& batch,
+                                 size_t lo, size_t hi, int depth) {
+    if (page_id == 0 || depth > 100) {
+        return;
+    }
+    Page* page = th.bpm->fetch_page(page_id);
+    if (!page) {
+        return;
+    }
+    PageHeader* ph = get_header(*page);
+
+    if (ph->page_level == PageLevel::LEAF) {
+        for (size_t i = lo; i < hi; i++) {
+            const Key& key = batch_key(batch, i);
+            BSearchResult r = search_record(*page, key.data(), key.size());
+            if (!r.found || slot_is_deleted(*page, r.index)) {
+                continue;
+            }
+            uint16_t value_len = 0;
+            const uint8_t* value_data = slot_value(*page, r.index, value_len);
+            if (value_data == nullptr) {
+                continue;
+            }
+            if (*slot_flags(*page, r.index) & RECORD_OVERFLOW) {
+                if (!overflow_load(th, value_data, value_len, batch.out[batch.order[i]])) {
+                    continue;
+                }
+            } else {
+                batch.out[batch.order[i]].assign(value_data, value_len);
+            }
+            batch.out_found[batch.order[i]] = true;
+            batch.found++;
+        }
+        th.bpm->unpin_page(page_id, false);
+        return;
+    }
+    if (ph->page_level != PageLevel::INTERNAL) {
+        th.bpm->unpin_page(page_id, false);
+        return;
+    }
+
+    size_t i = lo;
+    while (i < hi) {
+        uint16_t pos = 0;
+        uint32_t child = internal_find_child(*page, batch_key(batch, i), &pos);
+
+        // Keys below the next separator share this child
+        size_t j = i + 1;
+        if (pos < ph->cell_count) {
+            InternalEntry* sep_entry = reinterpret_cast<InternalEntry*>(page->data + *slot_ptr(*page, pos));
+            const uint8_t* sep = reinterpret_cast<const uint8_t*>(sep_entry + 1);
+            uint16_t sep_len = sep_entry->key_size;
+            while (j < hi) {
+                const Key& k = batch_key(batch, j);
+                if (compare_keys(k.data(), k.size(), sep, sep_len) >= 0) {
+                    break;
+                }
+                j++;
+            }
+        } else {
+            j = hi;
+        }
+
+        multi_search_subtree(th, child, batch, i, j, depth + 1);
+        i = j;
+    }
+    th.bpm->unpin_page(page_id, false);
+}
+
+size_t btree_multi_search(TableHandle& th, const std::vector<Key>& keys, std::vector<Value>& out_values,
+                          std::vector<bool>& out_found) {
+    out_values.clear();
+    out_values.resize(keys.size());
+    out_found.assign(keys.size(), false);
+    btree_flush_write_buffer(th);
+    if (!th.bpm || th.root_page == 0 || keys.empty()) {
+        return 0;
+    }
+
+    std::vector<size_t> order(keys.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    auto key_less = [&keys](size_t a, size_t b) {
+        return compare_keys(keys[a].data(), keys[a].size(), keys[b].data(), keys[b].size()) < 0;
+    };
+    if (!std::is_sorted(order.begin(), order.end(), key_less)) {
+        std::stable_sort(order.begin(), order.end(), key_less);
+    }
+
+    MultiSearchBatch batch{keys, order, out_values, out_found};
+    multi_search_subtree(th, th.root_page, batch, 0, order.size(), 0);
+    return batch.found;
+}
@@ -0,0 +1,144 @@
+#include <cstdint>
+#include "storage/page.hpp"
+#include "storage/btree.hpp"
+#include "storage/table_handle.hpp"
+#include "storage/buffer_pool.hpp"
+#include "storage/record.hpp"
+#include <cstring>
+
+static constexpr uint32_t OVERFLOW_PAGE_CAPACITY = PAGE_SIZE - sizeof(PageHeader);
+
+uint32_t overflow_write(TableHandle& th, const uint8_t* data, uint32_t size) {
+    if (!th.bpm || size == 0) {
+        return 0;
+    }
+    uint32_t first_page = 0;
+    uint32_t prev_page = 0;
+    uint32_t written = 0;
+    while (written < size) {
+        uint32_t page_id = allocate_page(th);
+        if (page_id == INVALID_PAGE_ID) {
+            overflow_free(th, first_page);
+            return 0;
+        }
+        Page* page = th.bpm->new_page(page_id, PageType::OVERFLOW, PageLevel::NONE);
+        if (!page) {
+            free_page(th, page_id);
+            overflow_free(th, first_page);
+            return 0;
+        }
+        uint32_t chunk = size - written < OVERFLOW_PAGE_CAPACITY ? size - written : OVERFLOW_PAGE_CAPACITY;
+        std::memcpy(page->data + sizeof(PageHeader), data + written, chunk);
+        PageHeader* ph = get_header(*page);
+        ph->free_start = static_cast<uint16_t>(sizeof(PageHeader) + chunk);
+        ph->prev_page_id = prev_page;
+        th.bpm->unpin_page(page_id, true);
+
+        if (prev_page != 0) {
+            Page* prev = th.bpm->fetch_page(prev_page);
+            if (prev) {
+                get_header(*prev)->next_page_id = page_id;
+                th.bpm->unpin_page(prev_page, true);
+            }
+        } else {
+            first_page = page_id;
+        }
+        prev_page = page_id;
+        written += chunk;
+    }
+    return first_page;
+}
+
+bool overflow_read(TableHandle& th, uint32_t first_page, uint8_t* out, uint32_t size) {
+    if (!th.bpm) {
+        return false;
+    }
+    uint32_t page_id = first_page;
+    uint32_t read = 0;
+    while (read < size) {
+        if (page_id == 0) {
+            return false;
+        }
+        Page* page = th.bpm->fetch_page(page_id);
+        if (!page) {
+            return false;
+        }
+        PageHeader* ph = get_header(*page);
+        if (ph->page_type != PageType::OVERFLOW) {
+            th.bpm->unpin_page(page_id, false);
+            return false;
+        }
+        uint32_t chunk = ph->free_start - sizeof(PageHeader);
+        if (chunk > size - read) {
+            chunk = size - read;
+        }
+        std::memcpy(out + read, page->data + sizeof(PageHeader), chunk);
+        read += chunk;
+        uint32_t next = ph->next_page_id;
+        th.bpm->unpin_page(page_id, false);
+        page_id = next;
+    }
+    return true;
+}
+
+void overflow_free(TableHandle& th, uint32_t first_page) {
+    if (!th.bpm) {
+        return;
+    }
+    uint32_t page_id = first_page;
+    while (page_id != 0) {
+        Page* page = th.bpm->fetch_page(page_id);
+        if (!page) {
+            return;
+        }
+        uint32_t next = get_header(*page)->next_page_id;
+        bool is_overflow = get_header(*page)->page_type == PageType::OVERFLOW;
+        th.bpm->unpin_page(page_id, false);
+        if (!is_overflow) {
+            return;
+        }
+        free_page(th, page_id);
+        page_id = next;
+    }
+}
+
+uint16_t overflow_store(TableHandle& th, const Value& value, uint8_t* stored) {
+    uint16_t prefix_len = value.size() < OVERFLOW_INLINE_PREFIX ? value.size() : OVERFLOW_INLINE_PREFIX;
+    OverflowRef ref;
+    ref.total_size = value.size();
+    ref.first_page = overflow_write(th, value.data() + prefix_len, value.size() - prefix_len);
+    if (ref.first_page == 0) {
+        return 0;
+    }
+    std::memcpy(stored, &ref, sizeof(ref));
+    std::memcpy(stored + sizeof(ref), value.data(), prefix_len);
+    return sizeof(ref) + prefix_len;
+}
+
+bool overflow_load(TableHandle& th, const uint8_t* stored, uint16_t stored_len, Value& value) {
+    if (stored_len < sizeof(OverflowRef)) {
+        return false;
+    }
+    OverflowRef ref;
+    std::memcpy(&ref, stored, sizeof(ref));
+    uint16_t prefix_len = stored_len - sizeof(OverflowRef);
+    if (ref.total_size < prefix_len || ref.total_size > UINT16_MAX) {
+        return false;
+    }
+    std::vector<uint8_t> full(ref.total_size);
+    std::memcpy(full.data(), stored + sizeof(OverflowRef), prefix_len);
+    if (!overflow_read(th, ref.first_page, full.data() + prefix_len, ref.total_size - prefix_len)) {
+        return false;
+    }
+    value.assign(full.data(), static_cast<uint16_t>(full.size()));
+    return true;
+}
+
+uint32_t overflow_first_page(const uint8_t* stored, uint16_t stored_len) {
+    if (stored_len < sizeof(OverflowRef)) {
+        return 0;
+    }
+    OverflowRef ref;
+    std::memcpy(&ref, stored, sizeof(ref));
+    return ref.first_page;
+}
@@ -0,0 +1,459 @@
+#include <cstdint>
+#include "storage/page.hpp"
+#include "storage/btree.hpp"
+#include "storage/table_handle.hpp"
+#include "storage/buffer_pool.hpp"
+#include "storage/record.hpp"
+#include <cstring>
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+extern uint16_t write_internal_entry(Page& page, const Key& key, uint32_t child);
+
+// Vacuum rebuilds the tree bottom-up instead of moving records one at a time. The
+// live records stream from the old leaves into new pages, so memory holds one old
+// leaf, one overflow value and one open page per tree level. The old tree is freed
+// only after the new root is in place. A failure before that frees every new page
+// and leaves the tree as it was.
+//
+// The leaves come from a range of free pages reserved up front, taken in page order,
+// so the leaf chain is contiguous with next_page_id pointing at the next page
+// number. Internal pages and overflow chains come from the pages after that range.
+// The first copy goes above the end of the file, which frees the front for a
+// second copy that lands there, and the free pages left at the end are then cut off.
+
+// A page a level of the new tree is filling, with the smallest key below it
+struct VacuumNode {
+    Page page;
+    uint32_t page_id = 0;
+    Key first_key;
+    bool open = false;
+    uint32_t pages = 0;          // Pages this level has started
+    uint32_t last_written = 0;   // Its last finished page
+};
+
+struct VacuumBuild {
+    TableHandle& th;
+    uint16_t limit;
+    const uint8_t* snapshot;     // Page bitmap from before the build
+    uint32_t leaf_first;
+    uint32_t leaf_end;           // Leaves take the pages free in snapshot within [leaf_first, leaf_end)
+    VacuumNode leaf;
+    uint32_t prev_leaf = 0;
+    uint32_t leaves = 0;         // Leaves written
+    std::deque<VacuumNode> levels;  // Internal levels from the bottom; push_back keeps references valid
+    uint32_t root = 0;
+
+    VacuumBuild(TableHandle& t, uint16_t fill_limit, const uint8_t* bits, uint32_t first, uint32_t end)
+        : th(t), limit(fill_limit), snapshot(bits), leaf_first(first), leaf_end(end) {}
+};
+
+static constexpr uint32_t BITMAP_PAGES = (PAGE_SIZE - sizeof(PageHeader)) * 8;
+
+static bool bit_set(const uint8_t* bits, uint32_t page_id) {
+    return (bits[page_id / 8] & (1 << (page_id % 8))) != 0;
+}
+
+static uint16_t used_bytes(Page& page) {
+    PageHeader* ph = get_header(page);
+    return static_cast<uint16_t>(PAGE_SIZE - sizeof(PageHeader) - (ph->free_end - ph->free_start));
+}
+
+// A record needing need bytes opens a new leaf once the current one has cells and
+// would pass limit
+static bool starts_leaf(uint16_t cells, uint32_t used, uint16_t need, uint16_t limit) {
+    return cells > 0 && used + need > limit;
+}
+
+// Leaves the live records pack into at limit bytes, read by walking the old leaf chain
+static bool count_packed_leaves(TableHandle& th, uint16_t limit, uint32_t& count) {
+    Page leaf;
+    uint32_t page_id = find_leftmost_leaf_page(th, leaf);
+    if (page_id == UINT32_MAX) {
+        return false;
+    }
+    count = 0;
+    uint16_t cells = 0;
+    uint32_t used = 0;
+    while (true) {
+        for (uint16_t i = 0; i < get_header(leaf)->cell_count; i++) {
+            if (*slot_flags(leaf, i) & RECORD_DELETED) {
+                continue;
+            }
+            uint16_t need = stored_entry_size(leaf, i) + NEW_SLOT_ENTRY_SIZE;
+            if (count == 0 || starts_leaf(cells, used, need, limit)) {
+                count++;
+                cells = 0;
+                used = 0;
+            }
+            cells++;
+            used += need;
+        }
+        page_id = get_header(leaf)->next_page_id;
+        if (page_id == 0) {
+            break;
+        }
+        Page* page = th.bpm->fetch_page(page_id);
+        if (!page) {
+            return false;
+        }
+        std::memcpy(leaf.data, page->data, PAGE_SIZE);
+        th.bpm->unpin_page(page_id, false);
+    }
+    count = std::max<uint32_t>(count, 1);  // An empty tree keeps one empty leaf
+    return true;
+}
+
+// Page id just past the count-th page at or above first that is free in bits; 0 when
+// the bitmap has fewer
+static uint32_t reserve_end(const uint8_t* bits, uint32_t first, uint32_t count) {
+    for (uint32_t page_id = first; page_id < BITMAP_PAGES; page_id++) {
+        if (!bit_set(bits, page_id) && --count == 0) {
+            return page_id + 1;
+        }
+    }
+    return 0;
+}
+
+// Next reserved leaf page after page_id, or a page from the allocator once the
+// reserved range runs out
+static uint32_t next_leaf_page(VacuumBuild& b, uint32_t page_id) {
+    for (uint32_t id = std::max(page_id + 1, b.leaf_first); id < b.leaf_end; id++) {
+        if (!bit_set(b.snapshot, id)) {
+            return id;
+        }
+    }
+    return allocate_page(b.th);
+}
+
+static bool write_node(TableHandle& th, VacuumNode& node, PageType type, PageLevel level) {
+    Page* page = th.bpm->new_page(node.page_id, type, level);
+    if (!page) {
+        return false;
+    }
+    std::memcpy(page->data, node.page.data, PAGE_SIZE);
+    th.bpm->unpin_page(node.page_id, true);
+    node.open = false;
+    return true;
+}
+
+static bool finish_internal(VacuumBuild& b, size_t level, bool last);
+
+// Files child under the page level is filling, starting a new one when it is full.
+// Returns the parent's page id, 0 on failure.
+static uint32_t push_child(VacuumBuild& b, size_t level, uint32_t child, const Key& first_key) {
+    if (level == b.levels.size()) {
+        b.levels.emplace_back();
+    }
+    VacuumNode& node = b.levels[level];
+    if (node.open) {
+        Page& page = node.page;
+        uint16_t entry_size = sizeof(InternalEntry) + first_key.size();
+        if (can_insert(page, entry_size) && used_bytes(page) + entry_size + NEW_SLOT_ENTRY_SIZE <= b.limit) {
+            uint16_t offset = write_internal_entry(page, first_key, child);
+            insert_slot(page, get_header(page)->cell_count, offset);
+            return node.page_id;
+        }
+        if (!finish_internal(b, level, false)) {
+            return 0;
+        }
+    }
+    node.page_id = allocate_page(b.th);
+    if (node.page_id == INVALID_PAGE_ID) {
+        return 0;
+    }
+    init_page(node.page, node.page_id, PageType::INDEX, PageLevel::INTERNAL);
+    *reinterpret_cast<uint32_t*>(get_header(node.page)->reserved) = child;
+    node.first_key = Key::owned(first_key.data(), first_key.size());
+    node.open = true;
+    node.pages++;
+    return node.page_id;
+}
+
+// Hands the lone child of a level's last page to the page before it, which may go
+// over the fill limit for it, rather than end the level on a page with no entries
+static bool fold_last_child(VacuumBuild& b, VacuumNode& node) {
+    if (node.pages < 2 || get_header(node.page)->cell_count > 0) {
+        return false;
+    }
+    uint32_t child = internal_child_at(node.page, 0);
+    Page* prev = b.th.bpm->fetch_page(node.last_written);
+    if (!prev) {
+        return false;
+    }
+    uint16_t entry_size = sizeof(InternalEntry) + node.first_key.size();
+    if (!can_insert(*prev, entry_size)) {
+        b.th.bpm->unpin_page(node.last_written, false);
+        return false;
+    }
+    uint16_t offset = write_internal_entry(*prev, node.first_key, child);
+    insert_slot(*prev, get_header(*prev)->cell_count, offset);
+    b.th.bpm->unpin_page(node.last_written, true);
+    Page* child_page = b.th.bpm->fetch_page(child);
+    if (!child_page) {
+        return false;
+    }
+    get_header(*child_page)->parent_page_id = node.last_written;
+    b.th.bpm->unpin_page(child, true);
+    free_page(b.th, node.page_id);
+    node.open = false;
+    return true;
+}
+
+// Writes the page level is filling. At the end of the build the only page of a
+// level is the root; any other page is filed under the level above first.
+static bool finish_internal(VacuumBuild& b, size_t level, bool last) {
+    VacuumNode& node = b.levels[level];
+    if (last && fold_last_child(b, node)) {
+        return true;
+    }
+    uint32_t parent = 0;
+    if (last && node.pages == 1) {
+        b.root = node.page_id;
+    } else {
+        parent = push_child(b, level + 1, node.page_id, node.first_key);
+        if (parent == 0) {
+            return false;
+        }
+    }
+    get_header(node.page)->parent_page_id = parent;
+    node.last_written = node.page_id;
+    return write_node(b.th, node, PageType::INDEX, PageLevel::INTERNAL);
+}
+
+// Writes the open leaf, linked to next_id. A lone leaf at the end is the root.
+static bool finish_leaf(VacuumBuild& b, uint32_t next_id) {
+    VacuumNode& leaf = b.leaf;
+    PageHeader* ph = get_header(leaf.page);
+    ph->prev_page_id = b.prev_leaf;
+    ph->next_page_id = next_id;
+    ph->parent_page_id = 0;
+    if (next_id == 0 && b.leaves == 0) {
+        b.root = leaf.page_id;
+    } else {
+        ph->parent_page_id = push_child(b, 0, leaf.page_id, leaf.first_key);
+        if (ph->parent_page_id == 0) {
+            return false;
+        }
+    }
+    b.prev_leaf = leaf.page_id;
+    b.leaves++;
+    return write_node(b.th, leaf, PageType::DATA, PageLevel::LEAF);
+}
+
+static bool open_leaf(VacuumBuild& b) {
+    uint32_t page_id = next_leaf_page(b, b.leaf.open ? b.leaf.page_id : b.leaf_first - 1);
+    if (page_id == INVALID_PAGE_ID || (b.leaf.open && !finish_leaf(b, page_id))) {
+        return false;
+    }
+    init_page(b.leaf.page, page_id, PageType::DATA, PageLevel::LEAF);
+    b.leaf.page_id = page_id;
+    b.leaf.first_key = Key();
+    b.leaf.open = true;
+    return true;
+}
+
+// Copies record i of an old leaf into the new leaves; an overflow value gets a new chain
+static bool add_record(VacuumBuild& b, Page& old_leaf, uint16_t i) {
+    uint8_t flags = *slot_flags(old_leaf, i);
+    if (flags & RECORD_DELETED) {
+        return true;
+    }
+    uint16_t need = stored_entry_size(old_leaf, i) + NEW_SLOT_ENTRY_SIZE;
+    if ((!b.leaf.open || starts_leaf(get_header(b.leaf.page)->cell_count, used_bytes(b.leaf.page), need, b.limit)) &&
+        !open_leaf(b)) {
+        return false;
+    }
+    Page& leaf = b.leaf.page;
+    if (get_header(leaf)->cell_count == 0) {
+        uint16_t key_len = 0;
+        const uint8_t* key = slot_key(old_leaf, i, key_len);
+        b.leaf.first_key = Key::owned(key, key_len);
+    }
+    append_leaf_records(leaf, old_leaf, i, i + 1);
+    if (!(flags & RECORD_OVERFLOW)) {
+        return true;
+    }
+    uint16_t stored_len = 0;
+    const uint8_t* stored = slot_value(old_leaf, i, stored_len);
+    Value value;
+    if (!overflow_load(b.th, stored, stored_len, value)) {
+        return false;
+    }
+    uint16_t slot = static_cast<uint16_t>(get_header(leaf)->cell_count - 1);
+    uint16_t copy_len = 0;
+    uint8_t* copy = const_cast<uint8_t*>(slot_value(leaf, slot, copy_len));
+    uint8_t fresh[OVERFLOW_STORED_SIZE];
+    uint16_t fresh_len = overflow_store(b.th, value, fresh);
+    if (fresh_len == 0 || fresh_len != copy_len) {
+        if (fresh_len != 0) {
+            overflow_free(b.th, overflow_first_page(fresh, fresh_len));
+        }
+        return false;
+    }
+    std::memcpy(copy, fresh, fresh_len);
+    return true;
+}
+
+// Streams the old leaves into the new tree and closes every level
+static bool build_tree(VacuumBuild& b) {
+    Page old_leaf;
+    uint32_t page_id = find_leftmost_leaf_page(b.th, old_leaf);
+    if (page_id == UINT32_MAX) {
+        return false;
+    }
+    while (true) {
+        for (uint16_t i = 0; i < get_header(old_leaf)->cell_count; i++) {
+            if (!add_record(b, old_leaf, i)) {
+                return false;
+            }
+        }
+        page_id = get_header(old_leaf)->next_page_id;
+        if (page_id == 0) {
+            break;
+        }
+        Page* page = b.th.bpm->fetch_page(page_id);
+        if (!page) {
+            return false;
+        }
+        std::memcpy(old_leaf.data, page->data, PAGE_SIZE);
+        b.th.bpm->unpin_page(page_id, false);
+    }
+    if ((!b.leaf.open && !open_leaf(b)) || !finish_leaf(b, 0)) {
+        return false;
+    }
+    for (size_t level = 0; level < b.levels.size(); level++) {
+        if (b.levels[level].open && !finish_internal(b, level, true)) {
+            return false;
+        }
+    }
+    return b.root != 0;
+}
+
+// Frees the tree under page_id together with the overflow chains of its leaf records
+static void free_tree(TableHandle& th, uint32_t page_id, int depth) {
+    Page* page = page_id == 0 || depth > 100 ? nullptr : th.bpm->fetch_page(page_id);
+    if (!page) {
+        return;
+    }
+    std::vector<uint32_t> children;
+    std::vector<uint32_t> chains;
+    if (get_header(*page)->page_level == PageLevel::LEAF) {
+        for (uint16_t i = 0; i < get_header(*page)->cell_count; i++) {
+            if (*slot_flags(*page, i) & RECORD_OVERFLOW) {
+                uint16_t stored_len = 0;
+                const uint8_t* stored = slot_value(*page, i, stored_len);
+                chains.push_back(overflow_first_page(stored, stored_len));
+            }
+        }
+    } else {
+        for (uint16_t pos = 0; pos <= get_header(*page)->cell_count; pos++) {
+            children.push_back(internal_child_at(*page, pos));
+        }
+    }
+    th.bpm->unpin_page(page_id, false);
+    for (uint32_t chain : chains) {
+        overflow_free(th, chain);
+    }
+    for (uint32_t child : children) {
+        free_tree(th, child, depth + 1);
+    }
+    free_page(th, page_id);
+}
+
+// Copies the tree into new pages, the leaves taken from the lowest free pages at or
+// above first, then switches the root and frees the old tree. On failure the pages
+// the copy took are freed and the tree is left as it was.
+static bool rebuild_tree(TableHandle& th, uint16_t limit, uint32_t first) {
+    uint32_t leaf_count = 0;
+    if (!count_packed_leaves(th, limit, leaf_count)) {
+        return false;
+    }
+    Page* bitmap = th.bpm->fetch_page(1);
+    if (!bitmap) {
+        return false;
+    }
+    uint8_t* bits = bitmap->data + sizeof(PageHeader);
+    std::vector<uint8_t> snapshot(bits, bits + PAGE_SIZE - sizeof(PageHeader));
+    uint32_t leaf_end = reserve_end(bits, first, leaf_count);
+    if (leaf_end == 0) {
+        th.bpm->unpin_page(1, false);
+        return false;
+    }
+    // Fence off every page below the leaf range so the allocator hands out pages
+    // after it for internal pages and overflow chains
+    for (uint32_t page_id = 0; page_id < leaf_end; page_id++) {
+        bits[page_id / 8] |= static_cast<uint8_t>(1 << (page_id % 8));
+    }
+    th.bpm->unpin_page(1, true);
+    th.bpm->flush_page(1);
+
+    VacuumBuild b(th, limit, snapshot.data(), first, leaf_end);
+    bool built = build_tree(b);
+
+    bitmap = th.bpm->fetch_page(1);
+    if (!bitmap) {
+        return false;
+    }
+    bits = bitmap->data + sizeof(PageHeader);
+    if (!built) {
+        // Every page set now but free before was taken by the copy
+        for (uint32_t page_id = 3; page_id < BITMAP_PAGES; page_id++) {
+            if (bit_set(bits, page_id) && !bit_set(snapshot.data(), page_id)) {
+                th.bpm->delete_page(page_id);
+            }
+        }
+        std::memcpy(bits, snapshot.data(), snapshot.size());
+        th.bpm->unpin_page(1, true);
+        th.bpm->flush_page(1);
+        return false;
+    }
+    // Give back the fenced pages and the reserved leaf pages the copy did not use
+    for (uint32_t page_id = 0; page_id < leaf_end; page_id++) {
+        bool used_leaf = page_id >= first && page_id <= b.prev_leaf;
+        if (!bit_set(snapshot.data(), page_id) && !used_leaf) {
+            bits[page_id / 8] &= static_cast<uint8_t>(~(1 << (page_id % 8)));
+        }
+    }
+    th.bpm->unpin_page(1, true);
+
+    // The new pages reach the file before the meta page points at them
+    th.bpm->flush_all();
+    uint32_t old_root = th.root_page;
+    Page* meta = th.bpm->fetch_page(0);
+    if (!meta) {
+        return false;
+    }
+    get_header(*meta)->root_page = b.root;
+    th.bpm->unpin_page(0, true);
+    th.bpm->flush_page(0);
+    th.root_page = b.root;
+    th.rightmost_leaf = 0;
+    free_tree(th, old_root, 0);
+    return true;
+}
+
+uint32_t btree_vacuum(TableHandle& th, uint16_t fill_percent) {
+    btree_flush_write_buffer(th);
+    if (!th.bpm || fill_percent == 0 || fill_percent > 100) {
+        return 0;
+    }
+    if (write_buffer_pending(th)) {
+        return 0;  // Messages the tree could not take yet would be lost
+    }
+    // Measured against the file's extent including pages not yet written back
+    uint32_t pages_before = th.bpm->file_page_count();
+    if (th.root_page != 0) {
+        uint16_t limit = static_cast<uint16_t>((PAGE_SIZE - sizeof(PageHeader)) * fill_percent / 100);
+        bool moved = rebuild_tree(th, limit, pages_before) && rebuild_tree(th, limit, 3);
+        if (!moved) {
+            th.bpm->flush_all();
+            release_free_tail(th);
+            return 0;
+        }
+    }
+    th.bpm->flush_all();
+    release_free_tail(th);
+    return pages_before - std::min(pages_before, th.bpm->file_page_count());
+}
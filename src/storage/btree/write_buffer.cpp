@@ -0,0 +1,366 @@
+#include <cstdint>
+#include "storage/page.hpp"
+#include "storage/btree.hpp"
+#include "storage/hash_index.hpp"
+#include "storage/table_handle.hpp"
+#include "storage/buffer_pool.hpp"
+#include "storage/record.hpp"
+#include <algorithm>
+#include <vector>
+
+// Buffered messages are records in slotted buffer pages: the key, then a value of
+// one WriteMessage byte followed by the payload. A key hashes to one buffer page,
+// so a lookup probes a single page and a key has at most one pending message.
+
+struct BufferedMessage {
+    std::vector<uint8_t> key;
+    WriteMessage op;
+    std::vector<uint8_t> value;
+};
+
+// Largest message kept in the buffer; bigger ones bypass it
+static constexpr uint16_t MAX_BUFFERED_RECORD = PAGE_SIZE / 4;
+
+static uint32_t buffer_page_for(const TableHandle& th, const Key& key) {
+    return th.write_buffer[hash_key(key.data(), key.size()) % th.write_buffer.size()];
+}
+
+static bool store_buffer_meta(TableHandle& th) {
+    Page* meta = th.bpm->fetch_page(0);
+    if (!meta) {
+        return false;
+    }
+    WriteBufferMeta* wb = reinterpret_cast<WriteBufferMeta*>(meta->data + sizeof(PageHeader));
+    wb->magic = th.write_buffer.empty() ? 0 : WRITE_BUFFER_MAGIC;
+    wb->page_count = static_cast<uint32_t>(th.write_buffer.size());
+    std::copy(th.write_buffer.begin(), th.write_buffer.end(), reinterpret_cast<uint32_t*>(wb + 1));
+    th.bpm->unpin_page(0, true);
+    th.bpm->flush_page(0);
+    return true;
+}
+
+bool btree_enable_write_buffer(TableHandle& th, uint16_t pages) {
+    constexpr size_t max_pages = (PAGE_SIZE - sizeof(PageHeader) - sizeof(WriteBufferMeta)) / sizeof(uint32_t);
+    // Hash and LSM files keep their own metadata where WriteBufferMeta would go
+    if (!th.bpm || !th.write_buffer.empty() || !th.hash_directory.empty() || th.lsm || pages == 0 ||
+        pages > max_pages) {
+        return false;
+    }
+    std::vector<uint32_t> ids;
+    for (uint16_t i = 0; i < pages; i++) {
+        uint32_t page_id = allocate_page(th);
+        Page* page = page_id == INVALID_PAGE_ID ? nullptr : th.bpm->new_page(page_id, PageType::INDEX, PageLevel::LEAF);
+        if (!page) {
+            for (uint32_t id : ids) {
+                free_page(th, id);
+            }
+            return false;
+        }
+        th.bpm->unpin_page(page_id, true);
+        ids.push_back(page_id);
+    }
+    th.write_buffer = std::move(ids);
+    return store_buffer_meta(th);
+}
+
+// True while any buffer page still holds a message
+bool write_buffer_pending(TableHandle& th) {
+    for (uint32_t page_id : th.write_buffer) {
+        Page* page = th.bpm->fetch_page(page_id);
+        if (!page) {
+            return true;
+        }
+        bool empty = get_header(*page)->cell_count == 0;
+        th.bpm->unpin_page(page_id, false);
+        if (!empty) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool btree_disable_write_buffer(TableHandle& th) {
+    if (!th.bpm || th.write_buffer.empty()) {
+        return false;
+    }
+    btree_flush_write_buffer(th);
+    if (write_buffer_pending(th)) {
+        return false;
+    }
+    std::vector<uint32_t> pages;
+    pages.swap(th.write_buffer);
+    for (uint32_t page_id : pages) {
+        free_page(th, page_id);
+    }
+    return store_buffer_meta(th);
+}
+
+bool write_buffer_find(TableHandle& th, const Key& key, WriteMessage& op, Value& value) {
+    uint32_t page_id = buffer_page_for(th, key);
+    Page* page = th.bpm->fetch_page(page_id);
+    if (!page) {
+        return false;
+    }
+    BSearchResult r = search_record(*page, key.data(), key.size());
+    uint16_t len = 0;
+    const uint8_t* data = r.found ? slot_value(*page, r.index, len) : nullptr;
+    bool found = data != nullptr && len > 0;
+    if (found) {
+        op = static_cast<WriteMessage>(data[0]);
+        value.assign(data + 1, len - 1);
+    }
+    th.bpm->unpin_page(page_id, false);
+    return found;
+}
+
+// Applies one message straight to the tree, with the buffer detached. A put of a
+// live key and an update or delete of a missing key do nothing. Returns false only
+// when the tree could not take the message.
+static bool apply_message(TableHandle& th, const Key& key, WriteMessage op, const Value& value) {
+    Value current;
+    if (op == MSG_PUT) {
+        return btree_insert(th, key, value) || btree_search(th, key, current);
+    }
+    if (op == MSG_UPSERT) {
+        return btree_insert(th, key, value) || btree_update(th, key, value);
+    }
+    bool applied = op == MSG_UPDATE ? btree_update(th, key, value) : btree_delete(th, key);
+    return applied || !btree_search(th, key, current);
+}
+
+// Messages too large for a buffer page go straight to the tree, after the buffer is
+// flushed so an older message for the key cannot land on top of them. With nothing
+// pending, a put gets the tree's own answer.
+static bool write_buffer_bypass(TableHandle& th, const Key& key, WriteMessage op, const Value& value) {
+    btree_flush_write_buffer(th);
+    if (write_buffer_pending(th)) {
+        return false;
+    }
+    std::vector<uint32_t> pages;
+    pages.swap(th.write_buffer);
+    bool ok = op == MSG_PUT ? btree_insert(th, key, value) : apply_message(th, key, op, value);
+    th.write_buffer.swap(pages);
+    return ok;
+}
+
+bool write_buffer_put(TableHandle& th, const Key& key, WriteMessage op, const Value& value) {
+    if (!th.bpm || key.empty()) {
+        return false;
+    }
+    if (value.size() > OVERFLOW_THRESHOLD || record_size(key.size(), value.size() + 1) > MAX_BUFFERED_RECORD) {
+        return write_buffer_bypass(th, key, op, value);
+    }
+    uint8_t message[MAX_BUFFERED_RECORD];
+    if (!value.empty()) {
+        std::memcpy(message + 1, value.data(), value.size());
+    }
+    uint16_t message_len = static_cast<uint16_t>(value.size() + 1);
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        uint32_t page_id = buffer_page_for(th, key);
+        Page* page = th.bpm->fetch_page(page_id);
+        if (!page) {
+            return false;
+        }
+        BSearchResult r = search_record(*page, key.data(), key.size());
+        if (r.found) {
+            // The newer message replaces the pending one. An update is dropped after a
+            // delete and turns a put into an upsert, as does a put after a delete
+            uint16_t len = 0;
+            const uint8_t* pending = slot_value(*page, r.index, len);
+            WriteMessage pending_op = static_cast<WriteMessage>(pending[0]);
+            if (op == MSG_UPDATE && pending_op == MSG_DELETE) {
+                th.bpm->unpin_page(page_id, false);
+                return true;
+            }
+            if ((op == MSG_UPDATE && (pending_op == MSG_PUT || pending_op == MSG_UPSERT)) ||
+                (op == MSG_PUT && pending_op == MSG_DELETE)) {
+                op = MSG_UPSERT;
+            }
+            page_delete(*page, key.data(), key.size());
+        }
+        message[0] = op;
+        bool stored = page_insert(*page, key.data(), key.size(), message, message_len);
+        if (!stored) {
+            page_compact(*page);
+            stored = page_insert(*page, key.data(), key.size(), message, message_len);
+        }
+        th.bpm->unpin_page(page_id, true);
+        if (stored) {
+            return true;
+        }
+        // The merged message already accounts for any pending one dropped above
+        btree_flush_write_buffer(th);
+    }
+    return false;
+}
+
+// Dirtied pages a flush lets pile up before writing them back with a single sync
+static constexpr size_t WRITE_BACK_GROUP = 32;
+
+// Applies messages [lo, hi) that route to the subtree at page_id, changing leaves
+// in place only. Messages that would reshape the tree (splits, deletes, overflow
+// values) are left for the caller to apply one by one.
+static void apply_in_place(TableHandle& th, uint32_t page_id, const std::vector<BufferedMessage>& msgs,
+                           size_t lo, size_t hi, std::vector<size_t>& leftovers, size_t& dirtied, int depth) {
+    Page* page = page_id == 0 || depth > 100 ? nullptr : th.bpm->fetch_page(page_id);
+    if (!page) {
+        for (size_t i = lo; i < hi; i++) {
+            leftovers.push_back(i);
+        }
+        return;
+    }
+    PageHeader* ph = get_header(*page);
+
+    if (ph->page_level == PageLevel::LEAF) {
+        bool dirty = false;
+        for (size_t i = lo; i < hi; i++) {
+            const BufferedMessage& m = msgs[i];
+            uint16_t key_len = static_cast<uint16_t>(m.key.size());
+            uint16_t value_len = static_cast<uint16_t>(m.value.size());
+            BSearchResult r = search_record(*page, m.key.data(), key_len);
+            bool live = r.found && !slot_is_deleted(*page, r.index);
+            if (m.op == MSG_PUT && live) {
+                continue;
+            }
+            if (m.op == MSG_DELETE || (m.op == MSG_UPDATE && !live)) {
+                if (live) {
+                    leftovers.push_back(i);
+                }
+                continue;
+            }
+            if (r.found && (*slot_flags(*page, r.index) & RECORD_OVERFLOW)) {
+                leftovers.push_back(i);
+                continue;
+            }
+            if (r.found && page_update(*page, m.key.data(), key_len, m.value.data(), value_len)) {
+                *slot_flags(*page, search_record(*page, m.key.data(), key_len).index) &= ~RECORD_DELETED;
+                dirty = true;
+            } else if (!r.found && page_insert(*page, m.key.data(), key_len, m.value.data(), value_len)) {
+                dirty = true;
+            } else {
+                leftovers.push_back(i);
+            }
+        }
+        th.bpm->unpin_page(page_id, dirty);
+        if (dirty && ++dirtied % WRITE_BACK_GROUP == 0) {
+            th.bpm->flush_all();
+        }
+        return;
+    }
+    if (ph->page_level != PageLevel::INTERNAL) {
+        th.bpm->unpin_page(page_id, false);
+        return;
+    }
+
+    size_t i = lo;
+    while (i < hi) {
+        Key key(msgs[i].key.data(), static_cast<uint16_t>(msgs[i].key.size()));
+        uint16_t pos = 0;
+        uint32_t child = internal_find_child(*page, key, &pos);
+
+        // Messages below the next separator share this child
+        size_t j = i + 1;
+        if (pos < ph->cell_count) {
+            InternalEntry* sep_entry = reinterpret_cast<InternalEntry*>(page->data + *slot_ptr(*page, pos));
+            const uint8_t* sep = reinterpret_cast<const uint8_t*>(sep_entry + 1);
+            while (j < hi && compare_keys(msgs[j].key.data(), static_cast<uint16_t>(msgs[j].key.size()),
+                                          sep, sep_entry->key_size) < 0) {
+                j++;
+            }
+        } else {
+            j = hi;
+        }
+        apply_in_place(th, child, msgs, i, j, leftovers, dirtied, depth + 1);
+        i = j;
+    }
+    th.bpm->unpin_page(page_id, false);
+}
+
+size_t btree_flush_write_buffer(TableHandle& th) {
+    if (!th.bpm || th.write_buffer.empty()) {
+        return 0;
+    }
+    // Detach the buffer so the tree operations below write straight to the leaves
+    std::vector<uint32_t> pages;
+    pages.swap(th.write_buffer);
+
+    std::vector<BufferedMessage> msgs;
+    bool all_read = true;
+    for (uint32_t page_id : pages) {
+        Page* page = th.bpm->fetch_page(page_id);
+        if (!page) {
+            all_read = false;
+            continue;
+        }
+        for (uint16_t i = 0; i < get_header(*page)->cell_count; i++) {
+            uint16_t key_len = 0;
+            uint16_t len = 0;
+            const uint8_t* key = slot_key(*page, i, key_len);
+            const uint8_t* data = slot_value(*page, i, len);
+            if (key == nullptr || data == nullptr || len == 0) {
+                continue;
+            }
+            msgs.push_back({std::vector<uint8_t>(key, key + key_len), static_cast<WriteMessage>(data[0]),
+                            std::vector<uint8_t>(data + 1, data + len)});
+        }
+        th.bpm->unpin_page(page_id, false);
+    }
+    std::sort(msgs.begin(), msgs.end(), [](const BufferedMessage& a, const BufferedMessage& b) {
+        return compare_keys(a.key.data(), static_cast<uint16_t>(a.key.size()),
+                            b.key.data(), static_cast<uint16_t>(b.key.size())) < 0;
+    });
+
+    // Batch pass: each leaf is pinned once for all of its messages, and the leaves
+    // it dirties go back to disk a group at a time rather than one sync per eviction
+    std::vector<size_t> leftovers;
+    size_t dirtied = 0;
+    if (th.root_page != 0) {
+        apply_in_place(th, th.root_page, msgs, 0, msgs.size(), leftovers, dirtied, 0);
+    } else {
+        for (size_t i = 0; i < msgs.size(); i++) {
+            leftovers.push_back(i);
+        }
+    }
+    std::vector<size_t> failed;
+    for (size_t i : leftovers) {
+        const BufferedMessage& m = msgs[i];
+        Key key(m.key.data(), static_cast<uint16_t>(m.key.size()));
+        Value value(m.value.data(), static_cast<uint16_t>(m.value.size()));
+        if (!apply_message(th, key, m.op, value)) {
+            failed.push_back(i);
+        }
+        if (++dirtied % WRITE_BACK_GROUP == 0) {
+            th.bpm->flush_all();
+        }
+    }
+
+    // Only now do the messages leave the buffer: all at once when every one landed,
+    // otherwise one by one so the failed and unread ones stay pending
+    th.write_buffer.swap(pages);
+    if (failed.empty() && all_read) {
+        for (uint32_t page_id : th.write_buffer) {
+            Page* page = th.bpm->fetch_page(page_id);
+            if (page) {
+                init_page(*page, page_id, PageType::INDEX, PageLevel::LEAF);
+                th.bpm->unpin_page(page_id, true);
+            }
+        }
+        return msgs.size();
+    }
+    std::sort(failed.begin(), failed.end());
+    for (size_t i = 0, f = 0; i < msgs.size(); i++) {
+        if (f < failed.size() && failed[f] == i) {
+            f++;
+            continue;
+        }
+        Key key(msgs[i].key.data(), static_cast<uint16_t>(msgs[i].key.size()));
+        uint32_t page_id = buffer_page_for(th, key);
+        Page* page = th.bpm->fetch_page(page_id);
+        if (page) {
+            page_delete(*page, key.data(), key.size());
+            th.bpm->unpin_page(page_id, true);
+        }
+    }
+    return msgs.size() - failed.size();
+}
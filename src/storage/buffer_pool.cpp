@@ -159,16 +159,62 @@ bool BufferPoolManager::flush_page(uint32_t page_id) {
 }
 
 void BufferPoolManager::flush_all() {
+    bool written = false;
     for (auto& [page_id, frame_id] : page_table_) {
         Frame& frame = frames_[frame_id];
         if (frame.dirty) {
             try {
-                disk_manager_.write_page(static_cast<int>(page_id), frame.page.data);
+                disk_manager_.write_page(static_cast<int>(page_id), frame.page.data, false);
                 frame.dirty = false;
+                written = true;
             } catch (const std::exception&) {
             }
         }
     }
+    if (written) {
+        try {
+            disk_manager_.flush();
+        } catch (const std::exception&) {
+        }
+    }
+}
+
+bool BufferPoolManager::truncate(uint32_t page_count) {
+    std::vector<uint32_t> dropped;
+    for (const auto& [page_id, frame_id] : page_table_) {
+        if (page_id < page_count) {
+            continue;
+        }
+        if (frames_[frame_id].pin_count > 0) {
+            return false;
+        }
+        dropped.push_back(page_id);
+    }
+    for (uint32_t page_id : dropped) {
+        delete_page(page_id);
+    }
+    try {
+        if (disk_manager_.page_count() > page_count) {
+            disk_manager_.truncate(page_count);
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+uint32_t BufferPoolManager::file_page_count() {
+    uint32_t count = 0;
+    try {
+        count = disk_manager_.page_count();
+    } catch (const std::exception&) {
+        return 0;
+    }
+    // Pages created in the pool but not written yet still count
+    for (const auto& [page_id, frame_id] : page_table_) {
+        count = std::max(count, page_id + 1);
+    }
+    return count;
 }
 
 size_t BufferPoolManager::get_pinned_count() const {
@@ -236,9 +282,14 @@ bool BufferPoolManager::evict_frame(size_t frame_id) {
     return true;
 }
 
+// A frame already on the list is spliced to the front, so a hit never allocates
 void BufferPoolManager::mark_frame_used(size_t frame_id) {
-    remove_from_lru(frame_id);
-    lru_list_.push_front(frame_id);
+    auto it = std::find(lru_list_.begin(), lru_list_.end(), frame_id);
+    if (it != lru_list_.end()) {
+        lru_list_.splice(lru_list_.begin(), lru_list_, it);
+    } else {
+        lru_list_.push_front(frame_id);
+    }
 }
 
 void BufferPoolManager::remove_from_lru(size_t frame_id) {
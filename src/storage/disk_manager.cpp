@@ -69,7 +69,7 @@ void DiskManager::read_page(int page_id, uint8_t* page_data) {
     }
 }
 
-void DiskManager::write_page(int page_id, const void* page_data) {
+void DiskManager::write_page(int page_id, const void* page_data, bool sync) {
     long offset = static_cast<long>(page_id * PAGE_SIZE);
     long required_size = offset + PAGE_SIZE;
     
@@ -87,7 +87,9 @@ void DiskManager::write_page(int page_id, const void* page_data) {
         if (extend_bytes != 1) {
             throw std::runtime_error("Failed to extend file");
         }
-        _commit(file_descriptor);
+        if (sync) {
+            _commit(file_descriptor);
+        }
     }
 
     if (lseek(file_descriptor, offset, SEEK_SET) < 0) {
@@ -100,11 +102,34 @@ void DiskManager::write_page(int page_id, const void* page_data) {
         throw std::runtime_error("Failed to write the complete page");
     }
     
-    _commit(file_descriptor);
+    if (sync) {
+        _commit(file_descriptor);
+    }
 }
 
 void DiskManager::flush() {
     if (_commit(file_descriptor) < 0) {
         throw std::runtime_error("Failed to flush data to disk");
     }
-}
\ No newline at end of file
+}
+
+uint32_t DiskManager::page_count() {
+    long size = lseek(file_descriptor, 0, SEEK_END);
+    if (size < 0) {
+        throw std::runtime_error("Failed to get file size");
+    }
+    return static_cast<uint32_t>((size + PAGE_SIZE - 1) / PAGE_SIZE);
+}
+
+void DiskManager::truncate(uint32_t page_count) {
+    long size = static_cast<long>(page_count) * PAGE_SIZE;
+    #ifdef _WIN32
+    int result = _chsize(file_descriptor, size);
+    #else
+    int result = ftruncate(file_descriptor, size);
+    #endif
+    if (result != 0) {
+        throw std::runtime_error("Failed to truncate file");
+    }
+    _commit(file_descriptor);
+}
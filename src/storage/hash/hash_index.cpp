@@ -0,0 +1,470 @@
+#include "storage/hash_index.hpp"
+#include "storage/buffer_pool.hpp"
+#include "storage/page.hpp"
+#include "storage/record.hpp"
+#include <cstring>
+#include <unordered_set>
+
+static HashMeta* hash_meta(Page& meta) {
+    return reinterpret_cast<HashMeta*>(meta.data + sizeof(PageHeader));
+}
+
+static uint32_t* meta_dir_pages(Page& meta) {
+    return reinterpret_cast<uint32_t*>(meta.data + sizeof(PageHeader) + sizeof(HashMeta));
+}
+
+static uint32_t* dir_entries(Page& page) {
+    return reinterpret_cast<uint32_t*>(page.data + sizeof(PageHeader));
+}
+
+static uint8_t& local_depth(Page& bucket) {
+    return get_header(bucket)->reserved[0];
+}
+
+// Deepest directory the meta page can describe
+static uint8_t max_global_depth() {
+    uint64_t capacity = static_cast<uint64_t>(HASH_MAX_DIR_PAGES) * HASH_DIR_ENTRIES_PER_PAGE;
+    uint8_t depth = 0;
+    while (depth < 31 && (uint64_t{2} << depth) <= capacity) {
+        depth++;
+    }
+    return depth;
+}
+
+static uint8_t global_depth(const TableHandle& th) {
+    uint8_t depth = 0;
+    while ((size_t{1} << depth) < th.hash_directory.size()) {
+        depth++;
+    }
+    return depth;
+}
+
+static uint32_t bucket_for(const TableHandle& th, uint64_t hash) {
+    return th.hash_directory[hash & (th.hash_directory.size() - 1)];
+}
+
+uint64_t hash_key(const uint8_t* key, uint16_t key_len) {
+    // FNV-1a, then the murmur3 finalizer so the low bits used by the directory mix well
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (uint16_t i = 0; i < key_len; i++) {
+        h = (h ^ key[i]) * 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Writes directory slots first, first + stride, ... from the cached directory to its pages
+static bool store_directory(TableHandle& th, size_t first, size_t stride) {
+    Page* meta = th.bpm->fetch_page(0);
+    if (!meta) {
+        return false;
+    }
+    const uint32_t* dir_pages = meta_dir_pages(*meta);
+    uint32_t current = UINT32_MAX;
+    Page* page = nullptr;
+    bool ok = true;
+    for (size_t slot = first; slot < th.hash_directory.size(); slot += stride) {
+        uint32_t index = static_cast<uint32_t>(slot / HASH_DIR_ENTRIES_PER_PAGE);
+        if (index != current) {
+            if (page) {
+                th.bpm->unpin_page(dir_pages[current], true);
+            }
+            current = index;
+            page = th.bpm->fetch_page(dir_pages[current]);
+            if (!page) {
+                ok = false;
+                break;
+            }
+        }
+        dir_entries(*page)[slot % HASH_DIR_ENTRIES_PER_PAGE] = th.hash_directory[slot];
+    }
+    if (page) {
+        th.bpm->unpin_page(dir_pages[current], true);
+    }
+    th.bpm->unpin_page(0, false);
+    return ok;
+}
+
+// Doubles the directory, adding directory pages as needed; the new upper half
+// points at the same buckets as the lower half
+static bool double_directory(TableHandle& th) {
+    size_t size = th.hash_directory.size();
+    uint8_t depth = global_depth(th);
+    if (depth >= max_global_depth()) {
+        return false;
+    }
+    Page* meta = th.bpm->fetch_page(0);
+    if (!meta) {
+        return false;
+    }
+    HashMeta* hm = hash_meta(*meta);
+    uint32_t needed = static_cast<uint32_t>((size * 2 + HASH_DIR_ENTRIES_PER_PAGE - 1) / HASH_DIR_ENTRIES_PER_PAGE);
+    while (hm->dir_page_count < needed) {
+        uint32_t page_id = allocate_page(th);
+        Page* page = page_id == INVALID_PAGE_ID ? nullptr : th.bpm->new_page(page_id, PageType::INDEX, PageLevel::NONE);
+        if (!page) {
+            th.bpm->unpin_page(0, true);
+            return false;
+        }
+        th.bpm->unpin_page(page_id, true);
+        meta_dir_pages(*meta)[hm->dir_page_count++] = page_id;
+    }
+    hm->global_depth = depth + 1;
+    th.bpm->unpin_page(0, true);
+
+    th.hash_directory.resize(size * 2);
+    std::copy(th.hash_directory.begin(), th.hash_directory.begin() + size, th.hash_directory.begin() + size);
+    return store_directory(th, size, 1);
+}
+
+// Splits a bucket on the next hash bit. low_bits is the hash of any key that maps to it.
+static bool split_bucket(TableHandle& th, uint32_t bucket_id, uint64_t low_bits) {
+    Page* bucket = th.bpm->fetch_page(bucket_id);
+    if (!bucket) {
+        return false;
+    }
+    uint8_t depth = local_depth(*bucket);
+    if (depth >= max_global_depth() || get_header(*bucket)->next_page_id != 0 ||
+        (depth == global_depth(th) && !double_directory(th))) {
+        th.bpm->unpin_page(bucket_id, false);
+        return false;
+    }
+    uint32_t sibling_id = allocate_page(th);
+    Page* sibling = sibling_id == INVALID_PAGE_ID ? nullptr : th.bpm->new_page(sibling_id, PageType::INDEX, PageLevel::LEAF);
+    if (!sibling) {
+        th.bpm->unpin_page(bucket_id, false);
+        return false;
+    }
+
+    Page old = *bucket;
+    init_page(*bucket, bucket_id, PageType::INDEX, PageLevel::LEAF);
+    local_depth(*bucket) = depth + 1;
+    local_depth(*sibling) = depth + 1;
+    uint16_t count = get_header(old)->cell_count;
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t key_len = 0;
+        const uint8_t* key = slot_key(old, i, key_len);
+        bool high = (hash_key(key, key_len) >> depth) & 1;
+        append_leaf_records(high ? *sibling : *bucket, old, i, i + 1);
+    }
+    th.bpm->unpin_page(sibling_id, true);
+    th.bpm->unpin_page(bucket_id, true);
+
+    size_t first = (low_bits & ((size_t{1} << depth) - 1)) | (size_t{1} << depth);
+    size_t stride = size_t{1} << (depth + 1);
+    for (size_t slot = first; slot < th.hash_directory.size(); slot += stride) {
+        th.hash_directory[slot] = sibling_id;
+    }
+    return store_directory(th, first, stride);
+}
+
+// Pins the chain page holding key; nullptr when the key is absent
+static Page* find_in_chain(TableHandle& th, const Key& key, uint32_t& page_id, uint16_t& index) {
+    page_id = bucket_for(th, hash_key(key.data(), key.size()));
+    while (page_id != 0) {
+        Page* page = th.bpm->fetch_page(page_id);
+        if (!page) {
+            return nullptr;
+        }
+        BSearchResult r = search_record(*page, key.data(), key.size());
+        if (r.found) {
+            index = r.index;
+            return page;
+        }
+        uint32_t next = get_header(*page)->next_page_id;
+        th.bpm->unpin_page(page_id, false);
+        page_id = next;
+    }
+    return nullptr;
+}
+
+// Inserts a stored record into the first chain page with room, compacting a page
+// before giving up on it. Returns false when every page in the chain is full.
+static bool insert_into_chain(TableHandle& th, uint32_t page_id, const Key& key,
+                              const uint8_t* value, uint16_t value_len, bool overflow) {
+    while (page_id != 0) {
+        Page* page = th.bpm->fetch_page(page_id);
+        if (!page) {
+            return false;
+        }
+        bool inserted = page_insert(*page, key.data(), key.size(), value, value_len);
+        if (!inserted) {
+            page_compact(*page);
+            inserted = page_insert(*page, key.data(), key.size(), value, value_len);
+        }
+        if (inserted) {
+            if (overflow) {
+                *slot_flags(*page, search_record(*page, key.data(), key.size()).index) |= RECORD_OVERFLOW;
+            }
+            th.bpm->unpin_page(page_id, true);
+            return true;
+        }
+        uint32_t next = get_header(*page)->next_page_id;
+        th.bpm->unpin_page(page_id, true);  // Compacted
+        page_id = next;
+    }
+    return false;
+}
+
+// Appends an empty overflow bucket to the chain starting at bucket_id
+static bool chain_bucket(TableHandle& th, uint32_t bucket_id) {
+    uint32_t tail_id = bucket_id;
+    Page* tail = th.bpm->fetch_page(tail_id);
+    while (tail && get_header(*tail)->next_page_id != 0) {
+        uint32_t next = get_header(*tail)->next_page_id;
+        th.bpm->unpin_page(tail_id, false);
+        tail_id = next;
+        tail = th.bpm->fetch_page(tail_id);
+    }
+    if (!tail) {
+        return false;
+    }
+    uint32_t page_id = allocate_page(th);
+    Page* page = page_id == INVALID_PAGE_ID ? nullptr : th.bpm->new_page(page_id, PageType::INDEX, PageLevel::LEAF);
+    if (!page) {
+        th.bpm->unpin_page(tail_id, false);
+        return false;
+    }
+    local_depth(*page) = local_depth(*tail);
+    get_header(*tail)->next_page_id = page_id;
+    th.bpm->unpin_page(page_id, true);
+    th.bpm->unpin_page(tail_id, true);
+    return true;
+}
+
+// Inserts a stored record into key's bucket, splitting or chaining the bucket until it fits
+static bool insert_stored(TableHandle& th, const Key& key, const uint8_t* value, uint16_t value_len, bool overflow) {
+    uint64_t hash = hash_key(key.data(), key.size());
+    while (true) {
+        uint32_t bucket_id = bucket_for(th, hash);
+        if (insert_into_chain(th, bucket_id, key, value, value_len, overflow)) {
+            return true;
+        }
+        // Split while the hash bits can still separate keys, then fall back to chaining
+        if (!split_bucket(th, bucket_id, hash) && !chain_bucket(th, bucket_id)) {
+            return false;
+        }
+    }
+}
+
+bool hash_create(const std::string& name) {
+    if (!create_table(name)) {
+        return false;
+    }
+    TableHandle th(name);
+    if (!open_table(name, th)) {
+        return false;
+    }
+    // Page 2, the B+tree root written by create_table, becomes bucket 0
+    Page* bucket = th.bpm->fetch_page(2);
+    uint32_t dir_id = allocate_page(th);
+    Page* dir = dir_id == INVALID_PAGE_ID ? nullptr : th.bpm->new_page(dir_id, PageType::INDEX, PageLevel::NONE);
+    Page* meta = th.bpm->fetch_page(0);
+    if (!bucket || !dir || !meta) {
+        return false;
+    }
+    init_page(*bucket, 2, PageType::INDEX, PageLevel::LEAF);
+    dir_entries(*dir)[0] = 2;
+    get_header(*meta)->root_page = 0;
+    HashMeta* hm = hash_meta(*meta);
+    hm->magic = HASH_MAGIC;
+    hm->global_depth = 0;
+    hm->dir_page_count = 1;
+    meta_dir_pages(*meta)[0] = dir_id;
+    th.bpm->unpin_page(0, true);
+    th.bpm->unpin_page(dir_id, true);
+    th.bpm->unpin_page(2, true);
+    th.bpm->flush_all();
+    return true;
+}
+
+bool hash_load(TableHandle& th) {
+    if (!th.bpm) {
+        return false;
+    }
+    Page* meta = th.bpm->fetch_page(0);
+    if (!meta) {
+        return false;
+    }
+    HashMeta hm = *hash_meta(*meta);
+    if (hm.magic != HASH_MAGIC || hm.dir_page_count > HASH_MAX_DIR_PAGES) {
+        th.bpm->unpin_page(0, false);
+        return false;
+    }
+    std::vector<uint32_t> dir_pages(meta_dir_pages(*meta), meta_dir_pages(*meta) + hm.dir_page_count);
+    th.bpm->unpin_page(0, false);
+
+    std::vector<uint32_t> directory(size_t{1} << hm.global_depth);
+    for (size_t slot = 0; slot < directory.size(); slot += HASH_DIR_ENTRIES_PER_PAGE) {
+        uint32_t page_id = dir_pages[slot / HASH_DIR_ENTRIES_PER_PAGE];
+        Page* page = th.bpm->fetch_page(page_id);
+        if (!page) {
+            return false;
+        }
+        size_t count = std::min<size_t>(HASH_DIR_ENTRIES_PER_PAGE, directory.size() - slot);
+        std::memcpy(directory.data() + slot, dir_entries(*page), count * sizeof(uint32_t));
+        th.bpm->unpin_page(page_id, false);
+    }
+    th.hash_directory = std::move(directory);
+    th.root_page = 0;
+    return true;
+}
+
+bool hash_open(const std::string& name, TableHandle& th) {
+    return open_table(name, th) && hash_load(th);
+}
+
+bool hash_search(TableHandle& th, const Key& key, Value& value) {
+    if (!is_hash_table(th) || key.empty()) {
+        return false;
+    }
+    uint32_t page_id = 0;
+    uint16_t index = 0;
+    Page* page = find_in_chain(th, key, page_id, index);
+    if (!page) {
+        return false;
+    }
+    uint16_t value_len = 0;
+    const uint8_t* value_data = slot_value(*page, index, value_len);
+    bool ok = value_data != nullptr;
+    if (ok && (*slot_flags(*page, index) & RECORD_OVERFLOW)) {
+        ok = overflow_load(th, value_data, value_len, value);
+    } else if (ok) {
+        value.assign(value_data, value_len);
+    }
+    th.bpm->unpin_page(page_id, false);
+    return ok;
+}
+
+bool hash_insert(TableHandle& th, const Key& key, const Value& value) {
+    if (!is_hash_table(th) || key.empty() || key.size() > OVERFLOW_THRESHOLD) {
+        return false;
+    }
+    uint32_t found_id = 0;
+    uint16_t found_index = 0;
+    if (find_in_chain(th, key, found_id, found_index)) {
+        th.bpm->unpin_page(found_id, false);
+        return false;
+    }
+
+    uint8_t stored[OVERFLOW_STORED_SIZE];
+    const uint8_t* value_data = value.data();
+    uint16_t value_len = value.size();
+    bool overflow = value.size() > OVERFLOW_THRESHOLD;
+    if (overflow) {
+        value_len = overflow_store(th, value, stored);
+        if (value_len == 0) {
+            return false;
+        }
+        value_data = stored;
+    }
+
+    if (insert_stored(th, key, value_data, value_len, overflow)) {
+        return true;
+    }
+    if (overflow) {
+        overflow_free(th, overflow_first_page(stored, value_len));
+    }
+    return false;
+}
+
+bool hash_update(TableHandle& th, const Key& key, const Value& value) {
+    if (!is_hash_table(th) || key.empty()) {
+        return false;
+    }
+    uint32_t page_id = 0;
+    uint16_t index = 0;
+    Page* page = find_in_chain(th, key, page_id, index);
+    if (!page) {
+        return false;
+    }
+    bool old_overflow = (*slot_flags(*page, index) & RECORD_OVERFLOW) != 0;
+    uint16_t stored_len = 0;
+    const uint8_t* stored = slot_value(*page, index, stored_len);
+    uint32_t old_chain = old_overflow ? overflow_first_page(stored, stored_len) : 0;
+    if (value.size() <= OVERFLOW_THRESHOLD && page_update(*page, key.data(), key.size(), value.data(), value.size())) {
+        *slot_flags(*page, search_record(*page, key.data(), key.size()).index) &= ~RECORD_OVERFLOW;
+        th.bpm->unpin_page(page_id, true);
+    } else {
+        // Overflow values and values the bucket cannot hold go through a fresh insert.
+        // The old record is kept aside and goes back, chain and all, if that fails.
+        std::vector<uint8_t> old_stored(stored, stored + stored_len);
+        page_delete(*page, key.data(), key.size());
+        th.bpm->unpin_page(page_id, true);
+        if (!hash_insert(th, key, value)) {
+            insert_stored(th, key, old_stored.data(), static_cast<uint16_t>(old_stored.size()), old_overflow);
+            return false;
+        }
+    }
+    if (old_chain != 0) {
+        overflow_free(th, old_chain);
+    }
+    return true;
+}
+
+bool hash_delete(TableHandle& th, const Key& key) {
+    if (!is_hash_table(th) || key.empty()) {
+        return false;
+    }
+    uint32_t page_id = 0;
+    uint16_t index = 0;
+    Page* page = find_in_chain(th, key, page_id, index);
+    if (!page) {
+        return false;
+    }
+    uint32_t chain = 0;
+    if (*slot_flags(*page, index) & RECORD_OVERFLOW) {
+        uint16_t stored_len = 0;
+        const uint8_t* stored = slot_value(*page, index, stored_len);
+        chain = overflow_first_page(stored, stored_len);
+    }
+    page_delete(*page, key.data(), key.size());
+    th.bpm->unpin_page(page_id, true);
+    if (chain != 0) {
+        overflow_free(th, chain);
+    }
+    return true;
+}
+
+bool hash_scan_bucket(TableHandle& th, uint32_t bucket_id, BTreeRangeScanCallback callback, void* ctx) {
+    for (uint32_t page_id = bucket_id; page_id != 0;) {
+        Page* page = th.bpm->fetch_page(page_id);
+        if (!page) {
+            return false;
+        }
+        for (uint16_t i = 0; i < get_header(*page)->cell_count; i++) {
+            uint16_t key_len = 0;
+            uint16_t value_len = 0;
+            const uint8_t* key = slot_key(*page, i, key_len);
+            const uint8_t* value = slot_value(*page, i, value_len);
+            if (key == nullptr || value == nullptr) {
+                continue;
+            }
+            Value v(value, value_len);
+            if ((*slot_flags(*page, i) & RECORD_OVERFLOW) && !overflow_load(th, value, value_len, v)) {
+                continue;
+            }
+            callback(Key(key, key_len), v, ctx);
+        }
+        uint32_t next = get_header(*page)->next_page_id;
+        th.bpm->unpin_page(page_id, false);
+        page_id = next;
+    }
+    return true;
+}
+
+void hash_scan(TableHandle& th, BTreeRangeScanCallback callback, void* ctx) {
+    if (!is_hash_table(th) || callback == nullptr) {
+        return;
+    }
+    std::unordered_set<uint32_t> visited;
+    for (uint32_t bucket_id : th.hash_directory) {
+        if (visited.insert(bucket_id).second && !hash_scan_bucket(th, bucket_id, callback, ctx)) {
+            return;
+        }
+    }
+}
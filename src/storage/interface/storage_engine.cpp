@@ -2,12 +2,105 @@
 #include "storage/table_handle.hpp"
 #include "storage/buffer_pool.hpp"
 #include "storage/btree.hpp"
+#include "storage/hash_index.hpp"
+#include "storage/lsm_tree.hpp"
 #include "storage/relational/catalog.hpp"
 #include "storage/relational/row_codec.hpp"
+#include "storage/relational/row_view.hpp"
+#include "storage/relational/compiled_codec.hpp"
+#include "storage/relational/pax_block.hpp"
 #include <cstring>
 #include <algorithm>
 #include <cstdio>
 
+namespace {
+// Each secondary index lives in its own file next to the table: data/<table>.<index>.db
+std::string index_table_name(const std::string& table_name, const std::string& index_name) {
+    return table_name + "." + index_name;
+}
+
+// Size and spilled flag of each dictionary of a table, taken before a row is encoded
+using DictionaryMarks = std::vector<std::pair<size_t, bool>>;
+
+DictionaryMarks mark_dictionaries(const Relational::TableDictionaries* dictionaries) {
+    DictionaryMarks marks;
+    if (dictionaries != nullptr) {
+        for (const auto& dictionary : *dictionaries) {
+            marks.emplace_back(dictionary.size(), dictionary.spilled());
+        }
+    }
+    return marks;
+}
+
+// Drops the codes interned since marks were taken
+void rollback_dictionaries(Relational::TableDictionaries* dictionaries, const DictionaryMarks& marks) {
+    for (size_t i = 0; dictionaries != nullptr && i < marks.size() && i < dictionaries->size(); i++) {
+        (*dictionaries)[i].truncate(marks[i].first, marks[i].second);
+    }
+}
+
+bool has_prefix(const Key& key, const std::vector<uint8_t>& prefix) {
+    if (prefix.empty()) {
+        return true;
+    }
+    return key.size() >= prefix.size() && std::memcmp(key.data(), prefix.data(), prefix.size()) == 0;
+}
+
+// Primary keys filed under an index key prefix (one encoded column value), at most
+// limit of them. The primary key leads each index value, ahead of any INCLUDE columns.
+std::vector<std::vector<uint8_t>> index_entries(TableHandle& index, const Relational::RowCodec& codec,
+                                                const std::vector<uint8_t>& prefix, size_t limit) {
+    std::vector<std::vector<uint8_t>> pks;
+    if (prefix.empty() || prefix.size() > UINT16_MAX) {
+        return pks;
+    }
+    Relational::Tuple key_row;
+    BTreeCursor cursor(index);
+    for (bool ok = cursor.seek(Key(prefix.data(), static_cast<uint16_t>(prefix.size())));
+         ok && pks.size() < limit; ok = cursor.next()) {
+        if (!has_prefix(cursor.key(), prefix)) {
+            break;
+        }
+        Value v = cursor.value();
+        const uint8_t* p = v.data();
+        if (codec.decode_key(p, v.data() + v.size(), key_row)) {
+            pks.emplace_back(v.data(), p);
+        }
+    }
+    return pks;
+}
+
+// Smallest byte string above every string that starts with prefix; empty when none is
+std::vector<uint8_t> prefix_successor(std::vector<uint8_t> prefix) {
+    while (!prefix.empty() && prefix.back() == 0xFF) {
+        prefix.pop_back();
+    }
+    if (!prefix.empty()) {
+        prefix.back()++;
+    }
+    return prefix;
+}
+
+std::vector<std::string> column_names(const Relational::TableSchema& schema, const std::vector<size_t>& columns) {
+    std::vector<std::string> names;
+    for (size_t column : columns) {
+        if (column < schema.columns.size()) {
+            names.push_back(schema.columns[column].name);
+        }
+    }
+    return names;
+}
+
+int find_column(const Relational::TableSchema& schema, const std::string& column_name) {
+    for (size_t i = 0; i < schema.columns.size(); ++i) {
+        if (schema.columns[i].name == column_name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+}
+
 StorageEngine::StorageEngine() = default;
 
 StorageEngine::~StorageEngine() {
@@ -22,29 +115,79 @@ bool StorageEngine::create_table(const std::string& table_name) {
     return ::create_table(table_name);
 }
 
+bool StorageEngine::create_hash_table(const std::string& table_name) {
+    if (open_tables_.find(table_name) != open_tables_.end()) {
+        return false;
+    }
+    return hash_create(table_name);
+}
+
+bool StorageEngine::create_lsm_table(const std::string& table_name) {
+    if (open_tables_.find(table_name) != open_tables_.end()) {
+        return false;
+    }
+    return lsm_create(table_name);
+}
+
 bool StorageEngine::create_table(const std::string& table_name, const Relational::TableSchema& schema) {
     if (open_tables_.find(table_name) != open_tables_.end()) {
         return false;
     }
-    if (!::create_table(table_name)) {
+    bool created = false;
+    switch (schema.storage) {
+        case Relational::TableStorage::HASH: created = hash_create(table_name); break;
+        case Relational::TableStorage::LSM: created = lsm_create(table_name); break;
+        case Relational::TableStorage::PAX:
+        default: created = ::create_table(table_name); break;
+    }
+    if (!created) {
         return false;
     }
-    if (!catalog_.register_table(table_name, schema)) {
+    Relational::TableSchema base = schema;
+    base.indexes.clear();
+    if (!catalog_.register_table(table_name, base)) {
         return false;
     }
+    // A table missing one of its indexes is dropped again, so the create can be retried
+    for (size_t i = 0; i < schema.columns.size(); ++i) {
+        const Relational::ColumnDef& col = schema.columns[i];
+        if (col.is_unique && schema.primary_key() != std::vector<size_t>{i} &&
+            !create_index(table_name, table_name + "_" + col.name + "_key", col.name, true)) {
+            drop_table(table_name);
+            return false;
+        }
+    }
+    for (const auto& index : schema.indexes) {
+        if (index.column >= schema.columns.size() ||
+            !create_index(table_name, index.name, schema.columns[index.column].name, index.unique,
+                          column_names(schema, index.include))) {
+            drop_table(table_name);
+            return false;
+        }
+    }
     return true;
 }
 
 bool StorageEngine::drop_table(const std::string& table_name) {
-    auto it = open_tables_.find(table_name);
+    auto schema_opt = catalog_.get_schema(table_name);
+    if (schema_opt.has_value() && schema_opt.value() != nullptr) {
+        for (const auto& index : schema_opt.value()->indexes) {
+            drop_tree(index_table_name(table_name, index.name));
+        }
+    }
+    catalog_.drop_table(table_name);
+    return drop_tree(table_name);
+}
+
+bool StorageEngine::drop_tree(const std::string& tree_name) {
+    auto it = open_tables_.find(tree_name);
     if (it != open_tables_.end()) {
         if (it->second && it->second->bpm) {
             it->second->bpm->flush_all();
         }
         open_tables_.erase(it);
     }
-    catalog_.drop_table(table_name);
-    std::string path = "data/" + table_name + ".db";
+    std::string path = "data/" + tree_name + ".db";
     return std::remove(path.c_str()) == 0;
 }
 
@@ -59,6 +202,7 @@ void StorageEngine::close_table(TableHandle* handle) {
     
     for (auto it = open_tables_.begin(); it != open_tables_.end(); ++it) {
         if (it->second.get() == handle) {
+            lsm_flush(*handle);
             if (handle->bpm) {
                 handle->bpm->flush_all();
             }
@@ -78,6 +222,10 @@ TableHandle* StorageEngine::get_or_open_table(const std::string& table_name) {
     if (!::open_table(table_name, *th)) {
         return nullptr;
     }
+    // Hash and LSM files keep their directories on the handle; B+tree files are left as they are
+    if (!hash_load(*th)) {
+        lsm_load(*th);
+    }
     
     TableHandle* handle = th.get();
     open_tables_[table_name] = std::move(th);
@@ -92,22 +240,60 @@ bool StorageEngine::insert_record(TableHandle* handle, const std::vector<uint8_t
     Key k(key.data(), static_cast<uint16_t>(key.size()));
     Value v(value.data(), static_cast<uint16_t>(value.size()));
     
-    return btree_insert(*handle, k, v);
+    if (is_lsm_table(*handle)) {
+        return lsm_insert(*handle, k, v);
+    }
+    return is_hash_table(*handle) ? hash_insert(*handle, k, v) : btree_insert(*handle, k, v);
 }
 
 bool StorageEngine::get_record(TableHandle* handle, const std::vector<uint8_t>& key, std::vector<uint8_t>& out_value) {
+    RecordView view;
+    if (!get_record(handle, std::string_view(reinterpret_cast<const char*>(key.data()), key.size()), view)) {
+        return false;
+    }
+    std::string_view v = view.value();
+    out_value.assign(v.begin(), v.end());
+    return true;
+}
+
+void RecordView::reset() {
+    cursor_.reset();
+    owned_ = Value();
+    value_ = {};
+}
+
+bool StorageEngine::get_record(TableHandle* handle, std::string_view key, RecordView& out) {
+    out.reset();
     if (handle == nullptr || key.empty() || key.size() > UINT16_MAX) {
         return false;
     }
-    
-    Key k(key.data(), static_cast<uint16_t>(key.size()));
-    Value v;
-    
-    if (!btree_search(*handle, k, v)) {
+
+    Key k(key);
+    // A buffered B+tree answers from its messages without flushing them, as a copy
+    if (is_lsm_table(*handle) || is_hash_table(*handle) || !handle->write_buffer.empty()) {
+        bool found = is_lsm_table(*handle)  ? lsm_search(*handle, k, out.owned_)
+                   : is_hash_table(*handle) ? hash_search(*handle, k, out.owned_)
+                                            : btree_search(*handle, k, out.owned_);
+        if (!found) {
+            return false;
+        }
+        out.value_ = std::string_view(reinterpret_cast<const char*>(out.owned_.data()), out.owned_.size());
+        return true;
+    }
+
+    BTreeCursor& cursor = out.cursor_.emplace(*handle);
+    if (!cursor.seek(k)) {
+        out.reset();
         return false;
     }
-    
-    out_value.assign(v.data(), v.data() + v.size());
+    Key found = cursor.key();
+    Value v = cursor.value();
+    if (compare_keys(found.data(), found.size(), k.data(), k.size()) != 0 ||
+        (v.data() == nullptr && cursor.value_is_overflow())) {
+        out.reset();
+        return false;
+    }
+    out.value_ = std::string_view(reinterpret_cast<const char*>(v.data()), v.size());
     return true;
 }
 
@@ -117,7 +303,10 @@ bool StorageEngine::delete_record(TableHandle* handle, const std::vector<uint8_t
     }
     
     Key k(key.data(), static_cast<uint16_t>(key.size()));
-    return btree_delete(*handle, k);
+    if (is_lsm_table(*handle)) {
+        return lsm_delete(*handle, k);
+    }
+    return is_hash_table(*handle) ? hash_delete(*handle, k) : btree_delete(*handle, k);
 }
 
 bool StorageEngine::update_record(TableHandle* handle, const std::vector<uint8_t>& key, const std::vector<uint8_t>& new_value) {
@@ -126,43 +315,356 @@ bool StorageEngine::update_record(TableHandle* handle, const std::vector<uint8_t
     }
     
     Key k(key.data(), static_cast<uint16_t>(key.size()));
-    
-    if (!btree_delete(*handle, k)) {
-        return false;
-    }
-    
     Value v(new_value.data(), static_cast<uint16_t>(new_value.size()));
-    return btree_insert(*handle, k, v);
+    if (is_lsm_table(*handle)) {
+        return lsm_update(*handle, k, v);
+    }
+    return is_hash_table(*handle) ? hash_update(*handle, k, v) : btree_update(*handle, k, v);
+}
+
+size_t StorageEngine::compact_table(TableHandle* handle) {
+    if (handle == nullptr || is_hash_table(*handle)) {
+        return 0;
+    }
+    return is_lsm_table(*handle) ? lsm_compact(*handle) : btree_compact(*handle);
+}
+
+bool StorageEngine::set_deferred_deletes(TableHandle* handle, bool enabled) {
+    return handle != nullptr && btree_set_deferred_deletes(*handle, enabled);
+}
+
+uint32_t StorageEngine::vacuum_table(TableHandle* handle, uint16_t fill_percent) {
+    // Hash buckets have no order to restore, and LSM runs are rewritten whole by compaction
+    if (handle == nullptr || is_hash_table(*handle) || is_lsm_table(*handle)) {
+        return 0;
+    }
+    return btree_vacuum(*handle, fill_percent);
 }
 
 namespace {
+struct BoundedScan {
+    BTreeRangeScanCallback callback;
+    void* ctx;
+    Key start;
+    Key end;
+};
+
+void bounded_scan_callback(const Key& k, const Value& v, void* ctx) {
+    BoundedScan* scan = static_cast<BoundedScan*>(ctx);
+    if ((!scan->start.empty() && compare_keys(k.data(), k.size(), scan->start.data(), scan->start.size()) < 0) ||
+        (!scan->end.empty() && compare_keys(k.data(), k.size(), scan->end.data(), scan->end.size()) > 0)) {
+        return;
+    }
+    scan->callback(k, v, scan->ctx);
+}
+
+// Visits records with start <= key <= end (empty bounds are open). The callback gets
+// the key and value in place, valid only until it returns.
+void scan_records(TableHandle& handle, const Key& start, const Key& end, BTreeRangeScanCallback callback, void* ctx) {
+    if (is_hash_table(handle)) {
+        // Hash files have no key order, so their bounds are checked per record
+        BoundedScan scan{callback, ctx, Key(start.data(), start.size()), Key(end.data(), end.size())};
+        hash_scan(handle, bounded_scan_callback, &scan);
+        return;
+    }
+    if (is_lsm_table(handle)) {
+        lsm_range_scan(handle, start, end, callback, ctx);
+        return;
+    }
+    btree_range_scan(handle, start, end, callback, ctx);
+}
+
+// The vector callbacks get copies in two buffers the whole scan reuses, so a scan
+// allocates only while they grow
 struct ScanContext {
     StorageEngine::ScanCallback user_callback;
     void* user_ctx;
+    std::vector<uint8_t> key;
+    std::vector<uint8_t> value;
 };
 
 void btree_scan_wrapper(const Key& k, const Value& v, void* ctx) {
     ScanContext* scan_ctx = static_cast<ScanContext*>(ctx);
-    std::vector<uint8_t> key_vec(k.data(), k.data() + k.size());
-    std::vector<uint8_t> value_vec(v.data(), v.data() + v.size());
-    scan_ctx->user_callback(key_vec, value_vec, scan_ctx->user_ctx);
+    scan_ctx->key.assign(k.data(), k.data() + k.size());
+    scan_ctx->value.assign(v.data(), v.data() + v.size());
+    scan_ctx->user_callback(scan_ctx->key, scan_ctx->value, scan_ctx->user_ctx);
 }
 
+struct ViewScanContext {
+    StorageEngine::ViewCallback user_callback;
+    void* user_ctx;
+};
+
+void view_scan_wrapper(const Key& k, const Value& v, void* ctx) {
+    ViewScanContext* scan_ctx = static_cast<ViewScanContext*>(ctx);
+    scan_ctx->user_callback(std::string_view(reinterpret_cast<const char*>(k.data()), k.size()),
+                            std::string_view(reinterpret_cast<const char*>(v.data()), v.size()), scan_ctx->user_ctx);
+}
+
+// Rows are read through a RowView over the record bytes, so a scan decodes only the
+// columns it returns and copies nothing for rows it drops
 struct RelationalScanContext {
-    const Relational::TableSchema* schema;
-    std::vector<Relational::Tuple>* rows;
+    const Relational::RowLayout* layout;
+    const Relational::CompiledRowCodec* codec = nullptr;  // Decodes whole rows
+    std::vector<size_t> columns;  // Projected columns, empty for all
+    std::vector<Relational::Tuple>* rows = nullptr;
+    StorageEngine::RowCallback visit = nullptr;
+    void* visit_ctx = nullptr;
+    std::vector<uint8_t> high;  // Upper key bound compared over its own length, empty when open
+    // The scan's bounds; a PAX block can straddle them, so its rows are checked
+    std::vector<uint8_t> start;
+    std::vector<uint8_t> stop;
 };
 
-void relational_scan_callback(const std::vector<uint8_t>& key, const std::vector<uint8_t>& value, void* ctx) {
-    (void)key;
+bool above_high(const RelationalScanContext& rctx, const uint8_t* key, size_t len) {
+    return !rctx.high.empty() && std::memcmp(key, rctx.high.data(), std::min<size_t>(len, rctx.high.size())) > 0;
+}
+
+void relational_scan_callback(const Key& key, const Value& value, void* ctx) {
+    RelationalScanContext* rctx = static_cast<RelationalScanContext*>(ctx);
+    if (above_high(*rctx, key.data(), key.size())) {
+        return;
+    }
+    Relational::Tuple tuple;
+    if (rctx->visit == nullptr && rctx->columns.empty()) {
+        if (rctx->codec->decode(value.data(), value.size(), tuple)) {
+            rctx->rows->push_back(std::move(tuple));
+        }
+        return;
+    }
+    Relational::RowView row(*rctx->layout, value.data(), value.size());
+    if (rctx->visit != nullptr) {
+        rctx->visit(row, rctx->visit_ctx);
+        return;
+    }
+    tuple = row.materialize(rctx->columns);
+    if (!tuple.empty()) {
+        rctx->rows->push_back(std::move(tuple));
+    }
+}
+
+// A PAX block's rows go through the same paths: visitors get a RowView over the
+// row re-encoded by the table's codec, projections read only their minipages
+void pax_relational_callback(const Relational::PaxBlockView& block, void* ctx) {
     RelationalScanContext* rctx = static_cast<RelationalScanContext*>(ctx);
-    if (rctx->schema == nullptr || rctx->rows == nullptr) return;
-    Relational::RowCodec codec(*rctx->schema);
-    Relational::Tuple row = codec.decode(value);
-    if (row.size() == rctx->schema->columns.size()) {
-        rctx->rows->push_back(std::move(row));
+    std::vector<uint8_t> encoded;
+    for (size_t r = 0; r < block.row_count(); r++) {
+        const uint8_t* key;
+        size_t len;
+        if (!block.key(r, key, len) ||
+            (!rctx->start.empty() && compare_keys(key, static_cast<uint16_t>(len), rctx->start.data(),
+                                                  static_cast<uint16_t>(rctx->start.size())) < 0)) {
+            continue;
+        }
+        if ((!rctx->stop.empty() && compare_keys(key, static_cast<uint16_t>(len), rctx->stop.data(),
+                                                 static_cast<uint16_t>(rctx->stop.size())) > 0) ||
+            above_high(*rctx, key, len)) {
+            return;
+        }
+        Relational::Tuple tuple;
+        if (rctx->visit != nullptr) {
+            tuple = block.row(r);
+            if (!tuple.empty() && rctx->codec->encode(tuple, encoded)) {
+                rctx->visit(Relational::RowView(*rctx->layout, encoded.data(), encoded.size()), rctx->visit_ctx);
+            }
+            continue;
+        }
+        if (rctx->columns.empty()) {
+            tuple = block.row(r);
+        } else {
+            tuple.resize(rctx->columns.size());
+            for (size_t i = 0; i < rctx->columns.size(); i++) {
+                if (!block.get(r, rctx->columns[i], tuple[i])) {
+                    tuple.clear();
+                    break;
+                }
+            }
+        }
+        if (!tuple.empty()) {
+            rctx->rows->push_back(std::move(tuple));
+        }
+    }
+}
+
+// Equality filter over a full scan. Compact rows compare the column's stored bytes,
+// so a dictionary column matches on its code without decoding the row
+struct EqualityScan {
+    size_t column;
+    const Relational::RowCodec* codec;
+    std::vector<uint8_t> key;    // The value's key encoding, for rows compared as values
+    std::vector<uint8_t> bytes;  // The value as compact rows store it, empty to compare values
+    std::vector<Relational::Tuple>* rows;
+};
+
+void equality_scan_callback(const Relational::RowView& row, void* ctx) {
+    EqualityScan* scan = static_cast<EqualityScan*>(ctx);
+    const uint8_t* data = nullptr;
+    size_t len = 0;
+    bool match;
+    if (!scan->bytes.empty() && row.get_raw(scan->column, data, len)) {
+        match = len == scan->bytes.size() && std::memcmp(data, scan->bytes.data(), len) == 0;
+    } else {
+        Relational::Value v;
+        match = row.get(scan->column, v) && scan->codec->encode_key_column(scan->column, v) == scan->key;
+    }
+    if (match) {
+        Relational::Tuple tuple = row.materialize();
+        if (!tuple.empty()) {
+            scan->rows->push_back(std::move(tuple));
+        }
+    }
+}
+
+// The same filter over PAX blocks: INT, DATETIME and BOOLEAN columns compare each
+// value in the column's minipage, the rest compare as values
+struct PaxEqualityScan {
+    size_t column;
+    const Relational::RowCodec* codec;
+    std::vector<uint8_t> key;
+    std::vector<uint8_t> bytes;  // The value as minipages store it, empty to compare values
+    std::vector<Relational::Tuple>* rows;
+};
+
+void pax_equality_callback(const Relational::PaxBlockView& block, void* ctx) {
+    PaxEqualityScan* scan = static_cast<PaxEqualityScan*>(ctx);
+    Relational::ColumnBatch batch;
+    bool minipage = !scan->bytes.empty() && block.column(scan->column, batch);
+    size_t width = scan->bytes.size();
+    for (size_t r = 0; r < block.row_count(); r++) {
+        bool match;
+        if (minipage) {
+            match = (batch.nulls[r / 8] & (1u << (r % 8))) == 0 &&
+                    std::memcmp(batch.data + r * width, scan->bytes.data(), width) == 0;
+        } else {
+            Relational::Value v;
+            match = block.get(r, scan->column, v) && scan->codec->encode_key_column(scan->column, v) == scan->key;
+        }
+        if (match) {
+            Relational::Tuple tuple = block.row(r);
+            if (!tuple.empty()) {
+                scan->rows->push_back(std::move(tuple));
+            }
+        }
+    }
+}
+
+// Column batches for scan_column. Values not already in a minipage are gathered
+// into data and nulls and handed out COLUMN_BATCH_ROWS at a time.
+constexpr size_t COLUMN_BATCH_ROWS = 256;
+
+struct ColumnScan {
+    size_t column;
+    Relational::ColumnType type;
+    size_t width;
+    StorageEngine::ColumnCallback callback;
+    void* ctx;
+    size_t count = 0;
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> nulls;
+};
+
+void flush_column(ColumnScan& scan) {
+    if (scan.count == 0) {
+        return;
+    }
+    scan.callback(Relational::ColumnBatch{scan.type, scan.count, scan.data.data(), scan.nulls.data()}, scan.ctx);
+    scan.count = 0;
+}
+
+void gather_column(ColumnScan& scan, const Relational::Value& value) {
+    if (scan.count == 0) {
+        scan.data.assign(COLUMN_BATCH_ROWS * scan.width, 0);
+        scan.nulls.assign((COLUMN_BATCH_ROWS + 7) / 8, 0);
+    }
+    if (Relational::is_null(value)) {
+        scan.nulls[scan.count / 8] |= static_cast<uint8_t>(1u << (scan.count % 8));
+    }
+    Relational::pax_value_bytes(scan.type, value, scan.data.data() + scan.count * scan.width);
+    if (++scan.count == COLUMN_BATCH_ROWS) {
+        flush_column(scan);
+    }
+}
+
+void column_row_callback(const Relational::RowView& row, void* ctx) {
+    ColumnScan* scan = static_cast<ColumnScan*>(ctx);
+    Relational::Value v;
+    if (row.get(scan->column, v)) {
+        gather_column(*scan, v);
     }
 }
+
+void column_block_callback(const Relational::PaxBlockView& block, void* ctx) {
+    ColumnScan* scan = static_cast<ColumnScan*>(ctx);
+    Relational::ColumnBatch batch;
+    if (block.column(scan->column, batch)) {
+        scan->callback(batch, scan->ctx);
+        return;
+    }
+    // The block predates the column: its rows read the default
+    for (size_t r = 0; r < block.row_count(); r++) {
+        Relational::Value v;
+        if (block.get(r, scan->column, v)) {
+            gather_column(*scan, v);
+        }
+    }
+    flush_column(*scan);
+}
+
+// B+tree tables are read through a cursor, so a projection decodes an overflow row
+// from the prefix kept in the leaf and reads its chain only when a projected
+// column lies past that prefix
+void cursor_relational_scan(TableHandle& handle, const Key& start, const Key& stop, RelationalScanContext& rctx) {
+    if (handle.root_page == 0) {
+        return;
+    }
+    bool projected = rctx.visit == nullptr && !rctx.columns.empty();
+    BTreeCursor cursor(handle);
+    for (bool ok = cursor.seek(start); ok; ok = cursor.next()) {
+        Key k = cursor.key();
+        if (k.data() == nullptr) {
+            continue;
+        }
+        if ((!stop.empty() && compare_keys(k.data(), k.size(), stop.data(), stop.size()) > 0) ||
+            above_high(rctx, k.data(), k.size())) {
+            return;
+        }
+        if (projected && cursor.value_is_overflow()) {
+            Value prefix = cursor.inline_value();
+            Relational::Tuple tuple =
+                Relational::RowView(*rctx.layout, prefix.data(), prefix.size()).materialize(rctx.columns);
+            if (!tuple.empty()) {
+                rctx.rows->push_back(std::move(tuple));
+                continue;
+            }
+        }
+        Value v = cursor.value();
+        if (v.data() != nullptr) {
+            relational_scan_callback(k, v, &rctx);
+        }
+    }
+}
+
+void scan_relational(TableHandle& handle, const std::vector<uint8_t>& start, const std::vector<uint8_t>& stop,
+                     RelationalScanContext& rctx) {
+    if (rctx.layout->schema.storage == Relational::TableStorage::PAX) {
+        rctx.start = start;
+        rctx.stop = stop;
+        pax_scan(handle, rctx.layout->schema, start, stop, pax_relational_callback, &rctx);
+        return;
+    }
+    Key k_start, k_stop;
+    if (!start.empty()) {
+        k_start = Key(start.data(), static_cast<uint16_t>(start.size()));
+    }
+    if (!stop.empty()) {
+        k_stop = Key(stop.data(), static_cast<uint16_t>(stop.size()));
+    }
+    if (is_hash_table(handle) || is_lsm_table(handle)) {
+        scan_records(handle, k_start, k_stop, relational_scan_callback, &rctx);
+        return;
+    }
+    cursor_relational_scan(handle, k_start, k_stop, rctx);
+}
 }
 
 void StorageEngine::scan_table(TableHandle* handle, ScanCallback callback, void* ctx) {
@@ -190,12 +692,34 @@ void StorageEngine::range_scan(TableHandle* handle, const std::vector<uint8_t>&
     ScanContext scan_ctx;
     scan_ctx.user_callback = callback;
     scan_ctx.user_ctx = ctx;
-    
-    btree_range_scan(*handle, k_start, k_end, btree_scan_wrapper, &scan_ctx);
+    scan_records(*handle, k_start, k_end, btree_scan_wrapper, &scan_ctx);
+}
+
+void StorageEngine::scan_table(TableHandle* handle, ViewCallback callback, void* ctx) {
+    range_scan(handle, std::string_view(), std::string_view(), callback, ctx);
+}
+
+void StorageEngine::range_scan(TableHandle* handle, std::string_view start_key, std::string_view end_key,
+                               ViewCallback callback, void* ctx) {
+    if (handle == nullptr || callback == nullptr) {
+        return;
+    }
+    Key k_start, k_end;
+    if (!start_key.empty() && start_key.size() <= UINT16_MAX) {
+        k_start = Key(start_key);
+    }
+    if (!end_key.empty() && end_key.size() <= UINT16_MAX) {
+        k_end = Key(end_key);
+    }
+    ViewScanContext scan_ctx{callback, ctx};
+    scan_records(*handle, k_start, k_end, view_scan_wrapper, &scan_ctx);
 }
 
 void StorageEngine::flush_all() {
     for (auto& [name, handle] : open_tables_) {
+        if (handle && is_lsm_table(*handle)) {
+            lsm_flush(*handle);
+        }
         if (handle && handle->bpm) {
             handle->bpm->flush_all();
         }
@@ -203,6 +727,16 @@ void StorageEngine::flush_all() {
 }
 
 bool StorageEngine::insert(const std::string& table_name, const Relational::Tuple& row) {
+    Relational::TableDictionaries* dictionaries = catalog_.get_dictionaries(table_name);
+    DictionaryMarks marks = mark_dictionaries(dictionaries);
+    if (!insert_row(table_name, row)) {
+        rollback_dictionaries(dictionaries, marks);
+        return false;
+    }
+    return true;
+}
+
+bool StorageEngine::insert_row(const std::string& table_name, const Relational::Tuple& row) {
     auto schema_opt = catalog_.get_schema(table_name);
     if (!schema_opt.has_value() || schema_opt.value() == nullptr) {
         return false;
@@ -214,31 +748,709 @@ bool StorageEngine::insert(const std::string& table_name, const Relational::Tupl
     }
     Relational::RowCodec codec(*schema);
     std::vector<uint8_t> key_bytes = codec.encode_key(row);
-    std::vector<uint8_t> value_bytes = codec.encode_value(row);
+    std::vector<uint8_t> value_bytes = catalog_.get_codec(table_name)->encode(row);
     if (key_bytes.empty() || value_bytes.empty()) {
         return false;
     }
-    return insert_record(handle, key_bytes, value_bytes);
+    // Check every unique index before the row goes in, so a violation changes nothing
+    for (const auto& index : schema->indexes) {
+        TableHandle* tree = open_index(table_name, index);
+        if (tree == nullptr) {
+            return false;
+        }
+        if (index.unique && !Relational::is_null(row[index.column]) &&
+            !index_entries(*tree, codec, codec.encode_key_column(index.column, row[index.column]), 1).empty()) {
+            return false;
+        }
+    }
+    bool inserted = schema->storage == Relational::TableStorage::PAX
+                        ? pax_insert(*handle, *schema, key_bytes, row)
+                        : insert_record(handle, key_bytes, value_bytes);
+    if (!inserted) {
+        return false;
+    }
+    if (!write_indexes(table_name, codec, nullptr, &row)) {
+        // Take the row back out so the table and its indexes still agree
+        if (schema->storage == Relational::TableStorage::PAX) {
+            pax_delete(*handle, *schema, key_bytes);
+        } else {
+            delete_record(handle, key_bytes);
+        }
+        return false;
+    }
+    return true;
+}
+
+bool StorageEngine::update(const std::string& table_name, const Relational::Tuple& row) {
+    Relational::TableDictionaries* dictionaries = catalog_.get_dictionaries(table_name);
+    DictionaryMarks marks = mark_dictionaries(dictionaries);
+    if (!update_row(table_name, row)) {
+        rollback_dictionaries(dictionaries, marks);
+        return false;
+    }
+    return true;
+}
+
+bool StorageEngine::update_row(const std::string& table_name, const Relational::Tuple& row) {
+    const Relational::TableSchema* schema = get_schema(table_name);
+    TableHandle* handle = get_or_open_table(table_name);
+    if (schema == nullptr || handle == nullptr) {
+        return false;
+    }
+    Relational::RowCodec codec(*schema);
+    std::vector<uint8_t> key_bytes = codec.encode_key(row);
+    std::vector<uint8_t> value_bytes = catalog_.get_codec(table_name)->encode(row);
+    Relational::Tuple old_row;
+    if (key_bytes.empty() || value_bytes.empty() || !read_row(table_name, key_bytes, old_row)) {
+        return false;
+    }
+    for (const auto& index : schema->indexes) {
+        TableHandle* tree = open_index(table_name, index);
+        if (tree == nullptr) {
+            return false;
+        }
+        if (!index.unique || Relational::is_null(row[index.column])) {
+            continue;
+        }
+        auto owners = index_entries(*tree, codec, codec.encode_key_column(index.column, row[index.column]), 2);
+        for (const auto& pk : owners) {
+            if (pk != key_bytes) {
+                return false;
+            }
+        }
+    }
+    bool updated = schema->storage == Relational::TableStorage::PAX
+                       ? pax_update(*handle, *schema, key_bytes, row)
+                       : update_record(handle, key_bytes, value_bytes);
+    if (!updated) {
+        return false;
+    }
+    if (!write_indexes(table_name, codec, &old_row, &row)) {
+        if (schema->storage == Relational::TableStorage::PAX) {
+            pax_update(*handle, *schema, key_bytes, old_row);
+        } else {
+            update_record(handle, key_bytes, catalog_.get_codec(table_name)->encode(old_row));
+        }
+        return false;
+    }
+    return true;
+}
+
+bool StorageEngine::remove(const std::string& table_name, const Relational::Value& pk) {
+    return remove(table_name, Relational::Tuple{pk});
+}
+
+bool StorageEngine::remove(const std::string& table_name, const Relational::Tuple& key) {
+    const Relational::TableSchema* schema = get_schema(table_name);
+    TableHandle* handle = get_or_open_table(table_name);
+    if (schema == nullptr || handle == nullptr || key.size() != schema->primary_key().size()) {
+        return false;
+    }
+    Relational::RowCodec codec(*schema);
+    std::vector<uint8_t> key_bytes = codec.encode_key_prefix(key);
+    Relational::Tuple old_row;
+    if (key_bytes.empty() || !read_row(table_name, key_bytes, old_row)) {
+        return false;
+    }
+    bool removed = schema->storage == Relational::TableStorage::PAX ? pax_delete(*handle, *schema, key_bytes)
+                                                                     : delete_record(handle, key_bytes);
+    if (!removed) {
+        return false;
+    }
+    if (!write_indexes(table_name, codec, &old_row, nullptr)) {
+        if (schema->storage == Relational::TableStorage::PAX) {
+            pax_insert(*handle, *schema, key_bytes, old_row);
+        } else {
+            insert_record(handle, key_bytes, catalog_.get_codec(table_name)->encode(old_row));
+        }
+        return false;
+    }
+    return true;
+}
+
+bool StorageEngine::write_indexes(const std::string& table_name, const Relational::RowCodec& codec,
+                                  const Relational::Tuple* old_row, const Relational::Tuple* new_row) {
+    const Relational::TableSchema* schema = get_schema(table_name);
+    if (schema == nullptr) {
+        return false;
+    }
+    // What each written entry held before: its value, or nothing when it did not exist
+    struct IndexUndo {
+        TableHandle* tree;
+        std::vector<uint8_t> key;
+        std::vector<uint8_t> value;
+    };
+    std::vector<IndexUndo> undo;
+    bool ok = true;
+    for (const auto& index : schema->indexes) {
+        TableHandle* tree = open_index(table_name, index);
+        if (tree == nullptr) {
+            ok = false;
+            break;
+        }
+        // NULL values have no index entry
+        std::vector<uint8_t> old_key, old_value, new_key, new_value;
+        if (old_row != nullptr && !Relational::is_null((*old_row)[index.column])) {
+            old_key = codec.encode_index_key(*old_row, index.column);
+            old_value = codec.encode_index_value(*old_row, index.include);
+        }
+        if (new_row != nullptr && !Relational::is_null((*new_row)[index.column])) {
+            new_key = codec.encode_index_key(*new_row, index.column);
+            new_value = codec.encode_index_value(*new_row, index.include);
+        }
+        if (new_key.size() > BTREE_MAX_KEY_SIZE) {
+            ok = false;  // The index tree cannot split around a key this long
+            break;
+        }
+        if (old_key == new_key) {
+            if (new_key.empty() || new_value == old_value) {
+                continue;
+            }
+            if (!update_record(tree, new_key, new_value)) {
+                ok = false;
+                break;
+            }
+            undo.push_back({tree, new_key, old_value});
+            continue;
+        }
+        if (!old_key.empty()) {
+            if (!delete_record(tree, old_key)) {
+                ok = false;
+                break;
+            }
+            undo.push_back({tree, old_key, old_value});
+        }
+        if (!new_key.empty()) {
+            if (!insert_record(tree, new_key, new_value)) {
+                ok = false;
+                break;
+            }
+            undo.push_back({tree, new_key, {}});
+        }
+    }
+    if (ok) {
+        return true;
+    }
+    for (auto it = undo.rbegin(); it != undo.rend(); ++it) {
+        if (it->value.empty()) {
+            delete_record(it->tree, it->key);
+        } else if (!update_record(it->tree, it->key, it->value)) {
+            insert_record(it->tree, it->key, it->value);
+        }
+    }
+    return false;
+}
+
+std::vector<Relational::Tuple> StorageEngine::lookup(const std::string& table_name, const std::string& column_name,
+                                                     const Relational::Value& value) {
+    std::vector<Relational::Tuple> rows;
+    const Relational::TableSchema* schema = get_schema(table_name);
+    if (schema == nullptr) {
+        return rows;
+    }
+    int column = find_column(*schema, column_name);
+    if (column < 0) {
+        return rows;
+    }
+    Relational::TableDictionaries* dictionaries = catalog_.get_dictionaries(table_name);
+    Relational::RowCodec codec(*schema, dictionaries);
+    std::vector<uint8_t> prefix = codec.encode_key_column(static_cast<size_t>(column), value);
+    if (prefix.empty()) {
+        return rows;  // NULL equals nothing
+    }
+    if (column == schema->pk_index) {
+        // The leading key column of a composite key is a key prefix: scan its range
+        if (schema->primary_key().size() > 1) {
+            return scan_range(table_name, Relational::Tuple{value}, Relational::Tuple{value});
+        }
+        Relational::Tuple row;
+        if (read_row(table_name, prefix, row)) {
+            rows.push_back(std::move(row));
+        }
+        return rows;
+    }
+    for (const auto& index : schema->indexes) {
+        if (index.column != static_cast<size_t>(column)) {
+            continue;
+        }
+        TableHandle* tree = open_index(table_name, index);
+        if (tree == nullptr) {
+            return rows;
+        }
+        for (const auto& pk : index_entries(*tree, codec, prefix, SIZE_MAX)) {
+            Relational::Tuple row;
+            if (read_row(table_name, pk, row)) {
+                rows.push_back(std::move(row));
+            }
+        }
+        return rows;
+    }
+    // No index on the column: filter a full scan
+    const Relational::ColumnDef& def = schema->columns[static_cast<size_t>(column)];
+    if (def.dictionary && dictionaries != nullptr) {
+        const Relational::StringDictionary& dictionary = (*dictionaries)[static_cast<size_t>(column)];
+        const std::string* s = std::get_if<std::string>(&value);
+        if (s != nullptr && dictionary.find(*s) == Relational::StringDictionary::NO_CODE && !dictionary.spilled()) {
+            return rows;  // Never stored
+        }
+    }
+    if (schema->storage == Relational::TableStorage::PAX) {
+        TableHandle* handle = get_or_open_table(table_name);
+        if (handle == nullptr) {
+            return rows;
+        }
+        PaxEqualityScan filter{static_cast<size_t>(column), &codec, prefix, {}, &rows};
+        if (def.type != Relational::ColumnType::FLOAT && def.type != Relational::ColumnType::DOUBLE &&
+            def.type != Relational::ColumnType::STRING) {
+            filter.bytes.resize(Relational::pax_width(def.type));
+            Relational::pax_value_bytes(def.type, value, filter.bytes.data());
+        }
+        pax_scan(*handle, *schema, {}, {}, pax_equality_callback, &filter);
+        return rows;
+    }
+    EqualityScan filter{static_cast<size_t>(column), &codec, prefix, {}, &rows};
+    // FLOAT and DOUBLE compare as values, where 0.0 equals -0.0
+    if (def.type != Relational::ColumnType::FLOAT && def.type != Relational::ColumnType::DOUBLE) {
+        codec.encode_compact_column(static_cast<size_t>(column), value, filter.bytes);
+    }
+    scan_rows(table_name, equality_scan_callback, &filter);
+    return rows;
+}
+
+bool StorageEngine::create_index(const std::string& table_name, const std::string& index_name,
+                                 const std::string& column_name, bool unique,
+                                 const std::vector<std::string>& include) {
+    const Relational::TableSchema* schema = get_schema(table_name);
+    if (schema == nullptr || index_name.empty() || catalog_.find_index(table_name, index_name) != nullptr) {
+        return false;
+    }
+    int column = find_column(*schema, column_name);
+    if (column < 0) {
+        return false;
+    }
+    Relational::IndexDef index{index_name, static_cast<size_t>(column), unique, {}};
+    for (const auto& name : include) {
+        int included = find_column(*schema, name);
+        if (included < 0) {
+            return false;
+        }
+        index.include.push_back(static_cast<size_t>(included));
+    }
+    std::string tree_name = index_table_name(table_name, index_name);
+    if (!::create_table(tree_name)) {
+        return false;
+    }
+    TableHandle* tree = get_or_open_table(tree_name);
+    if (tree == nullptr) {
+        drop_tree(tree_name);
+        return false;
+    }
+
+    // Backfill from the rows already in the table, streamed so memory stays constant;
+    // an entry that cannot go in drops the index rather than leave it missing rows
+    Relational::RowCodec codec(*schema);
+    RowStream stream;
+    if (!open_scan(table_name, stream)) {
+        drop_tree(tree_name);
+        return false;
+    }
+    Relational::Tuple row;
+    while (stream.next(row)) {
+        if (Relational::is_null(row[index.column])) {
+            continue;
+        }
+        std::vector<uint8_t> key = codec.encode_index_key(row, index.column);
+        if (key.size() > BTREE_MAX_KEY_SIZE ||
+            (unique &&
+             !index_entries(*tree, codec, codec.encode_key_column(index.column, row[index.column]), 1).empty()) ||
+            !insert_record(tree, key, codec.encode_index_value(row, index.include))) {
+            stream.close();
+            drop_tree(tree_name);
+            return false;
+        }
+    }
+    if (!catalog_.add_index(table_name, index)) {
+        drop_tree(tree_name);
+        return false;
+    }
+    return true;
+}
+
+const Relational::IndexDef* StorageEngine::find_covering_index(const std::string& table_name,
+                                                               const std::vector<std::string>& columns,
+                                                               const std::string& key_column) const {
+    const Relational::TableSchema* schema = get_schema(table_name);
+    if (schema == nullptr) {
+        return nullptr;
+    }
+    for (const auto& index : schema->indexes) {
+        if (!key_column.empty() && schema->columns[index.column].name != key_column) {
+            continue;
+        }
+        bool covered = true;
+        for (const auto& name : columns) {
+            int column = find_column(*schema, name);
+            covered = covered && column >= 0 && index.covers(static_cast<size_t>(column), *schema);
+        }
+        if (covered) {
+            return &index;
+        }
+    }
+    return nullptr;
+}
+
+bool StorageEngine::index_only_scan(const std::string& table_name, const std::string& index_name,
+                                    const std::vector<std::string>& columns, std::vector<Relational::Tuple>& out_rows,
+                                    const Relational::Value* equals) {
+    out_rows.clear();
+    const Relational::TableSchema* schema = get_schema(table_name);
+    const Relational::IndexDef* index = catalog_.find_index(table_name, index_name);
+    if (schema == nullptr || index == nullptr || schema->pk_index < 0) {
+        return false;
+    }
+    std::vector<size_t> projection;
+    for (const auto& name : columns) {
+        int column = find_column(*schema, name);
+        if (column < 0 || !index->covers(static_cast<size_t>(column), *schema)) {
+            return false;
+        }
+        projection.push_back(static_cast<size_t>(column));
+    }
+    TableHandle* tree = open_index(table_name, *index);
+    if (tree == nullptr) {
+        return false;
+    }
+
+    Relational::RowCodec codec(*schema);
+    std::vector<uint8_t> prefix;
+    if (equals != nullptr) {
+        prefix = codec.encode_key_column(index->column, *equals);
+        if (prefix.empty() || prefix.size() > UINT16_MAX) {
+            return false;
+        }
+    }
+    // Index entries hold the key column, then the primary key and INCLUDE columns
+    // in the value; decode those straight from the leaf into a sparse row. Rows go to
+    // out_rows only once the whole range decoded, so a failure leaves it empty.
+    std::vector<Relational::Tuple> rows;
+    Relational::Tuple row(schema->columns.size());
+    BTreeCursor cursor(*tree);
+    bool ok = prefix.empty() ? cursor.seek_first()
+                             : cursor.seek(Key(prefix.data(), static_cast<uint16_t>(prefix.size())));
+    for (; ok; ok = cursor.next()) {
+        Key k = cursor.key();
+        if (!has_prefix(k, prefix)) {
+            break;
+        }
+        Value v = cursor.value();
+        const uint8_t* kp = k.data();
+        const uint8_t* vp = v.data();
+        const uint8_t* vend = v.data() + v.size();
+        if (!codec.decode_key_column(index->column, kp, k.data() + k.size(), row[index->column]) ||
+            !codec.decode_key(vp, vend, row)) {
+            return false;
+        }
+        for (size_t included : index->include) {
+            if (!codec.decode_column(included, vp, vend, row[included])) {
+                return false;
+            }
+        }
+        Relational::Tuple projected;
+        projected.reserve(projection.size());
+        for (size_t column : projection) {
+            projected.push_back(row[column]);
+        }
+        rows.push_back(std::move(projected));
+    }
+    out_rows.swap(rows);
+    return true;
+}
+
+TableHandle* StorageEngine::open_index(const std::string& table_name, const Relational::IndexDef& index) {
+    return get_or_open_table(index_table_name(table_name, index.name));
+}
+
+bool StorageEngine::read_row(const std::string& table_name, const std::vector<uint8_t>& key, Relational::Tuple& out_row) {
+    const Relational::CompiledRowCodec* codec = catalog_.get_codec(table_name);
+    const Relational::TableSchema* schema = get_schema(table_name);
+    TableHandle* handle = get_or_open_table(table_name);
+    if (schema != nullptr && handle != nullptr && schema->storage == Relational::TableStorage::PAX) {
+        return pax_search(*handle, *schema, key, out_row);
+    }
+    RecordView value;
+    if (codec == nullptr ||
+        !get_record(handle, std::string_view(reinterpret_cast<const char*>(key.data()), key.size()), value)) {
+        return false;
+    }
+    return codec->decode(reinterpret_cast<const uint8_t*>(value.value().data()), value.value().size(), out_row);
 }
 
 std::vector<Relational::Tuple> StorageEngine::scan(const std::string& table_name) {
+    return scan(table_name, std::vector<std::string>{});
+}
+
+std::vector<Relational::Tuple> StorageEngine::scan(const std::string& table_name,
+                                                   const std::vector<std::string>& columns) {
     std::vector<Relational::Tuple> rows;
-    auto schema_opt = catalog_.get_schema(table_name);
-    if (!schema_opt.has_value() || schema_opt.value() == nullptr) {
+    const Relational::TableSchema* schema = get_schema(table_name);
+    TableHandle* handle = get_or_open_table(table_name);
+    if (schema == nullptr || handle == nullptr) {
         return rows;
     }
-    const Relational::TableSchema* schema = schema_opt.value();
+    Relational::RowLayout layout(*schema, catalog_.get_dictionaries(table_name));
+    RelationalScanContext rctx;
+    rctx.layout = &layout;
+    rctx.codec = catalog_.get_codec(table_name);
+    rctx.rows = &rows;
+    for (const std::string& name : columns) {
+        int column = find_column(*schema, name);
+        if (column < 0) {
+            return rows;
+        }
+        rctx.columns.push_back(static_cast<size_t>(column));
+    }
+    scan_relational(*handle, {}, {}, rctx);
+    return rows;
+}
+
+void StorageEngine::scan_rows(const std::string& table_name, RowCallback callback, void* ctx) {
+    const Relational::TableSchema* schema = get_schema(table_name);
     TableHandle* handle = get_or_open_table(table_name);
-    if (handle == nullptr) {
+    if (schema == nullptr || handle == nullptr || callback == nullptr) {
+        return;
+    }
+    Relational::RowLayout layout(*schema, catalog_.get_dictionaries(table_name));
+    RelationalScanContext rctx;
+    rctx.layout = &layout;
+    rctx.codec = catalog_.get_codec(table_name);
+    rctx.visit = callback;
+    rctx.visit_ctx = ctx;
+    scan_relational(*handle, {}, {}, rctx);
+}
+
+bool RowStream::decode(const uint8_t* data, size_t size, Relational::Tuple& row) const {
+    if (columns_.empty()) {
+        return codec_->decode(data, size, row);
+    }
+    row = Relational::RowView(*layout_, data, size).materialize(columns_);
+    return !row.empty();
+}
+
+// Rows of the block under the cursor, then the next block's
+bool RowStream::next_pax(Relational::Tuple& row) {
+    while (cursor_->valid()) {
+        Value value = cursor_->value();
+        Relational::PaxBlockView block(*schema_, value.data(), value.size());
+        while (block_row_ < block.row_count()) {
+            size_t r = block_row_++;
+            if (columns_.empty()) {
+                row = block.row(r);
+                if (!row.empty()) {
+                    return true;
+                }
+                continue;
+            }
+            row.resize(columns_.size());
+            bool ok = true;
+            for (size_t i = 0; i < columns_.size() && ok; i++) {
+                ok = block.get(r, columns_[i], row[i]);
+            }
+            if (ok) {
+                return true;
+            }
+        }
+        block_row_ = 0;
+        cursor_->next();
+    }
+    return false;
+}
+
+void RowStream::buffer_bucket_row(const Key&, const Value& value, void* ctx) {
+    RowStream* stream = static_cast<RowStream*>(ctx);
+    Relational::Tuple row;
+    if (stream->decode(value.data(), value.size(), row)) {
+        stream->buffered_.push_back(std::move(row));
+    }
+}
+
+// Decodes the rows of the next bucket not read yet; false after the last one
+bool RowStream::next_bucket() {
+    buffered_.clear();
+    position_ = 0;
+    while (hash_table_ != nullptr && directory_slot_ < hash_table_->hash_directory.size()) {
+        uint32_t bucket_id = hash_table_->hash_directory[directory_slot_++];
+        if (buckets_read_.insert(bucket_id).second) {
+            return hash_scan_bucket(*hash_table_, bucket_id, buffer_bucket_row, this);
+        }
+    }
+    return false;
+}
+
+bool RowStream::next(Relational::Tuple& row) {
+    if (lsm_cursor_) {
+        while (lsm_cursor_->valid()) {
+            Value value = lsm_cursor_->value();
+            bool ok = decode(value.data(), value.size(), row);
+            lsm_cursor_->next();
+            if (ok) {
+                return true;
+            }
+        }
+        return false;
+    }
+    if (!cursor_) {
+        while (position_ >= buffered_.size()) {
+            if (!next_bucket()) {
+                return false;
+            }
+        }
+        row = std::move(buffered_[position_++]);
+        return true;
+    }
+    if (schema_->storage == Relational::TableStorage::PAX) {
+        return next_pax(row);
+    }
+    // Rows that fail to decode are skipped, as scan drops them
+    while (cursor_->valid()) {
+        Value value = cursor_->value();
+        bool ok = decode(value.data(), value.size(), row);
+        cursor_->next();
+        if (ok) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t RowStream::next_batch(std::vector<Relational::Tuple>& rows, size_t max_rows) {
+    if (rows.size() < max_rows) {
+        rows.resize(max_rows);
+    }
+    size_t n = 0;
+    while (n < max_rows && next(rows[n])) {
+        n++;
+    }
+    rows.resize(n);
+    return n;
+}
+
+void RowStream::close() {
+    cursor_.reset();
+    lsm_cursor_.reset();
+    hash_table_ = nullptr;
+    directory_slot_ = 0;
+    buckets_read_.clear();
+    buffered_.clear();
+    buffered_.shrink_to_fit();
+    position_ = 0;
+}
+
+bool StorageEngine::open_scan(const std::string& table_name, RowStream& out, const std::vector<std::string>& columns) {
+    out.close();
+    out.layout_.reset();
+    out.columns_.clear();
+    out.block_row_ = 0;
+    const Relational::TableSchema* schema = get_schema(table_name);
+    TableHandle* handle = get_or_open_table(table_name);
+    const Relational::CompiledRowCodec* codec = catalog_.get_codec(table_name);
+    if (schema == nullptr || handle == nullptr || codec == nullptr) {
+        return false;
+    }
+    for (const std::string& name : columns) {
+        int column = find_column(*schema, name);
+        if (column < 0) {
+            return false;
+        }
+        out.columns_.push_back(static_cast<size_t>(column));
+    }
+    out.schema_ = schema;
+    out.codec_ = codec;
+    if (!out.columns_.empty()) {
+        out.layout_.emplace(*schema, catalog_.get_dictionaries(table_name));
+    }
+    if (is_lsm_table(*handle)) {
+        out.lsm_cursor_.emplace(*handle);
+        out.lsm_cursor_->seek_first();
+        return true;
+    }
+    if (is_hash_table(*handle)) {
+        out.hash_table_ = handle;
+        return true;
+    }
+    out.cursor_.emplace(*handle);
+    out.cursor_->seek_first();
+    return true;
+}
+
+std::vector<Relational::Tuple> StorageEngine::scan_range(const std::string& table_name, const Relational::Tuple& low,
+                                                         const Relational::Tuple& high) {
+    std::vector<Relational::Tuple> rows;
+    const Relational::TableSchema* schema = get_schema(table_name);
+    TableHandle* handle = get_or_open_table(table_name);
+    if (schema == nullptr || handle == nullptr) {
+        return rows;
+    }
+    Relational::RowLayout layout(*schema, catalog_.get_dictionaries(table_name));
+    std::vector<uint8_t> start = layout.codec.encode_key_prefix(low);
+    std::vector<uint8_t> end = layout.codec.encode_key_prefix(high);
+    if ((start.empty() && !low.empty()) || (end.empty() && !high.empty()) ||
+        start.size() > UINT16_MAX || end.size() > UINT16_MAX) {
         return rows;
     }
+    // A bound shorter than the key takes in every key it prefixes, so the scan runs
+    // up to the prefix's successor and the callback drops anything past the bound
+    std::vector<uint8_t> stop = high.size() < schema->primary_key().size() ? prefix_successor(end) : end;
     RelationalScanContext rctx;
-    rctx.schema = schema;
+    rctx.layout = &layout;
+    rctx.codec = catalog_.get_codec(table_name);
     rctx.rows = &rows;
-    scan_table(handle, relational_scan_callback, &rctx);
+    rctx.high = end;
+    scan_relational(*handle, start, stop, rctx);
     return rows;
 }
 
+bool StorageEngine::scan_column(const std::string& table_name, const std::string& column_name,
+                                ColumnCallback callback, void* ctx) {
+    const Relational::TableSchema* schema = get_schema(table_name);
+    TableHandle* handle = get_or_open_table(table_name);
+    if (schema == nullptr || handle == nullptr || callback == nullptr) {
+        return false;
+    }
+    int column = find_column(*schema, column_name);
+    if (column < 0) {
+        return false;
+    }
+    Relational::ColumnType type = schema->columns[static_cast<size_t>(column)].type;
+    size_t width = Relational::pax_width(type);
+    if (width == 0) {
+        return false;
+    }
+    ColumnScan scan{static_cast<size_t>(column), type, width, callback, ctx, 0, {}, {}};
+    if (schema->storage == Relational::TableStorage::PAX) {
+        pax_scan(*handle, *schema, {}, {}, column_block_callback, &scan);
+    } else {
+        scan_rows(table_name, column_row_callback, &scan);
+        flush_column(scan);
+    }
+    return true;
+}
+
+bool StorageEngine::add_column(const std::string& table_name, const Relational::ColumnDef& column) {
+    return catalog_.add_column(table_name, column);
+}
+
+uint32_t StorageEngine::optimize_table(const std::string& table_name, uint16_t fill_percent) {
+    const Relational::TableSchema* schema = get_schema(table_name);
+    if (schema == nullptr) {
+        return 0;
+    }
+    uint32_t released = vacuum_table(get_or_open_table(table_name), fill_percent);
+    for (const auto& index : schema->indexes) {
+        released += vacuum_table(open_index(table_name, index), fill_percent);
+    }
+    return released;
+}
+
 bool StorageEngine::has_table(const std::string& table_name) const {
     return catalog_.has_table(table_name);
 }
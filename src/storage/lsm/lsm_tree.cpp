@@ -0,0 +1,825 @@
+#include "storage/lsm_tree.hpp"
+#include "storage/hash_index.hpp"
+#include "storage/buffer_pool.hpp"
+#include "storage/page.hpp"
+#include "storage/record.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+static LsmMeta* lsm_meta(Page& meta) {
+    return reinterpret_cast<LsmMeta*>(meta.data + sizeof(PageHeader));
+}
+
+static uint32_t* meta_run_pages(Page& meta) {
+    return reinterpret_cast<uint32_t*>(meta.data + sizeof(PageHeader) + sizeof(LsmMeta));
+}
+
+static LsmRunHeader* run_header(Page& page) {
+    return reinterpret_cast<LsmRunHeader*>(page.data + sizeof(PageHeader));
+}
+
+static constexpr uint32_t BLOOM_BYTES_PER_PAGE = PAGE_SIZE - sizeof(PageHeader);
+static constexpr int BLOOM_PROBES = 7;
+
+// Probe i of a key, by double hashing the two halves of its 64-bit hash
+static uint32_t bloom_bit(uint64_t hash, int i, uint32_t bits) {
+    uint32_t h1 = static_cast<uint32_t>(hash);
+    uint32_t h2 = static_cast<uint32_t>(hash >> 32) | 1;
+    return (h1 + static_cast<uint32_t>(i) * h2) % bits;
+}
+
+static bool bloom_may_contain(const LsmRun& run, uint64_t hash) {
+    uint32_t bits = run.header.bloom_bits;
+    if (bits == 0) {
+        return true;
+    }
+    for (int i = 0; i < BLOOM_PROBES; i++) {
+        uint32_t bit = bloom_bit(hash, i, bits);
+        if (!(run.bloom[bit / 8] & (1 << (bit % 8)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Data page of run that would hold key, found by binary search over the fence keys
+static uint32_t fence_page_for(const LsmRun& run, const Key& key) {
+    auto it = std::upper_bound(run.fence_keys.begin(), run.fence_keys.end(), key,
+                               [](const Key& k, const std::vector<uint8_t>& fence) {
+        return compare_keys(k.data(), k.size(), fence.data(), static_cast<uint16_t>(fence.size())) < 0;
+    });
+    if (it == run.fence_keys.begin()) {
+        return 0;
+    }
+    return run.fence_pages[(it - run.fence_keys.begin()) - 1];
+}
+
+static bool store_runs(TableHandle& th) {
+    Page* meta = th.bpm->fetch_page(0);
+    if (!meta) {
+        return false;
+    }
+    const std::vector<LsmRun>& runs = th.lsm->runs;
+    LsmMeta* lm = lsm_meta(*meta);
+    lm->magic = LSM_MAGIC;
+    lm->run_count = static_cast<uint32_t>(runs.size());
+    for (size_t i = 0; i < runs.size(); i++) {
+        meta_run_pages(*meta)[i] = runs[i].header_page;
+    }
+    th.bpm->unpin_page(0, true);
+    th.bpm->flush_page(0);
+    return true;
+}
+
+static void free_chain(TableHandle& th, uint32_t page_id) {
+    while (page_id != 0) {
+        Page* page = th.bpm->fetch_page(page_id);
+        if (!page) {
+            return;
+        }
+        uint32_t next = get_header(*page)->next_page_id;
+        th.bpm->unpin_page(page_id, false);
+        free_page(th, page_id);
+        page_id = next;
+    }
+}
+
+// Frees the pages of a run; overflow chains belong to whoever holds the records
+static void free_run(TableHandle& th, const LsmRun& run) {
+    free_chain(th, run.header.first_page);
+    free_chain(th, run.header.fence_page);
+    free_chain(th, run.header.bloom_page);
+    free_page(th, run.header_page);
+}
+
+static bool load_run(TableHandle& th, uint32_t header_page, LsmRun& run) {
+    Page* page = th.bpm->fetch_page(header_page);
+    if (!page) {
+        return false;
+    }
+    run.header_page = header_page;
+    run.header = *run_header(*page);
+    th.bpm->unpin_page(header_page, false);
+
+    for (uint32_t page_id = run.header.fence_page; page_id != 0;) {
+        Page* fences = th.bpm->fetch_page(page_id);
+        if (!fences) {
+            return false;
+        }
+        for (uint16_t i = 0; i < get_header(*fences)->cell_count; i++) {
+            uint16_t key_len = 0;
+            uint16_t value_len = 0;
+            const uint8_t* key = slot_key(*fences, i, key_len);
+            const uint8_t* value = slot_value(*fences, i, value_len);
+            if (key == nullptr || value == nullptr || value_len != sizeof(uint32_t)) {
+                continue;
+            }
+            uint32_t data_page = 0;
+            std::memcpy(&data_page, value, sizeof(data_page));
+            run.fence_keys.emplace_back(key, key + key_len);
+            run.fence_pages.push_back(data_page);
+        }
+        uint32_t next = get_header(*fences)->next_page_id;
+        th.bpm->unpin_page(page_id, false);
+        page_id = next;
+    }
+
+    run.bloom.assign((run.header.bloom_bits + 7) / 8, 0);
+    size_t offset = 0;
+    for (uint32_t page_id = run.header.bloom_page; page_id != 0 && offset < run.bloom.size();) {
+        Page* bloom = th.bpm->fetch_page(page_id);
+        if (!bloom) {
+            return false;
+        }
+        size_t count = std::min<size_t>(BLOOM_BYTES_PER_PAGE, run.bloom.size() - offset);
+        std::memcpy(run.bloom.data() + offset, bloom->data + sizeof(PageHeader), count);
+        offset += count;
+        uint32_t next = get_header(*bloom)->next_page_id;
+        th.bpm->unpin_page(page_id, false);
+        page_id = next;
+    }
+    return true;
+}
+
+// Builds a run from records added in strictly increasing key order
+struct RunWriter {
+    TableHandle& th;
+    LsmRun run;
+    uint32_t page_id = 0;
+    Page* page = nullptr;
+    std::vector<uint64_t> hashes;
+};
+
+static bool writer_add(RunWriter& w, const uint8_t* key, uint16_t key_len,
+                       const uint8_t* value, uint16_t value_len, uint8_t flags) {
+    static const uint8_t no_value = 0;
+    if (value == nullptr) {
+        value = &no_value;  // Tombstones carry no value
+    }
+    if (!w.page || !page_insert(*w.page, key, key_len, value, value_len)) {
+        uint32_t page_id = allocate_page(w.th);
+        Page* page = page_id == INVALID_PAGE_ID ? nullptr : w.th.bpm->new_page(page_id, PageType::DATA, PageLevel::LEAF);
+        if (!page) {
+            return false;
+        }
+        if (w.page) {
+            get_header(*w.page)->next_page_id = page_id;
+            w.th.bpm->unpin_page(w.page_id, true);
+        } else {
+            w.run.header.first_page = page_id;
+        }
+        w.page = page;
+        w.page_id = page_id;
+        w.run.header.page_count++;
+        w.run.fence_keys.emplace_back(key, key + key_len);
+        w.run.fence_pages.push_back(page_id);
+        if (!page_insert(*page, key, key_len, value, value_len)) {
+            return false;
+        }
+    }
+    *slot_flags(*w.page, get_header(*w.page)->cell_count - 1) = flags;
+    w.hashes.push_back(hash_key(key, key_len));
+    w.run.header.entry_count++;
+    if (flags & RECORD_DELETED) {
+        w.run.header.tombstone_count++;
+    }
+    return true;
+}
+
+// Appends a page of the given kind to a chain whose tail is pinned in tail
+static Page* chain_page(TableHandle& th, uint32_t& first, uint32_t& tail_id, Page*& tail,
+                        PageType type, PageLevel level) {
+    uint32_t page_id = allocate_page(th);
+    Page* page = page_id == INVALID_PAGE_ID ? nullptr : th.bpm->new_page(page_id, type, level);
+    if (!page) {
+        return nullptr;
+    }
+    if (tail) {
+        get_header(*tail)->next_page_id = page_id;
+        th.bpm->unpin_page(tail_id, true);
+    } else {
+        first = page_id;
+    }
+    tail = page;
+    tail_id = page_id;
+    return page;
+}
+
+// Writes the fence pointers, bloom filter and header of the run; false when it is empty
+static bool writer_finish(RunWriter& w, uint8_t level, LsmRun& out) {
+    TableHandle& th = w.th;
+    if (!w.page) {
+        return false;
+    }
+    th.bpm->unpin_page(w.page_id, true);
+    w.page = nullptr;
+    LsmRun& run = w.run;
+    run.header.level = level;
+
+    uint32_t tail_id = 0;
+    Page* tail = nullptr;
+    for (size_t i = 0; i < run.fence_keys.size(); i++) {
+        const std::vector<uint8_t>& key = run.fence_keys[i];
+        uint8_t value[sizeof(uint32_t)];
+        std::memcpy(value, &run.fence_pages[i], sizeof(value));
+        if ((!tail || !page_insert(*tail, key.data(), static_cast<uint16_t>(key.size()), value, sizeof(value))) &&
+            (!chain_page(th, run.header.fence_page, tail_id, tail, PageType::INDEX, PageLevel::LEAF) ||
+             !page_insert(*tail, key.data(), static_cast<uint16_t>(key.size()), value, sizeof(value)))) {
+            if (tail) {
+                th.bpm->unpin_page(tail_id, true);
+            }
+            return false;
+        }
+    }
+    if (tail) {
+        th.bpm->unpin_page(tail_id, true);
+    }
+
+    uint64_t bits = std::max<uint64_t>(64, run.header.entry_count * LSM_BLOOM_BITS_PER_KEY);
+    run.header.bloom_bits = static_cast<uint32_t>(std::min<uint64_t>(bits, UINT32_MAX - 7));
+    run.bloom.assign((run.header.bloom_bits + 7) / 8, 0);
+    for (uint64_t hash : w.hashes) {
+        for (int i = 0; i < BLOOM_PROBES; i++) {
+            uint32_t bit = bloom_bit(hash, i, run.header.bloom_bits);
+            run.bloom[bit / 8] |= static_cast<uint8_t>(1 << (bit % 8));
+        }
+    }
+    tail = nullptr;
+    for (size_t offset = 0; offset < run.bloom.size(); offset += BLOOM_BYTES_PER_PAGE) {
+        if (!chain_page(th, run.header.bloom_page, tail_id, tail, PageType::META, PageLevel::NONE)) {
+            if (tail) {
+                th.bpm->unpin_page(tail_id, true);
+            }
+            return false;
+        }
+        size_t count = std::min<size_t>(BLOOM_BYTES_PER_PAGE, run.bloom.size() - offset);
+        std::memcpy(tail->data + sizeof(PageHeader), run.bloom.data() + offset, count);
+    }
+    if (tail) {
+        th.bpm->unpin_page(tail_id, true);
+    }
+
+    uint32_t header_id = allocate_page(th);
+    Page* header = header_id == INVALID_PAGE_ID ? nullptr : th.bpm->new_page(header_id, PageType::INDEX, PageLevel::NONE);
+    if (!header) {
+        return false;
+    }
+    *run_header(*header) = run.header;
+    th.bpm->unpin_page(header_id, true);
+    run.header_page = header_id;
+    out = std::move(run);
+    return true;
+}
+
+// Frees every page a failed writer allocated. With owns_overflow the overflow chains
+// its records point to go too; a merge output shares them with its inputs instead.
+static void writer_discard(RunWriter& w, bool owns_overflow) {
+    TableHandle& th = w.th;
+    if (w.page) {
+        th.bpm->unpin_page(w.page_id, true);
+        w.page = nullptr;
+    }
+    for (uint32_t page_id = owns_overflow ? w.run.header.first_page : 0; page_id != 0;) {
+        Page* page = th.bpm->fetch_page(page_id);
+        if (!page) {
+            break;
+        }
+        for (uint16_t i = 0; i < get_header(*page)->cell_count; i++) {
+            if (*slot_flags(*page, i) & RECORD_OVERFLOW) {
+                uint16_t stored_len = 0;
+                const uint8_t* stored = slot_value(*page, i, stored_len);
+                overflow_free(th, overflow_first_page(stored, stored_len));
+            }
+        }
+        uint32_t next = get_header(*page)->next_page_id;
+        th.bpm->unpin_page(page_id, false);
+        page_id = next;
+    }
+    free_chain(th, w.run.header.first_page);
+    free_chain(th, w.run.header.fence_page);
+    free_chain(th, w.run.header.bloom_page);
+    w.run = LsmRun();
+}
+
+// One input of a merge: the memtable or a run, positioned on its current record
+struct MergeSource {
+    const LsmMemTable::Node* node = nullptr;
+    bool from_run = false;
+    uint32_t page_id = 0;
+    Page* page = nullptr;
+    uint16_t index = 0;
+
+    bool valid = false;
+    const uint8_t* key = nullptr;
+    uint16_t key_len = 0;
+    const uint8_t* value = nullptr;
+    uint16_t value_len = 0;
+    uint8_t flags = 0;
+};
+
+// Moves a run source onto the record at its index, following the page chain
+static void source_settle(TableHandle& th, MergeSource& src) {
+    if (!src.from_run) {
+        src.valid = src.node != nullptr;
+        if (src.valid) {
+            src.key = src.node->key.data();
+            src.key_len = static_cast<uint16_t>(src.node->key.size());
+            src.value = src.node->value.data();
+            src.value_len = static_cast<uint16_t>(src.node->value.size());
+            src.flags = src.node->deleted ? RECORD_DELETED : 0;
+        }
+        return;
+    }
+    while (src.page && src.index >= get_header(*src.page)->cell_count) {
+        uint32_t next = get_header(*src.page)->next_page_id;
+        th.bpm->unpin_page(src.page_id, false);
+        src.page = next == 0 ? nullptr : th.bpm->fetch_page(next);
+        src.page_id = next;
+        src.index = 0;
+    }
+    src.valid = src.page != nullptr;
+    if (src.valid) {
+        src.key = slot_key(*src.page, src.index, src.key_len);
+        src.value = slot_value(*src.page, src.index, src.value_len);
+        src.flags = *slot_flags(*src.page, src.index);
+    }
+}
+
+static void source_open_run(TableHandle& th, MergeSource& src, const LsmRun& run, const Key& start) {
+    src.from_run = true;
+    uint32_t page_id = start.empty() ? run.header.first_page : fence_page_for(run, start);
+    if (page_id == 0) {
+        page_id = run.header.first_page;
+    }
+    src.page = page_id == 0 ? nullptr : th.bpm->fetch_page(page_id);
+    src.page_id = page_id;
+    src.index = 0;
+    if (src.page && !start.empty()) {
+        src.index = search_record(*src.page, start.data(), start.size()).index;
+    }
+    source_settle(th, src);
+}
+
+static void source_next(TableHandle& th, MergeSource& src) {
+    if (src.from_run) {
+        src.index++;
+    } else {
+        src.node = src.node->next[0];
+    }
+    source_settle(th, src);
+}
+
+static void source_close(TableHandle& th, MergeSource& src) {
+    if (src.page) {
+        th.bpm->unpin_page(src.page_id, false);
+        src.page = nullptr;
+    }
+    src.valid = false;
+}
+
+// Opens the memtable (when given) and runs [first, last) at start; newer sources come first
+static std::vector<MergeSource> open_sources(TableHandle& th, const LsmMemTable* memtable,
+                                             size_t first, size_t last, const Key& start) {
+    std::vector<MergeSource> sources;
+    sources.reserve(last - first + 1);
+    if (memtable) {
+        MergeSource src;
+        src.node = memtable->seek(start);
+        source_settle(th, src);
+        sources.push_back(src);
+    }
+    for (size_t i = first; i < last; i++) {
+        MergeSource src;
+        source_open_run(th, src, th.lsm->runs[i], start);
+        sources.push_back(src);
+    }
+    return sources;
+}
+
+// The source holding the smallest key, the newest one on a tie; -1 once all are done
+static int merge_winner(const std::vector<MergeSource>& sources) {
+    int best = -1;
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (sources[i].valid &&
+            (best < 0 || compare_keys(sources[i].key, sources[i].key_len,
+                                      sources[best].key, sources[best].key_len) < 0)) {
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+// Moves every source past the winner's key, passing the versions it shadows to shadowed
+template <typename Shadowed>
+static void merge_advance(TableHandle& th, std::vector<MergeSource>& sources, int best, Shadowed shadowed) {
+    MergeSource& winner = sources[best];
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (static_cast<int>(i) != best && sources[i].valid &&
+            compare_keys(sources[i].key, sources[i].key_len, winner.key, winner.key_len) == 0) {
+            shadowed(sources[i]);
+            source_next(th, sources[i]);
+        }
+    }
+    source_next(th, winner);
+}
+
+// Calls emit with the newest version of every key up to end (open when empty), in key
+// order and tombstones included. Versions it shadows are passed to shadowed.
+template <typename Emit, typename Shadowed>
+static void merge_sources(TableHandle& th, std::vector<MergeSource>& sources, const Key& end,
+                          Emit emit, Shadowed shadowed) {
+    while (true) {
+        int best = merge_winner(sources);
+        if (best < 0) {
+            break;
+        }
+        MergeSource& winner = sources[best];
+        if (!end.empty() && compare_keys(winner.key, winner.key_len, end.data(), end.size()) > 0) {
+            break;
+        }
+        if (!emit(winner)) {
+            break;
+        }
+        merge_advance(th, sources, best, shadowed);
+    }
+    for (MergeSource& src : sources) {
+        source_close(th, src);
+    }
+}
+
+// Merges runs [first, last) into one run at level, replacing them in the directory.
+// Tombstones are dropped when no older run lies below the merged ones. The inputs,
+// and the overflow chains of the records the merge shadowed, are freed only once
+// the new directory is stored; a failed merge frees its partial output and leaves
+// the runs as they were.
+static size_t merge_runs(TableHandle& th, size_t first, size_t last, uint8_t level) {
+    std::vector<LsmRun>& runs = th.lsm->runs;
+    bool bottom = last == runs.size();
+    RunWriter w{th, {}, 0, nullptr, {}};
+    size_t dropped = 0;
+    bool ok = true;
+    std::vector<uint32_t> shadowed_chains;
+    std::vector<MergeSource> sources = open_sources(th, nullptr, first, last, Key());
+    merge_sources(th, sources, Key(),
+        [&](const MergeSource& src) {
+            if (bottom && (src.flags & RECORD_DELETED)) {
+                dropped++;
+                return true;
+            }
+            ok = writer_add(w, src.key, src.key_len, src.value, src.value_len, src.flags);
+            return ok;
+        },
+        [&](const MergeSource& src) {
+            if (src.from_run && (src.flags & RECORD_OVERFLOW)) {
+                shadowed_chains.push_back(overflow_first_page(src.value, src.value_len));
+            }
+        });
+
+    LsmRun merged;
+    bool has_output = w.page != nullptr;
+    if (!ok || (has_output && !writer_finish(w, level, merged))) {
+        writer_discard(w, false);
+        return 0;
+    }
+    std::vector<LsmRun> old(std::make_move_iterator(runs.begin() + first), std::make_move_iterator(runs.begin() + last));
+    runs.erase(runs.begin() + first, runs.begin() + last);
+    if (has_output) {
+        runs.insert(runs.begin() + first, std::move(merged));
+    }
+    if (!store_runs(th)) {
+        if (has_output) {
+            free_run(th, runs[first]);
+            runs.erase(runs.begin() + first);
+        }
+        runs.insert(runs.begin() + first, std::make_move_iterator(old.begin()), std::make_move_iterator(old.end()));
+        return 0;
+    }
+    for (const LsmRun& run : old) {
+        free_run(th, run);
+    }
+    for (uint32_t chain : shadowed_chains) {
+        overflow_free(th, chain);
+    }
+    return dropped;
+}
+
+// Level 0 merges into level 1 once it holds too many runs; a deeper level merges
+// into the next once it outgrows its budget
+static void compact_levels(TableHandle& th) {
+    std::vector<LsmRun>& runs = th.lsm->runs;
+    size_t l0 = 0;
+    while (l0 < runs.size() && runs[l0].header.level == 0) {
+        l0++;
+    }
+    if (l0 > LSM_L0_RUNS) {
+        size_t last = l0 < runs.size() && runs[l0].header.level == 1 ? l0 + 1 : l0;
+        merge_runs(th, 0, last, 1);
+    }
+    uint64_t budget = LSM_LEVEL1_PAGES;
+    for (uint8_t level = 1; level < UINT8_MAX; level++, budget *= LSM_LEVEL_RATIO) {
+        size_t i = 0;
+        while (i < runs.size() && runs[i].header.level < level) {
+            i++;
+        }
+        if (i == runs.size() || runs[i].header.level != level) {
+            break;
+        }
+        if (runs[i].header.page_count <= budget) {
+            continue;
+        }
+        size_t last = i + 1 < runs.size() && runs[i + 1].header.level == level + 1 ? i + 2 : i + 1;
+        merge_runs(th, i, last, static_cast<uint8_t>(level + 1));
+    }
+}
+
+bool lsm_create(const std::string& name) {
+    if (!create_table(name)) {
+        return false;
+    }
+    TableHandle th(name);
+    if (!open_table(name, th)) {
+        return false;
+    }
+    Page* meta = th.bpm->fetch_page(0);
+    if (!meta) {
+        return false;
+    }
+    get_header(*meta)->root_page = 0;
+    LsmMeta* lm = lsm_meta(*meta);
+    lm->magic = LSM_MAGIC;
+    lm->run_count = 0;
+    th.bpm->unpin_page(0, true);
+    th.bpm->flush_all();
+    return true;
+}
+
+bool lsm_load(TableHandle& th) {
+    if (!th.bpm) {
+        return false;
+    }
+    Page* meta = th.bpm->fetch_page(0);
+    if (!meta) {
+        return false;
+    }
+    LsmMeta lm = *lsm_meta(*meta);
+    if (lm.magic != LSM_MAGIC || lm.run_count > LSM_MAX_RUNS) {
+        th.bpm->unpin_page(0, false);
+        return false;
+    }
+    std::vector<uint32_t> headers(meta_run_pages(*meta), meta_run_pages(*meta) + lm.run_count);
+    th.bpm->unpin_page(0, false);
+
+    auto tree = std::make_shared<LsmTree>();
+    for (uint32_t header_page : headers) {
+        LsmRun run;
+        if (!load_run(th, header_page, run)) {
+            return false;
+        }
+        tree->runs.push_back(std::move(run));
+    }
+    th.lsm = std::move(tree);
+    th.root_page = 0;
+    return true;
+}
+
+bool lsm_open(const std::string& name, TableHandle& th) {
+    return open_table(name, th) && lsm_load(th);
+}
+
+enum class LsmLookup { MISSING, FOUND, DELETED };
+
+// Newest version of key: memtable first, then each run whose bloom filter admits it
+static LsmLookup lsm_lookup(TableHandle& th, const Key& key, Value* value) {
+    const LsmMemTable::Node* node = th.lsm->memtable.find(key);
+    if (node) {
+        if (node->deleted) {
+            return LsmLookup::DELETED;
+        }
+        if (value) {
+            value->assign(node->value.data(), static_cast<uint16_t>(node->value.size()));
+        }
+        return LsmLookup::FOUND;
+    }
+    uint64_t hash = hash_key(key.data(), key.size());
+    for (const LsmRun& run : th.lsm->runs) {
+        if (!bloom_may_contain(run, hash)) {
+            continue;
+        }
+        uint32_t page_id = fence_page_for(run, key);
+        Page* page = page_id == 0 ? nullptr : th.bpm->fetch_page(page_id);
+        if (!page) {
+            continue;
+        }
+        BSearchResult r = search_record(*page, key.data(), key.size());
+        if (!r.found) {
+            th.bpm->unpin_page(page_id, false);
+            continue;
+        }
+        LsmLookup result = LsmLookup::FOUND;
+        uint8_t flags = *slot_flags(*page, r.index);
+        if (flags & RECORD_DELETED) {
+            result = LsmLookup::DELETED;
+        } else if (value) {
+            uint16_t value_len = 0;
+            const uint8_t* value_data = slot_value(*page, r.index, value_len);
+            if (flags & RECORD_OVERFLOW) {
+                if (!overflow_load(th, value_data, value_len, *value)) {
+                    result = LsmLookup::MISSING;
+                }
+            } else {
+                value->assign(value_data, value_len);
+            }
+        }
+        th.bpm->unpin_page(page_id, false);
+        return result;
+    }
+    return LsmLookup::MISSING;
+}
+
+static bool lsm_put(TableHandle& th, const Key& key, const Value& value, bool deleted) {
+    LsmMemTable& memtable = th.lsm->memtable;
+    memtable.put(key, value, deleted);
+    if (memtable.bytes() >= LSM_MEMTABLE_BYTES) {
+        return lsm_flush(th);
+    }
+    return true;
+}
+
+bool lsm_search(TableHandle& th, const Key& key, Value& value) {
+    if (!is_lsm_table(th) || key.empty()) {
+        return false;
+    }
+    return lsm_lookup(th, key, &value) == LsmLookup::FOUND;
+}
+
+bool lsm_insert(TableHandle& th, const Key& key, const Value& value) {
+    if (!is_lsm_table(th) || key.empty() || key.size() > OVERFLOW_THRESHOLD) {
+        return false;
+    }
+    if (lsm_lookup(th, key, nullptr) == LsmLookup::FOUND) {
+        return false;
+    }
+    return lsm_put(th, key, value, false);
+}
+
+bool lsm_update(TableHandle& th, const Key& key, const Value& value) {
+    if (!is_lsm_table(th) || key.empty() || lsm_lookup(th, key, nullptr) != LsmLookup::FOUND) {
+        return false;
+    }
+    return lsm_put(th, key, value, false);
+}
+
+bool lsm_delete(TableHandle& th, const Key& key) {
+    if (!is_lsm_table(th) || key.empty() || lsm_lookup(th, key, nullptr) != LsmLookup::FOUND) {
+        return false;
+    }
+    return lsm_put(th, key, Value(), true);
+}
+
+void lsm_range_scan(TableHandle& th, const Key& start_key, const Key& end_key,
+                    BTreeRangeScanCallback callback, void* ctx) {
+    if (!is_lsm_table(th) || callback == nullptr) {
+        return;
+    }
+    std::vector<MergeSource> sources = open_sources(th, &th.lsm->memtable, 0, th.lsm->runs.size(), start_key);
+    merge_sources(th, sources, end_key,
+        [&](const MergeSource& src) {
+            if (src.flags & RECORD_DELETED) {
+                return true;
+            }
+            Value v(src.value, src.value_len);
+            if ((src.flags & RECORD_OVERFLOW) && !overflow_load(th, src.value, src.value_len, v)) {
+                return true;
+            }
+            callback(Key(src.key, src.key_len), v, ctx);
+            return true;
+        },
+        [](const MergeSource&) {});
+}
+
+LsmCursor::LsmCursor(TableHandle& th) : th_(th) {}
+
+LsmCursor::~LsmCursor() {
+    close();
+}
+
+bool LsmCursor::seek_first() {
+    close();
+    if (!is_lsm_table(th_)) {
+        return false;
+    }
+    sources_ = open_sources(th_, &th_.lsm->memtable, 0, th_.lsm->runs.size(), Key());
+    return settle();
+}
+
+bool LsmCursor::next() {
+    if (current_ < 0) {
+        return false;
+    }
+    merge_advance(th_, sources_, current_, [](const MergeSource&) {});
+    return settle();
+}
+
+// Stops on the next key whose newest version is live
+bool LsmCursor::settle() {
+    while ((current_ = merge_winner(sources_)) >= 0) {
+        if (!(sources_[current_].flags & RECORD_DELETED)) {
+            return true;
+        }
+        merge_advance(th_, sources_, current_, [](const MergeSource&) {});
+    }
+    close();
+    return false;
+}
+
+void LsmCursor::close() {
+    for (MergeSource& src : sources_) {
+        source_close(th_, src);
+    }
+    sources_.clear();
+    current_ = -1;
+}
+
+Key LsmCursor::key() const {
+    if (current_ < 0) {
+        return Key();
+    }
+    return Key(sources_[current_].key, sources_[current_].key_len);
+}
+
+Value LsmCursor::value() const {
+    if (current_ < 0) {
+        return Value();
+    }
+    const MergeSource& src = sources_[current_];
+    if (src.flags & RECORD_OVERFLOW) {
+        if (!overflow_load(th_, src.value, src.value_len, overflow_value_)) {
+            return Value();
+        }
+        return Value(overflow_value_.data(), overflow_value_.size());
+    }
+    return Value(src.value, src.value_len);
+}
+
+bool lsm_flush(TableHandle& th) {
+    if (!is_lsm_table(th)) {
+        return false;
+    }
+    LsmMemTable& memtable = th.lsm->memtable;
+    if (memtable.empty()) {
+        return true;
+    }
+    if (th.lsm->runs.size() >= LSM_MAX_RUNS) {
+        return false;
+    }
+    // With no runs below, tombstones have nothing left to hide
+    bool bottom = th.lsm->runs.empty();
+    RunWriter w{th, {}, 0, nullptr, {}};
+    for (const LsmMemTable::Node* node = memtable.seek(Key()); node; node = node->next[0]) {
+        uint16_t key_len = static_cast<uint16_t>(node->key.size());
+        bool ok = true;
+        if (node->deleted) {
+            ok = bottom || writer_add(w, node->key.data(), key_len, nullptr, 0, RECORD_DELETED);
+        } else if (node->value.size() > OVERFLOW_THRESHOLD) {
+            uint8_t stored[OVERFLOW_STORED_SIZE];
+            Value value(node->value.data(), static_cast<uint16_t>(node->value.size()));
+            uint16_t stored_len = overflow_store(th, value, stored);
+            ok = stored_len != 0 && writer_add(w, node->key.data(), key_len, stored, stored_len, RECORD_OVERFLOW);
+            if (!ok && stored_len != 0) {
+                overflow_free(th, overflow_first_page(stored, stored_len));
+            }
+        } else {
+            ok = writer_add(w, node->key.data(), key_len, node->value.data(),
+                            static_cast<uint16_t>(node->value.size()), 0);
+        }
+        if (!ok) {
+            writer_discard(w, true);
+            return false;
+        }
+    }
+    LsmRun run;
+    if (w.page != nullptr) {
+        if (!writer_finish(w, 0, run)) {
+            writer_discard(w, true);
+            return false;
+        }
+        th.lsm->runs.insert(th.lsm->runs.begin(), std::move(run));
+    }
+    memtable.clear();
+    store_runs(th);
+    compact_levels(th);
+    return true;
+}
+
+size_t lsm_compact(TableHandle& th) {
+    if (!lsm_flush(th)) {
+        return 0;
+    }
+    std::vector<LsmRun>& runs = th.lsm->runs;
+    if (runs.empty() || (runs.size() == 1 && runs[0].header.tombstone_count == 0)) {
+        return 0;
+    }
+    uint8_t level = std::max<uint8_t>(1, runs.back().header.level);
+    return merge_runs(th, 0, runs.size(), level);
+}
@@ -0,0 +1,98 @@
+#include "storage/lsm_tree.hpp"
+#include "storage/buffer_pool.hpp"
+#include "storage/record.hpp"
+#include <algorithm>
+
+LsmMemTable::LsmMemTable() {
+    head_.next.assign(MAX_HEIGHT, nullptr);
+}
+
+LsmMemTable::~LsmMemTable() {
+    clear();
+}
+
+void LsmMemTable::clear() {
+    Node* node = head_.next[0];
+    while (node) {
+        Node* next = node->next[0];
+        delete node;
+        node = next;
+    }
+    head_.next.assign(MAX_HEIGHT, nullptr);
+    height_ = 1;
+    bytes_ = 0;
+    size_ = 0;
+}
+
+int LsmMemTable::random_height() {
+    // xorshift32; each level is kept with probability 1/4
+    int height = 1;
+    while (height < MAX_HEIGHT) {
+        rng_ ^= rng_ << 13;
+        rng_ ^= rng_ >> 17;
+        rng_ ^= rng_ << 5;
+        if ((rng_ & 3) != 0) {
+            break;
+        }
+        height++;
+    }
+    return height;
+}
+
+static int compare_node(const LsmMemTable::Node* node, const Key& key) {
+    return compare_keys(node->key.data(), static_cast<uint16_t>(node->key.size()), key.data(), key.size());
+}
+
+void LsmMemTable::put(const Key& key, const Value& value, bool deleted) {
+    Node* update[MAX_HEIGHT];
+    Node* node = &head_;
+    for (int level = height_ - 1; level >= 0; level--) {
+        while (node->next[level] && compare_node(node->next[level], key) < 0) {
+            node = node->next[level];
+        }
+        update[level] = node;
+    }
+    Node* found = node->next[0];
+    if (found && compare_node(found, key) == 0) {
+        bytes_ -= found->value.size();
+        found->value.assign(value.data(), value.data() + value.size());
+        found->deleted = deleted;
+        bytes_ += found->value.size();
+        return;
+    }
+
+    int height = random_height();
+    for (int level = height_; level < height; level++) {
+        update[level] = &head_;
+    }
+    height_ = std::max(height_, height);
+    Node* fresh = new Node();
+    fresh->key.assign(key.data(), key.data() + key.size());
+    fresh->value.assign(value.data(), value.data() + value.size());
+    fresh->deleted = deleted;
+    fresh->next.assign(height, nullptr);
+    for (int level = 0; level < height; level++) {
+        fresh->next[level] = update[level]->next[level];
+        update[level]->next[level] = fresh;
+    }
+    bytes_ += fresh->key.size() + fresh->value.size() + sizeof(Node) + height * sizeof(Node*);
+    size_++;
+}
+
+const LsmMemTable::Node* LsmMemTable::seek(const Key& key) const {
+    if (key.empty()) {
+        return head_.next[0];
+    }
+    const Node* node = &head_;
+    for (int level = height_ - 1; level >= 0; level--) {
+        while (node->next[level] && compare_node(node->next[level], key) < 0) {
+            node = node->next[level];
+        }
+    }
+    return node->next[0];
+}
+
+const LsmMemTable::Node* LsmMemTable::find(const Key& key) const {
+    const Node* node = seek(key);
+    return node && !key.empty() && compare_node(node, key) == 0 ? node : nullptr;
+}
@@ -12,6 +12,9 @@ void init_page(Page& page, uint32_t page_id, PageType page_type, PageLevel page_
     page_header->page_level = page_level;
     std::fill_n(page_header->reserved, sizeof(page_header->reserved) / sizeof(page_header->reserved[0]), 0);
     page_header->flags = 0;
+    if (KEY_PREFIX_SLOTS && page_level != PageLevel::NONE) {
+        page_header->flags |= PAGE_FLAG_KEY_PREFIX;
+    }
     page_header->cell_count = 0;
     page_header->free_start = sizeof(PageHeader);
     page_header->free_end = PAGE_SIZE;
@@ -5,7 +5,7 @@
 
 bool can_insert(Page& page, uint16_t record_size) {
     PageHeader* page_header = get_header(page);
-    uint16_t slot_space = (page_header->cell_count + 1) * sizeof(uint16_t);
+    uint16_t slot_space = (page_header->cell_count + 1) * slot_entry_size(page);
     return page_header->free_start + record_size + slot_space <= page_header->free_end;
 }
 
@@ -33,7 +33,9 @@ uint16_t write_record(Page& page, const uint8_t* key, uint16_t key_len, const ui
 
     std::memcpy(ptr, key, key_len);
     ptr += key_len;
-    std::memcpy(ptr, value, value_len);
+    if (value_len > 0) {
+        std::memcpy(ptr, value, value_len);
+    }
 
     uint16_t total_size = record_size(key_len, value_len);
     page_header->free_start = offset + total_size;
@@ -44,15 +46,14 @@ BSearchResult search_record(Page& page, const uint8_t* key, uint16_t key_len) {
     PageHeader* header = get_header(page);
     uint16_t left = 0;
     uint16_t right = header->cell_count;
+    uint32_t prefix = key_prefix(key, key_len);
 
     while (left < right) {
         uint16_t mid = left + (right - left) / 2;
-        uint16_t mid_key_len = 0;
-        const uint8_t* mid_key = slot_key(page, mid, mid_key_len);
-        if (mid_key == nullptr) {
+        int cmp = 0;
+        if (!compare_slot_key(page, mid, key, key_len, prefix, cmp)) {
             return {false, left};
         }
-        int cmp = compare_keys(mid_key, mid_key_len, key, key_len);
         if (cmp < 0) {
             left = mid + 1;
         } else if (cmp > 0) {
@@ -64,7 +65,8 @@ BSearchResult search_record(Page& page, const uint8_t* key, uint16_t key_len) {
     return {false, left};
 }
 
-bool page_insert(Page& page, const uint8_t* key, uint16_t key_size, const uint8_t* value, uint16_t value_size) {
+bool page_insert(Page& page, const uint8_t* key, uint16_t key_size, const uint8_t* value, uint16_t value_size,
+                 uint8_t flags) {
     PageHeader* header = get_header(page);
     
     BSearchResult result = search_record(page, key, key_size);
@@ -86,8 +88,9 @@ bool page_insert(Page& page, const uint8_t* key, uint16_t key_size, const uint8_
         header->free_start = old_free_start;
         return false;
     }
+    reinterpret_cast<RecordHeader*>(page.data + roffset)->flags = flags;
     
-    if (header->free_start > header->free_end - sizeof(uint16_t)) {
+    if (header->free_start > header->free_end - slot_entry_size(page)) {
         header->free_start = old_free_start;
         return false;
     }
@@ -122,3 +125,76 @@ bool page_delete(Page& page, const uint8_t* key, uint16_t key_len) {
     remove_slot(page, sr.index);
     return true;
 }
+
+uint16_t stored_entry_size(Page& page, uint16_t index) {
+    const uint8_t* entry = page.data + *slot_ptr(page, index);
+    if (get_header(page)->page_level == PageLevel::INTERNAL) {
+        return sizeof(InternalEntry) + reinterpret_cast<const InternalEntry*>(entry)->key_size;
+    }
+    const RecordHeader* rh = reinterpret_cast<const RecordHeader*>(entry);
+    return record_size(rh->key_size, rh->value_size);
+}
+
+void page_compact(Page& page) {
+    PageHeader* header = get_header(page);
+    Page old_page;
+    std::memcpy(old_page.data, page.data, PAGE_SIZE);
+
+    uint16_t offset = sizeof(PageHeader);
+    for (uint16_t i = 0; i < header->cell_count; i++) {
+        uint16_t* slot = slot_ptr(page, i);
+        uint16_t rsize = stored_entry_size(old_page, i);
+        std::memcpy(page.data + offset, old_page.data + *slot, rsize);
+        *slot = offset;
+        offset += rsize;
+    }
+    std::memset(page.data + offset, 0, header->free_start - offset);
+    header->free_start = offset;
+}
+
+bool page_update(Page& page, const uint8_t* key, uint16_t key_len, const uint8_t* value, uint16_t value_len) {
+    BSearchResult sr = search_record(page, key, key_len);
+    if (!sr.found) return false;
+    uint16_t* slot = slot_ptr(page, sr.index);
+    if (slot == nullptr) return false;
+    RecordHeader* rh = reinterpret_cast<RecordHeader*>(page.data + *slot);
+
+    // Shrinking or same-size values are overwritten where they are
+    if (value_len <= rh->value_size) {
+        std::memcpy(page.data + *slot + sizeof(RecordHeader) + rh->key_size, value, value_len);
+        rh->value_size = value_len;
+        return true;
+    }
+
+    // Larger values move to free space and the slot is repointed; key and prefix are unchanged
+    PageHeader* header = get_header(page);
+    uint16_t rsize = record_size(key_len, value_len);
+    if (header->free_start + rsize > header->free_end) {
+        // The old record's bytes are free once it is replaced, so the page is packed
+        // without it when the new one only fits in their place
+        page_compact(page);
+        uint16_t old_offset = *slot;
+        uint16_t old_size = stored_entry_size(page, sr.index);
+        if (header->free_start - old_size + rsize > header->free_end) {
+            return false;
+        }
+        std::memmove(page.data + old_offset, page.data + old_offset + old_size,
+                     header->free_start - old_offset - old_size);
+        for (uint16_t i = 0; i < header->cell_count; i++) {
+            uint16_t* other = slot_ptr(page, i);
+            if (*other > old_offset) {
+                *other -= old_size;
+            }
+        }
+        header->free_start -= old_size;
+        std::memset(page.data + header->free_start, 0, old_size);
+    } else {
+        reinterpret_cast<RecordHeader*>(page.data + *slot)->flags |= RECORD_DELETED;
+    }
+    uint16_t roffset = write_record(page, key, key_len, value, value_len);
+    if (roffset == 0) {
+        return false;
+    }
+    *slot = roffset;
+    return true;
+}
@@ -1,7 +1,69 @@
 #include "storage/relational/catalog.hpp"
+#include "storage/relational/compiled_codec.hpp"
 
 namespace Relational {
 
+bool IndexDef::covers(size_t col, const TableSchema& schema) const {
+    if (col == column || schema.is_key_column(col)) {
+        return true;
+    }
+    for (size_t included : include) {
+        if (included == col) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<size_t> TableSchema::primary_key() const {
+    if (!key_columns.empty()) {
+        return key_columns;
+    }
+    if (pk_index < 0) {
+        return {};
+    }
+    return {static_cast<size_t>(pk_index)};
+}
+
+bool TableSchema::is_key_column(size_t column) const {
+    if (key_columns.empty()) {
+        return pk_index >= 0 && column == static_cast<size_t>(pk_index);
+    }
+    for (size_t key_column : key_columns) {
+        if (key_column == column) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t TableSchema::column_count(uint32_t at_version) const {
+    size_t count = 0;
+    while (count < columns.size() && columns[count].added_in <= at_version) {
+        count++;
+    }
+    return count;
+}
+
+namespace {
+bool value_has_type(const Value& value, ColumnType type) {
+    switch (type) {
+        case ColumnType::INT:
+        case ColumnType::DATETIME:
+            return std::holds_alternative<int>(value);
+        case ColumnType::FLOAT:
+            return std::holds_alternative<float>(value);
+        case ColumnType::DOUBLE:
+            return std::holds_alternative<double>(value);
+        case ColumnType::STRING:
+            return std::holds_alternative<std::string>(value);
+        case ColumnType::BOOLEAN:
+            return std::holds_alternative<bool>(value);
+    }
+    return false;
+}
+}
+
 Catalog::Catalog() = default;
 
 Catalog::~Catalog() = default;
@@ -10,7 +72,18 @@ bool Catalog::register_table(const std::string& table_name, const TableSchema& s
     if (tables.find(table_name) != tables.end()) {
         return false;
     }
-    tables.insert(std::make_pair(table_name, schema));
+    for (size_t column : schema.key_columns) {
+        if (column >= schema.columns.size()) {
+            return false;
+        }
+    }
+    if (!schema.key_columns.empty() && static_cast<int>(schema.key_columns[0]) != schema.pk_index) {
+        return false;
+    }
+    auto inserted = tables.insert(std::make_pair(table_name, schema));
+    auto& table_dictionaries = dictionaries[table_name];
+    table_dictionaries = std::make_unique<TableDictionaries>(schema.columns.size());
+    codecs[table_name] = std::make_unique<CompiledRowCodec>(inserted.first->second, table_dictionaries.get());
     return true;
 }
 
@@ -23,6 +96,16 @@ std::optional<const TableSchema*> Catalog::get_schema(const std::string& table_n
     return &found_pair->second;
 }
 
+const CompiledRowCodec* Catalog::get_codec(const std::string& table_name) const {
+    auto found_pair = codecs.find(table_name);
+    return found_pair == codecs.end() ? nullptr : found_pair->second.get();
+}
+
+TableDictionaries* Catalog::get_dictionaries(const std::string& table_name) const {
+    auto found_pair = dictionaries.find(table_name);
+    return found_pair == dictionaries.end() ? nullptr : found_pair->second.get();
+}
+
 bool Catalog::has_table(const std::string& table_name) const {
     return tables.find(table_name) != tables.end();
 }
@@ -34,8 +117,60 @@ bool Catalog::drop_table(const std::string& table_name) {
     }
 
     tables.erase(found_pair);
+    codecs.erase(table_name);
+    dictionaries.erase(table_name);
     return true;
 }
 
+bool Catalog::add_index(const std::string& table_name, const IndexDef& index) {
+    auto found_pair = tables.find(table_name);
+    if (found_pair == tables.end() || index.column >= found_pair->second.columns.size()) {
+        return false;
+    }
+    for (size_t included : index.include) {
+        if (included >= found_pair->second.columns.size()) {
+            return false;
+        }
+    }
+    if (find_index(table_name, index.name) != nullptr) {
+        return false;
+    }
+    found_pair->second.indexes.push_back(index);
+    return true;
 }
 
+bool Catalog::add_column(const std::string& table_name, const ColumnDef& column) {
+    auto found_pair = tables.find(table_name);
+    if (found_pair == tables.end() || column.is_unique ||
+        (!is_null(column.default_value) && !value_has_type(column.default_value, column.type))) {
+        return false;
+    }
+    TableSchema& schema = found_pair->second;
+    for (const auto& existing : schema.columns) {
+        if (existing.name == column.name) {
+            return false;
+        }
+    }
+    schema.version++;
+    schema.columns.push_back(column);
+    schema.columns.back().added_in = schema.version;
+    // Recompiled for the new version; the dictionaries keep the codes rows already hold
+    dictionaries[table_name]->resize(schema.columns.size());
+    codecs[table_name] = std::make_unique<CompiledRowCodec>(schema, dictionaries[table_name].get());
+    return true;
+}
+
+const IndexDef* Catalog::find_index(const std::string& table_name, const std::string& index_name) const {
+    auto found_pair = tables.find(table_name);
+    if (found_pair == tables.end()) {
+        return nullptr;
+    }
+    for (const auto& index : found_pair->second.indexes) {
+        if (index.name == index_name) {
+            return &index;
+        }
+    }
+    return nullptr;
+}
+
+}
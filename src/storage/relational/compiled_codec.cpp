@@ -0,0 +1,235 @@
+#include "storage/relational/compiled_codec.hpp"
+#include <cstring>
+
+namespace Relational {
+
+namespace {
+template <typename T>
+bool store_fixed(const Value& value, uint8_t* out) {
+    const T* x = std::get_if<T>(&value);
+    if (x == nullptr) return false;
+    std::memcpy(out, x, sizeof(T));
+    return true;
+}
+
+template <typename T>
+void load_fixed(const uint8_t* data, Value& out) {
+    T x;
+    std::memcpy(&x, data, sizeof(T));
+    out = x;
+}
+
+bool store_bool(const Value& value, uint8_t* out) {
+    const bool* x = std::get_if<bool>(&value);
+    if (x == nullptr) return false;
+    *out = *x ? 1 : 0;
+    return true;
+}
+
+void load_bool(const uint8_t* data, Value& out) {
+    out = *data != 0;
+}
+
+bool is_null_bit(const uint8_t* row, size_t column) {
+    return (row[1 + column / 8] & (1u << (column % 8))) != 0;
+}
+
+size_t varint_size(int value) {
+    uint64_t zigzag = (static_cast<uint64_t>(static_cast<int64_t>(value)) << 1) ^
+                      static_cast<uint64_t>(static_cast<int64_t>(value) >> 63);
+    size_t n = 1;
+    while (zigzag >= 0x80) {
+        zigzag >>= 7;
+        n++;
+    }
+    return n;
+}
+}
+
+CompiledRowCodec::CompiledRowCodec(const TableSchema& schema, TableDictionaries* dictionaries)
+    : schema_(schema), dictionaries_(dictionaries), column_count_(schema.columns.size()) {
+    for (uint32_t version = 0; version <= schema.version; version++) {
+        programs_.push_back(compile(schema.column_count(version)));
+    }
+}
+
+CompiledRowCodec::Program CompiledRowCodec::compile(size_t column_count) const {
+    CompactLayout layout(schema_, column_count);
+    Program program{column_count, 1 + layout.bitmap_bytes + layout.fixed_bytes, {}, {}};
+    for (size_t i = 0; i < column_count; i++) {
+        uint32_t column = static_cast<uint32_t>(i);
+        bool key = schema_.is_key_column(i);
+        uint32_t offset = static_cast<uint32_t>(1 + layout.bitmap_bytes + layout.position[i]);
+        switch (schema_.columns[i].type) {
+            case ColumnType::FLOAT:
+                program.fixed.push_back({column, offset, key, store_fixed<float>, load_fixed<float>});
+                break;
+            case ColumnType::DOUBLE:
+                program.fixed.push_back({column, offset, key, store_fixed<double>, load_fixed<double>});
+                break;
+            case ColumnType::BOOLEAN:
+                program.fixed.push_back({column, offset, key, store_bool, load_bool});
+                break;
+            case ColumnType::STRING:
+                if (schema_.columns[i].dictionary) {
+                    StringDictionary* dictionary =
+                        dictionaries_ != nullptr && i < dictionaries_->size() ? &(*dictionaries_)[i] : nullptr;
+                    program.variable.push_back({column, key, VariableKind::DICTIONARY, dictionary});
+                } else {
+                    program.variable.push_back({column, key, VariableKind::STRING, nullptr});
+                }
+                break;
+            case ColumnType::INT:
+            case ColumnType::DATETIME:
+                program.variable.push_back({column, key, VariableKind::VARINT, nullptr});
+                break;
+        }
+    }
+    return program;
+}
+
+std::vector<uint8_t> CompiledRowCodec::encode(const Tuple& tuple) const {
+    std::vector<uint8_t> out;
+    if (!encode(tuple, out)) {
+        out.clear();
+    }
+    return out;
+}
+
+bool CompiledRowCodec::encode(const Tuple& tuple, std::vector<uint8_t>& out) const {
+    if (tuple.size() != column_count_) return false;
+    const Program& program = programs_.back();
+    // Size the row first so it is written with a single allocation
+    size_t data_size = 0;
+    for (const VariableField& field : program.variable) {
+        const Value& value = tuple[field.column];
+        bool string = field.kind != VariableKind::VARINT;
+        if (is_null(value)) {
+            if (field.key) return false;
+        } else if (const std::string* s = string ? std::get_if<std::string>(&value) : nullptr) {
+            if (field.kind == VariableKind::STRING) {
+                data_size += s->size();
+            } else {
+                uint32_t code = field.dictionary != nullptr ? field.dictionary->intern(*s) : StringDictionary::NO_CODE;
+                data_size += code == StringDictionary::NO_CODE ? 1 + s->size() : varint_size(static_cast<int>(code) + 1);
+            }
+        } else if (const int* x = string ? nullptr : std::get_if<int>(&value)) {
+            data_size += varint_size(*x);
+        } else {
+            return false;
+        }
+    }
+    if (data_size > UINT16_MAX) return false;
+    size_t offset_width = data_size > UINT8_MAX ? 2 : 1;
+    uint8_t prefix[11] = {ROW_VERSIONED};
+    size_t prefix_size = schema_.version > 0 ? 1 + write_varint(schema_.version, prefix + 1) : 0;
+    out.assign(prefix_size + program.head_size + program.variable.size() * offset_width + data_size, 0);
+    std::memcpy(out.data(), prefix, prefix_size);
+
+    uint8_t* row = out.data() + prefix_size;
+    row[0] = offset_width == 2 ? ROW_COMPACT_V1_WIDE : ROW_COMPACT_V1;
+    for (const FixedField& field : program.fixed) {
+        const Value& value = tuple[field.column];
+        if (is_null(value)) {
+            if (field.key) return false;
+            row[1 + field.column / 8] |= static_cast<uint8_t>(1u << (field.column % 8));
+        } else if (!field.store(value, row + field.offset)) {
+            return false;
+        }
+    }
+    uint8_t* table = row + program.head_size;
+    uint8_t* data = table + program.variable.size() * offset_width;
+    size_t end = 0;
+    for (size_t k = 0; k < program.variable.size(); k++) {
+        const VariableField& field = program.variable[k];
+        const Value& value = tuple[field.column];
+        if (is_null(value)) {
+            row[1 + field.column / 8] |= static_cast<uint8_t>(1u << (field.column % 8));
+        } else if (field.kind != VariableKind::VARINT) {
+            const std::string& s = std::get<std::string>(value);
+            // Interned while sizing, so this is a lookup
+            uint32_t code = field.kind == VariableKind::DICTIONARY && field.dictionary != nullptr
+                                ? field.dictionary->find(s) : StringDictionary::NO_CODE;
+            if (field.kind == VariableKind::DICTIONARY && code != StringDictionary::NO_CODE) {
+                end += write_varint(static_cast<int64_t>(code) + 1, data + end);
+            } else {
+                if (field.kind == VariableKind::DICTIONARY) {
+                    data[end++] = 0;
+                }
+                std::memcpy(data + end, s.data(), s.size());
+                end += s.size();
+            }
+        } else {
+            end += write_varint(std::get<int>(value), data + end);
+        }
+        table[k * offset_width] = static_cast<uint8_t>(end);
+        if (offset_width == 2) {
+            table[k * offset_width + 1] = static_cast<uint8_t>(end >> 8);
+        }
+    }
+    return true;
+}
+
+Tuple CompiledRowCodec::decode(const std::vector<uint8_t>& data) const {
+    Tuple out;
+    if (!decode(data.data(), data.size(), out)) {
+        out.clear();
+    }
+    return out;
+}
+
+bool CompiledRowCodec::decode_fixed(const Program& program, const uint8_t* data, size_t size, Tuple& out) const {
+    if (size < program.head_size) return false;
+    out.resize(column_count_);
+    for (size_t i = program.column_count; i < column_count_; i++) {
+        out[i] = schema_.columns[i].default_value;
+    }
+    for (const FixedField& field : program.fixed) {
+        if (is_null_bit(data, field.column)) {
+            out[field.column] = Null();
+        } else {
+            field.load(data + field.offset, out[field.column]);
+        }
+    }
+    return true;
+}
+
+bool CompiledRowCodec::decode(const uint8_t* data, size_t size, Tuple& out) const {
+    RowFormat format = row_format(data, size);
+    if (format == RowFormat::TAGGED) {
+        out = RowCodec(schema_, dictionaries_).decode(data, size);
+        return out.size() == column_count_;
+    }
+    uint32_t version;
+    if (format != RowFormat::COMPACT || !split_row_version(data, size, version) || version >= programs_.size()) {
+        return false;
+    }
+    const Program& program = programs_[version];
+    if (!decode_fixed(program, data, size, out)) return false;
+    if (program.variable.empty()) {
+        return true;
+    }
+    size_t offset_width = data[0] == ROW_COMPACT_V1_WIDE ? 2 : 1;
+    const uint8_t* table = data + program.head_size;
+    size_t data_start = program.head_size + program.variable.size() * offset_width;
+    if (size < data_start) return false;
+    size_t start = 0;
+    for (size_t k = 0; k < program.variable.size(); k++) {
+        const VariableField& field = program.variable[k];
+        size_t end = offset_width == 2 ? static_cast<size_t>(table[2 * k] | (table[2 * k + 1] << 8))
+                                       : static_cast<size_t>(table[k]);
+        if (end < start || data_start + end > size) return false;
+        if (is_null_bit(data, field.column)) {
+            out[field.column] = Null();
+        } else if (field.kind == VariableKind::STRING) {
+            out[field.column] = std::string(reinterpret_cast<const char*>(data + data_start + start), end - start);
+        } else if (!read_compact_value(schema_.columns[field.column], data + data_start + start, end - start,
+                                       out[field.column], field.dictionary)) {
+            return false;
+        }
+        start = end;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,472 @@
+#include "storage/relational/pax_block.hpp"
+#include "storage/record.hpp"
+#include "storage/buffer_pool.hpp"
+#include <cstring>
+
+namespace Relational {
+
+namespace {
+uint16_t read_u16(const uint8_t* p) {
+    uint16_t x;
+    std::memcpy(&x, p, 2);
+    return x;
+}
+
+void append_u16(std::vector<uint8_t>& out, size_t x) {
+    uint16_t v = static_cast<uint16_t>(x);
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&v);
+    out.insert(out.end(), p, p + 2);
+}
+
+void set_u16(std::vector<uint8_t>& out, size_t at, size_t x) {
+    uint16_t v = static_cast<uint16_t>(x);
+    std::memcpy(out.data() + at, &v, 2);
+}
+
+}
+
+bool pax_value_bytes(ColumnType type, const Value& value, uint8_t* out) {
+    size_t width = pax_width(type);
+    if (width == 0) return false;
+    std::memset(out, 0, width);
+    if (is_null(value)) return true;
+    switch (type) {
+        case ColumnType::INT:
+        case ColumnType::DATETIME: {
+            const int* x = std::get_if<int>(&value);
+            if (x == nullptr) return false;
+            int32_t v = *x;
+            std::memcpy(out, &v, 4);
+            return true;
+        }
+        case ColumnType::FLOAT: {
+            const float* x = std::get_if<float>(&value);
+            if (x == nullptr) return false;
+            std::memcpy(out, x, 4);
+            return true;
+        }
+        case ColumnType::DOUBLE: {
+            const double* x = std::get_if<double>(&value);
+            if (x == nullptr) return false;
+            std::memcpy(out, x, 8);
+            return true;
+        }
+        case ColumnType::BOOLEAN: {
+            const bool* x = std::get_if<bool>(&value);
+            if (x == nullptr) return false;
+            out[0] = *x ? 1 : 0;
+            return true;
+        }
+        case ColumnType::STRING:
+            break;
+    }
+    return false;
+}
+
+size_t pax_width(ColumnType type) {
+    switch (type) {
+        case ColumnType::INT:
+        case ColumnType::DATETIME:
+        case ColumnType::FLOAT:
+            return 4;
+        case ColumnType::DOUBLE:
+            return 8;
+        case ColumnType::BOOLEAN:
+            return 1;
+        case ColumnType::STRING:
+            return 0;
+    }
+    return 0;
+}
+
+std::vector<uint8_t> encode_pax_block(const TableSchema& schema, const std::vector<std::vector<uint8_t>>& keys,
+                                      const std::vector<Tuple>& rows) {
+    size_t n = rows.size();
+    size_t columns = schema.columns.size();
+    if (keys.size() != n || n > UINT16_MAX) return {};
+    std::vector<uint8_t> out;
+    append_u16(out, n);
+    append_u16(out, columns);
+    out.resize(4 + 2 * (columns + 1));
+
+    size_t total = 0;
+    for (const auto& key : keys) {
+        total += key.size();
+        append_u16(out, total);
+    }
+    for (const auto& key : keys) {
+        out.insert(out.end(), key.begin(), key.end());
+    }
+    set_u16(out, 4, out.size());
+
+    for (size_t c = 0; c < columns; c++) {
+        ColumnType type = schema.columns[c].type;
+        size_t bitmap = out.size();
+        out.resize(out.size() + (n + 7) / 8, 0);
+        for (size_t r = 0; r < n; r++) {
+            if (rows[r].size() != columns) return {};
+            if (is_null(rows[r][c])) {
+                if (schema.is_key_column(c)) return {};
+                out[bitmap + r / 8] |= static_cast<uint8_t>(1u << (r % 8));
+            }
+        }
+        if (type != ColumnType::STRING) {
+            size_t width = pax_width(type);
+            for (size_t r = 0; r < n; r++) {
+                out.resize(out.size() + width);
+                if (!pax_value_bytes(type, rows[r][c], out.data() + out.size() - width)) return {};
+            }
+        } else {
+            total = 0;
+            for (size_t r = 0; r < n; r++) {
+                const std::string* s = std::get_if<std::string>(&rows[r][c]);
+                if (s == nullptr && !is_null(rows[r][c])) return {};
+                total += s != nullptr ? s->size() : 0;
+                append_u16(out, total);
+            }
+            for (size_t r = 0; r < n; r++) {
+                if (const std::string* s = std::get_if<std::string>(&rows[r][c])) {
+                    out.insert(out.end(), s->begin(), s->end());
+                }
+            }
+        }
+        set_u16(out, 4 + 2 * (c + 1), out.size());
+        if (out.size() > UINT16_MAX) return {};
+    }
+    return out;
+}
+
+PaxBlockView::PaxBlockView(const TableSchema& _schema, const uint8_t* _data, size_t _size)
+    : schema(_schema), data(_data), size(_size) {
+    if (size < 4) return;
+    rows = read_u16(data);
+    stored_columns = read_u16(data + 2);
+    size_t header = 4 + 2 * (stored_columns + 1);
+    if (stored_columns > schema.columns.size() || header > size) return;
+    size_t previous = header;
+    for (size_t m = 0; m <= stored_columns; m++) {
+        size_t end = read_u16(data + 4 + 2 * m);
+        if (end < previous || end > size) return;
+        previous = end;
+    }
+    ok = true;
+}
+
+bool PaxBlockView::minipage(size_t m, size_t& start, size_t& end) const {
+    if (!ok || m > stored_columns) return false;
+    start = m == 0 ? 4 + 2 * (stored_columns + 1) : read_u16(data + 4 + 2 * (m - 1));
+    end = read_u16(data + 4 + 2 * m);
+    return true;
+}
+
+bool PaxBlockView::entry(size_t start, size_t end, size_t row, const uint8_t*& out, size_t& len) const {
+    size_t base = start + 2 * rows;
+    if (row >= rows || base > end) return false;
+    size_t from = row == 0 ? 0 : read_u16(data + start + 2 * (row - 1));
+    size_t to = read_u16(data + start + 2 * row);
+    if (from > to || base + to > end) return false;
+    out = data + base + from;
+    len = to - from;
+    return true;
+}
+
+bool PaxBlockView::key(size_t row, const uint8_t*& out, size_t& len) const {
+    size_t start, end;
+    return minipage(0, start, end) && entry(start, end, row, out, len);
+}
+
+size_t PaxBlockView::lower_bound(const uint8_t* key_data, size_t len, bool& found) const {
+    size_t low = 0;
+    size_t high = rows;
+    found = false;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        const uint8_t* k = nullptr;
+        size_t k_len = 0;
+        if (!key(mid, k, k_len)) return rows;
+        int cmp = compare_keys(k, static_cast<uint16_t>(k_len), key_data, static_cast<uint16_t>(len));
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    const uint8_t* k = nullptr;
+    size_t k_len = 0;
+    found = key(low, k, k_len) &&
+            compare_keys(k, static_cast<uint16_t>(k_len), key_data, static_cast<uint16_t>(len)) == 0;
+    return low;
+}
+
+bool PaxBlockView::get(size_t row, size_t column, Value& out) const {
+    if (!ok || row >= rows || column >= schema.columns.size()) return false;
+    if (column >= stored_columns) {
+        out = schema.columns[column].default_value;
+        return true;
+    }
+    size_t start, end;
+    size_t bitmap = (rows + 7) / 8;
+    if (!minipage(column + 1, start, end) || start + bitmap > end) return false;
+    if (data[start + row / 8] & (1u << (row % 8))) {
+        out = Null();
+        return true;
+    }
+    ColumnType type = schema.columns[column].type;
+    size_t width = pax_width(type);
+    if (width == 0) {
+        const uint8_t* s = nullptr;
+        size_t len = 0;
+        if (!entry(start + bitmap, end, row, s, len)) return false;
+        out = std::string(reinterpret_cast<const char*>(s), len);
+        return true;
+    }
+    const uint8_t* p = data + start + bitmap + row * width;
+    if (start + bitmap + (row + 1) * width > end) return false;
+    switch (type) {
+        case ColumnType::INT:
+        case ColumnType::DATETIME: {
+            int32_t x;
+            std::memcpy(&x, p, 4);
+            out = static_cast<int>(x);
+            return true;
+        }
+        case ColumnType::FLOAT: {
+            float x;
+            std::memcpy(&x, p, 4);
+            out = x;
+            return true;
+        }
+        case ColumnType::DOUBLE: {
+            double x;
+            std::memcpy(&x, p, 8);
+            out = x;
+            return true;
+        }
+        case ColumnType::BOOLEAN:
+            out = *p != 0;
+            return true;
+        case ColumnType::STRING:
+            break;
+    }
+    return false;
+}
+
+Tuple PaxBlockView::row(size_t r) const {
+    Tuple result(schema.columns.size());
+    for (size_t c = 0; c < result.size(); c++) {
+        if (!get(r, c, result[c])) return {};
+    }
+    return result;
+}
+
+bool PaxBlockView::column(size_t c, ColumnBatch& out) const {
+    size_t start, end;
+    size_t bitmap = (rows + 7) / 8;
+    if (c >= stored_columns || !minipage(c + 1, start, end)) return false;
+    size_t width = pax_width(schema.columns[c].type);
+    if (width == 0 || start + bitmap + rows * width > end) return false;
+    out = {schema.columns[c].type, rows, data + start + bitmap, data + start};
+    return true;
+}
+
+}
+
+namespace {
+using Relational::PaxBlockView;
+using Relational::TableSchema;
+using Relational::Tuple;
+using Bytes = std::vector<uint8_t>;
+
+// The block that holds or would hold key: the last one whose key is <= key, or the
+// first block when key is below every block. False on an empty table.
+bool find_block(TableHandle& th, const Bytes& key, Bytes& block_key, Bytes& block) {
+    BTreeCursor cursor(th);
+    Key k(key.data(), static_cast<uint16_t>(key.size()));
+    bool ok = cursor.seek(k);
+    if (ok) {
+        Key found = cursor.key();
+        if (compare_keys(found.data(), found.size(), k.data(), k.size()) != 0 && !cursor.prev()) {
+            ok = cursor.seek_first();
+        }
+    } else {
+        ok = cursor.seek_last();
+    }
+    if (!ok) return false;
+    Key found = cursor.key();
+    Value value = cursor.value();
+    block_key.assign(found.data(), found.data() + found.size());
+    block.assign(value.data(), value.data() + value.size());
+    return true;
+}
+
+bool read_block(const TableSchema& schema, const Bytes& block, std::vector<Bytes>& keys, std::vector<Tuple>& rows) {
+    PaxBlockView view(schema, block.data(), block.size());
+    if (!view.valid()) return false;
+    for (size_t r = 0; r < view.row_count(); r++) {
+        const uint8_t* k = nullptr;
+        size_t len = 0;
+        Tuple row = view.row(r);
+        if (!view.key(r, k, len) || row.empty()) return false;
+        keys.emplace_back(k, k + len);
+        rows.push_back(std::move(row));
+    }
+    return true;
+}
+
+// Splits rows [from, to) into blocks of at most PAX_BLOCK_BYTES. An append keeps the
+// older rows together, so tables loaded in key order end up with full blocks.
+bool build_blocks(const TableSchema& schema, const std::vector<Bytes>& keys, const std::vector<Tuple>& rows,
+                  size_t from, size_t to, bool append, std::vector<std::pair<Bytes, Bytes>>& out) {
+    std::vector<Bytes> part_keys(keys.begin() + from, keys.begin() + to);
+    std::vector<Tuple> part_rows(rows.begin() + from, rows.begin() + to);
+    Bytes block = Relational::encode_pax_block(schema, part_keys, part_rows);
+    if (!block.empty() && block.size() + part_keys[0].size() <= Relational::PAX_BLOCK_BYTES) {
+        out.emplace_back(part_keys[0], std::move(block));
+        return true;
+    }
+    if (to - from < 2) return false;  // One row alone is too wide
+    size_t split = append ? to - 1 : from + (to - from) / 2;
+    return build_blocks(schema, keys, rows, from, split, append, out) &&
+           build_blocks(schema, keys, rows, split, to, append, out);
+}
+
+// Takes back blocks store_rows inserted before a later write failed
+void remove_blocks(TableHandle& th, const std::vector<std::pair<Bytes, Bytes>>& blocks, size_t count,
+                   const Bytes& old_key) {
+    for (size_t i = 0; i < count; i++) {
+        const Bytes& key = blocks[i].first;
+        if (key != old_key) {
+            btree_delete(th, Key(key.data(), static_cast<uint16_t>(key.size())));
+        }
+    }
+}
+
+// Replaces the block stored under old_key with rows, split as needed. The new blocks
+// go in before the old one is replaced or removed, so a failed write takes them back
+// out and leaves the old block as it was.
+bool store_rows(TableHandle& th, const TableSchema& schema, const Bytes& old_key, const std::vector<Bytes>& keys,
+                const std::vector<Tuple>& rows, bool append) {
+    Key old_k(old_key.data(), static_cast<uint16_t>(old_key.size()));
+    if (rows.empty()) {
+        return btree_delete(th, old_k);
+    }
+    std::vector<std::pair<Bytes, Bytes>> blocks;
+    if (!build_blocks(schema, keys, rows, 0, rows.size(), append, blocks)) return false;
+    const Bytes* replacement = nullptr;  // The block keeping old_key, when one does
+    for (size_t i = 0; i < blocks.size(); i++) {
+        const Bytes& key = blocks[i].first;
+        if (!old_key.empty() && key == old_key) {
+            replacement = &blocks[i].second;
+            continue;
+        }
+        Key k(key.data(), static_cast<uint16_t>(key.size()));
+        Value v(blocks[i].second.data(), static_cast<uint16_t>(blocks[i].second.size()));
+        if (!btree_insert(th, k, v)) {
+            remove_blocks(th, blocks, i, old_key);
+            return false;
+        }
+    }
+    if (old_key.empty()) {
+        return true;
+    }
+    // A key below the first block moves that block's key down, dropping the old one
+    bool ok = replacement != nullptr
+                  ? btree_update(th, old_k, Value(replacement->data(), static_cast<uint16_t>(replacement->size())))
+                  : btree_delete(th, old_k);
+    if (!ok) {
+        remove_blocks(th, blocks, blocks.size(), old_key);
+    }
+    return ok;
+}
+
+struct PaxScan {
+    const TableSchema* schema;
+    PaxBlockCallback callback;
+    void* ctx;
+};
+
+void pax_scan_callback(const Key&, const Value& value, void* ctx) {
+    PaxScan* scan = static_cast<PaxScan*>(ctx);
+    PaxBlockView view(*scan->schema, value.data(), value.size());
+    if (view.valid()) {
+        scan->callback(view, scan->ctx);
+    }
+}
+}
+
+bool pax_search(TableHandle& th, const TableSchema& schema, const Bytes& key, Tuple& row) {
+    Bytes block_key, block;
+    if (key.empty() || !find_block(th, key, block_key, block)) return false;
+    PaxBlockView view(schema, block.data(), block.size());
+    bool found = false;
+    size_t r = view.lower_bound(key.data(), key.size(), found);
+    if (!found) return false;
+    row = view.row(r);
+    return !row.empty();
+}
+
+bool pax_insert(TableHandle& th, const TableSchema& schema, const Bytes& key, const Tuple& row) {
+    if (key.empty() || key.size() > UINT16_MAX) return false;
+    Bytes block_key, block;
+    std::vector<Bytes> keys;
+    std::vector<Tuple> rows;
+    if (find_block(th, key, block_key, block) && !read_block(schema, block, keys, rows)) return false;
+    size_t pos = 0;
+    while (pos < keys.size() && compare_keys(keys[pos].data(), static_cast<uint16_t>(keys[pos].size()), key.data(),
+                                             static_cast<uint16_t>(key.size())) < 0) {
+        pos++;
+    }
+    if (pos < keys.size() && keys[pos] == key) return false;
+    bool append = !keys.empty() && pos == keys.size();
+    keys.insert(keys.begin() + pos, key);
+    rows.insert(rows.begin() + pos, row);
+    return store_rows(th, schema, block_key, keys, rows, append);
+}
+
+bool pax_update(TableHandle& th, const TableSchema& schema, const Bytes& key, const Tuple& row) {
+    Bytes block_key, block;
+    std::vector<Bytes> keys;
+    std::vector<Tuple> rows;
+    if (key.empty() || !find_block(th, key, block_key, block) || !read_block(schema, block, keys, rows)) return false;
+    for (size_t r = 0; r < keys.size(); r++) {
+        if (keys[r] == key) {
+            rows[r] = row;
+            return store_rows(th, schema, block_key, keys, rows, false);
+        }
+    }
+    return false;
+}
+
+bool pax_delete(TableHandle& th, const TableSchema& schema, const Bytes& key) {
+    Bytes block_key, block;
+    std::vector<Bytes> keys;
+    std::vector<Tuple> rows;
+    if (key.empty() || !find_block(th, key, block_key, block) || !read_block(schema, block, keys, rows)) return false;
+    for (size_t r = 0; r < keys.size(); r++) {
+        if (keys[r] == key) {
+            // The block keeps its key: it is still below every row left in it
+            keys.erase(keys.begin() + static_cast<std::ptrdiff_t>(r));
+            rows.erase(rows.begin() + static_cast<std::ptrdiff_t>(r));
+            return store_rows(th, schema, block_key, keys, rows, false);
+        }
+    }
+    return false;
+}
+
+void pax_scan(TableHandle& th, const TableSchema& schema, const Bytes& start, const Bytes& end,
+              PaxBlockCallback callback, void* ctx) {
+    Bytes first;
+    if (!start.empty()) {
+        Bytes block;
+        if (!find_block(th, start, first, block)) return;
+    }
+    Key k_start, k_end;
+    if (!first.empty()) {
+        k_start = Key(first.data(), static_cast<uint16_t>(first.size()));
+    }
+    if (!end.empty()) {
+        k_end = Key(end.data(), static_cast<uint16_t>(end.size()));
+    }
+    PaxScan scan{&schema, callback, ctx};
+    btree_range_scan(th, k_start, k_end, pax_scan_callback, &scan);
+}
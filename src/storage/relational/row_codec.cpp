@@ -1,19 +1,31 @@
 #include "storage/relational/row_codec.hpp"
 #include <cstring>
+#include <algorithm>
 
 namespace Relational {
 
-RowCodec::RowCodec(const TableSchema& _schema) : schema(_schema) {}
+RowCodec::RowCodec(const TableSchema& _schema, TableDictionaries* _dictionaries)
+    : schema(_schema), dictionaries(_dictionaries) {}
 
 namespace {
-    constexpr uint8_t TAG_INT = 0;
-    constexpr uint8_t TAG_FLOAT = 1;
-    constexpr uint8_t TAG_DOUBLE = 2;
-    constexpr uint8_t TAG_STRING = 3;
-    constexpr uint8_t TAG_BOOLEAN = 4;
-    constexpr uint8_t TAG_DATETIME = 5;
+// A zigzag varint filling exactly len bytes
+bool read_varint(const uint8_t* data, size_t len, int64_t& out) {
+    uint64_t zigzag = 0;
+    if (len == 0 || len > 10) return false;
+    for (size_t i = 0; i < len; i++) {
+        bool last = i + 1 == len;
+        if (((data[i] & 0x80) == 0) != last) return false;
+        zigzag |= static_cast<uint64_t>(data[i] & 0x7F) << (7 * i);
+    }
+    out = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+    return true;
+}
 
 void append_column(std::vector<uint8_t>& result, Relational::ColumnType type, const Relational::Value& v) {
+    if (is_null(v)) {
+        result.push_back(TAG_NULL);
+        return;
+    }
     switch (type) {
         case Relational::ColumnType::INT: {
             result.push_back(TAG_INT);
@@ -62,13 +74,159 @@ void append_column(std::vector<uint8_t>& result, Relational::ColumnType type, co
     }
 }
 
+// Key encodings carry no type tag, since every key of a table has the same column
+// types, and compare with memcmp in value order
+void append_big_endian(std::vector<uint8_t>& result, uint64_t bits, size_t bytes) {
+    for (size_t i = bytes; i-- > 0;) {
+        result.push_back(static_cast<uint8_t>(bits >> (i * 8)));
+    }
+}
+
+uint64_t read_big_endian(const uint8_t* p, size_t bytes) {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        bits = (bits << 8) | p[i];
+    }
+    return bits;
+}
+
+// IEEE floats order like sign-magnitude integers: flipping the sign bit of positive
+// values and every bit of negative ones makes them order as unsigned integers
+template <typename Float, typename Bits>
+Bits float_to_key(Float x) {
+    constexpr Bits sign = Bits(1) << (sizeof(Bits) * 8 - 1);
+    if (x == 0) {
+        x = 0;  // -0.0 equals 0.0, so both get one encoding
+    }
+    Bits bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return (bits & sign) ? ~bits : bits | sign;
+}
+
+template <typename Float, typename Bits>
+Float float_from_key(Bits bits) {
+    constexpr Bits sign = Bits(1) << (sizeof(Bits) * 8 - 1);
+    bits = (bits & sign) ? bits & ~sign : ~bits;
+    Float x;
+    std::memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+// Strings escape each 0x00 byte as 0x00 0xFF and end with 0x00 0x01, so a string
+// sorts before every longer string it prefixes and the columns after it stay aligned
+constexpr uint8_t STRING_ESCAPE = 0xFF;
+constexpr uint8_t STRING_END = 0x01;
+
+// Keys have no NULL encoding: primary key columns cannot be NULL, and NULL values
+// are left out of secondary indexes
+bool append_key_column(std::vector<uint8_t>& result, ColumnType type, const Value& v) {
+    if (is_null(v)) {
+        return false;
+    }
+    switch (type) {
+        case ColumnType::INT:
+            append_big_endian(result, static_cast<uint32_t>(std::get<int>(v)) ^ 0x80000000u, 4);
+            break;
+        case ColumnType::FLOAT:
+            append_big_endian(result, float_to_key<float, uint32_t>(std::get<float>(v)), 4);
+            break;
+        case ColumnType::DOUBLE:
+            append_big_endian(result, float_to_key<double, uint64_t>(std::get<double>(v)), 8);
+            break;
+        case ColumnType::STRING: {
+            const std::string& s = std::get<std::string>(v);
+            for (char c : s) {
+                result.push_back(static_cast<uint8_t>(c));
+                if (c == 0) {
+                    result.push_back(STRING_ESCAPE);
+                }
+            }
+            result.push_back(0);
+            result.push_back(STRING_END);
+            break;
+        }
+        case ColumnType::BOOLEAN:
+            result.push_back(std::get<bool>(v) ? 1 : 0);
+            break;
+        case ColumnType::DATETIME: {
+            // Seconds since the epoch when the value carries them
+            const int* seconds = std::get_if<int>(&v);
+            int64_t x = seconds ? *seconds : 0;
+            append_big_endian(result, static_cast<uint64_t>(x) ^ (uint64_t(1) << 63), 8);
+            break;
+        }
+    }
+    return true;
+}
+
+size_t compact_fixed_width(ColumnType type) {
+    switch (type) {
+        case ColumnType::FLOAT: return 4;
+        case ColumnType::DOUBLE: return 8;
+        case ColumnType::BOOLEAN: return 1;
+        default: return 0;
+    }
+}
+
+bool write_compact_fixed(ColumnType type, const Value& v, uint8_t* out) {
+    if (const float* x = type == ColumnType::FLOAT ? std::get_if<float>(&v) : nullptr) {
+        std::memcpy(out, x, 4);
+    } else if (const double* x = type == ColumnType::DOUBLE ? std::get_if<double>(&v) : nullptr) {
+        std::memcpy(out, x, 8);
+    } else if (const bool* x = type == ColumnType::BOOLEAN ? std::get_if<bool>(&v) : nullptr) {
+        *out = *x ? 1 : 0;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool append_compact_variable(std::vector<uint8_t>& result, const ColumnDef& column, const Value& v,
+                             StringDictionary* dictionary) {
+    if (column.type == ColumnType::STRING) {
+        const std::string* s = std::get_if<std::string>(&v);
+        if (s == nullptr) return false;
+        if (column.dictionary) {
+            append_dictionary_string(result, *s, dictionary);
+        } else {
+            result.insert(result.end(), s->begin(), s->end());
+        }
+        return true;
+    }
+    const int* x = std::get_if<int>(&v);
+    if (x == nullptr) return false;
+    uint8_t buf[10];
+    result.insert(result.end(), buf, buf + write_varint(*x, buf));
+    return true;
+}
+
 }
 
 std::vector<uint8_t> RowCodec::encode_key(const Tuple& tuple) const {
     std::vector<uint8_t> result;
-    if (schema.pk_index < 0 || static_cast<size_t>(schema.pk_index) >= schema.columns.size()) return result;
-    if (tuple.size() <= static_cast<size_t>(schema.pk_index)) return result;
-    append_column(result, schema.columns[static_cast<size_t>(schema.pk_index)].type, tuple[static_cast<size_t>(schema.pk_index)]);
+    std::vector<size_t> key = schema.primary_key();
+    for (size_t column : key) {
+        if (column >= schema.columns.size() || column >= tuple.size()) return {};
+        if (!append_key_column(result, schema.columns[column].type, tuple[column])) return {};
+    }
+    return result;
+}
+
+std::vector<uint8_t> RowCodec::encode_key_prefix(const Tuple& key_values) const {
+    std::vector<uint8_t> result;
+    std::vector<size_t> key = schema.primary_key();
+    if (key_values.size() > key.size()) return result;
+    for (size_t i = 0; i < key_values.size(); ++i) {
+        if (key[i] >= schema.columns.size()) return {};
+        if (!append_key_column(result, schema.columns[key[i]].type, key_values[i])) return {};
+    }
+    return result;
+}
+
+std::vector<uint8_t> RowCodec::encode_key_column(size_t column, const Value& value) const {
+    std::vector<uint8_t> result;
+    if (column >= schema.columns.size() ||
+        !append_key_column(result, schema.columns[column].type, value)) return {};
     return result;
 }
 
@@ -76,7 +234,71 @@ std::vector<uint8_t> RowCodec::encode_value(const Tuple& tuple) const {
     return encode(tuple);
 }
 
+std::vector<uint8_t> RowCodec::encode_column(size_t column, const Value& value) const {
+    std::vector<uint8_t> result;
+    if (column >= schema.columns.size()) return result;
+    append_column(result, schema.columns[column].type, value);
+    return result;
+}
+
+std::vector<uint8_t> RowCodec::encode_index_value(const Tuple& tuple, const std::vector<size_t>& include) const {
+    std::vector<uint8_t> result = encode_key(tuple);
+    if (result.empty()) return result;
+    for (size_t column : include) {
+        if (column >= tuple.size()) return {};
+        append_column(result, schema.columns[column].type, tuple[column]);
+    }
+    return result;
+}
+
+std::vector<uint8_t> RowCodec::encode_index_key(const Tuple& tuple, size_t column) const {
+    if (column >= tuple.size()) return {};
+    std::vector<uint8_t> pk = encode_key(tuple);
+    if (pk.empty()) return {};
+    std::vector<uint8_t> result = encode_key_column(column, tuple[column]);
+    result.insert(result.end(), pk.begin(), pk.end());
+    return result;
+}
+
 std::vector<uint8_t> RowCodec::encode(const Tuple& tuple) const {
+    if (tuple.size() != schema.columns.size()) return {};
+    CompactLayout layout(schema);
+    std::vector<uint8_t> head(1 + layout.bitmap_bytes + layout.fixed_bytes, 0);
+    std::vector<uint8_t> data;
+    std::vector<size_t> ends;
+    for (size_t i = 0; i < schema.columns.size(); ++i) {
+        ColumnType type = schema.columns[i].type;
+        if (is_null(tuple[i])) {
+            if (schema.is_key_column(i)) return {};
+            head[1 + i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+        } else if (layout.width[i] != 0) {
+            if (!write_compact_fixed(type, tuple[i], head.data() + 1 + layout.bitmap_bytes + layout.position[i])) return {};
+        } else if (!append_compact_variable(data, schema.columns[i], tuple[i], dictionary(i))) {
+            return {};
+        }
+        if (layout.width[i] == 0) {
+            ends.push_back(data.size());
+        }
+    }
+    if (data.size() > UINT16_MAX) return {};
+    bool wide = data.size() > UINT8_MAX;
+    head[0] = wide ? ROW_COMPACT_V1_WIDE : ROW_COMPACT_V1;
+    for (size_t end : ends) {
+        head.push_back(static_cast<uint8_t>(end));
+        if (wide) {
+            head.push_back(static_cast<uint8_t>(end >> 8));
+        }
+    }
+    head.insert(head.end(), data.begin(), data.end());
+    if (schema.version > 0) {
+        uint8_t prefix[11] = {ROW_VERSIONED};
+        size_t prefix_size = 1 + write_varint(schema.version, prefix + 1);
+        head.insert(head.begin(), prefix, prefix + prefix_size);
+    }
+    return head;
+}
+
+std::vector<uint8_t> RowCodec::encode_tagged(const Tuple& tuple) const {
     std::vector<uint8_t> result;
     if (tuple.size() != schema.columns.size()) return result;
 
@@ -86,64 +308,383 @@ std::vector<uint8_t> RowCodec::encode(const Tuple& tuple) const {
     return result;
 }
 
+bool RowCodec::decode_column(size_t column, const uint8_t*& p, const uint8_t* end, Value& out) const {
+    if (column >= schema.columns.size() || p >= end) return false;
+
+    uint8_t tag = *p++;
+    if (tag == TAG_NULL) {
+        out = Null();
+        return true;
+    }
+    switch (schema.columns[column].type) {
+        case ColumnType::INT: {
+            if (tag != TAG_INT || p + 4 > end) return false;
+            int32_t x;
+            std::memcpy(&x, p, 4);
+            p += 4;
+            out = static_cast<int>(x);
+            return true;
+        }
+        case ColumnType::FLOAT: {
+            if (tag != TAG_FLOAT || p + 4 > end) return false;
+            float x;
+            std::memcpy(&x, p, 4);
+            p += 4;
+            out = x;
+            return true;
+        }
+        case ColumnType::DOUBLE: {
+            if (tag != TAG_DOUBLE || p + 8 > end) return false;
+            double x;
+            std::memcpy(&x, p, 8);
+            p += 8;
+            out = x;
+            return true;
+        }
+        case ColumnType::STRING: {
+            if (tag != TAG_STRING || p + 2 > end) return false;
+            uint16_t len;
+            std::memcpy(&len, p, 2);
+            p += 2;
+            if (p + len > end) return false;
+            out = std::string(reinterpret_cast<const char*>(p), len);
+            p += len;
+            return true;
+        }
+        case ColumnType::BOOLEAN: {
+            if (tag != TAG_BOOLEAN || p >= end) return false;
+            out = *p++ != 0;
+            return true;
+        }
+        case ColumnType::DATETIME: {
+            if (tag != TAG_DATETIME || p + 8 > end) return false;
+            p += 8;
+            out = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RowCodec::decode_key_column(size_t column, const uint8_t*& p, const uint8_t* end, Value& out) const {
+    if (column >= schema.columns.size() || p >= end) return false;
+
+    switch (schema.columns[column].type) {
+        case ColumnType::INT: {
+            if (p + 4 > end) return false;
+            out = static_cast<int>(static_cast<uint32_t>(read_big_endian(p, 4)) ^ 0x80000000u);
+            p += 4;
+            return true;
+        }
+        case ColumnType::FLOAT: {
+            if (p + 4 > end) return false;
+            out = float_from_key<float, uint32_t>(static_cast<uint32_t>(read_big_endian(p, 4)));
+            p += 4;
+            return true;
+        }
+        case ColumnType::DOUBLE: {
+            if (p + 8 > end) return false;
+            out = float_from_key<double, uint64_t>(read_big_endian(p, 8));
+            p += 8;
+            return true;
+        }
+        case ColumnType::STRING: {
+            std::string s;
+            while (p + 1 < end) {
+                if (p[0] != 0) {
+                    s.push_back(static_cast<char>(*p++));
+                } else if (p[1] == STRING_ESCAPE) {
+                    s.push_back(0);
+                    p += 2;
+                } else if (p[1] == STRING_END) {
+                    p += 2;
+                    out = std::move(s);
+                    return true;
+                } else {
+                    return false;
+                }
+            }
+            return false;
+        }
+        case ColumnType::BOOLEAN: {
+            out = *p++ != 0;
+            return true;
+        }
+        case ColumnType::DATETIME: {
+            if (p + 8 > end) return false;
+            out = static_cast<int>(static_cast<int64_t>(read_big_endian(p, 8) ^ (uint64_t(1) << 63)));
+            p += 8;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RowCodec::decode_key(const uint8_t*& p, const uint8_t* end, Tuple& row) const {
+    if (row.size() < schema.columns.size()) {
+        row.resize(schema.columns.size());
+    }
+    std::vector<size_t> key = schema.primary_key();
+    for (size_t column : key) {
+        if (!decode_key_column(column, p, end, row[column])) return false;
+    }
+    return !key.empty();
+}
+
 Tuple RowCodec::decode(const std::vector<uint8_t>& data) const {
+    return decode(data.data(), data.size());
+}
+
+Tuple RowCodec::decode(const uint8_t* data, size_t size) const {
     Tuple result;
-    const uint8_t* p = data.data();
-    const uint8_t* end = data.data() + data.size();
-
-    for (const auto& col : schema.columns) {
-        if (p >= end) return {};
-
-        uint8_t tag = *p++;
-        switch (col.type) {
-            case ColumnType::INT: {
-                if (tag != TAG_INT || p + 4 > end) return {};
-                int32_t x;
-                std::memcpy(&x, p, 4);
-                p += 4;
-                result.push_back(static_cast<int>(x));
-                break;
-            }
-            case ColumnType::FLOAT: {
-                if (tag != TAG_FLOAT || p + 4 > end) return {};
-                float x;
-                std::memcpy(&x, p, 4);
-                p += 4;
-                result.push_back(x);
-                break;
-            }
-            case ColumnType::DOUBLE: {
-                if (tag != TAG_DOUBLE || p + 8 > end) return {};
-                double x;
-                std::memcpy(&x, p, 8);
-                p += 8;
-                result.push_back(x);
-                break;
-            }
-            case ColumnType::STRING: {
-                if (tag != TAG_STRING || p + 2 > end) return {};
-                uint16_t len;
-                std::memcpy(&len, p, 2);
-                p += 2;
-                if (p + len > end) return {};
-                result.emplace_back(std::string(reinterpret_cast<const char*>(p), len));
-                p += len;
-                break;
-            }
-            case ColumnType::BOOLEAN: {
-                if (tag != TAG_BOOLEAN || p >= end) return {};
-                result.push_back(*p++ != 0);
-                break;
-            }
-            case ColumnType::DATETIME: {
-                if (tag != TAG_DATETIME || p + 8 > end) return {};
-                p += 8;
-                result.push_back(0);
-                break;
-            }
+    uint32_t version;
+    if (!split_row_version(data, size, version) || version > schema.version) return result;
+    size_t count = schema.column_count(version);
+    RowFormat format = row_format(data, size);
+    if (format == RowFormat::COMPACT) {
+        CompactLayout layout(schema, count);
+        for (size_t i = 0; i < count; ++i) {
+            const uint8_t* column = nullptr;
+            size_t len = 0;
+            Value v;
+            if (!compact_column(layout, data, size, i, column, len) ||
+                !read_compact_value(schema.columns[i], column, len, v, dictionary(i))) return {};
+            result.push_back(std::move(v));
+        }
+    } else if (format == RowFormat::TAGGED) {
+        const uint8_t* p = data;
+        const uint8_t* end = data + size;
+        for (size_t i = 0; i < count; ++i) {
+            Value v;
+            if (!decode_column(i, p, end, v)) return {};
+            result.push_back(std::move(v));
         }
+    } else {
+        return result;
+    }
+    for (size_t i = count; i < schema.columns.size(); ++i) {
+        result.push_back(schema.columns[i].default_value);
     }
     return result;
 }
 
+RowFormat row_format(const uint8_t* data, size_t size) {
+    uint32_t version;
+    if (!split_row_version(data, size, version) || size == 0) return RowFormat::INVALID;
+    if (data[0] <= TAG_NULL) return RowFormat::TAGGED;
+    if (data[0] == ROW_COMPACT_V1 || data[0] == ROW_COMPACT_V1_WIDE) return RowFormat::COMPACT;
+    return RowFormat::INVALID;
+}
+
+bool split_row_version(const uint8_t*& data, size_t& size, uint32_t& version) {
+    version = 0;
+    if (size == 0 || data[0] != ROW_VERSIONED) return true;
+    size_t len = 1;
+    while (1 + len <= size && len <= 5 && (data[len] & 0x80) != 0) {
+        len++;
+    }
+    int64_t x;
+    if (1 + len > size || !read_varint(data + 1, len, x) || x < 0 || x > UINT32_MAX) return false;
+    version = static_cast<uint32_t>(x);
+    data += 1 + len;
+    size -= 1 + len;
+    return true;
+}
+
+CompactLayout::CompactLayout(const TableSchema& schema, size_t column_count) {
+    column_count = std::min(column_count, schema.columns.size());
+    bitmap_bytes = (column_count + 7) / 8;
+    for (size_t i = 0; i < column_count; i++) {
+        const ColumnDef& column = schema.columns[i];
+        size_t fixed = compact_fixed_width(column.type);
+        position.push_back(static_cast<uint32_t>(fixed != 0 ? fixed_bytes : var_count));
+        width.push_back(static_cast<uint8_t>(fixed));
+        if (fixed != 0) {
+            fixed_bytes += fixed;
+        } else {
+            var_count++;
+        }
+    }
+}
+
+bool compact_column(const CompactLayout& layout, const uint8_t* row, size_t size, size_t column,
+                    const uint8_t*& data, size_t& len) {
+    if (column >= layout.width.size() || size == 0 || (row[0] != ROW_COMPACT_V1 && row[0] != ROW_COMPACT_V1_WIDE)) {
+        return false;
+    }
+    size_t offset_width = row[0] == ROW_COMPACT_V1_WIDE ? 2 : 1;
+    size_t fixed_start = 1 + layout.bitmap_bytes;
+    size_t table = fixed_start + layout.fixed_bytes;
+    size_t data_start = table + layout.var_count * offset_width;
+    if (size < data_start) return false;
+    if (row[1 + column / 8] & (1u << (column % 8))) {
+        data = nullptr;
+        len = 0;
+        return true;
+    }
+    if (layout.width[column] != 0) {
+        data = row + fixed_start + layout.position[column];
+        len = layout.width[column];
+        return true;
+    }
+    auto end_of = [&](size_t k) {
+        const uint8_t* p = row + table + k * offset_width;
+        return offset_width == 2 ? static_cast<size_t>(p[0] | (p[1] << 8)) : static_cast<size_t>(p[0]);
+    };
+    size_t k = layout.position[column];
+    size_t start = k == 0 ? 0 : end_of(k - 1);
+    size_t end = end_of(k);
+    if (start > end || data_start + end > size) return false;
+    data = row + data_start + start;
+    len = end - start;
+    return true;
+}
+
+size_t write_varint(int64_t value, uint8_t* out) {
+    uint64_t zigzag = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    size_t n = 0;
+    while (zigzag >= 0x80) {
+        out[n++] = static_cast<uint8_t>(zigzag | 0x80);
+        zigzag >>= 7;
+    }
+    out[n++] = static_cast<uint8_t>(zigzag);
+    return n;
+}
+
+bool read_compact_value(const ColumnDef& column, const uint8_t* data, size_t len, Value& out,
+                        const StringDictionary* dictionary) {
+    if (data == nullptr) {
+        out = Null();
+        return true;
+    }
+    if (column.dictionary && column.type == ColumnType::STRING) {
+        uint32_t code;
+        if (!read_dictionary_code(data, len, code)) return false;
+        if (code != StringDictionary::NO_CODE) {
+            const std::string* value = dictionary != nullptr ? dictionary->value(code) : nullptr;
+            if (value == nullptr) return false;
+            out = *value;
+            return true;
+        }
+        data++;  // An uncoded value after its 0 marker
+        len--;
+    }
+    switch (column.type) {
+        case ColumnType::INT:
+        case ColumnType::DATETIME: {
+            int64_t x;
+            if (!read_varint(data, len, x) || x < INT32_MIN || x > INT32_MAX) return false;
+            out = static_cast<int>(x);
+            return true;
+        }
+        case ColumnType::FLOAT: {
+            if (len != 4) return false;
+            float x;
+            std::memcpy(&x, data, 4);
+            out = x;
+            return true;
+        }
+        case ColumnType::DOUBLE: {
+            if (len != 8) return false;
+            double x;
+            std::memcpy(&x, data, 8);
+            out = x;
+            return true;
+        }
+        case ColumnType::BOOLEAN: {
+            if (len != 1) return false;
+            out = *data != 0;
+            return true;
+        }
+        case ColumnType::STRING:
+            out = std::string(reinterpret_cast<const char*>(data), len);
+            return true;
+    }
+    return false;
+}
+
+bool read_dictionary_code(const uint8_t* data, size_t len, uint32_t& code) {
+    if (len > 0 && data[0] == 0) {
+        code = StringDictionary::NO_CODE;
+        return true;
+    }
+    int64_t x;
+    if (!read_varint(data, len, x) || x <= 0 || x > static_cast<int64_t>(DICTIONARY_MAX_ENTRIES)) return false;
+    code = static_cast<uint32_t>(x - 1);
+    return true;
+}
+
+void append_dictionary_string(std::vector<uint8_t>& out, const std::string& value, StringDictionary* dictionary) {
+    uint32_t code = dictionary != nullptr ? dictionary->intern(value) : StringDictionary::NO_CODE;
+    uint8_t buf[10];
+    if (code == StringDictionary::NO_CODE) {
+        out.push_back(0);
+        out.insert(out.end(), value.begin(), value.end());
+        return;
+    }
+    out.insert(out.end(), buf, buf + write_varint(static_cast<int64_t>(code) + 1, buf));
+}
+
+uint32_t StringDictionary::intern(const std::string& value) {
+    auto found = codes.find(value);
+    if (found != codes.end()) {
+        return found->second;
+    }
+    if (values.size() >= DICTIONARY_MAX_ENTRIES) {
+        spilled_ = true;
+        return NO_CODE;
+    }
+    uint32_t code = static_cast<uint32_t>(values.size());
+    values.push_back(value);
+    codes.emplace(value, code);
+    return code;
+}
+
+void StringDictionary::truncate(size_t count, bool spilled) {
+    while (values.size() > count) {
+        codes.erase(values.back());
+        values.pop_back();
+    }
+    spilled_ = spilled;
+}
+
+uint32_t StringDictionary::find(const std::string& value) const {
+    auto found = codes.find(value);
+    return found == codes.end() ? NO_CODE : found->second;
+}
+
+const std::string* StringDictionary::value(uint32_t code) const {
+    return code < values.size() ? &values[code] : nullptr;
+}
+
+bool RowCodec::encode_compact_column(size_t column, const Value& value, std::vector<uint8_t>& out) const {
+    out.clear();
+    if (column >= schema.columns.size() || is_null(value)) return false;
+    const ColumnDef& def = schema.columns[column];
+    if (def.dictionary && def.type == ColumnType::STRING) {
+        const std::string* s = std::get_if<std::string>(&value);
+        const StringDictionary* dict = dictionary(column);
+        if (s == nullptr) return false;
+        uint32_t code = dict != nullptr ? dict->find(*s) : StringDictionary::NO_CODE;
+        if (code == StringDictionary::NO_CODE) {
+            out.push_back(0);
+            out.insert(out.end(), s->begin(), s->end());
+        } else {
+            uint8_t buf[10];
+            out.assign(buf, buf + write_varint(static_cast<int64_t>(code) + 1, buf));
+        }
+        return true;
+    }
+    size_t width = compact_fixed_width(def.type);
+    if (width != 0) {
+        out.resize(width);
+        return write_compact_fixed(def.type, value, out.data());
+    }
+    return append_compact_variable(out, def, value, nullptr);
+}
+
+StringDictionary* RowCodec::dictionary(size_t column) const {
+    return dictionaries != nullptr && column < dictionaries->size() ? &(*dictionaries)[column] : nullptr;
+}
+
 }
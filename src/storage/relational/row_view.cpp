@@ -0,0 +1,190 @@
+#include "storage/relational/row_view.hpp"
+#include <cstring>
+#include <algorithm>
+
+namespace Relational {
+
+namespace {
+// Encoded size of a column including its tag; 0 for STRING, whose size is in the row
+size_t encoded_width(ColumnType type) {
+    switch (type) {
+        case ColumnType::INT:
+        case ColumnType::FLOAT:
+            return 1 + 4;
+        case ColumnType::DOUBLE:
+        case ColumnType::DATETIME:
+            return 1 + 8;
+        case ColumnType::BOOLEAN:
+            return 1 + 1;
+        case ColumnType::STRING:
+            return 0;
+    }
+    return 0;
+}
+}
+
+RowLayout::RowLayout(const TableSchema& _schema, TableDictionaries* _dictionaries)
+    : schema(_schema), dictionaries(_dictionaries), codec(_schema, _dictionaries) {
+    for (uint32_t version = 0; version <= schema.version; version++) {
+        compact.emplace_back(schema, schema.column_count(version));
+    }
+    uint32_t offset = 0;
+    for (const ColumnDef& column : schema.columns) {
+        fixed_offsets.push_back(offset);
+        size_t width = encoded_width(column.type);
+        if (width == 0) {
+            break;
+        }
+        offset += static_cast<uint32_t>(width);
+    }
+}
+
+RowView::RowView(const RowLayout& _layout, const uint8_t* _data, size_t size)
+    : layout(_layout), row(_data), data(_data), end(_data + size), format(row_format(_data, size)) {
+    uint32_t version = 0;
+    if (format == RowFormat::COMPACT) {
+        split_row_version(data, size, version);
+        end = data + size;
+        if (version < layout.compact.size()) {
+            compact = &layout.compact[version];
+        } else {
+            format = RowFormat::INVALID;  // Written under a newer schema
+        }
+    }
+    stored_columns = layout.schema.column_count(version);
+}
+
+const uint8_t* RowView::column_data(size_t column) const {
+    if (column >= stored_columns || layout.fixed_offsets.empty()) {
+        return nullptr;
+    }
+    size_t start = std::min(column, layout.fixed_offsets.size() - 1);
+    size_t offset = layout.fixed_offsets[start];
+    size_t size = static_cast<size_t>(end - data);
+    for (size_t i = start; i < column && offset < size; i++) {
+        size_t width = data[offset] == TAG_NULL ? 1 : encoded_width(layout.schema.columns[i].type);
+        if (width == 0) {
+            if (offset + 3 > size) {
+                return nullptr;
+            }
+            uint16_t len;
+            std::memcpy(&len, data + offset + 1, 2);
+            width = 3 + len;
+        }
+        offset += width;
+    }
+    return offset < size ? data + offset : nullptr;
+}
+
+bool RowView::is_null(size_t column) const {
+    Value v;
+    return get(column, v) && Relational::is_null(v);
+}
+
+template <typename T>
+bool RowView::get_as(size_t column, T& out) const {
+    Value v;
+    const T* x = get(column, v) ? std::get_if<T>(&v) : nullptr;
+    if (x == nullptr) return false;
+    out = *x;
+    return true;
+}
+
+bool RowView::get_int(size_t column, int& out) const {
+    return get_as(column, out);
+}
+
+bool RowView::get_float(size_t column, float& out) const {
+    return get_as(column, out);
+}
+
+bool RowView::get_double(size_t column, double& out) const {
+    return get_as(column, out);
+}
+
+bool RowView::get_bool(size_t column, bool& out) const {
+    return get_as(column, out);
+}
+
+bool RowView::get_string(size_t column, std::string_view& out) const {
+    if (column >= column_count() || layout.schema.columns[column].type != ColumnType::STRING) {
+        return false;
+    }
+    if (column >= stored_columns && format != RowFormat::INVALID) {
+        const std::string* value = std::get_if<std::string>(&layout.schema.columns[column].default_value);
+        if (value == nullptr) return false;
+        out = *value;
+        return true;
+    }
+    if (format == RowFormat::COMPACT) {
+        const uint8_t* p = nullptr;
+        size_t len = 0;
+        if (!get_raw(column, p, len)) {
+            return false;
+        }
+        if (layout.schema.columns[column].dictionary) {
+            uint32_t code;
+            if (!read_dictionary_code(p, len, code)) return false;
+            if (code == StringDictionary::NO_CODE) {
+                out = std::string_view(reinterpret_cast<const char*>(p + 1), len - 1);
+                return true;
+            }
+            const StringDictionary* dictionary = dictionary_for(column);
+            const std::string* value = dictionary != nullptr ? dictionary->value(code) : nullptr;
+            if (value == nullptr) return false;
+            out = *value;
+            return true;
+        }
+        out = std::string_view(reinterpret_cast<const char*>(p), len);
+        return true;
+    }
+    const uint8_t* p = format == RowFormat::TAGGED ? column_data(column) : nullptr;
+    if (p == nullptr || *p != TAG_STRING || end - p < 3) return false;
+    uint16_t len;
+    std::memcpy(&len, p + 1, 2);
+    if (static_cast<size_t>(end - (p + 3)) < len) return false;
+    out = std::string_view(reinterpret_cast<const char*>(p + 3), len);
+    return true;
+}
+
+bool RowView::get(size_t column, Value& out) const {
+    if (column >= stored_columns && column < column_count() && format != RowFormat::INVALID) {
+        out = layout.schema.columns[column].default_value;
+        return true;
+    }
+    if (format == RowFormat::COMPACT) {
+        const uint8_t* p = nullptr;
+        size_t len = 0;
+        return compact_column(*compact, data, static_cast<size_t>(end - data), column, p, len) &&
+               read_compact_value(layout.schema.columns[column], p, len, out, dictionary_for(column));
+    }
+    const uint8_t* p = format == RowFormat::TAGGED ? column_data(column) : nullptr;
+    return p != nullptr && layout.codec.decode_column(column, p, end, out);
+}
+
+bool RowView::get_raw(size_t column, const uint8_t*& out, size_t& len) const {
+    out = nullptr;
+    return format == RowFormat::COMPACT && column < stored_columns &&
+           compact_column(*compact, data, static_cast<size_t>(end - data), column, out, len) && out != nullptr;
+}
+
+const StringDictionary* RowView::dictionary_for(size_t column) const {
+    return layout.dictionaries != nullptr && column < layout.dictionaries->size() ? &(*layout.dictionaries)[column]
+                                                                                   : nullptr;
+}
+
+Tuple RowView::materialize(const std::vector<size_t>& columns) const {
+    if (columns.empty()) {
+        return layout.codec.decode(row, static_cast<size_t>(end - row));
+    }
+    Tuple result;
+    result.reserve(columns.size());
+    for (size_t column : columns) {
+        Value v;
+        if (!get(column, v)) return {};
+        result.push_back(std::move(v));
+    }
+    return result;
+}
+
+}
@@ -10,13 +10,69 @@ uint16_t* slot_ptr(Page& page, uint16_t index) {
     if (index >= header->cell_count) {
         return nullptr;
     }
-    uint16_t slot_offset = header->free_end + (index * sizeof(uint16_t));
-    if (slot_offset + sizeof(uint16_t) > PAGE_SIZE) {
+    uint16_t entry_size = slot_entry_size(page);
+    uint32_t slot_offset = header->free_end + (index * entry_size);
+    if (slot_offset + entry_size > PAGE_SIZE) {
         return nullptr;
     }
     return reinterpret_cast<uint16_t*>(page.data + slot_offset);
 }
 
+uint32_t key_prefix(const uint8_t* key, uint16_t key_len) {
+    // Big-endian packing, zero padded: integer order matches compare_keys order
+    uint32_t prefix = 0;
+    for (uint16_t i = 0; i < KEY_PREFIX_SIZE; i++) {
+        prefix <<= 8;
+        if (i < key_len) {
+            prefix |= key[i];
+        }
+    }
+    return prefix;
+}
+
+uint32_t slot_prefix(Page& page, uint16_t index) {
+    uint16_t* slot = slot_ptr(page, index);
+    if (slot == nullptr || !(get_header(page)->flags & PAGE_FLAG_KEY_PREFIX)) {
+        return 0;
+    }
+    uint32_t prefix;
+    std::memcpy(&prefix, reinterpret_cast<uint8_t*>(slot) + sizeof(uint16_t), sizeof(prefix));
+    return prefix;
+}
+
+static const uint8_t* entry_key(Page& page, uint16_t record_offset, uint16_t& key_len) {
+    if (get_header(page)->page_level == PageLevel::INTERNAL) {
+        InternalEntry* entry = reinterpret_cast<InternalEntry*>(page.data + record_offset);
+        key_len = entry->key_size;
+        return page.data + record_offset + sizeof(InternalEntry);
+    }
+    RecordHeader* record_header = reinterpret_cast<RecordHeader*>(page.data + record_offset);
+    key_len = record_header->key_size;
+    return page.data + record_offset + sizeof(RecordHeader);
+}
+
+bool compare_slot_key(Page& page, uint16_t index, const uint8_t* key, uint16_t key_len, uint32_t prefix, int& cmp) {
+    PageHeader* header = get_header(page);
+    if (header->flags & PAGE_FLAG_KEY_PREFIX) {
+        uint32_t mid_prefix = slot_prefix(page, index);
+        if (mid_prefix != prefix) {
+            cmp = mid_prefix < prefix ? -1 : 1;
+            return true;
+        }
+    }
+    uint16_t* slot = slot_ptr(page, index);
+    if (slot == nullptr || *slot < sizeof(PageHeader) || *slot >= header->free_start) {
+        return false;
+    }
+    uint16_t mid_key_len = 0;
+    const uint8_t* mid_key = entry_key(page, *slot, mid_key_len);
+    if (*slot + mid_key_len > header->free_start) {
+        return false;
+    }
+    cmp = compare_keys(mid_key, mid_key_len, key, key_len);
+    return true;
+}
+
 const uint8_t* slot_key(Page& page, uint16_t slot_index, uint16_t& key_len) {
     PageHeader* header = get_header(page);
     if (slot_index >= header->cell_count) {
@@ -64,7 +120,7 @@ const uint8_t* slot_value(Page& page, uint16_t slot_index, uint16_t& value_len)
     }
     RecordHeader* record_header = reinterpret_cast<RecordHeader*>(page.data + record_offset);
     if (record_header->key_size == 0 || record_header->key_size > PAGE_SIZE ||
-        record_header->value_size == 0 || record_header->value_size > PAGE_SIZE) {
+        record_header->value_size > PAGE_SIZE) {
         value_len = 0;
         return nullptr;
     }
@@ -77,6 +133,23 @@ const uint8_t* slot_value(Page& page, uint16_t slot_index, uint16_t& value_len)
     return page.data + key_end;
 }
 
+uint8_t* slot_flags(Page& page, uint16_t slot_index) {
+    PageHeader* header = get_header(page);
+    if (slot_index >= header->cell_count) {
+        return nullptr;
+    }
+    uint16_t* slot = slot_ptr(page, slot_index);
+    if (slot == nullptr || *slot < sizeof(PageHeader) || *slot >= header->free_start) {
+        return nullptr;
+    }
+    return &reinterpret_cast<RecordHeader*>(page.data + *slot)->flags;
+}
+
+bool slot_is_deleted(Page& page, uint16_t slot_index) {
+    const uint8_t* flags = slot_flags(page, slot_index);
+    return flags != nullptr && (*flags & RECORD_DELETED);
+}
+
 void insert_slot(Page& page, uint16_t index, uint16_t record_offset) {
     PageHeader* header = get_header(page);
     
@@ -84,33 +157,31 @@ void insert_slot(Page& page, uint16_t index, uint16_t record_offset) {
         throw std::runtime_error("Invalid slot index");
     }
     
+    uint16_t entry_size = slot_entry_size(page);
     uint16_t old_free_end = header->free_end;
     uint16_t current_count = header->cell_count;
-    uint16_t new_free_end = old_free_end - sizeof(uint16_t);
+    uint16_t new_free_end = old_free_end - entry_size;
     
     if (new_free_end < header->free_start) {
         throw std::runtime_error("Slot directory would overlap with records");
     }
     
-    if (new_free_end + (current_count + 1) * sizeof(uint16_t) > PAGE_SIZE) {
+    if (new_free_end + (current_count + 1u) * entry_size > PAGE_SIZE) {
         throw std::runtime_error("Slot directory would exceed page size");
     }
     
     header->free_end = new_free_end;
     
-    std::vector<uint16_t> temp_slots(current_count);
-    for (uint16_t i = 0; i < current_count; i++) {
-        temp_slots[i] = *reinterpret_cast<uint16_t*>(page.data + old_free_end + i * sizeof(uint16_t));
-    }
+    // Entries before index move down by one entry; entries after it stay in place
+    std::memmove(page.data + new_free_end, page.data + old_free_end, index * entry_size);
     
-    for (uint16_t i = 0; i < index; i++) {
-        *reinterpret_cast<uint16_t*>(page.data + new_free_end + i * sizeof(uint16_t)) = temp_slots[i];
-    }
-    
-    *reinterpret_cast<uint16_t*>(page.data + new_free_end + index * sizeof(uint16_t)) = record_offset;
-    
-    for (uint16_t i = index; i < current_count; i++) {
-        *reinterpret_cast<uint16_t*>(page.data + new_free_end + (i + 1) * sizeof(uint16_t)) = temp_slots[i];
+    uint8_t* entry = page.data + new_free_end + index * entry_size;
+    std::memcpy(entry, &record_offset, sizeof(uint16_t));
+    if (header->flags & PAGE_FLAG_KEY_PREFIX) {
+        uint16_t key_len = 0;
+        const uint8_t* key = entry_key(page, record_offset, key_len);
+        uint32_t prefix = key_prefix(key, key_len);
+        std::memcpy(entry + sizeof(uint16_t), &prefix, sizeof(prefix));
     }
     
     header->cell_count += 1;
@@ -122,24 +193,11 @@ void remove_slot(Page& page, uint16_t index) {
         throw std::runtime_error("Could not remove an invalid slot");
     }
     
+    uint16_t entry_size = slot_entry_size(page);
     uint16_t old_free_end = header->free_end;
-    uint16_t current_count = header->cell_count;
-    
-    std::vector<uint16_t> slot_values(current_count);
-    for (uint16_t i = 0; i < current_count; i++) {
-        slot_values[i] = *reinterpret_cast<uint16_t*>(page.data + old_free_end + i * sizeof(uint16_t));
-    }
     
-    header->free_end += sizeof(uint16_t);
-    uint16_t new_free_end = header->free_end;
-
-    for(uint16_t i = 0; i < index; ++i) {
-        *reinterpret_cast<uint16_t*>(page.data + new_free_end + i * sizeof(uint16_t)) = slot_values[i];
-    }
+    std::memmove(page.data + old_free_end + entry_size, page.data + old_free_end, index * entry_size);
     
-    for(uint16_t i = index + 1; i < current_count; ++i) {
-        *reinterpret_cast<uint16_t*>(page.data + new_free_end + (i - 1) * sizeof(uint16_t)) = slot_values[i];
-    }
-
+    header->free_end += entry_size;
     header->cell_count -= 1;
 }
@@ -6,6 +6,7 @@
 #include <direct.h> // _mkdir
 #include <cerrno>
 #include <assert.h>
+#include <algorithm>
 
 
 bool open_table(const std::string &name, TableHandle &th) {
@@ -27,6 +28,12 @@ bool open_table(const std::string &name, TableHandle &th) {
         }
         PageHeader* ph = get_header(*meta);
         th.root_page = ph->root_page;
+        th.deferred_deletes = (ph->flags & PAGE_FLAG_DEFERRED_DELETES) != 0;
+        const WriteBufferMeta* wb = reinterpret_cast<const WriteBufferMeta*>(meta->data + sizeof(PageHeader));
+        if (wb->magic == WRITE_BUFFER_MAGIC) {
+            const uint32_t* pages = reinterpret_cast<const uint32_t*>(wb + 1);
+            th.write_buffer.assign(pages, pages + wb->page_count);
+        }
         th.bpm->unpin_page(0, false);
         return true;
     }
@@ -129,4 +136,32 @@ void free_page(TableHandle& th, uint32_t page_id) {
     th.bpm->delete_page(page_id);
 }
 
+uint32_t release_free_tail(TableHandle& th) {
+    if (!th.bpm) {
+        return 0;
+    }
+    Page* bitmap = th.bpm->fetch_page(1);
+    if (!bitmap) {
+        return 0;
+    }
 
+    const uint8_t* bm = bitmap->data + sizeof(PageHeader);
+    uint32_t keep = 3;
+    for (uint32_t byte_idx = PAGE_SIZE - sizeof(PageHeader); byte_idx-- > 0;) {
+        if (bm[byte_idx] != 0) {
+            uint32_t bit_idx = 7;
+            while ((bm[byte_idx] & (1 << bit_idx)) == 0) {
+                bit_idx--;
+            }
+            keep = std::max(keep, byte_idx * 8 + bit_idx + 1);
+            break;
+        }
+    }
+    th.bpm->unpin_page(1, false);
+
+    uint32_t pages = th.bpm->file_page_count();
+    if (pages <= keep || !th.bpm->truncate(keep)) {
+        return 0;
+    }
+    return pages - keep;
+}
@@ -307,6 +307,40 @@ void CatalogManager::write_schema(const std::string& db_path, const std::string&
     }
 }
 
+void CatalogManager::add_index(const std::string& db_path, const std::string& table_name, const IndexDef& index) {
+    CreateTableStmt schema = read_schema(db_path, table_name);
+    std::vector<std::string> referenced = index.include_columns;
+    referenced.insert(referenced.begin(), index.column_name);
+    for (const auto& name : referenced) {
+        bool has_column = std::any_of(schema.columns.begin(), schema.columns.end(),
+                                      [&](const ColumnDef& col) { return col.name == name; });
+        if (!has_column) {
+            throw std::runtime_error("Column '" + name + "' does not exist in table '" + table_name + "'");
+        }
+    }
+    for (const auto& existing : schema.indexes) {
+        if (existing.name == index.name) {
+            throw std::runtime_error("Index '" + index.name + "' already exists on table '" + table_name + "'");
+        }
+    }
+    schema.indexes.push_back(index);
+    write_schema(db_path, table_name, schema);
+}
+
+std::vector<IndexDef> CatalogManager::list_indexes(const std::string& db_path, const std::string& table_name) {
+    return read_schema(db_path, table_name).indexes;
+}
+
+std::optional<IndexDef> CatalogManager::find_index(const std::string& db_path, const std::string& table_name, const std::string& column_name) {
+    std::optional<IndexDef> found;
+    for (const auto& index : list_indexes(db_path, table_name)) {
+        if (index.column_name == column_name && (!found || (index.is_unique && !found->is_unique))) {
+            found = index;
+        }
+    }
+    return found;
+}
+
 void CatalogManager::flush() {
     for (uint8_t i = 0; i < 3; ++i) {
         if (dirty_flags[i][0] || dirty_flags[i][1]) {
@@ -49,6 +49,36 @@ std::vector<uint8_t> serialize_schema(const CreateTableStmt& schema) {
         // We'll handle it if it exists via template or reflection, but for now skip
         result.push_back(flags);
     }
+
+    // Index section, omitted when the table has no secondary indexes
+    if (!schema.indexes.empty()) {
+        uint16_t num_indexes = static_cast<uint16_t>(schema.indexes.size());
+        result.push_back(static_cast<uint8_t>(num_indexes & 0xFF));
+        result.push_back(static_cast<uint8_t>((num_indexes >> 8) & 0xFF));
+        for (const auto& index : schema.indexes) {
+            for (const std::string* text : {&index.name, &index.column_name}) {
+                uint16_t len = static_cast<uint16_t>(text->size());
+                result.push_back(static_cast<uint8_t>(len & 0xFF));
+                result.push_back(static_cast<uint8_t>((len >> 8) & 0xFF));
+                result.insert(result.end(), text->begin(), text->end());
+            }
+            uint8_t flags = index.is_unique ? INDEX_FLAG_UNIQUE : 0;
+            if (!index.include_columns.empty()) flags |= INDEX_FLAG_INCLUDE;
+            result.push_back(flags);
+            if (index.include_columns.empty()) {
+                continue;
+            }
+            uint16_t num_include = static_cast<uint16_t>(index.include_columns.size());
+            result.push_back(static_cast<uint8_t>(num_include & 0xFF));
+            result.push_back(static_cast<uint8_t>((num_include >> 8) & 0xFF));
+            for (const auto& column : index.include_columns) {
+                uint16_t len = static_cast<uint16_t>(column.size());
+                result.push_back(static_cast<uint8_t>(len & 0xFF));
+                result.push_back(static_cast<uint8_t>((len >> 8) & 0xFF));
+                result.insert(result.end(), column.begin(), column.end());
+            }
+        }
+    }
     
     return result;
 }
@@ -116,6 +146,46 @@ CreateTableStmt deserialize_schema(const uint8_t* data, uint16_t size) {
 
         schema.columns.push_back(col);
     }
+
+    // Optional index section
+    if (ptr != end) {
+        if (ptr + 2 > end) throw std::runtime_error("Invalid schema: index count");
+        uint16_t num_indexes = static_cast<uint16_t>(ptr[0]) |
+                              (static_cast<uint16_t>(ptr[1]) << 8);
+        ptr += 2;
+        schema.indexes.reserve(num_indexes);
+        for (uint16_t i = 0; i < num_indexes; ++i) {
+            IndexDef index;
+            for (std::string* text : {&index.name, &index.column_name}) {
+                if (ptr + 2 > end) throw std::runtime_error("Invalid schema: index name length");
+                uint16_t len = static_cast<uint16_t>(ptr[0]) |
+                              (static_cast<uint16_t>(ptr[1]) << 8);
+                ptr += 2;
+                if (ptr + len > end) throw std::runtime_error("Invalid schema: index name");
+                text->assign(reinterpret_cast<const char*>(ptr), len);
+                ptr += len;
+            }
+            if (ptr >= end) throw std::runtime_error("Invalid schema: index flags");
+            uint8_t flags = *ptr++;
+            index.is_unique = (flags & INDEX_FLAG_UNIQUE) != 0;
+            if (flags & INDEX_FLAG_INCLUDE) {
+                if (ptr + 2 > end) throw std::runtime_error("Invalid schema: include count");
+                uint16_t num_include = static_cast<uint16_t>(ptr[0]) |
+                                      (static_cast<uint16_t>(ptr[1]) << 8);
+                ptr += 2;
+                for (uint16_t j = 0; j < num_include; ++j) {
+                    if (ptr + 2 > end) throw std::runtime_error("Invalid schema: include name length");
+                    uint16_t len = static_cast<uint16_t>(ptr[0]) |
+                                  (static_cast<uint16_t>(ptr[1]) << 8);
+                    ptr += 2;
+                    if (ptr + len > end) throw std::runtime_error("Invalid schema: include name");
+                    index.include_columns.emplace_back(reinterpret_cast<const char*>(ptr), len);
+                    ptr += len;
+                }
+            }
+            schema.indexes.push_back(index);
+        }
+    }
     
     if (ptr != end) {
         throw std::runtime_error("Schema data has extra bytes");
@@ -0,0 +1,84 @@
+#include "storage/page.hpp"
+#include "storage/record.hpp"
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static void fill_page(Page& page, bool prefixed, const std::vector<std::string>& keys) {
+    init_page(page, 2, PageType::DATA, PageLevel::LEAF);
+    if (!prefixed) {
+        get_header(page)->flags &= ~PAGE_FLAG_KEY_PREFIX;
+    }
+    for (const auto& k : keys) {
+        bool ok = page_insert(page, (const uint8_t*)k.data(), (uint16_t)k.size(), (const uint8_t*)"v", 1);
+        assert(ok && "page_insert failed");
+    }
+}
+
+void test_prefix_matches_legacy_search() {
+    std::cout << "\n--- key prefix search test ---\n";
+
+    // Short keys, keys sharing the 4-byte prefix and keys differing only past it
+    std::vector<std::string> keys = {
+        "m", "ab", "abc", "abcd", "abcde", "abcdf", "abce", "b", "user_0001", "user_0002",
+        "user_0010", "zz", std::string("a\0", 2), "a", "zzzz", "zzzz0"
+    };
+
+    Page prefixed;
+    Page legacy;
+    fill_page(prefixed, true, keys);
+    fill_page(legacy, false, keys);
+
+    assert((get_header(prefixed)->flags & PAGE_FLAG_KEY_PREFIX) && "prefixed page should carry the flag");
+    assert(slot_entry_size(prefixed) == sizeof(uint16_t) + KEY_PREFIX_SIZE);
+    assert(slot_entry_size(legacy) == sizeof(uint16_t));
+    assert(get_header(prefixed)->cell_count == keys.size());
+    std::cout << "[OK] Built prefixed and legacy pages with " << keys.size() << " keys\n";
+
+    // Slot order must be identical between both layouts
+    for (uint16_t i = 0; i < get_header(prefixed)->cell_count; i++) {
+        uint16_t len_a = 0, len_b = 0;
+        const uint8_t* a = slot_key(prefixed, i, len_a);
+        const uint8_t* b = slot_key(legacy, i, len_b);
+        assert(a != nullptr && b != nullptr);
+        assert(compare_keys(a, len_a, b, len_b) == 0 && "slot order differs");
+        assert(slot_prefix(prefixed, i) == key_prefix(a, len_a) && "stale slot prefix");
+    }
+    std::cout << "[OK] Slot order and prefixes consistent\n";
+
+    std::vector<std::string> probes = keys;
+    probes.insert(probes.end(), {"", "0", "aa", "abcc", "abcdz", "user_0000", "user_0005", "user_1", "zzzz00", "~"});
+    for (const auto& p : probes) {
+        BSearchResult r1 = search_record(prefixed, (const uint8_t*)p.data(), (uint16_t)p.size());
+        BSearchResult r2 = search_record(legacy, (const uint8_t*)p.data(), (uint16_t)p.size());
+        assert(r1.found == r2.found && r1.index == r2.index && "prefixed search disagrees with legacy search");
+    }
+    std::cout << "[OK] " << probes.size() << " probes agree between layouts\n";
+
+    // Deletes must keep prefixes aligned with their slots
+    assert(page_delete(prefixed, (const uint8_t*)"abcd", 4));
+    assert(page_delete(prefixed, (const uint8_t*)"m", 1));
+    BSearchResult r = search_record(prefixed, (const uint8_t*)"abcde", 5);
+    assert(r.found && "key lost after delete");
+    r = search_record(prefixed, (const uint8_t*)"abcd", 4);
+    assert(!r.found && "deleted key still found");
+    for (uint16_t i = 0; i < get_header(prefixed)->cell_count; i++) {
+        uint16_t len = 0;
+        const uint8_t* k = slot_key(prefixed, i, len);
+        assert(slot_prefix(prefixed, i) == key_prefix(k, len) && "prefix misaligned after delete");
+    }
+    std::cout << "[OK] Prefixes stay aligned after deletes\n";
+}
+
+int main() {
+    try {
+        test_prefix_matches_legacy_search();
+        std::cout << "key prefix search test completed successfully!" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -7,6 +7,7 @@
 #include <iomanip>
 #include <fstream>
 #include <functional>
+#include <map>
 #include "storage/btree.hpp"
 #include "storage/table_handle.hpp"
 #include "storage/buffer_pool.hpp"
@@ -1054,6 +1055,972 @@ void test_btree_merge_on_underutilization() {
     std::cout << "\n=== Merge on Underutilization Test PASSED ===\n";
 }
 
+void test_btree_cursor() {
+    std::cout << "\n=== B+ Tree Cursor Test ===\n";
+
+    const std::string table = "test_btree_cursor";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+
+    assert(create_table(table) && "create_table failed");
+    TableHandle th(table);
+    assert(open_table(table, th) && "open_table failed");
+
+    // Even keys only, so odd probes land between entries
+    const int num_records = 600;
+    std::string padding(40, 'p');
+    for (int i = 0; i < num_records; i++) {
+        char key_buf[16];
+        snprintf(key_buf, sizeof(key_buf), "cur_%05d", i * 2);
+        std::string value_str = std::string(key_buf) + padding;
+        Key k((const uint8_t*)key_buf, (uint16_t)strlen(key_buf));
+        Value v((const uint8_t*)value_str.c_str(), (uint16_t)value_str.length());
+        assert(btree_insert(th, k, v) && "btree_insert failed");
+    }
+    assert(count_leaf_pages(th, th.root_page) > 2 && "Cursor test needs several leaves");
+    std::cout << "[OK] Inserted " << num_records << " records\n";
+
+    {
+        BTreeCursor cursor(th);
+        int seen = 0;
+        for (bool ok = cursor.seek_first(); ok; ok = cursor.next()) {
+            char expected[16];
+            snprintf(expected, sizeof(expected), "cur_%05d", seen * 2);
+            Key k = cursor.key();
+            assert(k.size() == strlen(expected) && memcmp(k.data(), expected, k.size()) == 0 && "Forward order mismatch");
+            Value v = cursor.value();
+            assert(v.size() == k.size() + padding.size() && memcmp(v.data(), expected, k.size()) == 0 && "Value mismatch");
+            seen++;
+        }
+        assert(seen == num_records && "Forward scan count mismatch");
+        assert(!cursor.valid());
+        std::cout << "[OK] Forward scan visited all " << seen << " records in order\n";
+
+        seen = 0;
+        for (bool ok = cursor.seek_last(); ok; ok = cursor.prev()) {
+            char expected[16];
+            snprintf(expected, sizeof(expected), "cur_%05d", (num_records - 1 - seen) * 2);
+            Key k = cursor.key();
+            assert(memcmp(k.data(), expected, k.size()) == 0 && "Reverse order mismatch");
+            seen++;
+        }
+        assert(seen == num_records && "Reverse scan count mismatch");
+        std::cout << "[OK] Reverse scan visited all " << seen << " records in order\n";
+
+        // Seek between keys lands on the next larger key, then walk both ways
+        const char* probe = "cur_00301";
+        assert(cursor.seek(Key((const uint8_t*)probe, 9)) && "seek failed");
+        assert(memcmp(cursor.key().data(), "cur_00302", 9) == 0 && "seek should land on next key");
+        assert(cursor.prev() && memcmp(cursor.key().data(), "cur_00300", 9) == 0 && "prev after seek");
+        assert(cursor.next() && cursor.next() && memcmp(cursor.key().data(), "cur_00304", 9) == 0 && "next after prev");
+        std::cout << "[OK] seek/prev/next around a missing key\n";
+
+        assert(!cursor.seek(Key((const uint8_t*)"zzz", 3)) && "seek past the end should be invalid");
+        assert(!cursor.valid());
+
+        // Early stop (LIMIT) keeps exactly one leaf pinned until close
+        assert(cursor.seek_first());
+        for (int i = 0; i < 5; i++) {
+            cursor.next();
+        }
+        assert(th.bpm->get_pinned_count() == 1 && "Cursor should pin exactly one leaf");
+        cursor.close();
+        assert(th.bpm->get_pinned_count() == 0 && "close should release the leaf");
+        std::cout << "[OK] Cursor pins one leaf and releases it on close\n";
+    }
+    assert(th.bpm->get_pinned_count() == 0 && "Cursor destructor should unpin");
+
+    std::cout << "\n=== Cursor Test PASSED ===\n";
+}
+
+void test_btree_multi_search() {
+    std::cout << "\n=== B+ Tree Multi Search Test ===\n";
+
+    const std::string table = "test_btree_multi_search";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+
+    assert(create_table(table) && "create_table failed");
+    TableHandle th(table);
+    assert(open_table(table, th) && "open_table failed");
+
+    // Even keys only, so odd probes are misses
+    const int num_records = 800;
+    std::string padding(40, 'm');
+    for (int i = 0; i < num_records; i++) {
+        char key_buf[16];
+        snprintf(key_buf, sizeof(key_buf), "ms_%05d", i * 2);
+        std::string value_str = std::string(key_buf) + padding;
+        Key k((const uint8_t*)key_buf, (uint16_t)strlen(key_buf));
+        Value v((const uint8_t*)value_str.c_str(), (uint16_t)value_str.length());
+        assert(btree_insert(th, k, v) && "btree_insert failed");
+    }
+    assert(count_leaf_pages(th, th.root_page) > 2 && "Multi search test needs several leaves");
+    std::cout << "[OK] Inserted " << num_records << " records\n";
+
+    // Unsorted batch with hits, misses, duplicates and both ends of the tree
+    std::vector<int> probes = {1500, 3, 0, 1598, 1600, 700, 2, 700, 999, 42, 1200, 1201, 5000};
+    std::vector<std::string> probe_keys;
+    for (int p : probes) {
+        char key_buf[16];
+        snprintf(key_buf, sizeof(key_buf), "ms_%05d", p);
+        probe_keys.push_back(key_buf);
+    }
+    std::vector<Key> keys;
+    for (const auto& k : probe_keys) {
+        keys.emplace_back((const uint8_t*)k.data(), (uint16_t)k.size());
+    }
+
+    std::vector<Value> values;
+    std::vector<bool> hits;
+    size_t found = btree_multi_search(th, keys, values, hits);
+    assert(values.size() == keys.size() && hits.size() == keys.size() && "One result per key");
+
+    size_t expected_found = 0;
+    for (size_t i = 0; i < probes.size(); i++) {
+        bool hit = probes[i] % 2 == 0 && probes[i] < num_records * 2;
+        Value single;
+        assert(btree_search(th, keys[i], single) == hit && "btree_search disagrees with expectation");
+        assert(hits[i] == hit && "Found flag mismatch");
+        if (hit) {
+            expected_found++;
+            assert(values[i].size() == single.size() && "Value size mismatch");
+            assert(memcmp(values[i].data(), single.data(), single.size()) == 0 && "Value mismatch");
+        } else {
+            assert(values[i].empty() && "Missing key should have an empty value");
+        }
+    }
+    assert(found == expected_found && "Found count mismatch");
+    assert(th.bpm->get_pinned_count() == 0 && "Multi search should release every page");
+    std::cout << "[OK] " << found << " of " << keys.size() << " probes found, results in caller order\n";
+
+    // Every key in one sorted batch
+    keys.clear();
+    probe_keys.clear();
+    for (int i = 0; i < num_records; i++) {
+        char key_buf[16];
+        snprintf(key_buf, sizeof(key_buf), "ms_%05d", i * 2);
+        probe_keys.push_back(key_buf);
+    }
+    for (const auto& k : probe_keys) {
+        keys.emplace_back((const uint8_t*)k.data(), (uint16_t)k.size());
+    }
+    found = btree_multi_search(th, keys, values, hits);
+    assert(found == (size_t)num_records && "Full sorted batch should find every key");
+    for (size_t i = 0; i < keys.size(); i++) {
+        assert(memcmp(values[i].data(), probe_keys[i].data(), probe_keys[i].size()) == 0 && "Value mismatch");
+    }
+    std::cout << "[OK] Sorted batch of " << num_records << " keys found every record\n";
+
+    // An empty value is a hit, not a miss
+    std::string empty_key = "ms_00001";
+    assert(btree_insert(th, Key(empty_key), Value()) && "Insert of an empty value failed");
+    keys.clear();
+    keys.emplace_back(empty_key);
+    keys.emplace_back("ms_00003");
+    found = btree_multi_search(th, keys, values, hits);
+    assert(found == 1 && hits[0] && values[0].empty() && !hits[1] && "Empty value reported as missing");
+    Value single;
+    assert(btree_search(th, keys[0], single) && single.empty() && "btree_search should find an empty value");
+    std::cout << "[OK] Empty values are found\n";
+
+    std::cout << "\n=== Multi Search Test PASSED ===\n";
+}
+
+// Average share of the usable page area taken by records and slots, over all leaves
+static int average_leaf_fill_percent(TableHandle& th) {
+    Page leaf;
+    uint32_t page_id = find_leftmost_leaf_page(th, leaf);
+    uint64_t used = 0;
+    uint64_t pages = 0;
+    while (page_id != UINT32_MAX && page_id != 0) {
+        Page* page = th.bpm->fetch_page(page_id);
+        assert(page && "fetch_page failed");
+        PageHeader* ph = get_header(*page);
+        for (uint16_t i = 0; i < ph->cell_count; i++) {
+            RecordHeader* rh = reinterpret_cast<RecordHeader*>(page->data + *slot_ptr(*page, i));
+            used += record_size(rh->key_size, rh->value_size) + slot_entry_size(*page);
+        }
+        pages++;
+        uint32_t next = ph->next_page_id;
+        th.bpm->unpin_page(page_id, false);
+        page_id = next;
+    }
+    return pages == 0 ? 0 : static_cast<int>((used * 100) / (pages * (PAGE_SIZE - sizeof(PageHeader))));
+}
+
+void test_btree_sequential_append() {
+    std::cout << "\n=== B+ Tree Sequential Append Test ===\n";
+
+    const std::string table = "test_btree_append";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+
+    assert(create_table(table) && "create_table failed");
+    TableHandle th(table);
+    assert(open_table(table, th) && "open_table failed");
+
+    // Monotonic keys, like storage_new row ids
+    const int num_records = 2000;
+    std::string padding(40, 'a');
+    for (int i = 0; i < num_records; i++) {
+        char key_buf[16];
+        snprintf(key_buf, sizeof(key_buf), "row_%06d", i);
+        std::string value_str = std::string(key_buf) + padding;
+        Key k((const uint8_t*)key_buf, (uint16_t)strlen(key_buf));
+        Value v((const uint8_t*)value_str.c_str(), (uint16_t)value_str.length());
+        assert(btree_insert(th, k, v) && "btree_insert failed");
+        assert(th.rightmost_leaf != 0 && "Append should keep the rightmost leaf cached");
+    }
+    assert(th.bpm->get_pinned_count() == 0 && "Appends should release every page");
+
+    int fill = average_leaf_fill_percent(th);
+    std::cout << "[OK] Inserted " << num_records << " monotonic keys into "
+              << count_leaf_pages(th, th.root_page) << " leaves, " << fill << "% average fill\n";
+    assert(fill >= 80 && "Sequential load should leave nearly full leaves");
+
+    for (int i = 0; i < num_records; i++) {
+        char key_buf[16];
+        snprintf(key_buf, sizeof(key_buf), "row_%06d", i);
+        Key k((const uint8_t*)key_buf, (uint16_t)strlen(key_buf));
+        Value v;
+        assert(btree_search(th, k, v) && "Appended key not found");
+        assert(memcmp(v.data(), key_buf, strlen(key_buf)) == 0 && "Value mismatch");
+    }
+    std::cout << "[OK] All appended keys found\n";
+
+    // Out-of-order keys still take the normal path
+    Key early((const uint8_t*)"row_000100x", 11);
+    Value early_v((const uint8_t*)"early", 5);
+    assert(btree_insert(th, early, early_v) && "Out-of-order insert failed");
+    Value found;
+    assert(btree_search(th, early, found) && found.size() == 5 && "Out-of-order key not found");
+    std::cout << "[OK] Out-of-order insert after appends\n";
+
+    std::cout << "\n=== Sequential Append Test PASSED ===\n";
+}
+
+void test_btree_update_in_place() {
+    std::cout << "\n=== B+ Tree In-Place Update Test ===\n";
+
+    const std::string table = "test_btree_update";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+
+    assert(create_table(table) && "create_table failed");
+    TableHandle th(table);
+    assert(open_table(table, th) && "open_table failed");
+
+    const int num_records = 300;
+    std::string padding(40, 'u');
+    for (int i = 0; i < num_records; i++) {
+        char key_buf[16];
+        snprintf(key_buf, sizeof(key_buf), "upd_%05d", i);
+        std::string value_str = std::string(key_buf) + padding;
+        Key k((const uint8_t*)key_buf, (uint16_t)strlen(key_buf));
+        Value v((const uint8_t*)value_str.c_str(), (uint16_t)value_str.length());
+        assert(btree_insert(th, k, v) && "btree_insert failed");
+    }
+    uint32_t root_before = th.root_page;
+    int leaves_before = count_leaf_pages(th, th.root_page);
+    std::cout << "[OK] Inserted " << num_records << " records into " << leaves_before << " leaves\n";
+
+    // Shrink every value, then grow it back past its original size
+    for (int round = 0; round < 2; round++) {
+        size_t len = round == 0 ? 12 : 52;
+        for (int i = 0; i < num_records; i++) {
+            char key_buf[16];
+            snprintf(key_buf, sizeof(key_buf), "upd_%05d", i);
+            std::string value_str = std::string(key_buf) + std::string(len - strlen(key_buf), (char)('0' + round));
+            Key k((const uint8_t*)key_buf, (uint16_t)strlen(key_buf));
+            Value v((const uint8_t*)value_str.c_str(), (uint16_t)value_str.length());
+            assert(btree_update(th, k, v) && "btree_update failed");
+        }
+        for (int i = 0; i < num_records; i++) {
+            char key_buf[16];
+            snprintf(key_buf, sizeof(key_buf), "upd_%05d", i);
+            Key k((const uint8_t*)key_buf, (uint16_t)strlen(key_buf));
+            Value v;
+            assert(btree_search(th, k, v) && "Updated key not found");
+            assert(v.size() == len && "Updated value size mismatch");
+            assert(v.data()[len - 1] == (uint8_t)('0' + round) && "Updated value mismatch");
+        }
+        assert(th.root_page == root_before && "Update changed the root");
+        assert(count_leaf_pages(th, th.root_page) == leaves_before && "Update changed the leaf count");
+        std::cout << "[OK] Updated all values to " << len << " bytes without restructuring\n";
+    }
+
+    // A value that only fits in the space of the one it replaces is updated in the page
+    Page page;
+    init_page(page, 2, PageType::DATA, PageLevel::LEAF);
+    std::string filler(100, 'f');
+    int filled = 0;
+    for (; ; filled++) {
+        std::string key = "page_" + std::to_string(100 + filled);
+        if (!page_insert(page, (const uint8_t*)key.data(), (uint16_t)key.size(), (const uint8_t*)filler.data(),
+                         (uint16_t)filler.size())) {
+            break;
+        }
+    }
+    PageHeader* ph = get_header(page);
+    // Grows by all the free space, so the new record needs the old one's bytes too
+    uint16_t spare = ph->free_end - ph->free_start;
+    assert(spare > 0 && "Leaf should have some free space left");
+    std::string grown(filler.size() + spare, 'g');
+    assert(page_update(page, (const uint8_t*)"page_100", 8, (const uint8_t*)grown.data(), (uint16_t)grown.size()) &&
+           "Update fitting in the old record's space should succeed");
+    uint16_t len = 0;
+    BSearchResult r = search_record(page, (const uint8_t*)"page_100", 8);
+    const uint8_t* stored = slot_value(page, r.index, len);
+    assert(r.found && len == grown.size() && memcmp(stored, grown.data(), len) == 0 && "Grown value mismatch");
+    r = search_record(page, (const uint8_t*)"page_101", 8);
+    stored = slot_value(page, r.index, len);
+    assert(r.found && len == filler.size() && memcmp(stored, filler.data(), len) == 0 && "Neighbour moved wrongly");
+    assert(ph->cell_count == filled && "Update changed the record count");
+    std::cout << "[OK] Grown value reuses the space of the record it replaces\n";
+
+    // The largest inline value does not fit in a full leaf and falls back to a split
+    std::string big(OVERFLOW_THRESHOLD, 'B');
+    Key k((const uint8_t*)"upd_00150", 9);
+    assert(btree_update(th, k, Value((const uint8_t*)big.data(), (uint16_t)big.size())) && "Large update failed");
+    Value v;
+    assert(btree_search(th, k, v) && v.size() == big.size() && "Large updated value mismatch");
+    assert(count_leaf_pages(th, th.root_page) > leaves_before && "Large update should split the leaf");
+
+    Key missing((const uint8_t*)"upd_99999", 9);
+    assert(!btree_update(th, missing, Value((const uint8_t*)"x", 1)) && "Update of missing key should fail");
+    assert(th.bpm->get_pinned_count() == 0 && "Updates should release every page");
+    std::cout << "[OK] Oversized update splits, missing key rejected\n";
+
+    std::cout << "\n=== In-Place Update Test PASSED ===\n";
+}
+
+void test_btree_delete_churn() {
+    std::cout << "\n=== B+ Tree Delete Churn Test ===\n";
+
+    const std::string table = "test_btree_churn";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+
+    assert(create_table(table) && "create_table failed");
+    TableHandle th(table);
+    assert(open_table(table, th) && "open_table failed");
+
+    const int num_records = 1500;
+    std::string padding(40, 'c');
+    auto make_key = [](int i, char* buf, size_t len) {
+        snprintf(buf, len, "churn_%05d", i);
+    };
+    for (int i = 0; i < num_records; i++) {
+        char key_buf[16];
+        make_key(i, key_buf, sizeof(key_buf));
+        std::string value_str = std::string(key_buf) + padding;
+        assert(btree_insert(th, Key(key_buf), Value((const uint8_t*)value_str.c_str(), (uint16_t)value_str.length())));
+    }
+    int leaves_before = count_leaf_pages(th, th.root_page);
+    std::cout << "[OK] Inserted " << num_records << " records into " << leaves_before << " leaves\n";
+
+    // Repeatedly drain and refill a range around a leaf boundary
+    std::vector<int> leaf_counts;
+    for (int round = 0; round < 20; round++) {
+        for (int i = 700; i < 740; i++) {
+            char key_buf[16];
+            make_key(i, key_buf, sizeof(key_buf));
+            assert(btree_delete(th, Key(key_buf)) && "Churn delete failed");
+        }
+        for (int i = 700; i < 740; i++) {
+            char key_buf[16];
+            make_key(i, key_buf, sizeof(key_buf));
+            std::string value_str = std::string(key_buf) + padding;
+            assert(btree_insert(th, Key(key_buf), Value((const uint8_t*)value_str.c_str(), (uint16_t)value_str.length())));
+        }
+        leaf_counts.push_back(count_leaf_pages(th, th.root_page));
+    }
+    for (size_t i = 2; i < leaf_counts.size(); i++) {
+        assert(leaf_counts[i] == leaf_counts[1] && "Churn should settle instead of merging and splitting every round");
+    }
+    std::cout << "[OK] Leaf count settled at " << leaf_counts.back() << " across churn rounds\n";
+
+    // Delete everything but every tenth key: leaves borrow and merge, internal nodes follow
+    for (int i = 0; i < num_records; i++) {
+        if (i % 10 == 0) continue;
+        char key_buf[16];
+        make_key(i, key_buf, sizeof(key_buf));
+        assert(btree_delete(th, Key(key_buf)) && "Sparse delete failed");
+    }
+    int leaves_after = count_leaf_pages(th, th.root_page);
+    assert(leaves_after < leaves_before / 4 && "Sparse deletes should merge leaves");
+    for (int i = 0; i < num_records; i++) {
+        char key_buf[16];
+        make_key(i, key_buf, sizeof(key_buf));
+        Value v;
+        assert(btree_search(th, Key(key_buf), v) == (i % 10 == 0) && "Wrong key set after sparse deletes");
+    }
+    {
+        BTreeCursor cursor(th);
+        int seen = 0;
+        for (bool ok = cursor.seek_first(); ok; ok = cursor.next()) {
+            seen++;
+        }
+        assert(seen == num_records / 10 && "Leaf chain broken after rebalancing");
+    }
+    assert(th.bpm->get_pinned_count() == 0 && "Rebalancing should release every page");
+    std::cout << "[OK] Sparse deletes shrank " << leaves_before << " leaves to " << leaves_after << "\n";
+
+    std::cout << "\n=== Delete Churn Test PASSED ===\n";
+}
+
+// Number of pages marked used in the table's allocation bitmap
+static int count_allocated_pages(TableHandle& th) {
+    Page* bitmap = th.bpm->fetch_page(1);
+    assert(bitmap && "fetch bitmap failed");
+    int used = 0;
+    for (uint32_t i = sizeof(PageHeader); i < PAGE_SIZE; i++) {
+        for (int bit = 0; bit < 8; bit++) {
+            used += (bitmap->data[i] >> bit) & 1;
+        }
+    }
+    th.bpm->unpin_page(1, false);
+    return used;
+}
+
+void test_btree_overflow_values() {
+    std::cout << "\n=== B+ Tree Overflow Value Test ===\n";
+
+    const std::string table = "test_btree_overflow";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+
+    assert(create_table(table) && "create_table failed");
+    TableHandle th(table);
+    assert(open_table(table, th) && "open_table failed");
+
+    auto make_value = [](int seed, size_t len) {
+        std::string v(len, ' ');
+        for (size_t i = 0; i < len; i++) {
+            v[i] = (char)('a' + (seed * 7 + i) % 26);
+        }
+        return v;
+    };
+
+    // Small rows interleaved with values far larger than a page
+    const int num_records = 60;
+    std::vector<std::string> values;
+    for (int i = 0; i < num_records; i++) {
+        size_t len = i % 3 == 0 ? 3 * PAGE_SIZE + i : 20;
+        if (i == 30) len = 60000;
+        values.push_back(make_value(i, len));
+    }
+    int pages_before = count_allocated_pages(th);
+    for (int i = 0; i < num_records; i++) {
+        char key_buf[16];
+        snprintf(key_buf, sizeof(key_buf), "ovf_%04d", i);
+        assert(btree_insert(th, Key(key_buf), Value((const uint8_t*)values[i].data(), (uint16_t)values[i].size())) &&
+               "Overflow insert failed");
+    }
+    assert(!btree_insert(th, Key("ovf_0000"), Value((const uint8_t*)values[0].data(), (uint16_t)values[0].size())) &&
+           "Duplicate overflow insert should fail");
+    for (int i = 0; i < num_records; i++) {
+        char key_buf[16];
+        snprintf(key_buf, sizeof(key_buf), "ovf_%04d", i);
+        Value v;
+        assert(btree_search(th, Key(key_buf), v) && "Overflow key not found");
+        assert(v.size() == values[i].size() && memcmp(v.data(), values[i].data(), v.size()) == 0 && "Overflow value mismatch");
+    }
+    std::cout << "[OK] Inserted and read back " << num_records << " records, largest 60000 bytes\n";
+
+    // Key-only and prefix access stay in the leaves
+    {
+        BTreeCursor cursor(th);
+        int seen = 0;
+        int overflowed = 0;
+        for (bool ok = cursor.seek_first(); ok; ok = cursor.next()) {
+            Value head = cursor.inline_value();
+            const std::string& expected = values[seen];
+            assert(head.size() <= expected.size() && memcmp(head.data(), expected.data(), head.size()) == 0 && "Inline prefix mismatch");
+            if (cursor.value_is_overflow()) {
+                overflowed++;
+                assert(head.size() == OVERFLOW_INLINE_PREFIX && "Overflow record should keep a short prefix inline");
+                Value full = cursor.value();
+                assert(full.size() == expected.size() && memcmp(full.data(), expected.data(), full.size()) == 0 && "Cursor overflow value mismatch");
+            }
+            seen++;
+        }
+        assert(seen == num_records && overflowed == num_records / 3 && "Unexpected overflow record count");
+    }
+    std::cout << "[OK] Cursor exposes inline prefixes and loads full values on demand\n";
+
+    // Updates across the threshold in both directions, then deletes, release the chains
+    std::string small = "now small";
+    std::string big = make_value(99, 5 * PAGE_SIZE);
+    assert(btree_update(th, Key("ovf_0003"), Value((const uint8_t*)small.data(), (uint16_t)small.size())));
+    assert(btree_update(th, Key("ovf_0004"), Value((const uint8_t*)big.data(), (uint16_t)big.size())));
+    Value v;
+    assert(btree_search(th, Key("ovf_0003"), v) && v.size() == small.size() && memcmp(v.data(), small.data(), v.size()) == 0);
+    assert(btree_search(th, Key("ovf_0004"), v) && v.size() == big.size() && memcmp(v.data(), big.data(), v.size()) == 0);
+    std::cout << "[OK] Updates move values in and out of overflow pages\n";
+
+    for (int i = 0; i < num_records; i++) {
+        char key_buf[16];
+        snprintf(key_buf, sizeof(key_buf), "ovf_%04d", i);
+        assert(btree_delete(th, Key(key_buf)) && "Overflow delete failed");
+    }
+    // The emptied tree also releases its initial root page
+    assert(count_allocated_pages(th) <= pages_before && "Deleting overflow records should free their chains");
+    assert(th.bpm->get_pinned_count() == 0 && "Overflow access should release every page");
+    std::cout << "[OK] Deletes freed every overflow page\n";
+
+    std::cout << "\n=== Overflow Value Test PASSED ===\n";
+}
+
+void test_btree_deferred_delete() {
+    std::cout << "\n=== B+ Tree Deferred Delete Test ===\n";
+
+    const std::string table = "test_btree_deferred_delete";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+
+    assert(create_table(table) && "create_table failed");
+    TableHandle th(table);
+    assert(open_table(table, th) && "open_table failed");
+    assert(btree_set_deferred_deletes(th, true) && th.deferred_deletes);
+    {
+        TableHandle reopened(table);
+        assert(open_table(table, reopened) && reopened.deferred_deletes && "Deferred deletes should persist");
+    }
+
+    auto make_key = [](int i) {
+        char key_buf[16];
+        snprintf(key_buf, sizeof(key_buf), "tomb_%05d", i);
+        return std::string(key_buf);
+    };
+    const int num_records = 2000;
+    std::string value(40, 'v');
+    for (int i = 0; i < num_records; i++) {
+        assert(btree_insert(th, Key(make_key(i)), Value((const uint8_t*)value.data(), (uint16_t)value.size())));
+    }
+    std::string big(3 * PAGE_SIZE, 'B');
+    assert(btree_insert(th, Key("tomb_big"), Value((const uint8_t*)big.data(), (uint16_t)big.size())));
+    int leaves_before = count_leaf_pages(th, th.root_page);
+    int pages_before = count_allocated_pages(th);
+
+    // Keep every tenth key; the rest become tombstones
+    for (int i = 0; i < num_records; i++) {
+        if (i % 10 != 0) {
+            assert(btree_delete(th, Key(make_key(i))) && "Deferred delete failed");
+        }
+    }
+    assert(btree_delete(th, Key("tomb_big")));
+    assert(!btree_delete(th, Key(make_key(1))) && "Deleting a tombstone should fail");
+    assert(count_leaf_pages(th, th.root_page) == leaves_before && "Deferred deletes should not restructure the tree");
+    assert(count_allocated_pages(th) == pages_before && "Overflow chains stay until compaction");
+    std::cout << "[OK] Deletes only marked tombstones, " << leaves_before << " leaves unchanged\n";
+
+    Value v;
+    assert(!btree_search(th, Key(make_key(1)), v) && "Tombstoned key should not be found");
+    assert(btree_search(th, Key(make_key(10)), v) && "Live key lost");
+    assert(!btree_update(th, Key(make_key(2)), Value((const uint8_t*)"x", 1)) && "Updating a tombstone should fail");
+    int forward = 0;
+    int backward = 0;
+    {
+        BTreeCursor cursor(th);
+        for (bool ok = cursor.seek(Key(make_key(1))); ok; ok = cursor.next()) {
+            Key k = cursor.key();
+            std::string expected = make_key(forward * 10 + 10);
+            assert(compare_keys(k.data(), k.size(), (const uint8_t*)expected.data(), (uint16_t)expected.size()) == 0 &&
+                   "Cursor returned a tombstone");
+            forward++;
+        }
+        for (bool ok = cursor.seek_last(); ok; ok = cursor.prev()) {
+            backward++;
+        }
+    }
+    std::vector<std::string> probe_keys = {make_key(0), make_key(5), make_key(20), "tomb_big"};
+    std::vector<Key> probes;
+    for (const std::string& k : probe_keys) {
+        probes.emplace_back(k);
+    }
+    std::vector<Value> found;
+    std::vector<bool> hits;
+    assert(btree_multi_search(th, probes, found, hits) == 2 && "Multi-search returned a tombstone");
+    assert(forward == num_records / 10 - 1 && backward == num_records / 10 && "Scans should skip tombstones");
+    std::cout << "[OK] Lookups, updates, cursors and multi-search skip tombstones\n";
+
+    // A tombstoned key can be inserted again with a new value
+    std::string revived = "revived";
+    assert(btree_insert(th, Key(make_key(7)), Value((const uint8_t*)revived.data(), (uint16_t)revived.size())));
+    assert(btree_search(th, Key(make_key(7)), v) && v.size() == revived.size() &&
+           memcmp(v.data(), revived.data(), v.size()) == 0 && "Revived key has the wrong value");
+    std::cout << "[OK] Re-inserting a tombstoned key revives it\n";
+
+    size_t reclaimed = btree_compact(th);
+    int leaves_after = count_leaf_pages(th, th.root_page);
+    assert(reclaimed > 0 && reclaimed <= (size_t)(num_records - num_records / 10 + 1) && "Unexpected tombstone count");
+    assert(btree_compact(th) == 0 && "Second compaction should find nothing");
+    assert(leaves_after < leaves_before / 4 && "Compaction should merge the emptied leaves");
+    assert(count_allocated_pages(th) < pages_before && "Compaction should free leaves and overflow chains");
+    for (int i = 0; i < num_records; i += 10) {
+        assert(btree_search(th, Key(make_key(i)), v) && "Live key lost by compaction");
+    }
+    assert(btree_search(th, Key(make_key(7)), v) && "Revived key lost by compaction");
+    assert(th.bpm->get_pinned_count() == 0 && "Compaction should release every page");
+    std::cout << "[OK] Compaction reclaimed " << reclaimed << " tombstones, leaves " << leaves_before
+              << " -> " << leaves_after << ", fill " << average_leaf_fill_percent(th) << "%\n";
+
+    // Tombstoning everything and compacting empties the tree
+    for (int i = 0; i < num_records; i += 10) {
+        assert(btree_delete(th, Key(make_key(i))));
+    }
+    assert(btree_delete(th, Key(make_key(7))));
+    btree_compact(th);
+    assert(th.root_page == 0 && "Fully compacted tree should be empty");
+    std::cout << "[OK] Compacting an all-tombstone tree empties it\n";
+
+    std::cout << "\n=== Deferred Delete Test PASSED ===\n";
+}
+
+void test_btree_write_buffer() {
+    std::cout << "\n=== B+ Tree Write Buffer Test ===\n";
+
+    const std::string table = "test_btree_write_buffer";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+
+    assert(create_table(table) && "create_table failed");
+    std::map<std::string, std::string> model;
+    {
+        TableHandle th(table);
+        assert(open_table(table, th) && "open_table failed");
+        assert(btree_enable_write_buffer(th, 4) && th.write_buffer.size() == 4);
+        assert(!btree_enable_write_buffer(th) && "Buffer enabled twice");
+
+        // Random-order inserts, updates and deletes, checked against a map
+        uint32_t seed = 12345;
+        auto next = [&seed]() { seed = seed * 1103515245 + 12345; return (seed >> 8) % 3000; };
+        for (int i = 0; i < 12000; i++) {
+            char key_buf[16];
+            snprintf(key_buf, sizeof(key_buf), "wb_%05u", next());
+            std::string key = key_buf;
+            std::string value = "val_" + std::to_string(i) + std::string(i % 40, 'x');
+            Value v((const uint8_t*)value.data(), (uint16_t)value.size());
+            int op = i % 10;
+            if (op < 6) {
+                // Inserts are blind: one of a key already in the leaves is accepted and
+                // then dropped when the buffer is applied
+                bool inserted = btree_insert(th, Key(key), v);
+                assert((inserted || model.count(key) == 1) && "Buffered insert should reject live keys only");
+                if (inserted && model.count(key) == 0) {
+                    model[key] = value;
+                }
+            } else if (op < 8) {
+                assert(btree_update(th, Key(key), v) && "Buffered update should be accepted");
+                if (model.count(key)) {
+                    model[key] = value;
+                }
+            } else {
+                assert(btree_delete(th, Key(key)) && "Buffered delete should be accepted");
+                model.erase(key);
+            }
+            if (i % 997 == 0) {
+                Value out;
+                bool found = btree_search(th, Key(key), out);
+                assert(found == (model.count(key) == 1) && "Lookup disagrees with pending messages");
+                assert(!found || std::string((const char*)out.data(), out.size()) == model[key]);
+            }
+        }
+        std::string big(2 * PAGE_SIZE, 'B');
+        assert(btree_insert(th, Key("wb_big"), Value((const uint8_t*)big.data(), (uint16_t)big.size())));
+        model["wb_big"] = big;
+        assert(th.bpm->get_pinned_count() == 0 && "Buffered writes should release every page");
+
+        for (const auto& entry : model) {
+            Value out;
+            assert(btree_search(th, Key(entry.first), out) && "Buffered key lost");
+            assert(std::string((const char*)out.data(), out.size()) == entry.second && "Buffered key has the wrong value");
+        }
+        std::cout << "[OK] Lookups see " << model.size() << " keys through the buffer\n";
+
+        // Cursors flush first and see the same contents in key order
+        auto it = model.begin();
+        BTreeCursor cursor(th);
+        for (bool ok = cursor.seek_first(); ok; ok = cursor.next(), ++it) {
+            assert(it != model.end() && "Cursor returned an extra key");
+            Key k = cursor.key();
+            assert(std::string((const char*)k.data(), k.size()) == it->first && "Cursor key order is wrong");
+        }
+        assert(it == model.end() && "Cursor missed keys");
+        std::cout << "[OK] Cursor scan matches the model after a flush\n";
+        assert(btree_flush_write_buffer(th) == 0 && "Scan should have emptied the buffer");
+
+        // A blind insert of a flushed key keeps the stored value; one after a delete replaces it
+        std::string first = model.begin()->first;
+        std::string last = model.rbegin()->first;
+        Value out;
+        assert(btree_insert(th, Key(first), Value((const uint8_t*)"dup", 3)) && "Blind insert should be accepted");
+        assert(btree_search(th, Key(first), out) && std::string((const char*)out.data(), out.size()) == model[first] &&
+               "Pending insert shadowed a live key");
+        assert(btree_delete(th, Key(last)) && btree_insert(th, Key(last), Value((const uint8_t*)"new", 3)));
+        model[last] = "new";
+        assert(btree_flush_write_buffer(th) == 2 && "Both messages should apply");
+        for (const std::string& key : {first, last}) {
+            assert(btree_search(th, Key(key), out) && std::string((const char*)out.data(), out.size()) == model[key] &&
+                   "Flushed insert has the wrong value");
+        }
+        std::cout << "[OK] Duplicate inserts are settled when the buffer is applied\n";
+
+        // Pending messages survive a reopen
+        assert(btree_insert(th, Key("wb_pending"), Value((const uint8_t*)"p", 1)));
+        assert(btree_delete(th, Key(model.begin()->first)));
+        model["wb_pending"] = "p";
+        model.erase(model.begin());
+        th.bpm->flush_all();
+    }
+    {
+        TableHandle th(table);
+        assert(open_table(table, th) && "reopen failed");
+        assert(th.write_buffer.size() == 4 && "Buffer pages lost on reopen");
+        Value out;
+        assert(btree_search(th, Key("wb_pending"), out) && out.size() == 1 && "Pending insert lost on reopen");
+        assert(btree_disable_write_buffer(th) && th.write_buffer.empty());
+        size_t count = 0;
+        BTreeCursor cursor(th);
+        for (bool ok = cursor.seek_first(); ok; ok = cursor.next()) {
+            count++;
+        }
+        assert(count == model.size() && "Disabling the buffer should apply every message");
+        th.bpm->flush_all();
+    }
+    {
+        TableHandle th(table);
+        assert(open_table(table, th) && th.write_buffer.empty() && "Disabled buffer came back on reopen");
+        Value out;
+        assert(!btree_insert(th, Key("wb_pending"), Value((const uint8_t*)"q", 1)) && "Unbuffered insert should see duplicates");
+    }
+    std::cout << "[OK] Pending messages persist across reopen and disabling applies them\n";
+
+    // With no free page the root leaf cannot split: the messages that fit land, and
+    // the rest stay buffered until the tree can take them
+    const std::string full_table = "test_btree_write_buffer_full";
+    std::string full_path = "data/" + full_table + ".db";
+    remove(full_path.c_str());
+    assert(create_table(full_table) && "create_table failed");
+    {
+        TableHandle th(full_table);
+        assert(open_table(full_table, th) && btree_enable_write_buffer(th, 4));
+        std::string value(120, 'f');
+        for (int i = 0; i < 20; i++) {
+            assert(btree_insert(th, Key("full_" + std::to_string(i)), Value((const uint8_t*)value.data(), (uint16_t)value.size())));
+        }
+        assert(!btree_insert(th, Key("full_3"), Value((const uint8_t*)"x", 1)) && "Pending insert should count as live");
+        Page* bitmap = th.bpm->fetch_page(1);
+        assert(bitmap && "fetch bitmap failed");
+        std::vector<uint8_t> saved(bitmap->data, bitmap->data + PAGE_SIZE);
+        std::memset(bitmap->data + sizeof(PageHeader), 0xFF, PAGE_SIZE - sizeof(PageHeader));
+        th.bpm->unpin_page(1, true);
+
+        size_t applied = btree_flush_write_buffer(th);
+        assert(applied < 20 && "Flush without free pages cannot split the leaf");
+        assert(!btree_disable_write_buffer(th) && th.write_buffer.size() == 4 && "Buffer dropped with messages pending");
+        Value out;
+        for (int i = 0; i < 20; i++) {
+            assert(btree_search(th, Key("full_" + std::to_string(i)), out) && out.size() == value.size() &&
+                   "Failed flush lost a message");
+        }
+
+        bitmap = th.bpm->fetch_page(1);
+        std::memcpy(bitmap->data, saved.data(), PAGE_SIZE);
+        th.bpm->unpin_page(1, true);
+        assert(btree_flush_write_buffer(th) == 20 - applied && "Retry should apply only the pending messages");
+        assert(btree_disable_write_buffer(th));
+        for (int i = 0; i < 20; i++) {
+            assert(btree_search(th, Key("full_" + std::to_string(i)), out) && "Message lost after the retry");
+        }
+    }
+    std::cout << "[OK] A failed flush keeps its messages and a later flush applies them\n";
+
+    std::cout << "\n=== Write Buffer Test PASSED ===\n";
+}
+
+static long file_size(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file ? static_cast<long>(file.tellg()) : -1;
+}
+
+void test_btree_vacuum() {
+    std::cout << "\n=== B+ Tree Vacuum Test ===\n";
+
+    const std::string table = "test_btree_vacuum";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+
+    assert(create_table(table) && "create_table failed");
+    auto make_key = [](int i) {
+        char key_buf[16];
+        snprintf(key_buf, sizeof(key_buf), "vac_%05d", i);
+        return std::string(key_buf);
+    };
+    auto make_value = [](int i) {
+        return i % 100 == 0 ? std::string(3 * PAGE_SIZE, 'A' + i % 26) : "value_" + std::to_string(i);
+    };
+    const int num_records = 6000;
+    std::map<std::string, std::string> model;
+    {
+        TableHandle th(table);
+        assert(open_table(table, th) && "open_table failed");
+        // Random insert order scatters the leaves over the file
+        uint32_t seed = 777;
+        std::vector<int> order;
+        for (int i = 0; i < num_records; i++) {
+            order.push_back(i);
+        }
+        for (int i = num_records - 1; i > 0; i--) {
+            seed = seed * 1103515245 + 12345;
+            std::swap(order[i], order[(seed >> 8) % (i + 1)]);
+        }
+        for (int i : order) {
+            std::string value = make_value(i);
+            assert(btree_insert(th, Key(make_key(i)), Value((const uint8_t*)value.data(), (uint16_t)value.size())));
+            model[make_key(i)] = value;
+        }
+        // Delete the upper two thirds outright and tombstone most of the rest
+        for (int i = num_records / 3; i < num_records; i++) {
+            assert(btree_delete(th, Key(make_key(i))));
+            model.erase(make_key(i));
+        }
+        assert(btree_set_deferred_deletes(th, true));
+        for (int i = 0; i < num_records / 3; i++) {
+            if (i % 4 != 0) {
+                assert(btree_delete(th, Key(make_key(i))));
+                model.erase(make_key(i));
+            }
+        }
+        th.bpm->flush_all();
+        long size_before = file_size(path);
+        int leaves_before = count_leaf_pages(th, th.root_page);
+
+        // With no free page the rebuild fails before the old tree is touched
+        Page* bitmap = th.bpm->fetch_page(1);
+        assert(bitmap && "fetch bitmap failed");
+        Page saved_bitmap;
+        std::memcpy(saved_bitmap.data, bitmap->data, PAGE_SIZE);
+        std::memset(bitmap->data + sizeof(PageHeader), 0xFF, PAGE_SIZE - sizeof(PageHeader));
+        th.bpm->unpin_page(1, true);
+        uint32_t root_before = th.root_page;
+        assert(btree_vacuum(th) == 0 && "Vacuum without free pages should fail");
+        bitmap = th.bpm->fetch_page(1);
+        assert(bitmap && std::memcmp(bitmap->data + sizeof(PageHeader), std::string(PAGE_SIZE - sizeof(PageHeader), '\xFF').data(),
+                                     PAGE_SIZE - sizeof(PageHeader)) == 0 && "Failed vacuum should restore the bitmap");
+        std::memcpy(bitmap->data, saved_bitmap.data, PAGE_SIZE);
+        th.bpm->unpin_page(1, true);
+        assert(th.root_page == root_before && count_leaf_pages(th, th.root_page) == leaves_before &&
+               "Failed vacuum should keep the old tree");
+
+        // An unreadable overflow chain aborts the rebuild instead of dropping the row
+        Page leaf;
+        uint32_t leaf_id = find_leaf_page(th, Key(make_key(0)), leaf);
+        uint32_t chain = 0;
+        for (uint16_t i = 0; i < get_header(leaf)->cell_count && chain == 0; i++) {
+            uint16_t key_len = 0;
+            const uint8_t* key = slot_key(leaf, i, key_len);
+            if (std::string((const char*)key, key_len) == make_key(0)) {
+                uint16_t stored_len = 0;
+                const uint8_t* stored = slot_value(leaf, i, stored_len);
+                chain = overflow_first_page(stored, stored_len);
+            }
+        }
+        assert(leaf_id != UINT32_MAX && chain != 0 && "Key 0 should hold an overflow value");
+        Page* chain_page = th.bpm->fetch_page(chain);
+        assert(chain_page && "fetch chain failed");
+        get_header(*chain_page)->page_type = PageType::FREE;
+        th.bpm->unpin_page(chain, true);
+        assert(btree_vacuum(th) == 0 && "Vacuum should fail on an unreadable chain");
+        assert(th.root_page == root_before && count_leaf_pages(th, th.root_page) == leaves_before &&
+               "Failed vacuum should keep the old tree");
+        chain_page = th.bpm->fetch_page(chain);
+        assert(chain_page && "fetch chain failed");
+        get_header(*chain_page)->page_type = PageType::OVERFLOW;
+        th.bpm->unpin_page(chain, true);
+        Value kept;
+        assert(btree_search(th, Key(make_key(0)), kept) && std::string((const char*)kept.data(), kept.size()) == model[make_key(0)] &&
+               "Failed vacuum should keep the row");
+        th.bpm->flush_all();
+        assert(file_size(path) == size_before && "Failed vacuum should leave the file size as it was");
+        std::cout << "[OK] Failed vacuum leaves the tree and the file unchanged\n";
+
+        uint32_t released = btree_vacuum(th);
+        long size_after = file_size(path);
+        assert(released > 0 && size_after == size_before - (long)released * PAGE_SIZE && "Vacuum should shrink the file");
+        assert(release_free_tail(th) == 0 && "Vacuum should leave no free pages at the end");
+        assert(th.bpm->get_pinned_count() == 0 && "Vacuum should release every page");
+
+        // The leaf chain runs through consecutive pages in key order
+        uint32_t page_id = find_leftmost_leaf_page(th, leaf);
+        int leaves_after = 0;
+        int fill_sum = 0;
+        while (page_id != 0) {
+            Page* page = th.bpm->fetch_page(page_id);
+            assert(page && "fetch leaf failed");
+            PageHeader* ph = get_header(*page);
+            for (uint16_t i = 0; i < ph->cell_count; i++) {
+                assert(!slot_is_deleted(*page, i) && "Vacuum should drop tombstones");
+            }
+            fill_sum += 100 * (PAGE_SIZE - sizeof(PageHeader) - (ph->free_end - ph->free_start)) / (PAGE_SIZE - sizeof(PageHeader));
+            uint32_t next_id = ph->next_page_id;
+            th.bpm->unpin_page(page_id, false);
+            assert((next_id == 0 || next_id == page_id + 1) && "Leaf chain should follow file order");
+            page_id = next_id;
+            leaves_after++;
+        }
+        assert(leaves_after < leaves_before && fill_sum / leaves_after >= VACUUM_FILL_PERCENT - 15 && "Leaves should be packed");
+        std::cout << "[OK] Vacuum released " << released << " pages, leaves " << leaves_before << " -> " << leaves_after
+                  << " at " << fill_sum / leaves_after << "% fill\n";
+
+        auto it = model.begin();
+        BTreeCursor cursor(th);
+        for (bool ok = cursor.seek_first(); ok; ok = cursor.next(), ++it) {
+            assert(it != model.end() && "Cursor returned an extra key");
+            Key k = cursor.key();
+            Value v = cursor.value();
+            assert(std::string((const char*)k.data(), k.size()) == it->first && "Cursor key out of order");
+            assert(std::string((const char*)v.data(), v.size()) == it->second && "Vacuum changed a value");
+        }
+        assert(it == model.end() && "Cursor missed keys");
+        cursor.close();
+        std::cout << "[OK] " << model.size() << " live keys and overflow values kept\n";
+
+        // The rebuilt tree takes writes as usual
+        assert(btree_set_deferred_deletes(th, false));
+        for (int i = num_records / 3; i < num_records / 2; i++) {
+            std::string value = make_value(i);
+            assert(btree_insert(th, Key(make_key(i)), Value((const uint8_t*)value.data(), (uint16_t)value.size())));
+            model[make_key(i)] = value;
+        }
+        assert(btree_delete(th, Key(make_key(0))));
+        model.erase(make_key(0));
+    }
+    {
+        TableHandle th(table);
+        assert(open_table(table, th) && "reopen failed");
+        for (const auto& entry : model) {
+            Value v;
+            assert(btree_search(th, Key(entry.first), v) && "Key lost after reopen");
+            assert(std::string((const char*)v.data(), v.size()) == entry.second && "Wrong value after reopen");
+        }
+        Value v;
+        assert(!btree_search(th, Key(make_key(num_records - 1)), v) && "Deleted key came back");
+
+        // Vacuuming a tree emptied by deletes leaves only the fixed pages
+        for (const auto& entry : model) {
+            assert(btree_delete(th, Key(entry.first)));
+        }
+        btree_vacuum(th);
+        assert(file_size(path) <= 3L * PAGE_SIZE && "Empty tree should shrink to its fixed pages");
+    }
+    std::cout << "[OK] Rebuilt tree accepts writes and survives reopen\n";
+
+    std::cout << "\n=== Vacuum Test PASSED ===\n";
+}
+
 int main() {
     try {
         test_btree_basic_insert_and_search();
@@ -1066,6 +2033,15 @@ int main() {
         test_btree_large_value_split();
         test_btree_delete();
         test_btree_merge_on_underutilization();
+        test_btree_cursor();
+        test_btree_multi_search();
+        test_btree_sequential_append();
+        test_btree_update_in_place();
+        test_btree_delete_churn();
+        test_btree_overflow_values();
+        test_btree_deferred_delete();
+        test_btree_write_buffer();
+        test_btree_vacuum();
         
         std::cout << "\n\n=== ALL B+ TREE TESTS PASSED ===\n";
         
@@ -1,9 +1,17 @@
 #include "storage/interface/storage_engine.hpp"
 #include "storage/relational/catalog.hpp"
+#include "storage/relational/row_view.hpp"
+#include "storage/relational/compiled_codec.hpp"
+#include "storage/table_handle.hpp"
+#include "storage/lsm_tree.hpp"
 #include <iostream>
 #include <cassert>
 #include <string>
+#include <string_view>
 #include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <climits>
 
 #define CHECK(cond, msg) do { if (!(cond)) { std::cerr << "FAIL: " << (msg) << std::endl; return 1; } } while(0)
 
@@ -11,6 +19,1089 @@ static void ensure_data_dir() {
     std::filesystem::create_directories("data");
 }
 
+static int test_secondary_indexes() {
+    std::cout << "\n=== Secondary Index Test ===" << std::endl;
+    const std::string table = "test_relational_index";
+    const std::string email_index = "data/" + table + "." + table + "_email_key.db";
+    const std::string age_index = "data/" + table + ".age_idx.db";
+    std::remove(("data/" + table + ".db").c_str());
+    std::remove(email_index.c_str());
+    std::remove(age_index.c_str());
+
+    StorageEngine engine;
+    Relational::TableSchema schema;
+    schema.pk_index = 0;
+    schema.columns = {
+        {"id", Relational::ColumnType::INT},
+        {"email", Relational::ColumnType::STRING, true},
+        {"age", Relational::ColumnType::INT}
+    };
+    CHECK(engine.create_table(table, schema), "create_table with UNIQUE column failed");
+    CHECK(engine.get_schema(table)->indexes.size() == 1, "UNIQUE column should get an implicit index");
+    CHECK(std::filesystem::exists(email_index), "unique index file missing");
+    std::cout << "[OK] UNIQUE column created its index" << std::endl;
+
+    for (int id = 1; id <= 40; id++) {
+        Relational::Tuple row = { id, std::string("user") + std::to_string(id) + "@x.io", 20 + id % 4 };
+        CHECK(engine.insert(table, row), "insert failed");
+    }
+    Relational::Tuple dup = { 99, std::string("user7@x.io"), 50 };
+    CHECK(!engine.insert(table, dup), "duplicate UNIQUE value should be rejected");
+    CHECK(engine.scan(table).size() == 40, "rejected row must not reach the table");
+    std::cout << "[OK] UNIQUE violation rejected without side effects" << std::endl;
+
+    CHECK(engine.create_index(table, "age_idx", "age"), "CREATE INDEX on age failed");
+    CHECK(!engine.create_index(table, "age_idx", "age"), "duplicate index name should fail");
+    CHECK(!engine.create_index(table, "age_unique", "age", true), "unique index over duplicate values should fail");
+    auto age_rows = engine.lookup(table, "age", 21);
+    CHECK(age_rows.size() == 10, "age lookup should find 10 rows (got " + std::to_string(age_rows.size()) + ")");
+    for (const auto& row : age_rows) {
+        CHECK(std::get<int>(row[2]) == 21, "age lookup returned a wrong row");
+    }
+    auto by_email = engine.lookup(table, "email", std::string("user13@x.io"));
+    CHECK(by_email.size() == 1 && std::get<int>(by_email[0][0]) == 13, "email lookup");
+    std::cout << "[OK] Index built over existing rows and answers lookups" << std::endl;
+
+    Relational::Tuple moved = { 13, std::string("new13@x.io"), 77 };
+    CHECK(engine.update(table, moved), "update failed");
+    CHECK(engine.lookup(table, "email", std::string("user13@x.io")).empty(), "old email still indexed");
+    CHECK(engine.lookup(table, "email", std::string("new13@x.io")).size() == 1, "new email not indexed");
+    CHECK(engine.lookup(table, "age", 77).size() == 1 && engine.lookup(table, "age", 21).size() == 9, "age index after update");
+    Relational::Tuple clash = { 14, std::string("new13@x.io"), 22 };
+    CHECK(!engine.update(table, clash), "update to a taken UNIQUE value should fail");
+    std::cout << "[OK] Updates move index entries" << std::endl;
+
+    CHECK(engine.remove(table, 13), "remove failed");
+    CHECK(!engine.remove(table, 13), "second remove should fail");
+    CHECK(engine.lookup(table, "email", std::string("new13@x.io")).empty() && engine.lookup(table, "age", 77).empty(),
+          "removed row still indexed");
+    CHECK(engine.insert(table, Relational::Tuple{ 100, std::string("new13@x.io"), 30 }), "freed UNIQUE value should be reusable");
+    CHECK(engine.lookup(table, "id", 100).size() == 1, "lookup on a column without index");
+    std::cout << "[OK] Deletes drop index entries" << std::endl;
+
+    CHECK(engine.drop_table(table), "drop_table failed");
+    CHECK(!std::filesystem::exists(email_index) && !std::filesystem::exists(age_index), "drop_table should remove index files");
+    std::cout << "[OK] drop_table removed the index trees" << std::endl;
+
+    std::cout << "\n=== Secondary Index Test PASSED ===" << std::endl;
+    return 0;
+}
+
+static int test_index_write_rollback() {
+    std::cout << "\n=== Index Write Rollback Test ===" << std::endl;
+    const std::string table = "test_relational_index_undo";
+    StorageEngine engine;
+    engine.drop_table(table);
+    Relational::TableSchema schema;
+    schema.pk_index = 0;
+    schema.columns = {
+        {"id", Relational::ColumnType::INT},
+        {"a", Relational::ColumnType::INT},
+        {"b", Relational::ColumnType::INT}
+    };
+    CHECK(engine.create_table(table, schema) && engine.create_index(table, "a_idx", "a") &&
+          engine.create_index(table, "b_idx", "b"), "create failed");
+    for (int id = 1; id <= 10; id++) {
+        CHECK(engine.insert(table, Relational::Tuple{ id, id, id }), "insert failed");
+    }
+    Relational::RowCodec codec(*engine.get_schema(table));
+    TableHandle* a_tree = engine.open_table(table + ".a_idx");
+    TableHandle* b_tree = engine.open_table(table + ".b_idx");
+    CHECK(a_tree != nullptr && b_tree != nullptr, "index trees missing");
+    std::vector<uint8_t> out;
+
+    // An entry already sitting in b_idx makes the row's second index write fail
+    Relational::Tuple blocked = { 50, 50, 50 };
+    std::vector<uint8_t> blocker = codec.encode_index_key(blocked, 2);
+    CHECK(engine.insert_record(b_tree, blocker, {1}), "planting the b_idx entry failed");
+    CHECK(!engine.insert(table, blocked), "insert with a failing index write should fail");
+    CHECK(engine.lookup(table, "id", 50).empty(), "failed insert left its row behind");
+    CHECK(!engine.get_record(a_tree, codec.encode_index_key(blocked, 1), out), "failed insert left its a_idx entry");
+    std::cout << "[OK] Failed insert took back the row and the earlier index entry" << std::endl;
+
+    Relational::Tuple moved = { 3, 50, 50 };
+    CHECK(engine.insert_record(b_tree, codec.encode_index_key(moved, 2), {1}), "planting the b_idx entry failed");
+    CHECK(!engine.update(table, moved), "update with a failing index write should fail");
+    auto rows = engine.lookup(table, "a", 3);
+    CHECK(rows.size() == 1 && std::get<int>(rows[0][2]) == 3, "failed update changed the row");
+    CHECK(!engine.get_record(a_tree, codec.encode_index_key(moved, 1), out), "failed update left its a_idx entry");
+    std::cout << "[OK] Failed update restored the row and its index entries" << std::endl;
+
+    // With its b_idx entry gone, removing row 4 fails on the second index
+    Relational::Tuple missing = { 4, 4, 4 };
+    CHECK(engine.delete_record(b_tree, codec.encode_index_key(missing, 2)), "dropping the b_idx entry failed");
+    CHECK(!engine.remove(table, 4), "remove with a failing index write should fail");
+    CHECK(engine.lookup(table, "a", 4).size() == 1, "failed remove lost the row or its a_idx entry");
+    std::cout << "[OK] Failed remove put the row and its index entry back" << std::endl;
+
+    CHECK(engine.delete_record(b_tree, blocker) && engine.delete_record(b_tree, codec.encode_index_key(moved, 2)) &&
+          engine.insert(table, blocked) && engine.update(table, Relational::Tuple{ 3, 30, 30 }),
+          "writes should succeed once the index is consistent");
+    CHECK(engine.lookup(table, "b", 30).size() == 1 && engine.lookup(table, "b", 3).empty(), "b_idx after update");
+    CHECK(engine.drop_table(table), "drop_table failed");
+
+    // An index key longer than a leaf split can take rejects the row instead of
+    // aborting the split; without the index the same rows fit through overflow pages
+    const std::string users = "test_relational_index_long_keys";
+    engine.drop_table(users);
+    Relational::TableSchema user_schema;
+    user_schema.pk_index = 0;
+    user_schema.columns = {
+        {"id", Relational::ColumnType::INT},
+        {"email", Relational::ColumnType::STRING, true}
+    };
+    CHECK(engine.create_table(users, user_schema), "create_table with a UNIQUE column failed");
+    std::string long_email(1500, 'e');
+    CHECK(!engine.insert(users, Relational::Tuple{ 1, long_email }) &&
+          !engine.insert(users, Relational::Tuple{ 2, long_email + "x" }), "over-long index keys should be rejected");
+    CHECK(engine.scan(users).empty(), "rejected rows left the table");
+    CHECK(engine.insert(users, Relational::Tuple{ 3, std::string("short@example.com") }) &&
+          engine.lookup(users, "email", std::string("short@example.com")).size() == 1, "short keys still index");
+    CHECK(engine.drop_table(users), "drop_table failed");
+    std::cout << "[OK] Over-long index keys reject the row" << std::endl;
+
+    user_schema.columns[1].is_unique = false;
+    CHECK(engine.create_table(users, user_schema), "create_table failed");
+    CHECK(engine.insert(users, Relational::Tuple{ 1, long_email }) &&
+          engine.insert(users, Relational::Tuple{ 2, long_email + "x" }), "unindexed long values should fit");
+    CHECK(!engine.create_index(users, "email_idx", "email"), "backfilling over-long keys should fail");
+    CHECK(engine.open_table(users)->bpm->get_pinned_count() == 0, "a failed backfill should end its scan");
+    CHECK(engine.get_schema(users)->indexes.empty() && engine.remove(users, 1) && engine.remove(users, 2),
+          "a failed backfill should leave no index behind");
+    CHECK(engine.create_index(users, "email_idx", "email"), "the index name should be free again");
+    CHECK(engine.drop_table(users), "drop_table failed");
+    std::cout << "[OK] A failed backfill drops the index" << std::endl;
+
+    // A table whose listed index cannot be built is not created at all
+    user_schema.indexes = { Relational::IndexDef{ "bad_idx", 9, false, {} } };
+    CHECK(!engine.create_table(users, user_schema), "an index on a missing column should fail the create");
+    CHECK(engine.get_schema(users) == nullptr, "a failed create left the table behind");
+    user_schema.indexes.clear();
+    CHECK(engine.create_table(users, user_schema) && engine.drop_table(users), "retrying the create failed");
+    std::cout << "[OK] A failed create_table can be retried" << std::endl;
+    std::cout << "\n=== Index Write Rollback Test PASSED ===" << std::endl;
+    return 0;
+}
+
+static int test_covering_index() {
+    std::cout << "\n=== Covering Index Test ===" << std::endl;
+    const std::string table = "test_relational_covering";
+    const std::string city_index = "data/" + table + ".city_idx.db";
+    std::remove(("data/" + table + ".db").c_str());
+    std::remove(city_index.c_str());
+
+    StorageEngine engine;
+    Relational::TableSchema schema;
+    schema.pk_index = 0;
+    schema.columns = {
+        {"id", Relational::ColumnType::INT},
+        {"city", Relational::ColumnType::STRING},
+        {"score", Relational::ColumnType::INT},
+        {"note", Relational::ColumnType::STRING}
+    };
+    CHECK(engine.create_table(table, schema), "create_table failed");
+    for (int id = 1; id <= 30; id++) {
+        Relational::Tuple row = { id, std::string(id % 3 == 0 ? "oslo" : "rome"), id * 10, std::string("n") + std::to_string(id) };
+        CHECK(engine.insert(table, row), "insert failed");
+    }
+    CHECK(!engine.create_index(table, "bad_idx", "city", false, {"missing"}), "unknown INCLUDE column should fail");
+    CHECK(engine.create_index(table, "city_idx", "city", false, {"score"}), "CREATE INDEX ... INCLUDE failed");
+    CHECK(engine.find_covering_index(table, {"city", "id", "score"}) != nullptr, "index should cover city, id, score");
+    CHECK(engine.find_covering_index(table, {"city", "note"}) == nullptr, "note is not covered");
+    std::vector<Relational::Tuple> rows;
+    CHECK(!engine.index_only_scan(table, "city_idx", {"note"}, rows), "uncovered column should be refused");
+    std::cout << "[OK] INCLUDE columns validated and coverage detected" << std::endl;
+
+    Relational::Tuple moved = { 9, std::string("oslo"), 999, std::string("changed") };
+    CHECK(engine.update(table, moved), "update failed");
+
+    // Drop every base row behind the index's back: the scan must still answer
+    TableHandle* base = engine.open_table(table);
+    Relational::RowCodec codec(*engine.get_schema(table));
+    for (const auto& row : engine.scan(table)) {
+        CHECK(engine.delete_record(base, codec.encode_key(row)), "base delete failed");
+    }
+    CHECK(engine.scan(table).empty(), "base table should be empty");
+
+    Relational::Value oslo = std::string("oslo");
+    CHECK(engine.index_only_scan(table, "city_idx", {"id", "score"}, rows, &oslo), "index-only scan failed");
+    CHECK(rows.size() == 10, "expected 10 oslo rows (got " + std::to_string(rows.size()) + ")");
+    for (const auto& row : rows) {
+        int id = std::get<int>(row[0]);
+        int expected = id == 9 ? 999 : id * 10;
+        CHECK(row.size() == 2 && std::get<int>(row[1]) == expected, "wrong projected score");
+    }
+    CHECK(engine.index_only_scan(table, "city_idx", {"city"}, rows) && rows.size() == 30, "full index-only scan");
+    CHECK(std::get<std::string>(rows.front()[0]) == "oslo" && std::get<std::string>(rows.back()[0]) == "rome",
+          "full scan should come back in index order");
+    std::cout << "[OK] Index-only scan answered without the base table" << std::endl;
+
+    // An entry past every good one that does not decode fails the scan with no rows
+    std::vector<uint8_t> bad_key = codec.encode_key_column(1, std::string("zurich"));
+    CHECK(engine.insert_record(engine.open_table(table + ".city_idx"), bad_key, {0xFF}), "planting the bad entry failed");
+    CHECK(!engine.index_only_scan(table, "city_idx", {"city"}, rows) && rows.empty(),
+          "a failed scan should leave no partial rows");
+    std::cout << "[OK] A failed index-only scan returned no rows" << std::endl;
+
+    CHECK(engine.drop_table(table), "drop_table failed");
+    std::cout << "\n=== Covering Index Test PASSED ===" << std::endl;
+    return 0;
+}
+
+static int test_hash_storage() {
+    std::cout << "\n=== Hash Storage Test ===" << std::endl;
+    const std::string table = "test_relational_hash";
+    std::remove(("data/" + table + ".db").c_str());
+
+    StorageEngine engine;
+    Relational::TableSchema schema;
+    schema.pk_index = 0;
+    schema.columns = {
+        {"id", Relational::ColumnType::INT},
+        {"name", Relational::ColumnType::STRING}
+    };
+    schema.storage = Relational::TableStorage::HASH;
+    CHECK(engine.create_table(table, schema), "create_table with hash storage failed");
+    for (int id = 1; id <= 500; id++) {
+        CHECK(engine.insert(table, Relational::Tuple{ id, std::string("name") + std::to_string(id) }), "insert failed");
+    }
+    auto hit = engine.lookup(table, "id", 321);
+    CHECK(hit.size() == 1 && std::get<std::string>(hit[0][1]) == "name321", "primary key lookup on hash table");
+    CHECK(engine.update(table, Relational::Tuple{ 321, std::string("renamed") }), "update failed");
+    CHECK(engine.remove(table, 7), "remove failed");
+    CHECK(engine.lookup(table, "id", 7).empty(), "removed row still found");
+    CHECK(std::get<std::string>(engine.lookup(table, "id", 321)[0][1]) == "renamed", "update not visible");
+    CHECK(engine.scan(table).size() == 499, "scan should see every remaining row");
+    std::cout << "[OK] Rows stored, updated and removed through the hash file" << std::endl;
+
+    CHECK(engine.drop_table(table), "drop_table failed");
+    std::cout << "\n=== Hash Storage Test PASSED ===" << std::endl;
+    return 0;
+}
+
+static int test_lsm_storage() {
+    std::cout << "\n=== LSM Storage Test ===" << std::endl;
+    const std::string table = "test_relational_lsm";
+    std::remove(("data/" + table + ".db").c_str());
+    std::remove(("data/" + table + ".by_name.db").c_str());
+
+    StorageEngine engine;
+    Relational::TableSchema schema;
+    schema.pk_index = 0;
+    schema.columns = {
+        {"id", Relational::ColumnType::INT},
+        {"name", Relational::ColumnType::STRING}
+    };
+    schema.storage = Relational::TableStorage::LSM;
+    CHECK(engine.create_table(table, schema), "create_table with lsm storage failed");
+    CHECK(engine.create_index(table, "by_name", "name"), "create_index on an lsm table failed");
+    for (int id = 500; id >= 1; id--) {
+        CHECK(engine.insert(table, Relational::Tuple{ id, std::string("name") + std::to_string(id) }), "insert failed");
+    }
+    CHECK(!engine.insert(table, Relational::Tuple{ 42, std::string("again") }), "duplicate primary key accepted");
+    CHECK(engine.update(table, Relational::Tuple{ 321, std::string("renamed") }), "update failed");
+    CHECK(engine.remove(table, 7), "remove failed");
+    CHECK(engine.lookup(table, "id", 7).empty(), "removed row still found");
+    CHECK(std::get<std::string>(engine.lookup(table, "id", 321)[0][1]) == "renamed", "update not visible");
+    CHECK(engine.lookup(table, "name", std::string("renamed")).size() == 1, "secondary index lookup");
+    std::vector<Relational::Tuple> rows = engine.scan(table);
+    CHECK(rows.size() == 499, "scan should see every remaining row");
+    CHECK(std::is_sorted(rows.begin(), rows.end(), [](const Relational::Tuple& a, const Relational::Tuple& b) {
+              return std::get<int>(a[0]) < std::get<int>(b[0]);
+          }), "LSM scan should merge runs in key order");
+    std::cout << "[OK] Rows stored, updated and removed through the LSM file" << std::endl;
+
+    CHECK(engine.drop_table(table), "drop_table failed");
+    std::cout << "\n=== LSM Storage Test PASSED ===" << std::endl;
+    return 0;
+}
+
+static int test_optimize_table() {
+    std::cout << "\n=== Optimize Table Test ===" << std::endl;
+    const std::string table = "test_relational_optimize";
+    std::remove(("data/" + table + ".db").c_str());
+    std::remove(("data/" + table + ".by_name.db").c_str());
+
+    StorageEngine engine;
+    Relational::TableSchema schema;
+    schema.pk_index = 0;
+    schema.columns = {
+        {"id", Relational::ColumnType::INT},
+        {"name", Relational::ColumnType::STRING}
+    };
+    CHECK(engine.create_table(table, schema), "create_table failed");
+    CHECK(engine.create_index(table, "by_name", "name"), "create_index failed");
+    for (int id = 1; id <= 3000; id++) {
+        CHECK(engine.insert(table, Relational::Tuple{ id, std::string("name") + std::to_string(id) }), "insert failed");
+    }
+    for (int id = 1; id <= 3000; id++) {
+        if (id % 10 != 0) {
+            CHECK(engine.remove(table, id), "remove failed");
+        }
+    }
+    CHECK(engine.optimize_table(table) > 0, "optimize_table should shrink the table and index files");
+    CHECK(engine.optimize_table(table) == 0, "a second optimize_table should find nothing to release");
+    CHECK(engine.scan(table).size() == 300, "optimize_table lost rows");
+    CHECK(engine.lookup(table, "name", std::string("name2500")).size() == 1, "index lookup after optimize_table");
+    CHECK(engine.insert(table, Relational::Tuple{ 1, std::string("back") }), "insert after optimize_table failed");
+    CHECK(engine.lookup(table, "id", 1).size() == 1, "row inserted after optimize_table not found");
+    std::cout << "[OK] Table and index vacuumed online" << std::endl;
+
+    CHECK(engine.drop_table(table), "drop_table failed");
+    std::cout << "\n=== Optimize Table Test PASSED ===" << std::endl;
+    return 0;
+}
+
+// True when the encodings of values (listed in ascending order) memcmp in that order
+// and each decodes back to its value
+static bool keys_ordered(const Relational::RowCodec& codec, size_t column, const std::vector<Relational::Value>& values) {
+    std::vector<uint8_t> previous;
+    for (size_t i = 0; i < values.size(); i++) {
+        std::vector<uint8_t> key = codec.encode_key_column(column, values[i]);
+        int cmp = std::memcmp(previous.data(), key.data(), std::min(previous.size(), key.size()));
+        if (i > 0 && (cmp > 0 || (cmp == 0 && previous.size() >= key.size()))) {
+            return false;
+        }
+        const uint8_t* p = key.data();
+        Relational::Value decoded;
+        if (!codec.decode_key_column(column, p, key.data() + key.size(), decoded) || decoded != values[i] ||
+            p != key.data() + key.size()) {
+            return false;
+        }
+        previous = key;
+    }
+    return true;
+}
+
+static int test_key_order() {
+    std::cout << "\n=== Order-Preserving Key Test ===" << std::endl;
+    Relational::TableSchema types;
+    types.pk_index = 0;
+    types.columns = {
+        {"i", Relational::ColumnType::INT},
+        {"f", Relational::ColumnType::FLOAT},
+        {"d", Relational::ColumnType::DOUBLE},
+        {"s", Relational::ColumnType::STRING},
+        {"b", Relational::ColumnType::BOOLEAN},
+        {"t", Relational::ColumnType::DATETIME}
+    };
+    Relational::RowCodec codec(types);
+    CHECK(keys_ordered(codec, 0, {INT_MIN, -256, -1, 0, 1, 255, 256, 65536, INT_MAX}), "INT keys out of order");
+    CHECK(keys_ordered(codec, 1, {-1e30f, -2.5f, -1.0f, 0.0f, 1e-30f, 1.0f, 2.5f, 1e30f}), "FLOAT keys out of order");
+    CHECK(keys_ordered(codec, 2, {-1e300, -2.5, -1e-300, 0.0, 1e-300, 0.5, 2.5, 1e300}), "DOUBLE keys out of order");
+    CHECK(keys_ordered(codec, 3, {std::string(""), std::string("\0", 1), std::string("\0\0", 2), std::string("\0a", 2),
+                                  std::string("a"), std::string("a\0", 2), std::string("ab"), std::string("b")}),
+          "STRING keys out of order");
+    CHECK(keys_ordered(codec, 4, {false, true}), "BOOLEAN keys out of order");
+    CHECK(keys_ordered(codec, 5, {-86400, 0, 1700000000}), "DATETIME keys out of order");
+    CHECK(codec.encode_key_column(2, -0.0) == codec.encode_key_column(2, 0.0), "-0.0 and 0.0 should share a key");
+    std::cout << "[OK] Every column type encodes memcmp-ordered and decodes back" << std::endl;
+
+    const std::string table = "test_relational_key_order";
+    std::remove(("data/" + table + ".db").c_str());
+    StorageEngine engine;
+    Relational::TableSchema schema;
+    schema.pk_index = 0;
+    schema.columns = {
+        {"id", Relational::ColumnType::INT},
+        {"name", Relational::ColumnType::STRING}
+    };
+    CHECK(engine.create_table(table, schema), "create_table failed");
+    for (int i = 0; i < 600; i++) {
+        int id = (i * 7919) % 600 - 300;  // Every id in [-300, 300) in scrambled order
+        CHECK(engine.insert(table, Relational::Tuple{ id, std::string("n") + std::to_string(id) }), "insert failed");
+    }
+    std::vector<Relational::Tuple> rows = engine.scan(table);
+    CHECK(rows.size() == 600, "scan lost rows");
+    for (size_t i = 0; i < rows.size(); i++) {
+        CHECK(std::get<int>(rows[i][0]) == static_cast<int>(i) - 300, "scan should return ids in numeric order");
+    }
+    rows = engine.scan_range(table, Relational::Tuple{ -5 }, Relational::Tuple{ 250 });
+    CHECK(rows.size() == 256 && std::get<int>(rows.front()[0]) == -5 && std::get<int>(rows.back()[0]) == 250,
+          "scan_range [-5, 250] should return 256 rows in order");
+    CHECK(engine.scan_range(table, Relational::Tuple{ 290 }, Relational::Tuple{}).size() == 10, "open upper bound");
+    CHECK(engine.scan_range(table, Relational::Tuple{}, Relational::Tuple{ -299 }).size() == 2, "open lower bound");
+    CHECK(engine.drop_table(table), "drop_table failed");
+    std::cout << "[OK] Numeric keys scan in value order and range predicates become one range scan" << std::endl;
+
+    // Composite key (city, id): rows cluster by city, then order by id
+    const std::string visits = "test_relational_composite";
+    std::remove(("data/" + visits + ".db").c_str());
+    Relational::TableSchema composite;
+    composite.pk_index = 1;
+    composite.key_columns = {1, 0};
+    composite.columns = {
+        {"id", Relational::ColumnType::INT},
+        {"city", Relational::ColumnType::STRING},
+        {"note", Relational::ColumnType::STRING}
+    };
+    CHECK(engine.create_table(visits, composite), "create_table with a composite key failed");
+    const char* cities[] = {"rome", "oslo", "lima", "oslo2"};
+    for (int id = 20; id > 0; id--) {
+        CHECK(engine.insert(visits, Relational::Tuple{ id, std::string(cities[id % 4]), std::string("v") }), "insert failed");
+    }
+    CHECK(!engine.insert(visits, Relational::Tuple{ 2, std::string("lima"), std::string("dup") }), "duplicate composite key");
+    CHECK(engine.insert(visits, Relational::Tuple{ 2, std::string("oslo"), std::string("same id, other city") }),
+          "same id under another city should be a new key");
+    rows = engine.scan_range(visits, Relational::Tuple{ std::string("oslo") }, Relational::Tuple{ std::string("oslo") });
+    CHECK(rows.size() == 6, "prefix range on the leading key column (got " + std::to_string(rows.size()) + ")");
+    for (size_t i = 0; i < rows.size(); i++) {
+        CHECK(std::get<std::string>(rows[i][1]) == "oslo", "prefix range leaked into another city");
+        CHECK(i == 0 || std::get<int>(rows[i - 1][0]) < std::get<int>(rows[i][0]), "rows of one city should order by id");
+    }
+    rows = engine.scan_range(visits, Relational::Tuple{ std::string("oslo"), 5 }, Relational::Tuple{ std::string("oslo"), 13 });
+    CHECK(rows.size() == 3, "range over the second key column");
+    CHECK(engine.lookup(visits, "city", std::string("lima")).size() == 5, "lookup on the leading key column");
+    CHECK(engine.remove(visits, Relational::Tuple{ std::string("oslo"), 2 }), "remove by composite key failed");
+    CHECK(!engine.remove(visits, std::string("lima")), "a partial key should not remove anything");
+    CHECK(engine.scan(visits).size() == 20, "remove should drop exactly one row");
+    rows = engine.scan(visits);
+    CHECK(std::get<std::string>(rows.front()[1]) == "lima" && std::get<std::string>(rows.back()[1]) == "rome",
+          "composite keys should scan in (city, id) order");
+    CHECK(engine.drop_table(visits), "drop_table failed");
+    std::cout << "[OK] Composite keys order by each column in turn" << std::endl;
+
+    std::cout << "\n=== Order-Preserving Key Test PASSED ===" << std::endl;
+    return 0;
+}
+
+struct RowViewSums {
+    long long ages = 0;
+    size_t name_bytes = 0;
+    size_t rows = 0;
+};
+
+static void sum_row_view(const Relational::RowView& row, void* ctx) {
+    RowViewSums* sums = static_cast<RowViewSums*>(ctx);
+    int age = 0;
+    std::string_view name;
+    if (row.get_int(3, age) && row.get_string(1, name)) {
+        sums->ages += age;
+        sums->name_bytes += name.size();
+        sums->rows++;
+    }
+}
+
+static int test_row_view() {
+    std::cout << "\n=== Row View Test ===" << std::endl;
+    Relational::TableSchema schema;
+    schema.pk_index = 0;
+    schema.columns = {
+        {"id", Relational::ColumnType::INT},
+        {"name", Relational::ColumnType::STRING},
+        {"score", Relational::ColumnType::DOUBLE},
+        {"age", Relational::ColumnType::INT},
+        {"active", Relational::ColumnType::BOOLEAN},
+        {"ratio", Relational::ColumnType::FLOAT}
+    };
+    Relational::RowLayout layout(schema);
+    CHECK(layout.fixed_offsets.size() == 2 && layout.fixed_offsets[1] == 5, "fixed offsets run up to the first STRING");
+    Relational::Tuple tuple = { 7, std::string("seven"), 2.5, 41, true, 0.25f };
+    std::vector<uint8_t> bytes = layout.codec.encode(tuple);
+    Relational::RowView view(layout, bytes.data(), bytes.size());
+    int id = 0, age = 0;
+    double score = 0;
+    bool active = false;
+    float ratio = 0;
+    std::string_view name;
+    CHECK(view.get_int(0, id) && id == 7 && view.get_string(1, name) && name == "seven", "leading columns");
+    CHECK(view.get_double(2, score) && score == 2.5 && view.get_int(3, age) && age == 41, "columns after a STRING");
+    CHECK(view.get_bool(4, active) && active && view.get_float(5, ratio) && ratio == 0.25f, "trailing columns");
+    CHECK(!view.get_int(1, id) && !view.get_string(0, name) && !view.get_int(6, id), "wrong type or column");
+    CHECK(view.materialize() == layout.codec.decode(bytes), "materialize should match decode");
+    CHECK((view.materialize({3, 0}) == Relational::Tuple{ 41, 7 }), "projected materialize");
+    Relational::RowView truncated(layout, bytes.data(), bytes.size() - 1);
+    CHECK(truncated.get_float(5, ratio) && !truncated.get_int(3, age) && truncated.materialize().empty(),
+          "a truncated row fails only on the columns it cuts");
+    std::vector<uint8_t> tagged = layout.codec.encode_tagged(tuple);
+    Relational::RowView legacy(layout, tagged.data(), tagged.size());
+    CHECK(legacy.get_double(2, score) && score == 2.5 && legacy.get_string(1, name) && name == "seven" &&
+          legacy.materialize() == tuple, "views should read rows in the older tagged format");
+    std::cout << "[OK] RowView reads columns in place" << std::endl;
+
+    const std::string table = "test_relational_row_view";
+    std::remove(("data/" + table + ".db").c_str());
+    StorageEngine engine;
+    CHECK(engine.create_table(table, schema), "create_table failed");
+    long long ages = 0;
+    for (int i = 0; i < 300; i++) {
+        std::string row_name = "user" + std::to_string(i);
+        CHECK(engine.insert(table, Relational::Tuple{ i, row_name, i * 0.5, 20 + i % 50, i % 2 == 0, 1.0f }),
+              "insert failed");
+        ages += 20 + i % 50;
+    }
+    std::vector<Relational::Tuple> rows = engine.scan(table, {"age", "id"});
+    CHECK(rows.size() == 300, "projected scan lost rows");
+    for (size_t i = 0; i < rows.size(); i++) {
+        CHECK((rows[i] == Relational::Tuple{ 20 + static_cast<int>(i) % 50, static_cast<int>(i) }),
+              "projected scan should return the listed columns in order");
+    }
+    CHECK(engine.scan(table, {"age", "missing"}).empty(), "unknown column");
+    RowViewSums sums;
+    engine.scan_rows(table, sum_row_view, &sums);
+    CHECK(sums.rows == 300 && sums.ages == ages, "scan_rows should visit every row");
+    CHECK(engine.drop_table(table), "drop_table failed");
+    std::cout << "[OK] Projected scans and row views over the table" << std::endl;
+
+    std::cout << "\n=== Row View Test PASSED ===" << std::endl;
+    return 0;
+}
+
+static int test_compiled_codec() {
+    std::cout << "\n=== Compiled Row Codec Test ===" << std::endl;
+    using Relational::ColumnType;
+    const std::vector<std::vector<ColumnType>> layouts = {
+        {ColumnType::INT, ColumnType::DOUBLE, ColumnType::BOOLEAN, ColumnType::FLOAT, ColumnType::DATETIME},
+        {ColumnType::INT, ColumnType::STRING, ColumnType::DOUBLE, ColumnType::STRING, ColumnType::BOOLEAN},
+        {ColumnType::STRING, ColumnType::STRING},
+        {ColumnType::FLOAT, ColumnType::STRING},
+    };
+    for (const auto& types : layouts) {
+        Relational::TableSchema schema;
+        schema.pk_index = 0;
+        Relational::Tuple tuple;
+        for (size_t i = 0; i < types.size(); i++) {
+            schema.columns.push_back({"c" + std::to_string(i), types[i]});
+            switch (types[i]) {
+                case ColumnType::INT: tuple.push_back(-42 - static_cast<int>(i)); break;
+                case ColumnType::FLOAT: tuple.push_back(1.5f); break;
+                case ColumnType::DOUBLE: tuple.push_back(-0.125); break;
+                case ColumnType::STRING: tuple.push_back(std::string(i * 3, 'x')); break;
+                case ColumnType::BOOLEAN: tuple.push_back(true); break;
+                case ColumnType::DATETIME: tuple.push_back(0); break;
+            }
+        }
+        Relational::RowCodec codec(schema);
+        Relational::CompiledRowCodec compiled(schema);
+        std::vector<uint8_t> bytes = compiled.encode(tuple);
+        CHECK(bytes == codec.encode(tuple), "compiled encode should write the same bytes as RowCodec");
+        CHECK(compiled.decode(bytes) == tuple, "compiled decode should round trip");
+        bytes.pop_back();
+        CHECK(compiled.decode(bytes).empty(), "a truncated row should not decode");
+        bytes.push_back(0);
+        bytes[0] ^= 0x7F;
+        CHECK(compiled.decode(bytes).empty(), "a wrong tag should not decode");
+    }
+    Relational::TableSchema schema;
+    schema.pk_index = 0;
+    schema.columns = {{"id", ColumnType::INT}, {"name", ColumnType::STRING}};
+    Relational::CompiledRowCodec compiled(schema);
+    CHECK(!compiled.all_fixed(), "a STRING column is variable-length");
+    CHECK(compiled.encode(Relational::Tuple{ std::string("1"), std::string("a") }).empty(), "wrong column type");
+    CHECK(compiled.encode(Relational::Tuple{ 1 }).empty(), "wrong column count");
+    std::cout << "[OK] Compiled programs match the per-column codec" << std::endl;
+
+    Relational::Catalog catalog;
+    CHECK(catalog.get_codec("t") == nullptr, "no codec before the table is registered");
+    CHECK(catalog.register_table("t", schema), "register_table failed");
+    const Relational::CompiledRowCodec* cached = catalog.get_codec("t");
+    CHECK(cached != nullptr && cached == catalog.get_codec("t"), "the catalog should keep one codec per table");
+    CHECK(catalog.drop_table("t") && catalog.get_codec("t") == nullptr, "drop_table should drop the codec");
+    std::cout << "[OK] The catalog compiles each table's codec once" << std::endl;
+
+    std::cout << "\n=== Compiled Row Codec Test PASSED ===" << std::endl;
+    return 0;
+}
+
+static int test_compact_rows() {
+    std::cout << "\n=== Compact Row Format Test ===" << std::endl;
+    Relational::TableSchema schema;
+    schema.pk_index = 0;
+    schema.columns = {
+        {"id", Relational::ColumnType::INT},
+        {"name", Relational::ColumnType::STRING},
+        {"age", Relational::ColumnType::INT},
+        {"score", Relational::ColumnType::DOUBLE},
+        {"seen", Relational::ColumnType::DATETIME},
+        {"email", Relational::ColumnType::STRING, true}
+    };
+    Relational::RowCodec codec(schema);
+    Relational::CompiledRowCodec compiled(schema);
+    Relational::Tuple row = { 1, std::string("Alice"), 25, 0.5, 1700000000, std::string("a@x") };
+    std::vector<uint8_t> bytes = codec.encode(row);
+    CHECK(bytes[0] == Relational::ROW_COMPACT_V1, "rows start with the format byte");
+    CHECK(bytes.size() < codec.encode_tagged(row).size(), "compact rows should be smaller than tagged ones");
+    CHECK(codec.decode(bytes) == row && compiled.decode(bytes) == row, "compact rows round trip");
+    CHECK(codec.decode(codec.encode_tagged(row)).size() == row.size(), "tagged rows still decode");
+
+    Relational::Tuple nulls = { 2, Relational::Null(), Relational::Null(), Relational::Null(), -5, Relational::Null() };
+    bytes = compiled.encode(nulls);
+    CHECK(bytes == codec.encode(nulls) && codec.decode(bytes) == nulls, "NULL columns round trip");
+    Relational::RowLayout layout(schema);
+    Relational::RowView view(layout, bytes.data(), bytes.size());
+    int age = 0;
+    CHECK(view.is_null(2) && !view.get_int(2, age) && !view.is_null(4), "views report NULL columns");
+    CHECK(codec.encode(Relational::Tuple{ Relational::Null(), std::string("x"), 1, 1.0, 0, std::string() }).empty() &&
+          compiled.encode(Relational::Tuple{ Relational::Null(), std::string("x"), 1, 1.0, 0, std::string() }).empty(),
+          "the primary key cannot be NULL");
+
+    Relational::Tuple wide = { -70000, std::string(300, 'w'), INT_MIN, -1.0, INT_MAX, std::string("\0z", 2) };
+    bytes = codec.encode(wide);
+    CHECK(bytes[0] == Relational::ROW_COMPACT_V1_WIDE && compiled.encode(wide) == bytes, "long rows use 2-byte offsets");
+    CHECK(codec.decode(bytes) == wide && compiled.decode(bytes) == wide, "wide rows round trip");
+    std::string_view tail;
+    CHECK(Relational::RowView(layout, bytes.data(), bytes.size()).get_string(5, tail) && tail == std::string("\0z", 2),
+          "views find the last column through the offset table");
+    bytes[0] = 0x90;
+    CHECK(codec.decode(bytes).empty() && compiled.decode(bytes).empty(), "unknown format versions are rejected");
+    std::cout << "[OK] Null bitmap, varints and offset table" << std::endl;
+
+    const std::string table = "test_relational_compact";
+    std::remove(("data/" + table + ".db").c_str());
+    std::remove(("data/" + table + "." + table + "_email_key.db").c_str());
+    StorageEngine engine;
+    CHECK(engine.create_table(table, schema), "create_table failed");
+    CHECK(engine.insert(table, row), "insert failed");
+    CHECK(engine.insert(table, nulls), "insert with NULLs failed");
+    CHECK(engine.insert(table, Relational::Tuple{ 3, std::string("Cy"), 40, 1.5, 0, Relational::Null() }),
+          "a second NULL in a UNIQUE column should not conflict");
+    CHECK(!engine.insert(table, Relational::Tuple{ 4, std::string("D"), 1, 1.0, 0, std::string("a@x") }),
+          "UNIQUE still rejects equal values");
+    CHECK(engine.lookup(table, "email", Relational::Null()).empty(), "NULL matches nothing");
+    CHECK(engine.lookup(table, "email", std::string("a@x")).size() == 1, "lookup through the unique index");
+    CHECK(engine.update(table, Relational::Tuple{ 1, std::string("Alice"), 26, 0.5, 0, Relational::Null() }),
+          "update to NULL failed");
+    CHECK(engine.lookup(table, "email", std::string("a@x")).empty(), "the old index entry should be gone");
+    CHECK(engine.update(table, Relational::Tuple{ 2, Relational::Null(), 7, 0.0, 0, std::string("b@x") }),
+          "update from NULL failed");
+    CHECK(engine.lookup(table, "email", std::string("b@x")).size() == 1, "the new value should be indexed");
+    std::vector<Relational::Tuple> rows = engine.scan(table);
+    CHECK(rows.size() == 3 && Relational::is_null(rows[0][5]) && Relational::is_null(rows[1][1]) &&
+          std::get<int>(rows[1][2]) == 7, "scan returns NULLs");
+    CHECK(engine.remove(table, 2) && engine.scan(table).size() == 2, "remove failed");
+    CHECK(engine.drop_table(table), "drop_table failed");
+    std::cout << "[OK] NULL columns through the engine; NULLs stay out of indexes" << std::endl;
+
+    std::cout << "\n=== Compact Row Format Test PASSED ===" << std::endl;
+    return 0;
+}
+
+static int test_dictionary_columns() {
+    std::cout << "\n=== Dictionary Column Test ===" << std::endl;
+    Relational::TableSchema schema;
+    schema.pk_index = 0;
+    schema.columns = {
+        {"id", Relational::ColumnType::INT},
+        {"status", Relational::ColumnType::STRING, false, true},
+        {"note", Relational::ColumnType::STRING}
+    };
+    Relational::TableDictionaries dictionaries(schema.columns.size());
+    Relational::RowCodec codec(schema, &dictionaries);
+    Relational::CompiledRowCodec compiled(schema, &dictionaries);
+    Relational::Tuple row = { 1, std::string("shipped"), std::string("first") };
+    std::vector<uint8_t> bytes = codec.encode(row);
+    CHECK(dictionaries[1].size() == 1 && dictionaries[1].find("shipped") == 0, "values are interned on encode");
+    CHECK(bytes.size() + 7 == Relational::RowCodec(schema).encode(row).size(), "a code replaces the string bytes");
+    CHECK(compiled.encode(row) == bytes, "the compiled codec writes the same codes");
+    CHECK(codec.decode(bytes) == row && compiled.decode(bytes) == row, "dictionary rows round trip");
+    Relational::Tuple other = { 2, std::string("pending"), Relational::Null() };
+    CHECK(compiled.decode(compiled.encode(other)) == other && dictionaries[1].size() == 2, "a second value gets a code");
+
+    Relational::RowLayout layout(schema, &dictionaries);
+    Relational::RowView view(layout, bytes.data(), bytes.size());
+    std::string_view status;
+    CHECK(view.get_string(1, status) && status == "shipped", "views read dictionary values");
+    std::vector<uint8_t> expected;
+    const uint8_t* raw = nullptr;
+    size_t len = 0;
+    CHECK(codec.encode_compact_column(1, std::string("shipped"), expected) && view.get_raw(1, raw, len) &&
+          len == expected.size() && std::memcmp(raw, expected.data(), len) == 0, "equal values have equal codes");
+
+    std::vector<uint8_t> uncoded = Relational::RowCodec(schema).encode(row);
+    CHECK(codec.decode(uncoded) == row, "values written without a dictionary still decode");
+    for (int i = 0; i < static_cast<int>(Relational::DICTIONARY_MAX_ENTRIES); i++) {
+        codec.encode(Relational::Tuple{ i, "s" + std::to_string(i), std::string() });
+    }
+    CHECK(dictionaries[1].size() == Relational::DICTIONARY_MAX_ENTRIES && dictionaries[1].spilled(),
+          "a full dictionary stops growing");
+    Relational::Tuple spilled = { 9, std::string("overflow"), std::string("x") };
+    bytes = compiled.encode(spilled);
+    CHECK(bytes == codec.encode(spilled) && codec.decode(bytes) == spilled && compiled.decode(bytes) == spilled,
+          "values past the cap are stored uncoded");
+    std::cout << "[OK] Codes, views and the dictionary cap" << std::endl;
+
+    const std::string table = "test_relational_dictionary";
+    std::remove(("data/" + table + ".db").c_str());
+    StorageEngine engine;
+    CHECK(engine.create_table(table, schema), "create_table failed");
+    const char* statuses[] = {"pending", "shipped", "delivered"};
+    for (int i = 0; i < 300; i++) {
+        CHECK(engine.insert(table, Relational::Tuple{ i, std::string(statuses[i % 3]), "note " + std::to_string(i) }),
+              "insert failed");
+    }
+    CHECK(engine.lookup(table, "status", std::string("shipped")).size() == 100, "lookup compares codes");
+    CHECK(engine.lookup(table, "status", std::string("returned")).empty(), "an unknown value matches nothing");
+    CHECK(engine.update(table, Relational::Tuple{ 1, std::string("returned"), Relational::Null() }), "update failed");
+    std::vector<Relational::Tuple> returned = engine.lookup(table, "status", std::string("returned"));
+    CHECK(returned.size() == 1 && std::get<int>(returned[0][0]) == 1, "updated values get codes");
+    CHECK(engine.lookup(table, "note", std::string("note 7")).size() == 1, "plain STRING columns still match");
+    CHECK(engine.scan(table).size() == 300, "scan decodes dictionary rows");
+
+    // Rejected rows leave no codes behind: the next new value takes the code after "returned"
+    CHECK(!engine.insert(table, Relational::Tuple{ 2, std::string("lost"), Relational::Null() }),
+          "a duplicate key is rejected");
+    CHECK(!engine.update(table, Relational::Tuple{ 999, std::string("ghost"), Relational::Null() }),
+          "an update of a missing row is rejected");
+    CHECK(engine.insert(table, Relational::Tuple{ 300, std::string("late"), Relational::Null() }), "insert failed");
+    Relational::TableDictionaries reference(schema.columns.size());
+    for (const char* status : {"pending", "shipped", "delivered", "returned", "late"}) {
+        reference[1].intern(status);
+    }
+    Relational::RowCodec reference_codec(schema, &reference);
+    std::vector<uint8_t> stored;
+    CHECK(engine.get_record(engine.open_table(table), reference_codec.encode_key_prefix(Relational::Tuple{ 300 }), stored),
+          "stored row missing");
+    Relational::Tuple late = reference_codec.decode(stored);
+    CHECK(late.size() == 3 && late[1] == Relational::Value(std::string("late")), "rejected rows took dictionary codes");
+    CHECK(engine.drop_table(table), "drop_table failed");
+    std::cout << "[OK] Equality lookups on dictionary codes" << std::endl;
+
+    std::cout << "\n=== Dictionary Column Test PASSED ===" << std::endl;
+    return 0;
+}
+
+static int test_add_column() {
+    std::cout << "\n=== Add Column Test ===" << std::endl;
+    const std::string table = "test_relational_add_column";
+    std::remove(("data/" + table + ".db").c_str());
+    std::remove(("data/" + table + ".city_idx.db").c_str());
+    StorageEngine engine;
+    Relational::TableSchema schema;
+    schema.pk_index = 0;
+    schema.columns = {
+        {"id", Relational::ColumnType::INT},
+        {"name", Relational::ColumnType::STRING}
+    };
+    CHECK(engine.create_table(table, schema), "create_table failed");
+    for (int i = 0; i < 200; i++) {
+        CHECK(engine.insert(table, Relational::Tuple{ i, "user " + std::to_string(i) }), "insert failed");
+    }
+    Relational::ColumnDef active{"active", Relational::ColumnType::BOOLEAN};
+    active.default_value = true;
+    CHECK(engine.add_column(table, active), "add_column failed");
+    CHECK(engine.add_column(table, Relational::ColumnDef{"city", Relational::ColumnType::STRING}),
+          "add_column without a default failed");
+    const Relational::TableSchema* got = engine.get_schema(table);
+    CHECK(got->version == 2 && got->columns.size() == 4 && got->column_count(0) == 2 && got->column_count(1) == 3,
+          "each added column is a schema version");
+    CHECK(!engine.add_column(table, Relational::ColumnDef{"name", Relational::ColumnType::INT}),
+          "duplicate column names are rejected");
+    Relational::ColumnDef bad{"score", Relational::ColumnType::INT};
+    bad.default_value = std::string("x");
+    CHECK(!engine.add_column(table, bad), "a default of another type is rejected");
+    CHECK(!engine.add_column(table, Relational::ColumnDef{"email", Relational::ColumnType::STRING, true}),
+          "UNIQUE columns cannot be added");
+    std::cout << "[OK] ADD COLUMN bumps the schema version" << std::endl;
+
+    std::vector<Relational::Tuple> rows = engine.scan(table);
+    CHECK(rows.size() == 200 && std::get<bool>(rows[5][2]) && Relational::is_null(rows[5][3]),
+          "old rows read the defaults");
+    CHECK(engine.scan(table, {"city", "active"})[0] == (Relational::Tuple{ Relational::Null(), true }),
+          "projections read the defaults");
+    CHECK(engine.insert(table, Relational::Tuple{ 500, std::string("new"), false, std::string("Oslo") }),
+          "insert at the new version failed");
+    CHECK(engine.update(table, Relational::Tuple{ 7, std::string("user 7"), false, std::string("Rome") }),
+          "update of an old row failed");
+    CHECK(engine.lookup(table, "active", true).size() == 199, "old rows match their default");
+    CHECK(engine.lookup(table, "city", std::string("Rome")).size() == 1, "updated rows hold the new column");
+    std::vector<Relational::Tuple> old_row = engine.lookup(table, "id", 8);
+    CHECK(old_row.size() == 1 && old_row[0] == (Relational::Tuple{ 8, std::string("user 8"), true, Relational::Null() }),
+          "point reads fill defaults");
+    CHECK(engine.create_index(table, "city_idx", "city") &&
+          engine.lookup(table, "city", std::string("Oslo")).size() == 1, "indexes backfill over old rows");
+    std::cout << "[OK] Rows of every version read through the engine" << std::endl;
+
+    Relational::RowCodec codec(*got);
+    Relational::CompiledRowCodec compiled(*got);
+    Relational::TableSchema before = *got;
+    before.columns.resize(2);
+    before.version = 0;
+    std::vector<uint8_t> v0 = Relational::RowCodec(before).encode(Relational::Tuple{ 1, std::string("a") });
+    Relational::Tuple expected = { 1, std::string("a"), true, Relational::Null() };
+    CHECK(codec.decode(v0) == expected && compiled.decode(v0) == expected, "version 0 rows decode with defaults");
+    std::vector<uint8_t> v2 = codec.encode(expected);
+    CHECK(v2[0] == Relational::ROW_VERSIONED && v2[1] == 4 && compiled.encode(expected) == v2,
+          "rows record the version they were written under");
+    CHECK(codec.decode(v2) == expected && compiled.decode(v2) == expected, "versioned rows round trip");
+    Relational::RowLayout layout(*got);
+    Relational::RowView old_view(layout, v0.data(), v0.size());
+    bool flag = false;
+    std::string_view name;
+    CHECK(old_view.get_bool(2, flag) && flag && old_view.is_null(3) && old_view.get_string(1, name) && name == "a",
+          "views read defaults for columns the row predates");
+    CHECK(Relational::RowCodec(before).decode(v2).empty(), "rows of a newer version are rejected");
+    CHECK(engine.drop_table(table), "drop_table failed");
+    std::cout << "[OK] Versioned rows in both codecs and views" << std::endl;
+
+    std::cout << "\n=== Add Column Test PASSED ===" << std::endl;
+    return 0;
+}
+
+struct ColumnSum {
+    long long sum = 0;
+    size_t count = 0;
+    size_t nulls = 0;
+};
+
+static void sum_int_column(const Relational::ColumnBatch& batch, void* ctx) {
+    ColumnSum* total = static_cast<ColumnSum*>(ctx);
+    for (size_t i = 0; i < batch.count; i++) {
+        int32_t v;
+        std::memcpy(&v, batch.data + i * 4, 4);
+        total->sum += v;
+        total->nulls += (batch.nulls[i / 8] >> (i % 8)) & 1;
+    }
+    total->count += batch.count;
+}
+
+static int test_pax_storage() {
+    std::cout << "\n=== PAX Storage Test ===" << std::endl;
+    const std::string pax = "test_relational_pax";
+    const std::string rows_table = "test_relational_pax_rows";
+    std::remove(("data/" + pax + ".db").c_str());
+    std::remove(("data/" + pax + ".name_idx.db").c_str());
+    std::remove(("data/" + rows_table + ".db").c_str());
+    StorageEngine engine;
+    Relational::TableSchema schema;
+    schema.pk_index = 0;
+    schema.columns = {
+        {"id", Relational::ColumnType::INT},
+        {"name", Relational::ColumnType::STRING},
+        {"score", Relational::ColumnType::INT},
+        {"amount", Relational::ColumnType::DOUBLE},
+        {"active", Relational::ColumnType::BOOLEAN}
+    };
+    CHECK(engine.create_table(rows_table, schema), "create_table(BTREE) failed");
+    schema.storage = Relational::TableStorage::PAX;
+    CHECK(engine.create_table(pax, schema), "create_table(PAX) failed");
+
+    // Inserted out of order, so blocks fill from the middle and split
+    const int n = 2000;
+    for (int i = 0; i < n; i++) {
+        int id = (i * 7919) % n;
+        Relational::Tuple row = { id, "name " + std::to_string(id % 37), id % 100, id * 0.5, id % 2 == 0 };
+        if (id % 5 == 0) {
+            row[4] = Relational::Null();
+        }
+        CHECK(engine.insert(pax, row) && engine.insert(rows_table, row), "insert failed");
+    }
+    CHECK(!engine.insert(pax, Relational::Tuple{ 5, std::string("dup"), 1, 1.0, true }), "duplicate keys are rejected");
+    CHECK(!engine.insert(pax, Relational::Tuple{ 5000, std::string("bad"), std::string("x"), 1.0, true }),
+          "rows of the wrong types are rejected");
+    std::vector<Relational::Tuple> rows = engine.scan(pax);
+    CHECK(rows.size() == static_cast<size_t>(n) && rows == engine.scan(rows_table), "PAX scan matches the row table");
+    std::vector<Relational::Tuple> row = engine.lookup(pax, "id", 1234);
+    CHECK(row.size() == 1 && row[0] == (Relational::Tuple{ 1234, std::string("name 13"), 34, 617.0, true }),
+          "point lookup finds the row in its block");
+    CHECK(engine.lookup(pax, "id", n).empty(), "missing keys are not found");
+    std::cout << "[OK] " << n << " rows in key order, point access by slot" << std::endl;
+
+    CHECK(engine.update(pax, Relational::Tuple{ 10, std::string("ten"), 99, 1.5, false }) &&
+          engine.update(rows_table, Relational::Tuple{ 10, std::string("ten"), 99, 1.5, false }), "update failed");
+    for (int id = 0; id < n; id += 3) {
+        CHECK(engine.remove(pax, id) && engine.remove(rows_table, id), "remove failed");
+    }
+    CHECK(!engine.remove(pax, 0), "removed rows are gone");
+    CHECK(engine.scan(pax) == engine.scan(rows_table), "updates and removes match the row table");
+    CHECK(engine.scan_range(pax, Relational::Tuple{ 100 }, Relational::Tuple{ 200 }) ==
+          engine.scan_range(rows_table, Relational::Tuple{ 100 }, Relational::Tuple{ 200 }), "range scans match");
+    CHECK(engine.scan(pax, {"amount", "id"}) == engine.scan(rows_table, {"amount", "id"}), "projections match");
+    CHECK(engine.lookup(pax, "score", 34).size() == engine.lookup(rows_table, "score", 34).size() &&
+          !engine.lookup(pax, "score", 34).empty(), "minipage filter matches");
+    CHECK(engine.lookup(pax, "name", std::string("name 13")) == engine.lookup(rows_table, "name", std::string("name 13")),
+          "string filter matches");
+    CHECK(engine.lookup(pax, "active", false) == engine.lookup(rows_table, "active", false), "boolean filter matches");
+    std::cout << "[OK] Updates, removes, ranges and filters match the row table" << std::endl;
+
+    ColumnSum pax_sum, row_sum;
+    CHECK(engine.scan_column(pax, "score", sum_int_column, &pax_sum) &&
+          engine.scan_column(rows_table, "score", sum_int_column, &row_sum), "scan_column failed");
+    CHECK(pax_sum.count == engine.scan(pax).size() && pax_sum.sum == row_sum.sum && pax_sum.count == row_sum.count,
+          "column sums match");
+    CHECK(!engine.scan_column(pax, "name", sum_int_column, &pax_sum), "STRING columns have no batches");
+    std::cout << "[OK] scan_column sums " << pax_sum.count << " values" << std::endl;
+
+    // Rows below the first block re-key and split it. With no free page the new blocks
+    // stop fitting, and a failed insert must leave the old block in place.
+    TableHandle* pax_handle = engine.open_table(pax);
+    CHECK(pax_handle != nullptr, "open_table(PAX) failed");
+    Page* bitmap = pax_handle->bpm->fetch_page(1);
+    CHECK(bitmap != nullptr, "fetch bitmap failed");
+    Page saved_bitmap;
+    std::memcpy(saved_bitmap.data, bitmap->data, PAGE_SIZE);
+    std::memset(bitmap->data + sizeof(PageHeader), 0xFF, PAGE_SIZE - sizeof(PageHeader));
+    pax_handle->bpm->unpin_page(1, true);
+    std::vector<Relational::Tuple> expected = engine.scan(pax);
+    int failures = 0;
+    for (int id = -1; id >= -300 && failures < 3; id--) {
+        Relational::Tuple low = { id, std::string("low"), 0, 0.0, true };
+        if (engine.insert(pax, low)) {
+            expected.insert(expected.begin(), low);
+        } else {
+            failures++;
+        }
+        CHECK(engine.scan(pax) == expected, "a failed block split lost rows");
+    }
+    CHECK(failures > 0, "inserts without free pages should fail");
+    bitmap = pax_handle->bpm->fetch_page(1);
+    CHECK(bitmap != nullptr, "fetch bitmap failed");
+    std::memcpy(bitmap->data, saved_bitmap.data, PAGE_SIZE);
+    pax_handle->bpm->unpin_page(1, true);
+    for (int id = -1; id >= -300; id--) {
+        engine.remove(pax, id);
+    }
+    CHECK(engine.scan(pax) == engine.scan(rows_table), "low rows removed");
+    std::cout << "[OK] Failed block splits keep the old block" << std::endl;
+
+    Relational::ColumnDef level{"level", Relational::ColumnType::INT};
+    level.default_value = 7;
+    CHECK(engine.add_column(pax, level), "add_column failed");
+    CHECK(engine.insert(pax, Relational::Tuple{ n, std::string("new"), 1, 1.0, true, Relational::Null() }),
+          "insert at the new version failed");
+    ColumnSum levels;
+    CHECK(engine.scan_column(pax, "level", sum_int_column, &levels) && levels.nulls == 1 &&
+          levels.sum == 7 * static_cast<long long>(levels.count - 1), "old blocks read the default");
+    CHECK(engine.lookup(pax, "level", 7).size() == levels.count - 1, "filters read the default");
+    CHECK(engine.create_index(pax, "name_idx", "name") &&
+          engine.lookup(pax, "name", std::string("new")).size() == 1, "indexes backfill from blocks");
+    engine.optimize_table(pax);
+    CHECK(engine.scan(pax).size() == levels.count, "blocks survive a vacuum");
+    CHECK(engine.drop_table(pax) && engine.drop_table(rows_table), "drop_table failed");
+    std::cout << "[OK] ADD COLUMN and indexes on PAX tables" << std::endl;
+
+    std::cout << "\n=== PAX Storage Test PASSED ===" << std::endl;
+    return 0;
+}
+
+// Flips every OVERFLOW page of the table to another type and back, so reads of a
+// chain fail while the pages are hidden
+static void hide_overflow_pages(StorageEngine& engine, const std::string& table, PageType from, PageType to) {
+    TableHandle* th = engine.open_table(table);
+    for (uint32_t id = 1; id < th->bpm->file_page_count(); id++) {
+        Page* page = th->bpm->fetch_page(id);
+        if (page == nullptr) {
+            continue;
+        }
+        bool match = get_header(*page)->page_type == from;
+        if (match) {
+            get_header(*page)->page_type = to;
+        }
+        th->bpm->unpin_page(id, match);
+    }
+}
+
+static int test_overflow_projection() {
+    std::cout << "\n=== Overflow Projection Test ===" << std::endl;
+    const std::string table = "test_relational_overflow";
+    std::remove(("data/" + table + ".db").c_str());
+    StorageEngine engine;
+    Relational::TableSchema schema;
+    schema.pk_index = 0;
+    schema.columns = {
+        {"id", Relational::ColumnType::INT},
+        {"amount", Relational::ColumnType::DOUBLE},
+        {"note", Relational::ColumnType::STRING}
+    };
+    CHECK(engine.create_table(table, schema), "create_table failed");
+    const int n = 40;
+    for (int i = 0; i < n; i++) {
+        CHECK(engine.insert(table, Relational::Tuple{ i, i * 1.5, std::string(3000, static_cast<char>('a' + i % 26)) }),
+              "insert of a large row failed");
+    }
+    std::vector<Relational::Tuple> notes = engine.scan(table, {"note"});
+    CHECK(notes.size() == static_cast<size_t>(n) && std::get<std::string>(notes[3][0]) == std::string(3000, 'd'),
+          "projecting the large column reads its chain");
+
+    // With the chains unreadable, whole rows are dropped but a projection of the
+    // columns in the leaf's prefix still sees every row
+    hide_overflow_pages(engine, table, PageType::OVERFLOW, PageType::FREE);
+    CHECK(engine.scan(table).empty(), "whole rows need the chain");
+    std::vector<Relational::Tuple> amounts = engine.scan(table, {"amount", "id"});
+    CHECK(amounts.size() == static_cast<size_t>(n) && amounts[7] == (Relational::Tuple{ 10.5, 7 }),
+          "projections of inline columns never read the chain");
+    CHECK(engine.scan_range(table, Relational::Tuple{ 5 }, Relational::Tuple{ 9 }).empty(), "ranges of whole rows");
+    hide_overflow_pages(engine, table, PageType::FREE, PageType::OVERFLOW);
+    CHECK(engine.scan(table).size() == static_cast<size_t>(n), "chains readable again");
+    CHECK(engine.drop_table(table), "drop_table failed");
+    std::cout << "[OK] Projections decode overflow rows from their inline prefix" << std::endl;
+
+    std::cout << "\n=== Overflow Projection Test PASSED ===" << std::endl;
+    return 0;
+}
+
+static int test_row_stream() {
+    std::cout << "\n=== Row Stream Test ===" << std::endl;
+    const Relational::TableStorage storages[] = { Relational::TableStorage::BTREE, Relational::TableStorage::PAX,
+                                                  Relational::TableStorage::HASH, Relational::TableStorage::LSM };
+    StorageEngine engine;
+    for (Relational::TableStorage storage : storages) {
+        const std::string table = "test_relational_stream_" + std::to_string(static_cast<int>(storage));
+        std::remove(("data/" + table + ".db").c_str());
+        Relational::TableSchema schema;
+        schema.pk_index = 0;
+        schema.storage = storage;
+        schema.columns = {
+            {"id", Relational::ColumnType::INT},
+            {"name", Relational::ColumnType::STRING},
+            {"score", Relational::ColumnType::DOUBLE}
+        };
+        CHECK(engine.create_table(table, schema), "create_table failed");
+        const int n = 3000;
+        for (int i = 0; i < n; i++) {
+            int id = (i * 7919) % n;
+            CHECK(engine.insert(table, Relational::Tuple{ id, "row " + std::to_string(id), id * 0.25 }), "insert failed");
+        }
+        for (int id = 0; id < n; id += 4) {
+            CHECK(engine.remove(table, id), "remove failed");
+        }
+
+        RowStream stream;
+        std::vector<Relational::Tuple> streamed;
+        Relational::Tuple row;
+        CHECK(engine.open_scan(table, stream), "open_scan failed");
+        while (stream.next(row)) {
+            streamed.push_back(row);
+        }
+        CHECK(!stream.next(row), "a finished stream stays finished");
+        CHECK(streamed == engine.scan(table), "streamed rows match scan");
+
+        std::vector<Relational::Tuple> batch;
+        std::vector<Relational::Tuple> projected;
+        CHECK(engine.open_scan(table, stream, {"score", "id"}), "open_scan with columns failed");
+        size_t batches = 0;
+        while (size_t count = stream.next_batch(batch, 100)) {
+            CHECK(count == batch.size() && count <= 100, "batch size");
+            projected.insert(projected.end(), batch.begin(), batch.end());
+            batches++;
+        }
+        CHECK(projected == engine.scan(table, {"score", "id"}) && batches == (projected.size() + 99) / 100,
+              "projected batches match scan");
+        CHECK(!engine.open_scan(table, stream, {"missing"}), "unknown columns are rejected");
+
+        // Stopping early releases the cursor, so the table can be written again
+        TableHandle* handle = engine.open_table(table);
+        CHECK(handle != nullptr && (storage != Relational::TableStorage::LSM || lsm_flush(*handle)), "lsm_flush failed");
+        CHECK(engine.open_scan(table, stream), "open_scan failed");
+        for (int i = 0; i < 10; i++) {
+            CHECK(stream.next(row), "early rows");
+        }
+        // An LSM stream reads through pinned run pages instead of a copy of the table
+        CHECK(storage != Relational::TableStorage::LSM || handle->bpm->get_pinned_count() > 0,
+              "LSM streams merge the runs in place");
+        stream.close();
+        CHECK(handle->bpm->get_pinned_count() == 0, "closing a stream unpins its pages");
+        CHECK(!stream.next(row), "a closed stream returns no rows");
+        CHECK(engine.insert(table, Relational::Tuple{ n, std::string("late"), 1.0 }), "insert after close failed");
+        CHECK(engine.drop_table(table), "drop_table failed");
+    }
+    RowStream missing;
+    CHECK(!engine.open_scan("test_relational_stream_missing", missing), "unknown tables are rejected");
+    std::cout << "[OK] Streams match scan on B+tree, PAX, hash and LSM tables" << std::endl;
+
+    std::cout << "\n=== Row Stream Test PASSED ===" << std::endl;
+    return 0;
+}
+
 int main() {
     ensure_data_dir();
     std::cout << "\n=== Relational Storage Engine Test ===" << std::endl;
@@ -75,5 +1166,8 @@ int main() {
     std::cout << "[OK] drop_table" << std::endl;
 
     std::cout << "\n=== Relational Storage Engine Test PASSED ===" << std::endl;
-    return 0;
+    return test_secondary_indexes() || test_index_write_rollback() || test_covering_index() || test_hash_storage() ||
+           test_lsm_storage() || test_optimize_table() || test_key_order() || test_row_view() ||
+           test_compiled_codec() || test_compact_rows() || test_dictionary_columns() ||
+           test_add_column() || test_pax_storage() || test_overflow_projection() || test_row_stream();
 }
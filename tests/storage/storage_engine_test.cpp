@@ -1,9 +1,14 @@
 #include "storage/interface/storage_engine.hpp"
+#include "storage/lsm_tree.hpp"
+#include "common/constants.hpp"
 #include <iostream>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <cassert>
 #include <cstring>
+#include <cstdio>
+#include <cstdlib>
 
 void test_basic_operations() {
     std::cout << "\n=== StorageEngine Basic Operations Test ===\n";
@@ -169,12 +174,325 @@ void test_range_scan() {
     std::cout << "\n=== Range Scan Test PASSED ===\n";
 }
 
+void test_hash_table() {
+    std::cout << "\n=== StorageEngine Hash Table Test ===\n";
+
+    StorageEngine se;
+    const std::string table_name = "test_storage_hash";
+    std::string path = "data/" + table_name + ".db";
+    std::remove(path.c_str());
+
+    assert(se.create_hash_table(table_name) && "create_hash_table failed");
+    TableHandle* th = se.open_table(table_name);
+    assert(th != nullptr && "open_table failed");
+
+    auto make_key = [](int i) {
+        std::string k = "hk_" + std::to_string(i);
+        return std::vector<uint8_t>(k.begin(), k.end());
+    };
+    auto make_value = [](int i, size_t size) {
+        return std::vector<uint8_t>(size, static_cast<uint8_t>('a' + i % 26));
+    };
+
+    const int count = 3000;
+    for (int i = 0; i < count; i++) {
+        size_t size = i % 97 == 0 ? PAGE_SIZE : 12;  // Some values go to overflow pages
+        assert(se.insert_record(th, make_key(i), make_value(i, size)) && "hash insert failed");
+    }
+    assert(!se.insert_record(th, make_key(7), make_value(7, 12)) && "duplicate key should be rejected");
+    std::cout << "[OK] Inserted " << count << " records into buckets that split as they filled\n";
+
+    std::vector<uint8_t> out_value;
+    for (int i = 0; i < count; i++) {
+        size_t size = i % 97 == 0 ? PAGE_SIZE : 12;
+        assert(se.get_record(th, make_key(i), out_value) && out_value == make_value(i, size) && "hash lookup failed");
+    }
+    assert(!se.get_record(th, make_key(count), out_value) && "missing key should not be found");
+    std::cout << "[OK] Every key found with its value\n";
+
+    for (int i = 0; i < count; i += 2) {
+        assert(se.delete_record(th, make_key(i)) && "hash delete failed");
+    }
+    for (int i = 1; i < count; i += 10) {
+        assert(se.update_record(th, make_key(i), make_value(i + 1, 300)) && "hash update failed");
+    }
+    assert(!se.delete_record(th, make_key(0)) && "deleted key should be gone");
+    std::cout << "[OK] Deleted half the keys and grew some values\n";
+
+    size_t scanned = 0;
+    se.scan_table(th, [](const std::vector<uint8_t>&, const std::vector<uint8_t>&, void* ctx) {
+        (*static_cast<size_t*>(ctx))++;
+    }, &scanned);
+    assert(scanned == count / 2 && "hash scan should visit every live record once");
+    std::cout << "[OK] Scan visited " << scanned << " records\n";
+
+    // With the page bitmap full the new overflow chain cannot be written, and the
+    // failed update must leave the old value and its chain in place
+    Page* bitmap = th->bpm->fetch_page(1);
+    assert(bitmap && "fetch bitmap failed");
+    std::vector<uint8_t> saved(bitmap->data, bitmap->data + PAGE_SIZE);
+    std::memset(bitmap->data + sizeof(PageHeader), 0xFF, PAGE_SIZE - sizeof(PageHeader));
+    th->bpm->unpin_page(1, true);
+    assert(!se.update_record(th, make_key(97), make_value(0, 2 * PAGE_SIZE)) && "update without free pages should fail");
+    assert(se.get_record(th, make_key(97), out_value) && out_value == make_value(97, PAGE_SIZE) &&
+           "failed update lost the old value");
+    bitmap = th->bpm->fetch_page(1);
+    std::memcpy(bitmap->data, saved.data(), PAGE_SIZE);
+    th->bpm->unpin_page(1, true);
+    std::cout << "[OK] A failed update kept the old record and its overflow chain\n";
+
+    se.close_table(th);
+    th = se.open_table(table_name);
+    assert(th != nullptr && "reopen failed");
+    for (int i = 1; i < count; i += 2) {
+        size_t size = i % 97 == 0 ? PAGE_SIZE : 12;
+        std::vector<uint8_t> expected = i % 10 == 1 ? make_value(i + 1, 300) : make_value(i, size);
+        assert(se.get_record(th, make_key(i), out_value) && out_value == expected && "lookup after reopen failed");
+    }
+    assert(!se.get_record(th, make_key(2), out_value) && "deleted key came back after reopen");
+    std::cout << "[OK] Directory and buckets persisted across reopen\n";
+
+    se.drop_table(table_name);
+    std::cout << "\n=== Hash Table Test PASSED ===\n";
+}
+
+void test_lsm_table() {
+    std::cout << "\n=== StorageEngine LSM Table Test ===\n";
+
+    StorageEngine se;
+    const std::string table_name = "test_storage_lsm";
+    std::string path = "data/" + table_name + ".db";
+    std::remove(path.c_str());
+
+    assert(se.create_lsm_table(table_name) && "create_lsm_table failed");
+    TableHandle* th = se.open_table(table_name);
+    assert(th != nullptr && "open_table failed");
+    assert(!btree_enable_write_buffer(*th) && "LSM metadata has no room for a write buffer");
+
+    auto make_key = [](int i) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "lk_%06d", i);
+        return std::vector<uint8_t>(buf, buf + std::strlen(buf));
+    };
+    auto make_value = [](int i, size_t size) {
+        return std::vector<uint8_t>(size, static_cast<uint8_t>('a' + i % 26));
+    };
+    auto value_size = [](int i) -> size_t { return i % 211 == 0 ? PAGE_SIZE : 24; };
+
+    // Enough rows for several memtable flushes and a level 0 merge, in scattered order
+    const int count = 20000;
+    for (int n = 0; n < count; n++) {
+        int i = static_cast<int>((n * 7919L) % count);
+        assert(se.insert_record(th, make_key(i), make_value(i, value_size(i))) && "lsm insert failed");
+    }
+    assert(!se.insert_record(th, make_key(7), make_value(7, 24)) && "duplicate key should be rejected");
+    std::cout << "[OK] Inserted " << count << " records through the memtable\n";
+
+    for (int i = 0; i < count; i += 3) {
+        assert(se.delete_record(th, make_key(i)) && "lsm delete failed");
+    }
+    for (int i = 1; i < count; i += 10) {
+        assert(se.update_record(th, make_key(i), make_value(i + 1, 40)) == (i % 3 != 0) && "lsm update failed");
+    }
+    assert(!se.delete_record(th, make_key(0)) && "deleted key should be gone");
+    std::cout << "[OK] Deleted a third of the keys and updated some values\n";
+
+    auto expected_value = [&](int i) {
+        return i % 10 == 1 ? make_value(i + 1, 40) : make_value(i, value_size(i));  // Only read for live keys
+    };
+    auto check_contents = [&](const char* when) {
+        std::vector<uint8_t> out_value;
+        for (int i = 0; i < count; i++) {
+            bool found = se.get_record(th, make_key(i), out_value);
+            assert(found == (i % 3 != 0) && when);
+            assert((!found || out_value == expected_value(i)) && when);
+        }
+        struct ScanState { int next; int seen; bool ordered; } state{0, 0, true};
+        se.range_scan(th, make_key(100), make_key(1099), [](const std::vector<uint8_t>& key, const std::vector<uint8_t>&, void* ctx) {
+            ScanState* s = static_cast<ScanState*>(ctx);
+            int i = std::stoi(std::string(key.begin() + 3, key.end()));
+            s->ordered = s->ordered && i > s->next;
+            s->next = i;
+            s->seen++;
+        }, &state);
+        assert(state.ordered && state.seen == 667 && when);
+
+        // The cursor merges the same sources one record at a time
+        LsmCursor cursor(*th);
+        int live = 0;
+        int previous = -1;
+        for (bool ok = cursor.seek_first(); ok; ok = cursor.next(), live++) {
+            Key k = cursor.key();
+            Value v = cursor.value();
+            int i = std::stoi(std::string(reinterpret_cast<const char*>(k.data()) + 3, k.size() - 3));
+            assert(i > previous && i % 3 != 0 && when);
+            assert(std::vector<uint8_t>(v.data(), v.data() + v.size()) == expected_value(i) && when);
+            previous = i;
+        }
+        assert(live == count - (count + 2) / 3 && !cursor.valid() && th->bpm->get_pinned_count() == 0 && when);
+    };
+    check_contents("lsm contents wrong before reopen");
+    std::cout << "[OK] Lookups and range scans merge the memtable with every run\n";
+
+    se.close_table(th);
+    th = se.open_table(table_name);
+    assert(th != nullptr && "reopen failed");
+    check_contents("lsm contents wrong after reopen");
+    std::cout << "[OK] Runs and the flushed memtable persisted across reopen\n";
+
+    // Leave only three free pages: the merge runs out part way, frees what it wrote
+    // and frees nothing else, so the runs and the pages they use stay as they were
+    Page* bitmap = th->bpm->fetch_page(1);
+    assert(bitmap && "fetch bitmap failed");
+    std::vector<uint8_t> saved(bitmap->data, bitmap->data + PAGE_SIZE);
+    uint8_t* bits = bitmap->data + sizeof(PageHeader);
+    std::memset(bits, 0xFF, PAGE_SIZE - sizeof(PageHeader));
+    for (int freed = 0, page = 0; freed < 3; page++) {
+        if (!(saved[sizeof(PageHeader) + page / 8] & (1 << (page % 8)))) {
+            bits[page / 8] &= static_cast<uint8_t>(~(1 << (page % 8)));
+            freed++;
+        }
+    }
+    std::vector<uint8_t> limited(bitmap->data, bitmap->data + PAGE_SIZE);
+    th->bpm->unpin_page(1, true);
+    size_t runs_before = th->lsm->runs.size();
+    assert(se.compact_table(th) == 0 && th->lsm->runs.size() == runs_before && "merge without free pages should fail");
+    bitmap = th->bpm->fetch_page(1);
+    assert(std::memcmp(bitmap->data, limited.data(), PAGE_SIZE) == 0 && "failed merge should free only its own output");
+    std::memcpy(bitmap->data, saved.data(), PAGE_SIZE);
+    th->bpm->unpin_page(1, true);
+    check_contents("lsm contents wrong after a failed compaction");
+    std::cout << "[OK] A failed compaction kept every run and overflow chain\n";
+
+    assert(se.compact_table(th) > 0 && "full compaction should drop tombstones");
+    check_contents("lsm contents wrong after compaction");
+    std::cout << "[OK] Full compaction dropped the tombstones\n";
+
+    se.drop_table(table_name);
+    std::cout << "\n=== LSM Table Test PASSED ===\n";
+}
+
+void test_deferred_deletes() {
+    std::cout << "\n=== StorageEngine Deferred Delete Test ===\n";
+
+    const std::string table_name = "test_storage_deferred";
+    const std::string hash_name = "test_storage_deferred_hash";
+    StorageEngine se;
+    se.drop_table(table_name);
+    se.drop_table(hash_name);
+    assert(se.create_table(table_name) && se.create_hash_table(hash_name) && "create failed");
+    TableHandle* th = se.open_table(table_name);
+    assert(th != nullptr && "open_table failed");
+    assert(!se.set_deferred_deletes(se.open_table(hash_name), true) && "hash tables have no deferred deletes");
+    assert(se.set_deferred_deletes(th, true) && "set_deferred_deletes failed");
+
+    auto key_of = [](int i) {
+        std::string k = "dd_" + std::to_string(1000 + i);
+        return std::vector<uint8_t>(k.begin(), k.end());
+    };
+    std::vector<uint8_t> value(24, 'd');
+    for (int i = 0; i < 200; i++) {
+        assert(se.insert_record(th, key_of(i), value) && "insert_record failed");
+    }
+    se.close_table(th);
+
+    // A fresh engine reads the setting back from the file
+    StorageEngine reopened;
+    th = reopened.open_table(table_name);
+    assert(th != nullptr && th->deferred_deletes && "deferred deletes should persist");
+    for (int i = 0; i < 200; i += 2) {
+        assert(reopened.delete_record(th, key_of(i)) && "delete_record failed");
+    }
+    std::vector<uint8_t> out_value;
+    assert(!reopened.get_record(th, key_of(0), out_value) && reopened.get_record(th, key_of(1), out_value));
+    assert(reopened.compact_table(th) == 100 && "deletes should have left tombstones");
+    std::cout << "[OK] Setting survived a reopen and deletes left tombstones for compact_table\n";
+
+    reopened.drop_table(table_name);
+    se.drop_table(hash_name);
+    std::cout << "\n=== Deferred Delete Test PASSED ===\n";
+}
+
+static std::string view_key(int i) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "vk_%05d", i);
+    return std::string(buf);
+}
+
+struct ViewScanState {
+    int next;
+    bool ordered;
+};
+
+void test_view_api() {
+    std::cout << "\n=== StorageEngine View API Test ===\n";
+
+    StorageEngine se;
+    const std::string table_name = "test_storage_views";
+    const std::string hash_name = "test_storage_views_hash";
+    std::remove(("data/" + table_name + ".db").c_str());
+    std::remove(("data/" + hash_name + ".db").c_str());
+    assert(se.create_table(table_name) && se.create_hash_table(hash_name) && "create failed");
+    TableHandle* th = se.open_table(table_name);
+    TableHandle* hash = se.open_table(hash_name);
+    assert(th != nullptr && hash != nullptr && "open_table failed");
+
+    auto make_value = [](int i) {
+        return std::string(i % 101 == 0 ? PAGE_SIZE : 20, static_cast<char>('a' + i % 26));  // Some overflow
+    };
+    auto bytes = [](const std::string& s) { return std::vector<uint8_t>(s.begin(), s.end()); };
+    const int count = 2000;
+    for (int i = 0; i < count; i++) {
+        assert(se.insert_record(th, bytes(view_key(i)), bytes(make_value(i))) && "insert failed");
+        assert(se.insert_record(hash, bytes(view_key(i)), bytes(make_value(i))) && "hash insert failed");
+    }
+
+    RecordView view;
+    for (int i = 0; i < count; i += 7) {
+        assert(se.get_record(th, view_key(i), view) && view.value() == make_value(i) && "view lookup failed");
+        assert(se.get_record(hash, view_key(i), view) && view.value() == make_value(i) && "hash view lookup failed");
+    }
+    assert(!se.get_record(th, view_key(count), view) && view.value().empty() && "missing key should not be found");
+    assert(!se.get_record(th, "vk_0000", view) && "a key prefix is not a match");
+    view.reset();
+    std::cout << "[OK] get_record views match, overflow values included\n";
+
+    ViewScanState state{0, true};
+    se.scan_table(th, [](std::string_view key, std::string_view, void* ctx) {
+        ViewScanState* s = static_cast<ViewScanState*>(ctx);
+        s->ordered = s->ordered && key == view_key(s->next);
+        s->next++;
+    }, &state);
+    assert(state.ordered && state.next == count && "view scan should visit every key in order");
+    ViewScanState range{500, true};
+    std::string low = view_key(500);
+    std::string high = view_key(899);
+    se.range_scan(th, low, high, [](std::string_view key, std::string_view value, void* ctx) {
+        ViewScanState* s = static_cast<ViewScanState*>(ctx);
+        s->ordered = s->ordered && key == view_key(s->next) && !value.empty();
+        s->next++;
+    }, &range);
+    assert(range.ordered && range.next == 900 && "view range scan should stop at its bound");
+    size_t hashed = 0;
+    se.scan_table(hash, [](std::string_view, std::string_view, void* ctx) { (*static_cast<size_t*>(ctx))++; }, &hashed);
+    assert(hashed == count && "hash view scan should visit every record");
+    std::cout << "[OK] View scans visit records in place\n";
+
+    se.drop_table(table_name);
+    se.drop_table(hash_name);
+    std::cout << "\n=== View API Test PASSED ===\n";
+}
+
 int main() {
     try {
         test_basic_operations();
         test_multiple_records();
         test_scan_table();
         test_range_scan();
+        test_hash_table();
+        test_lsm_table();
+        test_deferred_deletes();
+        test_view_api();
         
         std::cout << "\n\n=== ALL STORAGE ENGINE TESTS PASSED ===\n";
         return 0;